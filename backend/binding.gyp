@@ -1,19 +1,241 @@
 {
   "targets": [
     {
-      "target_name": "verifier",
+      "target_name": "engine",
+      "type": "static_library",
       "cflags!": ["-fno-exceptions"],
       "cflags_cc!": ["-fno-exceptions"],
       "sources": [
-        "native/addon.cc",
-        "engine/src/Verifier.cpp"
+        "engine/src/Verifier.cpp",
+        "engine/src/CompiledMachine.cpp",
+        "engine/src/BitParallelNFA.cpp",
+        "engine/src/Expression.cpp",
+        "engine/src/Simulator.cpp",
+        "engine/src/CodeGenerator.cpp",
+        "engine/src/ThreadedMachine.cpp",
+        "engine/src/TraceStore.cpp",
+        "engine/src/Breakpoints.cpp",
+        "engine/src/TraceCodec.cpp",
+        "engine/src/ModelFile.cpp",
+        "engine/src/Json.cpp",
+        "engine/src/Kiss2.cpp",
+        "engine/src/Statechart.cpp",
+        "engine/src/Scxml.cpp",
+        "engine/src/Checkpoint.cpp",
+        "engine/src/Swarm.cpp",
+        "engine/src/ConcurrentStateSet.cpp",
+        "engine/src/ParallelSearch.cpp",
+        "engine/src/DistributedExplorer.cpp",
+        "engine/src/IncrementalVerifier.cpp",
+        "engine/src/ReportCache.cpp",
+        "engine/src/JobScheduler.cpp",
+        "engine/src/VerificationStats.cpp",
+        "engine/src/Trace.cpp",
+        "engine/src/Metrics.cpp"
       ],
+      "include_dirs": ["engine/include"],
+      "defines": ["RSM_TRACING=1"],
+      "direct_dependent_settings": {
+        "include_dirs": ["engine/include"],
+        "defines": ["RSM_TRACING=1"]
+      },
+      "link_settings": {
+        "libraries": ["-lpthread"]
+      },
+      "cflags": ["-fPIC"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "verifier",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["native/addon.cc"],
       "include_dirs": [
-        "<!@(node -p \"require('node-addon-api').include\")",
-        "engine/include"
+        "<!@(node -p \"require('node-addon-api').include\")"
       ],
       "defines": ["NAPI_DISABLE_CPP_EXCEPTIONS"],
       "cflags_cc": ["-std=c++17"]
+    },
+    {
+      "target_name": "batch_verify",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tools/BatchVerify.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "threaded_bench",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/bench/ThreadedBench.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "model_tool",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tools/ModelTool.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "kiss_bench",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/bench/KissBench.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "verifier_bench",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/bench/VerifierBench.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "threaded_machine_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/ThreadedMachineTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "trace_codec_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/TraceCodecTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "report_cache_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/ReportCacheTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "statechart_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/StatechartTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "incremental_verifier_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/IncrementalVerifierTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "swarm_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/SwarmTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "graph_analysis_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/GraphAnalysisTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "parallel_search_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/ParallelSearchTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "distributed_explorer_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/DistributedExplorerTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "code_generator_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/CodeGeneratorTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "trace_store_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/TraceStoreTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "breakpoints_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/BreakpointsTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "kiss2_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/Kiss2Test.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "job_scheduler_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/JobSchedulerTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
+    },
+    {
+      "target_name": "metrics_test",
+      "type": "executable",
+      "dependencies": ["engine"],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "sources": ["engine/tests/MetricsTest.cpp"],
+      "cflags_cc": ["-std=c++17", "-O2"]
     }
   ]
 }
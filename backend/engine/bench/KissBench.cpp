@@ -0,0 +1,148 @@
+/**
+ * KISS2 import throughput: streams synthetic machines (and any KISS2 files
+ * given on the command line, e.g. the MCNC/LGSynth set) through KissParser
+ * in 64 KiB chunks, then simulates random input vectors against the cubes.
+ *
+ * Build: node-gyp build (target kiss_bench) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/bench/KissBench.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/Kiss2.cpp
+ */
+#include "Kiss2.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    constexpr size_t ChunkBytes = 64 * 1024;
+
+    /**
+     * Every state has termsPerState product terms whose cubes partition the
+     * input space on their leading bits; the remaining bits are don't-cares
+     */
+    std::string makeSynthetic(uint32_t states, uint32_t inputBits, uint32_t termsPerState)
+    {
+        std::mt19937 rng(7);
+        uint32_t splitBits = 0;
+        while ((1u << splitBits) < termsPerState)
+            splitBits++;
+
+        std::string text = ".i " + std::to_string(inputBits) + "\n.o 4\n.s " + std::to_string(states) +
+                           "\n.p " + std::to_string(uint64_t(states) * termsPerState) + "\n.r st0\n";
+        for (uint32_t s = 0; s < states; s++)
+        {
+            for (uint32_t t = 0; t < termsPerState; t++)
+            {
+                for (uint32_t bit = 0; bit < inputBits; bit++)
+                    text += bit < splitBits ? static_cast<char>('0' + ((t >> bit) & 1)) : '-';
+                text += " st" + std::to_string(s) + " st" + std::to_string(rng() % states) + " ";
+                for (int bit = 0; bit < 4; bit++)
+                    text += static_cast<char>('0' + (rng() & 1));
+                text += '\n';
+            }
+        }
+        text += ".e\n";
+        return text;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const char *name, const KissMachine &machine, uint64_t bytes, double seconds)
+    {
+        // Random walk over concrete input vectors, matching cubes lazily
+        std::mt19937_64 rng(11);
+        const uint64_t mask = machine.inputBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << machine.inputBits) - 1;
+        const size_t steps = 2000000;
+        uint32_t state = machine.graph.initialState < 0 ? 0 : static_cast<uint32_t>(machine.graph.initialState);
+        size_t fired = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < steps && machine.graph.stateCount() > 0; i++)
+        {
+            int32_t edge = machine.match(state, rng() & mask);
+            if (edge >= 0)
+            {
+                state = machine.graph.edgeTargets[edge];
+                fired++;
+            }
+        }
+        double simulate = secondsSince(start);
+
+        std::printf("%-24s %9zu states %10llu terms %8.1f MB %8.1f MB/s %7.2fM terms/s  sim %6.1fM steps/s (%.0f%% matched)\n",
+                    name,
+                    machine.graph.stateCount(),
+                    static_cast<unsigned long long>(machine.productTerms),
+                    bytes / 1e6,
+                    bytes / 1e6 / seconds,
+                    machine.productTerms / 1e6 / seconds,
+                    steps / 1e6 / simulate,
+                    100.0 * fired / steps);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct Synthetic
+    {
+        const char *name;
+        uint32_t states;
+        uint32_t inputBits;
+        uint32_t termsPerState;
+    };
+    const Synthetic synthetic[] = {
+        {"synthetic-10k-x16", 10000, 8, 16},
+        {"synthetic-100k-x16", 100000, 12, 16},
+        {"synthetic-250k-x16", 250000, 16, 16},
+    };
+
+    for (const auto &config : synthetic)
+    {
+        std::string text = makeSynthetic(config.states, config.inputBits, config.termsPerState);
+
+        auto start = std::chrono::steady_clock::now();
+        KissParser parser;
+        for (size_t offset = 0; offset < text.size(); offset += ChunkBytes)
+        {
+            parser.feed(text.data() + offset, std::min(ChunkBytes, text.size() - offset));
+        }
+        KissMachine machine = parser.finish();
+        report(config.name, machine, text.size(), secondsSince(start));
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *file = std::fopen(argv[i], "rb");
+        if (!file)
+        {
+            std::fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 1;
+        }
+
+        try
+        {
+            auto start = std::chrono::steady_clock::now();
+            KissParser parser;
+            char buffer[ChunkBytes];
+            size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                parser.feed(buffer, read);
+            }
+            uint64_t bytes = parser.bytesRead();
+            KissMachine machine = parser.finish();
+            report(argv[i], machine, bytes, secondsSince(start));
+        }
+        catch (const std::exception &e)
+        {
+            std::fprintf(stderr, "%s: %s\n", argv[i], e.what());
+        }
+        std::fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * Steps/sec of the bytecode interpreter vs. the threaded tier.
+ *
+ * Build: node-gyp build (target threaded_bench) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/bench/ThreadedBench.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/Expression.cpp \
+ *       engine/src/Simulator.cpp engine/src/ThreadedMachine.cpp
+ */
+#include "ThreadedMachine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    /**
+     * Ring of counters: every state has a guarded "tick" with an action,
+     * a fallback "tick" and a "reset" back to the start
+     */
+    StateMachine makeRing(int stateCount)
+    {
+        StateMachine machine;
+        machine.id = "bench";
+        machine.name = "bench";
+        machine.type = "mealy";
+
+        Variable counter;
+        counter.name = "count";
+        counter.initialValue = "0";
+        machine.stateVariables.push_back(counter);
+
+        for (int i = 0; i < stateCount; i++)
+        {
+            State state;
+            state.id = "s" + std::to_string(i);
+            state.name = state.id;
+            state.isInitial = i == 0;
+            machine.states.push_back(state);
+        }
+        for (int i = 0; i < stateCount; i++)
+        {
+            std::string from = "s" + std::to_string(i);
+            std::string next = "s" + std::to_string((i + 1) % stateCount);
+
+            Transition tick{"t" + std::to_string(i) + "a", from, next, "tick", "up", "count % 7 != 3 && count < 1000000000", "count = count + 1"};
+            Transition slow{"t" + std::to_string(i) + "b", from, from, "tick", "hold", "", "count += 2"};
+            Transition reset{"t" + std::to_string(i) + "c", from, "s0", "reset", "", "", "count = 0"};
+            machine.transitions.push_back(tick);
+            machine.transitions.push_back(slow);
+            machine.transitions.push_back(reset);
+        }
+        return machine;
+    }
+
+    template <typename Fn>
+    double stepsPerSecond(size_t steps, Fn &&fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return steps / elapsed.count();
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int stateCount = argc > 1 ? std::atoi(argv[1]) : 64;
+    const size_t steps = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000000;
+
+    StateMachine machine = makeRing(stateCount);
+    MachineProgram program = MachineProgram::compile(machine);
+
+    std::mt19937 rng(42);
+    std::vector<int32_t> inputs(steps);
+    const int32_t tick = program.graph.findInput("tick");
+    const int32_t reset = program.graph.findInput("reset");
+    for (auto &input : inputs)
+    {
+        input = rng() % 64 == 0 ? reset : tick;
+    }
+
+    Simulator interpreter(program);
+    double interpreted = stepsPerSecond(steps, [&]()
+                                        {
+                                            for (int32_t input : inputs)
+                                                interpreter.step(input);
+                                        });
+
+    auto threaded = ThreadedMachine::compile(program);
+    int32_t state = program.graph.initialState;
+    std::vector<int64_t> variables = program.variables.initialValues();
+    ThreadedMachine::RunResult result{0, false};
+    double compiled = stepsPerSecond(steps, [&]()
+                                     {
+                                         result = threaded->run(state, variables.data(), inputs.data(), inputs.size(), nullptr);
+                                     });
+
+    if (result.steps != steps || state != interpreter.currentState() || variables != interpreter.variables())
+    {
+        std::fprintf(stderr, "threaded run diverged from the interpreter\n");
+        return 1;
+    }
+
+    std::printf("{\"states\": %d, \"steps\": %zu, \"interpreterStepsPerSec\": %.0f, "
+                "\"threadedStepsPerSec\": %.0f, \"speedup\": %.2f}\n",
+                stateCount, steps, interpreted, compiled, compiled / interpreted);
+    return 0;
+}
@@ -0,0 +1,583 @@
+/**
+ * Verifier benchmarks: runs every public Verifier function and the
+ * conversion paths over synthetic machines of growing size and prints the
+ * results as JSON, one scaling curve per (generator, function).
+ *
+ *   verifier_bench [--generators chain,ring,grid,complete,powerlaw,protocol]
+ *                  [--functions name,...] [--min-transitions 10]
+ *                  [--max-transitions 1000000] [--time-limit 10]
+ *                  [--min-time-ms 100] [--out results.json]
+ *
+ * Sizes step by half decades. Each measurement runs in a forked child, so
+ * its peak RSS (machine included) comes from the child's rusage and a
+ * function slower than --time-limit seconds is killed and not run on larger
+ * machines of that generator. Progress goes to stderr. POSIX only.
+ *
+ * Build: node-gyp build (target verifier_bench) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/bench/VerifierBench.cpp \
+ *       engine/src/Verifier.cpp engine/src/CompiledMachine.cpp \
+ *       engine/src/Statechart.cpp engine/src/Checkpoint.cpp \
+ *       engine/src/ReportCache.cpp engine/src/Expression.cpp \
+ *       engine/src/Json.cpp engine/src/ModelFile.cpp \
+ *       engine/src/VerificationStats.cpp engine/src/Trace.cpp
+ */
+#include "CompiledMachine.h"
+#include "Json.h"
+#include "ModelFile.h"
+#include "Statechart.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    // Keeps results observable so the work is not optimized away
+    volatile size_t sink;
+
+    StateMachine emptyMachine(const std::string &name, size_t states)
+    {
+        StateMachine machine;
+        machine.id = name;
+        machine.name = name;
+        machine.type = "mealy";
+        machine.states.resize(states);
+        for (size_t i = 0; i < states; i++)
+        {
+            machine.states[i].id = "s" + std::to_string(i);
+            machine.states[i].name = machine.states[i].id;
+        }
+        machine.states[0].isInitial = true;
+        return machine;
+    }
+
+    void addTransition(StateMachine &machine, size_t from, size_t to, const std::string &input,
+                       const std::string &output = std::string())
+    {
+        Transition transition;
+        transition.id = "t" + std::to_string(machine.transitions.size());
+        transition.from = machine.states[from].id;
+        transition.to = machine.states[to].id;
+        transition.input = input;
+        transition.output = output;
+        machine.transitions.push_back(std::move(transition));
+    }
+
+    /**
+     * s0 -> s1 -> ... -> sN, the last state final
+     */
+    StateMachine chain(size_t transitions)
+    {
+        StateMachine machine = emptyMachine("chain", transitions + 1);
+        for (size_t i = 0; i < transitions; i++)
+            addTransition(machine, i, i + 1, "next");
+        machine.states.back().isFinal = true;
+        return machine;
+    }
+
+    /**
+     * A single cycle without final states, so final-state searches see
+     * everything
+     */
+    StateMachine ring(size_t transitions)
+    {
+        StateMachine machine = emptyMachine("ring", std::max<size_t>(transitions, 1));
+        for (size_t i = 0; i < transitions; i++)
+            addTransition(machine, i, (i + 1) % transitions, "next");
+        return machine;
+    }
+
+    /**
+     * Square grid with right and down moves, final in the far corner
+     */
+    StateMachine grid(size_t transitions)
+    {
+        size_t side = 2;
+        while (2 * side * (side - 1) < transitions)
+            side++;
+        StateMachine machine = emptyMachine("grid", side * side);
+        for (size_t row = 0; row < side && machine.transitions.size() < transitions; row++)
+        {
+            for (size_t column = 0; column < side && machine.transitions.size() < transitions; column++)
+            {
+                size_t at = row * side + column;
+                if (column + 1 < side)
+                    addTransition(machine, at, at + 1, "right");
+                if (row + 1 < side && machine.transitions.size() < transitions)
+                    addTransition(machine, at, at + side, "down");
+            }
+        }
+        machine.states.back().isFinal = true;
+        return machine;
+    }
+
+    /**
+     * Every state to every other, input naming the target
+     */
+    StateMachine complete(size_t transitions)
+    {
+        size_t states = 2;
+        while (states * (states - 1) < transitions)
+            states++;
+        StateMachine machine = emptyMachine("complete", states);
+        for (size_t from = 0; from < states && machine.transitions.size() < transitions; from++)
+        {
+            for (size_t to = 0; to < states && machine.transitions.size() < transitions; to++)
+            {
+                if (to != from)
+                    addTransition(machine, from, to, "go" + std::to_string(to % 64));
+            }
+        }
+        machine.states.back().isFinal = true;
+        return machine;
+    }
+
+    /**
+     * Random graph with power-law in-degrees: a random spanning tree from
+     * s0, then targets drawn half uniformly, half by preferential
+     * attachment; about four transitions per state, 1% of states final
+     */
+    StateMachine powerlaw(size_t transitions)
+    {
+        std::mt19937_64 random(42);
+        size_t states = std::max<size_t>(2, transitions / 4);
+        StateMachine machine = emptyMachine("powerlaw", states);
+        std::vector<uint32_t> endpoints;
+        for (size_t i = 1; i < states && machine.transitions.size() < transitions; i++)
+        {
+            size_t from = random() % i;
+            addTransition(machine, from, i, "in" + std::to_string(random() % 16), "out" + std::to_string(random() % 8));
+            endpoints.push_back(static_cast<uint32_t>(i));
+        }
+        while (machine.transitions.size() < transitions)
+        {
+            size_t from = random() % states;
+            size_t to = (random() & 1) || endpoints.empty() ? random() % states : endpoints[random() % endpoints.size()];
+            addTransition(machine, from, to, "in" + std::to_string(random() % 16), "out" + std::to_string(random() % 8));
+            endpoints.push_back(static_cast<uint32_t>(to));
+        }
+        for (size_t i = 0; i < states; i += 100)
+            machine.states[i].isFinal = true;
+        return machine;
+    }
+
+    /**
+     * Chained sessions of a stop-and-wait sender: idle, sending, waitAck,
+     * retry, closed (final) and error (a deadlock), eight transitions each
+     */
+    StateMachine protocol(size_t transitions)
+    {
+        size_t sessions = std::max<size_t>(1, (transitions + 7) / 8);
+        StateMachine machine = emptyMachine("protocol", sessions * 6);
+        for (size_t k = 0; k < sessions; k++)
+        {
+            size_t idle = 6 * k, sending = idle + 1, waitAck = idle + 2, retry = idle + 3, closed = idle + 4,
+                   error = idle + 5;
+            machine.states[idle].name = "idle" + std::to_string(k);
+            machine.states[closed].isFinal = true;
+            addTransition(machine, idle, sending, "req", "send");
+            addTransition(machine, sending, waitAck, "tx");
+            addTransition(machine, waitAck, idle, "ack", "deliver");
+            addTransition(machine, waitAck, retry, "timeout");
+            addTransition(machine, retry, waitAck, "tx", "resend");
+            addTransition(machine, retry, error, "giveup", "abort");
+            addTransition(machine, idle, closed, "close", "fin");
+            if (k + 1 < sessions)
+                addTransition(machine, idle, idle + 6, "next");
+        }
+        return machine;
+    }
+
+    struct Generator
+    {
+        const char *name;
+        std::function<StateMachine(size_t)> make;
+    };
+
+    const std::vector<Generator> &generators()
+    {
+        static const std::vector<Generator> all = {
+            {"chain", chain},
+            {"ring", ring},
+            {"grid", grid},
+            {"complete", complete},
+            {"powerlaw", powerlaw},
+            {"protocol", protocol},
+        };
+        return all;
+    }
+
+    /**
+     * A measured operation: setup (untimed) prepares inputs, run is timed
+     */
+    struct Benchmark
+    {
+        const char *name;
+        std::function<void(const StateMachine &, std::string &)> setup;
+        std::function<void(const StateMachine &, const std::string &)> run;
+    };
+
+    std::string modelPath()
+    {
+        return "/tmp/verifier_bench_" + std::to_string(getpid()) + ".rsm";
+    }
+
+    const std::vector<Benchmark> &benchmarks()
+    {
+        auto none = [](const StateMachine &, std::string &) {};
+        static const std::vector<Benchmark> all = {
+            {"isStateReachable", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::isStateReachable(m, m.states.back().id).isReachable; }},
+            {"getReachableStates", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::getReachableStates(m).size(); }},
+            {"isDeadlock", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::isDeadlock(m, m.states.back().id); }},
+            {"findDeadlocks", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::findDeadlocks(m).size(); }},
+            {"isLivelock", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::isLivelock(m, m.states.back().id); }},
+            {"checkInvariant", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::checkInvariant(m, "state != " + m.states.back().name).holds; }},
+            {"canReachFinalState", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::canReachFinalState(m).isReachable; }},
+            {"generateReport", none, [](const StateMachine &m, const std::string &)
+             { sink = Verifier::generateReport(m).reachableStates; }},
+            {"compile", none, [](const StateMachine &m, const std::string &)
+             { sink = CompiledMachine::compile(m).edgeCount(); }},
+            {"toStatechart", none, [](const StateMachine &m, const std::string &)
+             { sink = Statechart::fromStateMachine(m).nodes.size(); }},
+            {"toJson", none, [](const StateMachine &m, const std::string &)
+             { sink = stateMachineToJson(m).dump().size(); }},
+            {"fromJson", [](const StateMachine &m, std::string &input)
+             { input = stateMachineToJson(m).dump(); },
+             [](const StateMachine &, const std::string &input)
+             { sink = stateMachineFromJson(JsonValue::parse(input)).transitions.size(); }},
+            {"saveModel", none, [](const StateMachine &m, const std::string &)
+             { MappedModel::save(m, modelPath()); sink = 1; }},
+            {"openModel", [](const StateMachine &m, std::string &)
+             { MappedModel::save(m, modelPath()); },
+             [](const StateMachine &, const std::string &)
+             { sink = MappedModel::open(modelPath())->edgeCount(); }},
+        };
+        return all;
+    }
+
+    struct Measurement
+    {
+        bool ok = false;
+        bool timedOut = false;
+        std::string error;
+        double medianMs = 0;
+        double minMs = 0;
+        int repetitions = 0;
+        double peakRssMb = 0;
+    };
+
+    /**
+     * Run the benchmark in a child until minTimeMs has been spent (at least
+     * once), reporting median and minimum over the repetitions
+     */
+    Measurement measure(const Benchmark &benchmark, const StateMachine &machine, double minTimeMs,
+                        unsigned timeLimitSeconds)
+    {
+        Measurement result;
+        int channel[2];
+        if (pipe(channel) != 0)
+        {
+            result.error = "pipe failed";
+            return result;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(channel[0]);
+            alarm(timeLimitSeconds);
+            std::string line;
+            try
+            {
+                std::string input;
+                if (benchmark.setup)
+                    benchmark.setup(machine, input);
+                std::vector<double> times;
+                double total = 0;
+                while (times.empty() || (total < minTimeMs && times.size() < 1000))
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    benchmark.run(machine, input);
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    times.push_back(ms);
+                    total += ms;
+                }
+                std::sort(times.begin(), times.end());
+                char buffer[128];
+                std::snprintf(buffer, sizeof(buffer), "ok %.9g %.9g %zu\n", times[times.size() / 2], times[0],
+                              times.size());
+                line = buffer;
+            }
+            catch (const std::exception &e)
+            {
+                line = std::string("error ") + e.what() + "\n";
+            }
+            std::remove(modelPath().c_str());
+            ssize_t written = write(channel[1], line.data(), line.size());
+            _exit(written == static_cast<ssize_t>(line.size()) ? 0 : 1);
+        }
+        close(channel[1]);
+        if (pid < 0)
+        {
+            close(channel[0]);
+            result.error = "fork failed";
+            return result;
+        }
+
+        std::string output;
+        char buffer[256];
+        ssize_t read;
+        while ((read = ::read(channel[0], buffer, sizeof(buffer))) > 0)
+            output.append(buffer, static_cast<size_t>(read));
+        close(channel[0]);
+
+        int status = 0;
+        struct rusage usage;
+        wait4(pid, &status, 0, &usage);
+        // ru_maxrss is in KiB on Linux
+        result.peakRssMb = usage.ru_maxrss / 1024.0;
+        if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM)
+        {
+            result.timedOut = true;
+            std::remove(("/tmp/verifier_bench_" + std::to_string(pid) + ".rsm").c_str());
+            return result;
+        }
+
+        std::istringstream fields(output);
+        std::string tag;
+        fields >> tag;
+        if (tag == "ok")
+        {
+            fields >> result.medianMs >> result.minMs >> result.repetitions;
+            result.ok = true;
+        }
+        else
+        {
+            std::getline(fields, result.error);
+            if (result.error.empty())
+                result.error = "benchmark process failed";
+        }
+        return result;
+    }
+
+    /**
+     * Least-squares slope of log(time) against log(transitions): about 1
+     * for linear functions, 2 for quadratic ones. Points under 10 µs are
+     * dominated by noise and skipped.
+     */
+    double scalingExponent(const std::vector<std::pair<double, double>> &points)
+    {
+        double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (const auto &point : points)
+        {
+            if (point.second < 0.01)
+                continue;
+            double x = std::log(point.first), y = std::log(point.second);
+            n++;
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        if (n < 2 || n * sxx - sx * sx == 0)
+            return 0;
+        return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    }
+
+    std::vector<std::string> splitList(const std::string &list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr,
+                     "usage: verifier_bench [--generators a,b] [--functions a,b] [--min-transitions N]\n"
+                     "                      [--max-transitions N] [--time-limit S] [--min-time-ms MS]\n"
+                     "                      [--out results.json]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::set<std::string> selectedGenerators, selectedFunctions;
+    size_t minTransitions = 10, maxTransitions = 1000000;
+    unsigned timeLimit = 10;
+    double minTimeMs = 100;
+    std::string outPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+            return usage();
+        std::string value = argv[++i];
+        if (option == "--generators")
+        {
+            for (const auto &name : splitList(value))
+                selectedGenerators.insert(name);
+        }
+        else if (option == "--functions")
+        {
+            for (const auto &name : splitList(value))
+                selectedFunctions.insert(name);
+        }
+        else if (option == "--min-transitions")
+            minTransitions = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        else if (option == "--max-transitions")
+            maxTransitions = static_cast<size_t>(std::strtod(value.c_str(), nullptr));
+        else if (option == "--time-limit")
+            timeLimit = static_cast<unsigned>(std::max(1L, std::strtol(value.c_str(), nullptr, 10)));
+        else if (option == "--min-time-ms")
+            minTimeMs = std::strtod(value.c_str(), nullptr);
+        else if (option == "--out")
+            outPath = value;
+        else
+            return usage();
+    }
+
+    // 10, 30, 100, 300, ... (half decades)
+    std::vector<size_t> sizes;
+    for (double size = minTransitions; size <= maxTransitions * 1.0001; size *= std::sqrt(10.0))
+    {
+        size_t rounded = static_cast<size_t>(std::llround(size));
+        double magnitude = std::pow(10.0, std::floor(std::log10(static_cast<double>(rounded))));
+        sizes.push_back(static_cast<size_t>(std::round(rounded / magnitude) * magnitude));
+    }
+
+    JsonValue machines = JsonValue::array();
+    JsonValue curves = JsonValue::array();
+    for (const auto &generator : generators())
+    {
+        if (!selectedGenerators.empty() && !selectedGenerators.count(generator.name))
+            continue;
+
+        struct Curve
+        {
+            JsonValue points = JsonValue::array();
+            std::vector<std::pair<double, double>> samples;
+            std::string stoppedBy;
+            size_t stoppedAt = 0;
+        };
+        std::vector<Curve> perFunction(benchmarks().size());
+
+        for (size_t size : sizes)
+        {
+            auto start = std::chrono::steady_clock::now();
+            StateMachine machine = generator.make(size);
+            double generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            const double transitions = static_cast<double>(machine.transitions.size());
+
+            JsonValue info = JsonValue::object();
+            info.set("generator", JsonValue::string(generator.name));
+            info.set("transitions", JsonValue::number(transitions));
+            info.set("states", JsonValue::number(static_cast<double>(machine.states.size())));
+            info.set("generateMs", JsonValue::number(generateMs));
+            machines.push(std::move(info));
+
+            for (size_t b = 0; b < benchmarks().size(); b++)
+            {
+                const Benchmark &benchmark = benchmarks()[b];
+                Curve &curve = perFunction[b];
+                if ((!selectedFunctions.empty() && !selectedFunctions.count(benchmark.name)) ||
+                    !curve.stoppedBy.empty())
+                    continue;
+
+                std::fprintf(stderr, "%-10s %-20s %10.0f transitions ... ", generator.name, benchmark.name,
+                             transitions);
+                Measurement result = measure(benchmark, machine, minTimeMs, timeLimit);
+                if (!result.ok)
+                {
+                    curve.stoppedBy = result.timedOut ? "time limit" : result.error;
+                    curve.stoppedAt = machine.transitions.size();
+                    std::fprintf(stderr, "%s\n", curve.stoppedBy.c_str());
+                    continue;
+                }
+                std::fprintf(stderr, "%10.3f ms %8.1f ns/transition %8.1f MB\n", result.medianMs,
+                             result.medianMs * 1e6 / transitions, result.peakRssMb);
+
+                JsonValue point = JsonValue::object();
+                point.set("transitions", JsonValue::number(transitions));
+                point.set("states", JsonValue::number(static_cast<double>(machine.states.size())));
+                point.set("medianMs", JsonValue::number(result.medianMs));
+                point.set("minMs", JsonValue::number(result.minMs));
+                point.set("repetitions", JsonValue::number(result.repetitions));
+                point.set("nsPerTransition", JsonValue::number(result.medianMs * 1e6 / transitions));
+                point.set("peakRssMb", JsonValue::number(result.peakRssMb));
+                curve.points.push(std::move(point));
+                curve.samples.push_back({transitions, result.medianMs});
+            }
+        }
+
+        for (size_t b = 0; b < benchmarks().size(); b++)
+        {
+            Curve &curve = perFunction[b];
+            if (curve.samples.empty() && curve.stoppedBy.empty())
+                continue;
+            JsonValue entry = JsonValue::object();
+            entry.set("generator", JsonValue::string(generator.name));
+            entry.set("function", JsonValue::string(benchmarks()[b].name));
+            entry.set("scalingExponent", JsonValue::number(scalingExponent(curve.samples)));
+            if (!curve.stoppedBy.empty())
+            {
+                entry.set("stoppedBy", JsonValue::string(curve.stoppedBy));
+                entry.set("stoppedAtTransitions", JsonValue::number(static_cast<double>(curve.stoppedAt)));
+            }
+            entry.set("points", std::move(curve.points));
+            curves.push(std::move(entry));
+        }
+    }
+
+    JsonValue results = JsonValue::object();
+    results.set("benchmark", JsonValue::string("verifier"));
+    results.set("minTimeMs", JsonValue::number(minTimeMs));
+    results.set("timeLimitSeconds", JsonValue::number(timeLimit));
+    results.set("machines", std::move(machines));
+    results.set("curves", std::move(curves));
+    std::string text = results.dump() + "\n";
+
+    if (outPath.empty())
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+    FILE *file = std::fopen(outPath.c_str(), "wb");
+    if (!file || std::fwrite(text.data(), 1, text.size(), file) != text.size())
+    {
+        std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    std::fclose(file);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef ANALYSIS_BUDGET_H
+#define ANALYSIS_BUDGET_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Why an analysis returned before covering its whole state space
+     */
+    enum class StopReason
+    {
+        None = 0,
+        TimeBudget,
+        MemoryBudget,
+        ConfigurationLimit
+    };
+
+    /**
+     * "" for a complete analysis, otherwise "time", "memory" or
+     * "configurations"
+     */
+    inline const char *stopReasonName(StopReason reason)
+    {
+        static const char *names[] = {"", "time", "memory", "configurations"};
+        return names[static_cast<int>(reason)];
+    }
+
+    /**
+     * Limits on one analysis. Unlike a job deadline, exhausting a budget is
+     * not an error: the analysis stops and reports what it covered.
+     */
+    struct AnalysisBudget
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Clock::duration time = Clock::duration::max();
+        // Bytes held by the analysis' own tables, not by its input
+        size_t memoryBytes = std::numeric_limits<size_t>::max();
+
+        bool unlimited() const
+        {
+            return time == Clock::duration::max() && memoryBytes == std::numeric_limits<size_t>::max();
+        }
+    };
+
+    /**
+     * Tracks one run against its budget. Polled once per expanded state with
+     * the bytes currently in use; the clock is read every Interval polls.
+     * Once exhausted it stays exhausted.
+     */
+    class BudgetMeter
+    {
+    public:
+        static constexpr uint32_t Interval = 64;
+
+        explicit BudgetMeter(const AnalysisBudget &budget)
+            : budget(budget), started(AnalysisBudget::Clock::now()) {}
+
+        bool exhausted(size_t bytesInUse)
+        {
+            if (stopped != StopReason::None)
+                return true;
+            if (bytesInUse > budget.memoryBytes)
+                stopped = StopReason::MemoryBudget;
+            else if (budget.time != AnalysisBudget::Clock::duration::max() && ++polls % Interval == 0 &&
+                     AnalysisBudget::Clock::now() - started >= budget.time)
+                stopped = StopReason::TimeBudget;
+            return stopped != StopReason::None;
+        }
+
+        StopReason reason() const { return stopped; }
+
+        double elapsedMs() const
+        {
+            return std::chrono::duration<double, std::milli>(AnalysisBudget::Clock::now() - started).count();
+        }
+
+    private:
+        AnalysisBudget budget;
+        AnalysisBudget::Clock::time_point started;
+        StopReason stopped = StopReason::None;
+        uint32_t polls = 0;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // ANALYSIS_BUDGET_H
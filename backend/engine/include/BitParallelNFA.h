@@ -0,0 +1,278 @@
+#ifndef BIT_PARALLEL_NFA_H
+#define BIT_PARALLEL_NFA_H
+
+#include "CompiledMachine.h"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Bit-parallel simulation of a nondeterministic machine with at most
+     * Words * 64 states. The active state set is kept in Words machine words.
+     *
+     * For every input and every byte of the state set a 256-entry table holds
+     * the union of successors of the states in that byte, so one step costs
+     * Words * 8 table lookups ORed together, independent of how many states
+     * are active. Transitions without an input label are epsilon moves and are
+     * folded into the tables as epsilon closures.
+     */
+    template <size_t Words>
+    class BitParallelNFA
+    {
+    public:
+        using StateSet = std::array<uint64_t, Words>;
+        static constexpr size_t MaxStates = Words * 64;
+
+        explicit BitParallelNFA(const CompiledMachine &machine)
+            : inputCount(machine.inputCount()), initialSet{}, finalSet{}
+        {
+            const size_t stateCount = machine.stateCount();
+            if (stateCount > MaxStates)
+            {
+                throw std::invalid_argument(
+                    "Machine has " + std::to_string(stateCount) +
+                    " states, bit-parallel simulation supports at most " + std::to_string(MaxStates));
+            }
+
+            std::vector<StateSet> closure = epsilonClosures(machine);
+
+            // Per input, per state: closure of the direct successors
+            std::vector<StateSet> successors(inputCount * MaxStates, StateSet{});
+            for (size_t s = 0; s < stateCount; s++)
+            {
+                for (uint32_t e = machine.edgeOffsets[s]; e < machine.edgeOffsets[s + 1]; e++)
+                {
+                    int32_t input = machine.edgeInputs[e];
+                    if (input == CompiledMachine::NoInput)
+                    {
+                        continue;
+                    }
+                    unite(successors[input * MaxStates + s], closure[machine.edgeTargets[e]]);
+                }
+            }
+
+            // table[input][chunk][byte] = union of successors of the bits in byte
+            table.assign(inputCount * Chunks * 256, StateSet{});
+            for (size_t input = 0; input < inputCount; input++)
+            {
+                for (size_t chunk = 0; chunk < Chunks; chunk++)
+                {
+                    StateSet *row = &table[(input * Chunks + chunk) * 256];
+                    for (unsigned value = 1; value < 256; value++)
+                    {
+                        unsigned low = static_cast<unsigned>(__builtin_ctz(value));
+                        row[value] = row[value & (value - 1)];
+                        unite(row[value], successors[input * MaxStates + chunk * 8 + low]);
+                    }
+                }
+            }
+
+            if (machine.initialState >= 0)
+            {
+                initialSet = closure[machine.initialState];
+            }
+            for (size_t s = 0; s < stateCount; s++)
+            {
+                if (machine.finalStates[s])
+                {
+                    set(finalSet, s);
+                }
+            }
+        }
+
+        const StateSet &initial() const { return initialSet; }
+
+        /**
+         * Active set after reading one input; unknown inputs yield the empty set
+         */
+        StateSet step(const StateSet &active, int32_t input) const
+        {
+            StateSet next{};
+            if (input < 0 || static_cast<size_t>(input) >= inputCount)
+            {
+                return next;
+            }
+
+            const StateSet *rows = &table[static_cast<size_t>(input) * Chunks * 256];
+            for (size_t w = 0; w < Words; w++)
+            {
+                uint64_t word = active[w];
+                for (size_t b = 0; word != 0; b++, word >>= 8)
+                {
+                    unsigned value = static_cast<unsigned>(word & 0xff);
+                    if (value != 0)
+                    {
+                        unite(next, rows[(w * 8 + b) * 256 + value]);
+                    }
+                }
+            }
+            return next;
+        }
+
+        bool accepts(const StateSet &active) const
+        {
+            for (size_t w = 0; w < Words; w++)
+            {
+                if (active[w] & finalSet[w])
+                    return true;
+            }
+            return false;
+        }
+
+        static bool isEmpty(const StateSet &active)
+        {
+            for (size_t w = 0; w < Words; w++)
+            {
+                if (active[w] != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        static bool contains(const StateSet &active, size_t state)
+        {
+            return (active[state / 64] >> (state % 64)) & 1;
+        }
+
+        /**
+         * Run from the initial set; stops early once no state is active.
+         * Returns the number of inputs consumed.
+         */
+        size_t run(const std::vector<int32_t> &inputs, StateSet &active) const
+        {
+            active = initialSet;
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                if (isEmpty(active))
+                {
+                    return i;
+                }
+                active = step(active, inputs[i]);
+            }
+            return inputs.size();
+        }
+
+        /**
+         * Unanchored search: the initial set is re-injected before every input,
+         * and every position after which a final state is active is reported
+         * (as the number of inputs consumed).
+         */
+        std::vector<size_t> findMatches(const std::vector<int32_t> &inputs) const
+        {
+            std::vector<size_t> ends;
+            StateSet active = initialSet;
+            if (accepts(active))
+            {
+                ends.push_back(0);
+            }
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                active = step(active, inputs[i]);
+                unite(active, initialSet);
+                if (accepts(active))
+                {
+                    ends.push_back(i + 1);
+                }
+            }
+            return ends;
+        }
+
+    private:
+        static constexpr size_t Chunks = Words * 8;
+
+        size_t inputCount;
+        StateSet initialSet;
+        StateSet finalSet;
+        std::vector<StateSet> table;
+
+        static void set(StateSet &target, size_t state)
+        {
+            target[state / 64] |= uint64_t(1) << (state % 64);
+        }
+
+        static void unite(StateSet &target, const StateSet &other)
+        {
+            for (size_t w = 0; w < Words; w++)
+            {
+                target[w] |= other[w];
+            }
+        }
+
+        /**
+         * Reflexive-transitive closure over unlabeled transitions
+         */
+        static std::vector<StateSet> epsilonClosures(const CompiledMachine &machine)
+        {
+            const size_t stateCount = machine.stateCount();
+            std::vector<StateSet> closure(stateCount, StateSet{});
+            for (size_t s = 0; s < stateCount; s++)
+            {
+                set(closure[s], s);
+            }
+
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                for (size_t s = 0; s < stateCount; s++)
+                {
+                    for (uint32_t e = machine.edgeOffsets[s]; e < machine.edgeOffsets[s + 1]; e++)
+                    {
+                        if (machine.edgeInputs[e] != CompiledMachine::NoInput)
+                        {
+                            continue;
+                        }
+                        StateSet merged = closure[s];
+                        unite(merged, closure[machine.edgeTargets[e]]);
+                        if (merged != closure[s])
+                        {
+                            closure[s] = merged;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+            return closure;
+        }
+    };
+
+    /**
+     * Result of a nondeterministic run
+     */
+    struct NondeterministicRunResult
+    {
+        std::vector<std::string> activeStates;
+        bool accepted;
+        size_t stepsConsumed;
+    };
+
+    /**
+     * Entry points that pick the narrowest bit-parallel simulator for the
+     * machine (64 or 128 states) and fall back to a sparse set simulation
+     * for larger machines.
+     */
+    class NondeterministicSimulator
+    {
+    public:
+        static NondeterministicRunResult run(
+            const CompiledMachine &machine,
+            const std::vector<std::string> &inputs);
+
+        static std::vector<size_t> findMatches(
+            const CompiledMachine &machine,
+            const std::vector<std::string> &inputs);
+
+    private:
+        static std::vector<int32_t> encodeInputs(
+            const CompiledMachine &machine,
+            const std::vector<std::string> &inputs);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // BIT_PARALLEL_NFA_H
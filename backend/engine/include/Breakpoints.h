@@ -0,0 +1,145 @@
+#ifndef BREAKPOINTS_H
+#define BREAKPOINTS_H
+
+#include "ThreadedMachine.h"
+#include "TraceStore.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    struct BreakpointSpec
+    {
+        enum class Kind
+        {
+            State,      // a step enters target (self-loops included)
+            Transition, // transition target fires
+            Input,      // a step consumes input target
+            Output,     // a step emits output target
+            Variable,   // watchpoint: variable target changes value
+            Predicate   // condition becomes true (false before the step)
+        };
+
+        Kind kind = Kind::State;
+        std::string target;
+        // Guard-language condition checked after the step; required for Predicate
+        std::string condition;
+    };
+
+    /**
+     * Breakpoints compiled against a MachineProgram. State, transition, input
+     * and output breakpoints are folded onto the edges they can fire on, so
+     * the per-step cost of an unconditional set is one byte load.
+     */
+    struct BreakpointSet
+    {
+        std::vector<BreakpointSpec::Kind> kinds;
+        std::vector<Bytecode> conditions; // empty = unconditional
+        std::vector<int32_t> watchSlots;  // variable slot of a watchpoint, else -1
+
+        std::vector<uint8_t> edgeFlags;
+        std::vector<std::vector<uint32_t>> edgeBreakpoints; // in spec order
+        std::vector<uint32_t> stepBreakpoints;              // watchpoints and predicates
+
+        size_t size() const { return kinds.size(); }
+
+        /**
+         * True when the fired edge alone decides every breakpoint
+         */
+        bool edgeOnly() const;
+
+        /**
+         * Throws std::invalid_argument naming the first breakpoint whose target
+         * does not exist or whose condition does not parse
+         */
+        static BreakpointSet compile(
+            const StateMachine &machine,
+            const MachineProgram &program,
+            const std::vector<BreakpointSpec> &specs);
+    };
+
+    struct BreakpointWindow
+    {
+        uint32_t before = 8;
+        uint32_t after = 8;
+    };
+
+    struct BreakpointRunResult
+    {
+        size_t steps;       // inputs consumed, including the one that hit
+        bool failed;        // stopped at an input with no enabled transition
+        int32_t breakpoint; // index into the set, -1 when the batch ran out
+        std::vector<TraceFrame> context;
+        size_t hitFrame; // position of the hit configuration in context
+    };
+
+    /**
+     * Runs a TieredSimulator until a breakpoint matches. Nothing is recorded
+     * per step: the runner keeps a configuration checkpoint every ChunkSteps
+     * steps and the inputs since the older of two checkpoints, and rebuilds
+     * the context window around a hit by replaying from there.
+     *
+     * Edge-only sets run on the threaded tier a chunk at a time and scan the
+     * edge trace; a hit inside a chunk is re-run up to the hit step.
+     */
+    class BreakpointRunner
+    {
+    public:
+        // Chunk length, and the largest context window served
+        static constexpr uint32_t ChunkSteps = 4096;
+
+        BreakpointRunner(const MachineProgram &program, TieredSimulator &simulator);
+
+        /**
+         * Forget the replay history; call after resetting the simulator
+         */
+        void reset();
+
+        BreakpointRunResult run(
+            const BreakpointSet &breakpoints,
+            const int32_t *inputs,
+            size_t count,
+            const BreakpointWindow &window);
+
+        uint64_t position() const { return consumed; }
+
+    private:
+        struct Checkpoint
+        {
+            uint64_t step;
+            int32_t state;
+            int32_t edge;
+            std::vector<int64_t> values;
+        };
+
+        const MachineProgram &program;
+        TieredSimulator &simulator;
+
+        uint64_t consumed = 0;
+        uint64_t syncedSteps = 0;
+        int32_t lastEdge = -1;
+        Checkpoint older;
+        Checkpoint newer;
+        bool hasNewer = false;
+        std::vector<int32_t> history; // inputs consumed since older.step
+
+        // Watchpoint and predicate values before the current step
+        std::vector<int64_t> tracked;
+
+        void resync();
+        void commit(const int32_t *inputs, size_t count, int32_t state, const std::vector<int64_t> &values);
+        int32_t check(const BreakpointSet &breakpoints, int32_t edge, int64_t *values);
+
+        std::vector<TraceFrame> context(
+            uint32_t before,
+            uint32_t after,
+            const int32_t *remaining,
+            size_t remainingCount,
+            size_t &hitFrame) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // BREAKPOINTS_H
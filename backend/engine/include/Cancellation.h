@@ -0,0 +1,105 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Thrown from inside a job's loops once its token is cancelled or past
+     * its deadline
+     */
+    class JobCancelled : public std::runtime_error
+    {
+    public:
+        explicit JobCancelled(const std::string &message) : std::runtime_error(message) {}
+    };
+
+    /**
+     * Cooperative cancellation: set from any thread, polled by the job
+     */
+    class CancellationToken
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit CancellationToken(Clock::time_point deadline = Clock::time_point::max())
+            : deadlineAt(deadline) {}
+
+        void cancel() { requested.store(true, std::memory_order_relaxed); }
+        bool cancelRequested() const { return requested.load(std::memory_order_relaxed); }
+        bool expired() const { return deadlineAt != Clock::time_point::max() && Clock::now() >= deadlineAt; }
+        bool cancelled() const { return cancelRequested() || expired(); }
+        Clock::time_point deadline() const { return deadlineAt; }
+
+        void throwIfCancelled() const
+        {
+            if (cancelRequested())
+                throw JobCancelled("Job cancelled");
+            if (expired())
+                throw JobCancelled("Job deadline exceeded");
+        }
+
+        /**
+         * Token of the job running on this thread, or nullptr outside jobs
+         */
+        static const CancellationToken *current() { return active; }
+
+    private:
+        friend class CancellationScope;
+
+        std::atomic<bool> requested{false};
+        Clock::time_point deadlineAt;
+
+        static inline thread_local const CancellationToken *active = nullptr;
+    };
+
+    /**
+     * Makes a token current on this thread for the scope's lifetime
+     */
+    class CancellationScope
+    {
+    public:
+        explicit CancellationScope(const CancellationToken *token) : previous(CancellationToken::active)
+        {
+            CancellationToken::active = token;
+        }
+        ~CancellationScope() { CancellationToken::active = previous; }
+
+        CancellationScope(const CancellationScope &) = delete;
+        CancellationScope &operator=(const CancellationScope &) = delete;
+
+    private:
+        const CancellationToken *previous;
+    };
+
+    /**
+     * Placed in hot loops: checks the current job's token every Interval
+     * calls, so the cost outside jobs is one branch and inside a job a
+     * counter increment
+     */
+    class CancellationPoint
+    {
+    public:
+        static constexpr uint32_t Interval = 1024;
+
+        CancellationPoint() : token(CancellationToken::current()) {}
+
+        void check()
+        {
+            if (token && ++calls % Interval == 0)
+                token->throwIfCancelled();
+        }
+
+    private:
+        const CancellationToken *token;
+        uint32_t calls = 0;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // CANCELLATION_H
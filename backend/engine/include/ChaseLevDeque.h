@@ -0,0 +1,123 @@
+#ifndef CHASE_LEV_DEQUE_H
+#define CHASE_LEV_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Work-stealing deque (Chase-Lev, with the C11 orderings of Le et al.,
+     * "Correct and Efficient Work-Stealing for Weak Memory Models"). The
+     * owning thread pushes and pops at the bottom, so its own work runs in
+     * depth-first order; other threads steal the oldest item at the top.
+     * Only the owner may call push() and pop(); steal() is safe from any
+     * thread. Outgrown arrays are kept until destruction, since a thief may
+     * still be reading one.
+     */
+    template <typename T>
+    class ChaseLevDeque
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Deque items are copied through atomics");
+
+    public:
+        explicit ChaseLevDeque(int64_t capacity = 1024)
+        {
+            arrays.emplace_back(new Array(capacity));
+            array.store(arrays.back().get(), std::memory_order_relaxed);
+        }
+
+        ChaseLevDeque(const ChaseLevDeque &) = delete;
+        ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+        void push(T item)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            Array *a = array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1)
+                a = grow(a, t, b);
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        bool pop(T &item)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Array *a = array.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = a->get(b);
+            if (t < b)
+                return true;
+            // Last item: race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        bool steal(T &item)
+        {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+
+            Array *a = array.load(std::memory_order_acquire);
+            item = a->get(t);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        /**
+         * Racy snapshot, for heuristics only
+         */
+        bool empty() const
+        {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Array
+        {
+            int64_t capacity;
+            std::unique_ptr<std::atomic<T>[]> slots;
+
+            explicit Array(int64_t capacity) : capacity(capacity), slots(new std::atomic<T>[capacity]) {}
+
+            T get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+            void put(int64_t i, T item) { slots[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+        };
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<Array *> array;
+        // Owner only
+        std::vector<std::unique_ptr<Array>> arrays;
+
+        Array *grow(Array *old, int64_t t, int64_t b)
+        {
+            arrays.emplace_back(new Array(old->capacity * 2));
+            Array *bigger = arrays.back().get();
+            for (int64_t i = t; i < b; i++)
+                bigger->put(i, old->get(i));
+            array.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+    };
+
+} // namespace ReactiveSystem
+
+#endif // CHASE_LEV_DEQUE_H
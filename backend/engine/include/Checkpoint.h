@@ -0,0 +1,121 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "ReportCache.h"
+#include "Statechart.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * On-disk state of a configuration exploration, so a run interrupted by
+     * a restart, a deploy or its budget continues where it left off. Two
+     * files per chart, named by its canonical hash:
+     *
+     *   <hash>.ckpt       header, then one record per visited configuration
+     *                     in discovery order: key words, parent index and
+     *                     event. Records from `expanded` on are the
+     *                     frontier. Append-only: each save writes only the
+     *                     records found since the previous one.
+     *   <hash>.ckpt.meta  counters, entered states and findings so far,
+     *                     replaced atomically once the records are flushed.
+     *                     It names how many records are committed, so a
+     *                     crash mid-save loses only that save.
+     *
+     * Both files are little-endian and position-independent; a checkpoint
+     * resumes on any machine exploring a chart with the same hash. A third,
+     * <hash>.ckpt.lock, is held locked for the life of the object, so two
+     * explorations of one chart never write the same files; the files are
+     * removed once the exploration completes.
+     */
+    class ExplorationCheckpoint
+    {
+    public:
+        struct State
+        {
+            uint64_t committed = 0;
+            uint64_t expanded = 0;
+            uint64_t divergent = 0;
+            double elapsedMs = 0;
+            std::vector<uint64_t> entered;
+            // Counters and findings of the configurations expanded so far
+            StatechartReport report;
+        };
+
+        using Visit = std::function<void(const uint64_t *key, uint32_t parent, int32_t event)>;
+
+        /**
+         * eventCount is the number of the chart's events, which record
+         * events must index
+         */
+        ExplorationCheckpoint(const CheckpointOptions &options, const MachineHash &model, uint32_t keyWords,
+                              uint32_t eventCount);
+        ~ExplorationCheckpoint();
+
+        ExplorationCheckpoint(const ExplorationCheckpoint &) = delete;
+        ExplorationCheckpoint &operator=(const ExplorationCheckpoint &) = delete;
+
+        /**
+         * This object holds the chart's lock; when another exploration of
+         * the same chart does, the caller must not load or save
+         */
+        bool locked() const { return lock >= 0; }
+
+        /**
+         * Read the chart's checkpoint, passing the committed records to visit
+         * in order from the mapped file; false when there is none. Throws
+         * std::runtime_error when it is corrupt, a record's parent being no
+         * earlier record or its event none of the chart's included, or when
+         * it belongs to another chart.
+         */
+        bool load(State &state, const Visit &visit);
+
+        /**
+         * The interval has passed since the last save
+         */
+        bool due() const { return Clock::now() >= next; }
+
+        /**
+         * Append records [state.committed, count) and commit state; keys
+         * holds count * keyWords words. Throws std::runtime_error when the
+         * files cannot be written.
+         */
+        void save(State &state, size_t count, const uint64_t *keys, const uint32_t *parents, const int32_t *events);
+
+        /**
+         * Remove the records and meta files, once there is nothing left to
+         * resume
+         */
+        void discard();
+
+        const std::string &path() const { return recordsPath; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        MachineHash model;
+        uint32_t keyWords;
+        uint32_t eventCount;
+        std::chrono::milliseconds interval;
+        std::string recordsPath;
+        std::string metaPath;
+        std::string lockPath;
+        int lock = -1;
+        FILE *records = nullptr;
+        Clock::time_point next;
+
+        size_t recordSize() const { return keyWords * sizeof(uint64_t) + 2 * sizeof(uint32_t); }
+        void openRecords(bool truncate);
+        bool readMeta(State &state) const;
+        void writeMeta(const State &state) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,67 @@
+#ifndef CODE_GENERATOR_H
+#define CODE_GENERATOR_H
+
+#include "MealyMachine.h"
+#include <cstdint>
+#include <string>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Options for C++ code generation
+     */
+    struct CodeGenOptions
+    {
+        enum class Dispatch
+        {
+            Auto,   // table when the machine has no guards/actions, else switch
+            Switch, // nested switch over state and input
+            Table   // constexpr [state][input] transition table
+        };
+
+        std::string namespaceName = "generated";
+        std::string className;
+        Dispatch dispatch = Dispatch::Auto;
+
+        // Conformance harness: random walks replayed against the header
+        uint32_t conformanceSequences = 32;
+        uint32_t conformanceLength = 64;
+        uint32_t conformanceSeed = 1;
+    };
+
+    /**
+     * Generated sources
+     */
+    struct GeneratedCode
+    {
+        std::string headerName;
+        std::string header;
+        std::string conformanceTest;
+    };
+
+    /**
+     * Compiles a StateMachine into a self-contained C++17 header.
+     *
+     * States, inputs and outputs become enums, variables become int64_t
+     * members and guards/actions are emitted inline, so the generated class
+     * performs no allocation and holds no strings. The conformance test is a
+     * standalone main() that replays input sequences recorded from the
+     * reference Simulator and exits non-zero on the first divergence.
+     */
+    class CodeGenerator
+    {
+    public:
+        static GeneratedCode generate(
+            const StateMachine &machine,
+            const CodeGenOptions &options);
+
+        /**
+         * Turn an arbitrary label into a valid, non-reserved C++ identifier
+         */
+        static std::string toIdentifier(const std::string &label, const std::string &fallback);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // CODE_GENERATOR_H
@@ -0,0 +1,73 @@
+#ifndef COMPILED_MACHINE_H
+#define COMPILED_MACHINE_H
+
+#include "MealyMachine.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Index-based form of a StateMachine used by the native engines.
+     * States and input/output symbols are interned to dense integers and the
+     * outgoing transitions of every state are stored contiguously (CSR).
+     */
+    struct CompiledMachine
+    {
+        static constexpr int32_t NoInput = -1;
+        static constexpr int32_t NoOutput = -1;
+
+        std::vector<std::string> stateIds;
+        std::vector<std::string> stateNames;
+        std::vector<uint8_t> finalStates;
+        int32_t initialState = -1;
+
+        std::vector<std::string> inputSymbols;
+        std::vector<std::string> outputSymbols;
+
+        // Edges of state s are [edgeOffsets[s], edgeOffsets[s + 1])
+        std::vector<uint32_t> edgeOffsets;
+        std::vector<uint32_t> edgeTargets;
+        std::vector<int32_t> edgeInputs;
+        std::vector<int32_t> edgeOutputs;
+        std::vector<uint32_t> edgeTransitions;
+
+        std::unordered_map<std::string, uint32_t> stateIndex;
+        std::unordered_map<std::string, uint32_t> inputIndex;
+        std::unordered_map<std::string, uint32_t> outputIndex;
+
+        size_t stateCount() const { return stateIds.size(); }
+        size_t edgeCount() const { return edgeTargets.size(); }
+        size_t inputCount() const { return inputSymbols.size(); }
+        size_t outputCount() const { return outputSymbols.size(); }
+
+        // Graph interface shared with MappedModel (see GraphAnalysis.h)
+        int32_t initial() const { return initialState; }
+        uint32_t edgeBegin(uint32_t state) const { return edgeOffsets[state]; }
+        uint32_t edgeEnd(uint32_t state) const { return edgeOffsets[state + 1]; }
+        uint32_t target(uint32_t edge) const { return edgeTargets[edge]; }
+        bool isFinal(uint32_t state) const { return finalStates[state] != 0; }
+
+        /**
+         * Index of a state id, or -1 when unknown
+         */
+        int32_t findState(const std::string &stateId) const;
+
+        /**
+         * Index of an input symbol, or -1 when the machine never reads it
+         */
+        int32_t findInput(const std::string &input) const;
+
+        /**
+         * Build the index. Transitions whose endpoints do not exist are skipped;
+         * transitions without an input (output) label get NoInput (NoOutput).
+         */
+        static CompiledMachine compile(const StateMachine &machine);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // COMPILED_MACHINE_H
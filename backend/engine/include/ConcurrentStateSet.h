@@ -0,0 +1,98 @@
+#ifndef CONCURRENT_STATE_SET_H
+#define CONCURRENT_STATE_SET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Thrown when a ConcurrentStateSet reaches its capacity
+     */
+    class StateSetFull : public std::runtime_error
+    {
+    public:
+        StateSetFull() : std::runtime_error("State set capacity exhausted") {}
+    };
+
+    /**
+     * Lock-free visited set of fixed-width keys shared by search workers.
+     * Open addressing over a fixed table: a slot is claimed with one CAS on
+     * its tag, filled, then published by storing the key's hash; lookups
+     * that meet a slot being filled wait for it. A state's id is its slot,
+     * so ids are stable and index the per-state parent, event and colour
+     * arrays.
+     */
+    class ConcurrentStateSet
+    {
+    public:
+        static constexpr uint32_t NoParent = UINT32_MAX;
+        // Largest capacity whose table, at most half full, keeps every
+        // slot index below NoParent
+        static constexpr size_t MaxCapacity = size_t(1) << 30;
+
+        // Colour bits for nested depth-first search
+        static constexpr uint8_t Blue = 1;
+        static constexpr uint8_t Red = 2;
+
+        struct Insertion
+        {
+            uint32_t id;
+            bool inserted;
+        };
+
+        /**
+         * Room for capacity states; throws StateSetFull beyond that, and
+         * std::invalid_argument for a capacity above MaxCapacity
+         */
+        ConcurrentStateSet(size_t keyWords, size_t capacity);
+
+        /**
+         * Table bytes needed per state of capacity
+         */
+        static size_t bytesPerState(size_t keyWords);
+
+        /**
+         * Find or add key; the parent and the event leading from it are
+         * recorded only by the insertion
+         */
+        Insertion insert(const uint64_t *key, uint32_t parent, int32_t event);
+
+        const uint64_t *key(uint32_t id) const { return keys.get() + static_cast<size_t>(id) * keyWords; }
+        uint32_t parent(uint32_t id) const { return parents[id]; }
+        int32_t event(uint32_t id) const { return events[id]; }
+
+        bool hasColor(uint32_t id, uint8_t color) const
+        {
+            return (colors[id].load(std::memory_order_acquire) & color) != 0;
+        }
+        void setColor(uint32_t id, uint8_t color) { colors[id].fetch_or(color, std::memory_order_acq_rel); }
+
+        size_t size() const { return count.load(std::memory_order_relaxed); }
+        size_t capacity() const { return maxStates; }
+        size_t bytes() const { return slotCount * bytesPerState(keyWords) / 2; }
+
+    private:
+        static constexpr uint64_t Empty = 0;
+        static constexpr uint64_t Busy = 1;
+
+        size_t keyWords;
+        size_t maxStates;
+        size_t slotCount;
+        // Zeroed lazily by the OS: a large table costs nothing until used
+        std::unique_ptr<std::atomic<uint64_t>[], void (*)(void *)> tags{nullptr, std::free};
+        std::unique_ptr<uint64_t[]> keys;
+        std::unique_ptr<uint32_t[]> parents;
+        std::unique_ptr<int32_t[]> events;
+        std::unique_ptr<std::atomic<uint8_t>[], void (*)(void *)> colors{nullptr, std::free};
+        std::atomic<size_t> count{0};
+    };
+
+} // namespace ReactiveSystem
+
+#endif // CONCURRENT_STATE_SET_H
@@ -0,0 +1,71 @@
+#ifndef DISTRIBUTED_EXPLORER_H
+#define DISTRIBUTED_EXPLORER_H
+
+#include "AnalysisBudget.h"
+#include "Statechart.h"
+#include <cstdint>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    struct DistributedOptions
+    {
+        static constexpr unsigned MaxWorkers = 64;
+        static constexpr size_t MaxRingBytes = size_t(1) << 26;
+        static constexpr size_t MaxBatchSize = size_t(1) << 16;
+
+        // 1 to MaxWorkers
+        unsigned workers = 4;
+        // Each of the workers * workers (sender, receiver) rings; at most
+        // MaxRingBytes
+        size_t ringBytes = 1 << 20;
+        // Configurations buffered per destination before a batch is sent;
+        // at most MaxBatchSize
+        size_t batchSize = 256;
+        // Over all workers; at most ConcurrentStateSet::MaxCapacity
+        size_t maxConfigurations = 1 << 24;
+        // The memory budget is shared out equally between the workers
+        AnalysisBudget budget;
+    };
+
+    struct DistributedReport : StatechartReport
+    {
+        unsigned workers = 0;
+        // Configurations owned by each worker
+        std::vector<uint64_t> partitionSizes;
+        // Configurations sent to another worker
+        uint64_t messages = 0;
+    };
+
+    /**
+     * Shared-nothing exploration across local processes. The configuration
+     * space is partitioned by a hash of the configuration key: each worker
+     * process owns one partition, keeps its own visited table and queue in
+     * its own heap, and sends every successor it does not own to the owner
+     * in batches. Batches go through single-producer single-consumer rings,
+     * one per (sender, receiver) pair, in an anonymous shared mapping made
+     * before the fork; the transport is confined to that ring interface so
+     * that a socket transport could stand in for it across hosts.
+     *
+     * The calling process coordinates: it detects termination with
+     * Mattern's four-counter method (two consecutive waves over the
+     * workers' idle flags and sent/received counters must all agree),
+     * enforces the budget, polls cancellation, publishes progress, and
+     * merges the workers' results. Counts, deadlocks and unreachable states
+     * match StatechartExplorer::explore; deadlockPath is not reconstructed,
+     * since parent links would cross partitions.
+     *
+     * Workers are forked from the calling thread and run only engine code
+     * before _exit, so the model is shared copy-on-write. POSIX only.
+     */
+    class DistributedExplorer
+    {
+    public:
+        static DistributedReport explore(const Statechart &chart,
+                                         const DistributedOptions &options = DistributedOptions());
+    };
+
+} // namespace ReactiveSystem
+
+#endif // DISTRIBUTED_EXPLORER_H
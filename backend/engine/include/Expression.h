@@ -0,0 +1,173 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "MealyMachine.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Variables referenced by guards and actions, mapped to dense slots.
+     * All values are 64-bit integers; booleans are 0/1.
+     */
+    class VariableTable
+    {
+    public:
+        /**
+         * Declare the input, output and state variables of a machine
+         */
+        static VariableTable fromMachine(const StateMachine &machine);
+
+        /**
+         * Slot of a variable, declaring it (initial value 0) when unknown
+         */
+        int32_t resolve(const std::string &name);
+
+        int32_t find(const std::string &name) const;
+        int32_t declare(const std::string &name, int64_t initialValue);
+
+        size_t size() const { return names.size(); }
+        const std::string &name(size_t slot) const { return names[slot]; }
+        const std::vector<int64_t> &initialValues() const { return initial; }
+
+    private:
+        std::vector<std::string> names;
+        std::vector<int64_t> initial;
+        std::unordered_map<std::string, int32_t> index;
+    };
+
+    /**
+     * Parsed guard/action expression
+     */
+    struct ExprNode
+    {
+        enum class Kind
+        {
+            Literal,
+            Variable,
+            Unary,
+            Binary
+        };
+
+        Kind kind = Kind::Literal;
+        std::string op;
+        int64_t value = 0;
+        int32_t variable = -1;
+        std::unique_ptr<ExprNode> lhs;
+        std::unique_ptr<ExprNode> rhs;
+    };
+
+    /**
+     * One statement of an action: variable = value
+     */
+    struct Assignment
+    {
+        int32_t variable;
+        std::unique_ptr<ExprNode> value;
+    };
+
+    enum class OpCode : uint8_t
+    {
+        PushConst,
+        Load,
+        Store,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Mod,
+        Neg,
+        Not,
+        Eq,
+        Ne,
+        Lt,
+        Le,
+        Gt,
+        Ge,
+        ToBool,
+        Jump,
+        JumpIfZero,
+        JumpIfNonZero
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        int64_t operand;
+    };
+
+    /**
+     * Stack bytecode for a guard (leaves one value) or an action (leaves none)
+     */
+    struct Bytecode
+    {
+        static constexpr uint32_t MaxStack = 64;
+
+        std::vector<Instruction> code;
+        uint32_t maxStack = 0;
+
+        bool empty() const { return code.empty(); }
+    };
+
+    /**
+     * Parser, bytecode compiler and interpreter for the guard/action language:
+     *
+     *   guard:  x < 10 && (mode == 2 || !flag)     ('=' and '&'/'|' are accepted as
+     *                                               '==' and '&&'/'||')
+     *   action: x = x + 1; y += 2; z++
+     *
+     * Arithmetic wraps on overflow and division or modulo by zero yields 0, so
+     * evaluation never faults; generated code reproduces the same rules.
+     */
+    class Expression
+    {
+    public:
+        /**
+         * Parse a guard; an empty string yields nullptr (always true).
+         * Throws std::invalid_argument on syntax errors.
+         */
+        static std::unique_ptr<ExprNode> parseGuard(
+            const std::string &text,
+            VariableTable &variables);
+
+        /**
+         * Parse an action into assignments, in execution order
+         */
+        static std::vector<Assignment> parseAction(
+            const std::string &text,
+            VariableTable &variables);
+
+        static Bytecode compileGuard(const ExprNode *guard);
+        static Bytecode compileAction(const std::vector<Assignment> &action);
+
+        /**
+         * Run bytecode against variable storage; returns the guard value
+         * (non-zero = true), or 0 for actions
+         */
+        static int64_t execute(const Bytecode &bytecode, int64_t *variables);
+
+        /**
+         * Render an expression as C++ using the given variable accessor prefix
+         * (e.g. "vars_.") and the wrap-safe helpers of generated code
+         */
+        static std::string toCpp(
+            const ExprNode *node,
+            const std::vector<std::string> &variableNames,
+            const std::string &prefix);
+
+        /**
+         * Parse a variable's initial value ("true", "false" or an integer)
+         */
+        static int64_t parseLiteral(const std::string &text);
+
+        static int64_t applyBinary(OpCode op, int64_t lhs, int64_t rhs);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // EXPRESSION_H
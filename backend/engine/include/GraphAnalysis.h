@@ -0,0 +1,79 @@
+#ifndef GRAPH_ANALYSIS_H
+#define GRAPH_ANALYSIS_H
+
+#include "Cancellation.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Structural analyses over any CSR graph exposing stateCount(), initial(),
+     * edgeBegin(s), edgeEnd(s), target(e) and isFinal(s): CompiledMachine in
+     * memory or a MappedModel used in place.
+     */
+    namespace GraphAnalysis
+    {
+
+        /**
+         * reachable[s] != 0 when s is reachable from the initial state
+         */
+        template <class Graph>
+        std::vector<uint8_t> reachableStates(const Graph &graph)
+        {
+            std::vector<uint8_t> reachable(graph.stateCount(), 0);
+            if (graph.initial() < 0)
+            {
+                return reachable;
+            }
+
+            std::vector<uint32_t> queue;
+            queue.reserve(graph.stateCount());
+            queue.push_back(static_cast<uint32_t>(graph.initial()));
+            reachable[graph.initial()] = 1;
+
+            CancellationPoint cancellation;
+            for (size_t head = 0; head < queue.size(); head++)
+            {
+                cancellation.check();
+                uint32_t state = queue[head];
+                for (uint32_t e = graph.edgeBegin(state); e < graph.edgeEnd(state); e++)
+                {
+                    uint32_t next = graph.target(e);
+                    if (!reachable[next])
+                    {
+                        reachable[next] = 1;
+                        queue.push_back(next);
+                    }
+                }
+            }
+            return reachable;
+        }
+
+        /**
+         * Non-final states without outgoing edges. Matches
+         * Verifier::findDeadlocks on flat machines except for transitions
+         * to states that do not exist: building the graph drops them, so
+         * their source counts as a deadlock here but not there.
+         */
+        template <class Graph>
+        std::vector<uint32_t> deadlockStates(const Graph &graph)
+        {
+            std::vector<uint32_t> deadlocks;
+            for (uint32_t s = 0; s < graph.stateCount(); s++)
+            {
+                if (graph.edgeBegin(s) == graph.edgeEnd(s) && !graph.isFinal(s))
+                {
+                    deadlocks.push_back(s);
+                }
+            }
+            return deadlocks;
+        }
+
+    } // namespace GraphAnalysis
+
+} // namespace ReactiveSystem
+
+#endif // GRAPH_ANALYSIS_H
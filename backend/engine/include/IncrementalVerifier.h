@@ -0,0 +1,185 @@
+#ifndef INCREMENTAL_VERIFIER_H
+#define INCREMENTAL_VERIFIER_H
+
+#include "MealyMachine.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Snapshot of the incrementally maintained analyses. Counts are exact;
+     * the id lists are truncated to the requested limit.
+     */
+    struct IncrementalReport
+    {
+        uint64_t revision = 0;
+        uint32_t totalStates = 0;
+        uint32_t reachableStates = 0;
+        uint32_t transitions = 0;
+        uint32_t initialStates = 0;
+        bool finalReachable = false;
+
+        uint32_t deadlockCount = 0;
+        std::vector<std::string> deadlocks;
+        std::vector<std::string> unreachableStates;
+
+        // Completeness over the inputs used anywhere in the machine
+        uint32_t inputAlphabet = 0;
+        uint32_t incompleteCount = 0;
+        std::vector<std::string> incompleteStates;
+
+        uint32_t components = 0;
+        uint32_t cyclicComponents = 0;
+        // Reachable cycles with no way out and no final state
+        uint32_t trapComponents = 0;
+        std::vector<std::vector<std::string>> traps;
+
+        // Nodes and edges touched by the last edit
+        uint64_t lastEditWork = 0;
+    };
+
+    /**
+     * Verification state kept alive across editor edits (flat machines).
+     *
+     * Each edit updates the analyses instead of rebuilding them:
+     *   - reachability keeps a spanning tree from the initial state; an
+     *     insertion searches only from the newly reached state, a deletion
+     *     re-attaches only the subtree hanging off the removed edge
+     *   - SCCs are kept in topological order (Pearce-Kelly); an insertion
+     *     searches only between the two components' positions and merges a
+     *     closed cycle, a deletion inside a component re-runs Tarjan on that
+     *     component alone
+     *   - deadlocks and completeness are per-state counters
+     *
+     * State slots are never reused, so ids of removed states can come back.
+     * Throws std::invalid_argument for unknown ids, duplicate ids and
+     * hierarchical states.
+     */
+    class IncrementalVerifier
+    {
+    public:
+        /**
+         * Initial build; like CompiledMachine::compile, duplicate ids keep
+         * the first occurrence and dangling transitions are skipped
+         */
+        explicit IncrementalVerifier(const StateMachine &machine);
+
+        void addState(const State &state);
+        void removeState(const std::string &stateId);
+        void updateState(const State &state);
+
+        void addTransition(const Transition &transition);
+        void removeTransition(const std::string &transitionId);
+        void updateTransition(const Transition &transition);
+
+        IncrementalReport report(size_t listLimit = 1000) const;
+
+        uint64_t revision() const { return edits; }
+
+    private:
+        static constexpr uint32_t None = UINT32_MAX;
+
+        struct Node
+        {
+            std::string id;
+            std::string name;
+            bool alive = true;
+            bool isInitial = false;
+            bool isFinal = false;
+            uint32_t selfLoops = 0;
+            std::vector<uint32_t> out;
+            std::vector<uint32_t> in;
+            // (input, live transitions reading it), sorted by input
+            std::vector<std::pair<int32_t, uint32_t>> inputs;
+        };
+
+        struct Edge
+        {
+            std::string id;
+            uint32_t from;
+            uint32_t to;
+            int32_t input;
+            bool alive = true;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        std::unordered_map<std::string, uint32_t> nodeIndex;
+        std::unordered_map<std::string, uint32_t> edgeIndex;
+        uint32_t liveStates = 0;
+        uint32_t liveEdges = 0;
+        uint64_t edits = 0;
+        uint64_t work = 0;
+
+        // Completeness
+        std::unordered_map<std::string, int32_t> inputIndex;
+        std::vector<uint32_t> inputEdges;
+        uint32_t alphabet = 0;
+        // Live non-final states by number of distinct inputs
+        std::vector<uint32_t> distinctHistogram;
+        uint32_t deadlockCount = 0;
+
+        // Reachability: spanning tree rooted at the first initial state
+        std::set<uint32_t> initialNodes;
+        uint32_t root = None;
+        std::vector<uint8_t> reachable;
+        std::vector<uint32_t> parentEdge;
+        uint32_t reachableCount = 0;
+
+        // SCCs: order[position[c]] == c, edges only go forward in order
+        std::vector<uint32_t> component;
+        std::vector<std::vector<uint32_t>> members;
+        std::vector<uint32_t> exits;
+        std::vector<uint32_t> finals;
+        std::vector<uint32_t> loops;
+        std::vector<uint32_t> position;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> freeComponents;
+
+        // Search marks, cleared by bumping the stamp
+        std::vector<uint32_t> forwardMark;
+        std::vector<uint32_t> backwardMark;
+        uint32_t stamp = 0;
+
+        // Tarjan scratch, sized to the nodes
+        std::vector<uint32_t> visitStamp;
+        std::vector<uint32_t> visitIndex;
+        std::vector<uint32_t> lowLink;
+        std::vector<uint8_t> onStack;
+        uint32_t visit = 0;
+        uint32_t liveNonFinal = 0;
+
+        uint32_t node(const std::string &stateId) const;
+        uint32_t appendNode(const State &state);
+        uint32_t appendEdge(const Transition &transition);
+        void unlinkEdge(uint32_t edge);
+        void dropEdge(uint32_t edge);
+
+        void countState(uint32_t n, int delta);
+        void countInput(uint32_t n, int32_t input, int delta);
+        void setAlphabet(int32_t input, int delta);
+
+        void rebuildReachability();
+        void reach(uint32_t from, uint32_t edge);
+        void repairReachability(uint32_t target);
+        void updateRoot();
+
+        void rebuildComponents();
+        void tarjan(const std::vector<uint32_t> &scope, uint32_t within, std::vector<std::vector<uint32_t>> &out);
+        uint32_t newComponent();
+        void recount(uint32_t c);
+        void insertComponentEdge(uint32_t from, uint32_t to);
+        uint32_t merge(const std::vector<uint32_t> &components);
+        bool connected(uint32_t from, uint32_t to);
+        void split(uint32_t c);
+        void renumber(size_t from);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // INCREMENTAL_VERIFIER_H
@@ -0,0 +1,122 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include "Cancellation.h"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Scheduling classes, most urgent first
+     */
+    enum class JobPriority
+    {
+        Interactive = 0,
+        Normal = 1,
+        Bulk = 2
+    };
+
+    struct JobOptions
+    {
+        JobPriority priority = JobPriority::Normal;
+        CancellationToken::Clock::time_point deadline = CancellationToken::Clock::time_point::max();
+    };
+
+    /**
+     * Fixed pool of workers running jobs by class, then earliest deadline,
+     * then submission order. Jobs are not preempted; instead normal and bulk
+     * jobs together may occupy at most all workers but one, so an
+     * interactive job never waits behind a long batch (with a single
+     * worker, it waits for the running job).
+     *
+     * Each job runs with its token current on the worker thread, so the
+     * CancellationPoints in the analyses stop it once it is cancelled or
+     * past its deadline. Queued jobs that are cancelled or expire complete
+     * without running.
+     */
+    class JobScheduler
+    {
+    public:
+        using Work = std::function<void()>;
+        /**
+         * Called on a worker thread with nullptr on success, otherwise with
+         * the job's exception (JobCancelled when cancelled or expired)
+         */
+        using Done = std::function<void(std::exception_ptr error)>;
+
+        struct Stats
+        {
+            unsigned workers = 0;
+            size_t queued[3] = {0, 0, 0};
+            size_t running[3] = {0, 0, 0};
+            uint64_t completed = 0;
+            uint64_t failed = 0;
+            uint64_t cancelled = 0;
+        };
+
+        /**
+         * workers == 0 uses the hardware concurrency
+         */
+        explicit JobScheduler(unsigned workers = 0);
+        ~JobScheduler();
+
+        JobScheduler(const JobScheduler &) = delete;
+        JobScheduler &operator=(const JobScheduler &) = delete;
+
+        std::shared_ptr<CancellationToken> submit(Work work, Done done, const JobOptions &options = JobOptions());
+
+        /**
+         * Cancel a job; a queued job completes on the next idle worker, a
+         * running one at its next cancellation point
+         */
+        void cancel(const std::shared_ptr<CancellationToken> &token);
+
+        Stats stats() const;
+
+        /**
+         * "interactive", "normal" or "bulk"; throws std::invalid_argument
+         */
+        static JobPriority parsePriority(const std::string &name);
+
+    private:
+        using Clock = CancellationToken::Clock;
+        using QueueKey = std::pair<Clock::time_point, uint64_t>;
+
+        struct Job
+        {
+            std::shared_ptr<CancellationToken> token;
+            Work work;
+            Done done;
+        };
+
+        mutable std::mutex mutex;
+        std::condition_variable ready;
+        std::vector<std::thread> threads;
+        std::map<QueueKey, Job> queues[3];
+        size_t running[3] = {0, 0, 0};
+        size_t backgroundLimit;
+        uint64_t sequence = 0;
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+        uint64_t cancelledCount = 0;
+        bool stopping = false;
+
+        void workerLoop();
+        std::vector<Job> takeCancelled();
+        bool takeNext(Job &job, JobPriority &priority);
+    };
+
+} // namespace ReactiveSystem
+
+#endif // JOB_SCHEDULER_H
@@ -0,0 +1,91 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "MealyMachine.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Minimal JSON document for the command-line tools, which read and write
+     * the same machine JSON the server receives
+     */
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        JsonValue() = default;
+
+        /**
+         * Throws std::invalid_argument with the byte offset of the error
+         */
+        static JsonValue parse(const std::string &text);
+
+        static JsonValue boolean(bool value);
+        static JsonValue number(double value);
+        static JsonValue string(const std::string &value);
+        static JsonValue array();
+        static JsonValue object();
+
+        Type type() const { return kind; }
+        bool isNull() const { return kind == Type::Null; }
+        bool isString() const { return kind == Type::String; }
+        bool isNumber() const { return kind == Type::Number; }
+        bool isArray() const { return kind == Type::Array; }
+        bool isObject() const { return kind == Type::Object; }
+
+        bool asBool() const { return kind == Type::Boolean && flag; }
+        double asNumber() const { return numberValue; }
+        const std::string &asString() const { return text; }
+        const std::vector<JsonValue> &items() const { return elements; }
+        const std::vector<std::pair<std::string, JsonValue>> &members() const { return fields; }
+
+        /**
+         * Member of an object, or nullptr when absent
+         */
+        const JsonValue *get(const std::string &key) const;
+
+        /**
+         * String member, or fallback when absent; numbers and booleans are
+         * rendered as text
+         */
+        std::string getString(const std::string &key, const std::string &fallback = std::string()) const;
+
+        JsonValue &push(JsonValue value);
+        JsonValue &set(const std::string &key, JsonValue value);
+
+        std::string dump() const;
+
+    private:
+        Type kind = Type::Null;
+        bool flag = false;
+        double numberValue = 0;
+        std::string text;
+        std::vector<JsonValue> elements;
+        std::vector<std::pair<std::string, JsonValue>> fields;
+
+        void dump(std::string &out) const;
+    };
+
+    /**
+     * Read a machine in the frontend StateMachine JSON shape
+     */
+    StateMachine stateMachineFromJson(const JsonValue &json);
+
+    JsonValue stateMachineToJson(const StateMachine &machine);
+
+} // namespace ReactiveSystem
+
+#endif // JSON_H
@@ -0,0 +1,132 @@
+#ifndef KISS2_H
+#define KISS2_H
+
+#include "CompiledMachine.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Input cube over up to 64 input bits: a minterm m matches when
+     * (m & care) == value. Bit i is the i-th character of the cube text.
+     */
+    struct KissCube
+    {
+        uint64_t care;
+        uint64_t value;
+    };
+
+    /**
+     * A KISS2 machine compiled straight into the CSR graph. Input symbols are
+     * the cube texts as written ("1-0"), so structural analyses work without
+     * expanding don't-cares; cubes[i] is the decoded form of input symbol i.
+     * edgeTransitions holds the product-term index of every edge.
+     */
+    struct KissMachine
+    {
+        uint32_t inputBits = 0;
+        uint32_t outputBits = 0;
+        uint64_t productTerms = 0;
+        CompiledMachine graph;
+        std::vector<KissCube> cubes;
+
+        /**
+         * First edge (in file order) of state whose cube covers minterm, or -1
+         */
+        int32_t match(uint32_t state, uint64_t minterm) const;
+
+        /**
+         * Number of concrete input vectors covered by an input symbol
+         */
+        uint64_t mintermCount(int32_t input) const;
+
+        /**
+         * Enumerate the minterms of an input symbol on demand; fn returns
+         * false to stop early
+         */
+        template <class Fn>
+        void forEachMinterm(int32_t input, Fn &&fn) const
+        {
+            const KissCube &cube = cubes[input];
+            const uint64_t all = inputBits == 64 ? ~uint64_t(0) : ((uint64_t(1) << inputBits) - 1);
+            const uint64_t free = all & ~cube.care;
+
+            // Walk the subsets of the don't-care bits
+            uint64_t subset = 0;
+            do
+            {
+                if (!fn(cube.value | subset))
+                    return;
+                subset = (subset - free) & free;
+            } while (subset != 0);
+        }
+
+        /**
+         * Object form with one transition per product term ("t<term>"),
+         * cube texts as input/output labels
+         */
+        StateMachine toStateMachine(const std::string &name) const;
+    };
+
+    /**
+     * Streaming KISS2 (MCNC/LGSynth) parser. Text is fed in arbitrary chunks;
+     * only the current partial line is buffered, and each product term is
+     * appended to compact edge arrays that finish() buckets into CSR.
+     *
+     *   .i 2          input bits        .s 4    state count (advisory)
+     *   .o 1          output bits       .r s0   reset state
+     *   .p 10         product terms     .e      end
+     *   -1 s0 s1 0    input cube, current state, next state, output cube
+     *
+     * A current state of "*" stands for every state. Throws
+     * std::invalid_argument naming the offending line.
+     */
+    class KissParser
+    {
+    public:
+        void feed(const char *data, size_t size);
+        KissMachine finish();
+
+        uint64_t bytesRead() const { return bytes; }
+
+    private:
+        static constexpr uint32_t AnyState = UINT32_MAX;
+
+        uint64_t bytes = 0;
+        uint64_t line = 0;
+        std::string partial;
+        bool ended = false;
+
+        uint32_t inputBits = 0;
+        uint32_t outputBits = 0;
+        bool sawTerm = false;
+        std::string resetState;
+        std::string lastFromName;
+        uint32_t lastFrom = 0;
+
+        std::vector<std::string> stateNames;
+        std::unordered_map<std::string, uint32_t> stateIndex;
+        std::vector<std::string> inputSymbols;
+        std::unordered_map<std::string, uint32_t> inputIndex;
+        std::vector<std::string> outputSymbols;
+        std::unordered_map<std::string, uint32_t> outputIndex;
+
+        // One entry per product term, in file order
+        std::vector<uint32_t> termFrom;
+        std::vector<uint32_t> termTo;
+        std::vector<int32_t> termInput;
+        std::vector<int32_t> termOutput;
+
+        void parseLine(const char *begin, const char *end);
+        uint32_t state(const std::string &name);
+        uint64_t number(const std::string &token) const;
+        [[noreturn]] void fail(const std::string &message) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // KISS2_H
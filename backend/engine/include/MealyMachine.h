@@ -0,0 +1,71 @@
+#ifndef MEALY_MACHINE_H
+#define MEALY_MACHINE_H
+
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * State of a machine (mirrors the frontend State type, without layout data)
+     * parent is the id of the enclosing state (empty at top level); kind is
+     * empty for ordinary states, or "parallel", "history" or "deepHistory".
+     * Inside a composite state, isInitial marks its default child.
+     */
+    struct State
+    {
+        std::string id;
+        std::string name;
+        bool isInitial = false;
+        bool isFinal = false;
+        std::string parent;
+        std::string kind;
+    };
+
+    /**
+     * Transition between two states
+     * Optional label parts are empty when not set
+     */
+    struct Transition
+    {
+        std::string id;
+        std::string from;
+        std::string to;
+        std::string input;
+        std::string output;
+        std::string guard;
+        std::string action;
+    };
+
+    /**
+     * Input, output or state variable declaration
+     */
+    struct Variable
+    {
+        std::string name;
+        std::string type;
+        std::string initialValue;
+        bool hasRange = false;
+        long long min = 0;
+        long long max = 0;
+    };
+
+    /**
+     * Complete Mealy/Moore machine as received from the frontend
+     */
+    struct StateMachine
+    {
+        std::string id;
+        std::string name;
+        std::string type;
+        std::vector<State> states;
+        std::vector<Transition> transitions;
+        std::vector<Variable> inputVariables;
+        std::vector<Variable> outputVariables;
+        std::vector<Variable> stateVariables;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // MEALY_MACHINE_H
@@ -0,0 +1,226 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    namespace MetricsDetail
+    {
+        constexpr size_t Shards = 8;
+
+        /**
+         * This thread's shard: threads are dealt round robin, so a few
+         * threads each update their own cache lines
+         */
+        size_t threadShard();
+    }
+
+    /**
+     * Monotonic counter; add() is one relaxed atomic add on the calling
+     * thread's shard
+     */
+    class Counter
+    {
+    public:
+        void add(uint64_t amount = 1)
+        {
+            shards[MetricsDetail::threadShard()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        uint64_t value() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> value{0};
+        };
+        std::array<Shard, MetricsDetail::Shards> shards;
+    };
+
+    /**
+     * High-dynamic-range histogram of non-negative integers: exact below
+     * SubBuckets, then SubBuckets log-linear buckets per power of two, so
+     * every recorded value is known to within 1/SubBuckets (1.6%) up to
+     * 2^MaxBits; larger values fall in the last bucket. record() is a few
+     * relaxed atomic operations on the calling thread's shard, without
+     * locks; a shard is allocated by its first record.
+     */
+    class HdrHistogram
+    {
+    public:
+        static constexpr unsigned SubBits = 6;
+        static constexpr uint64_t SubBuckets = uint64_t(1) << SubBits;
+        static constexpr unsigned MaxBits = 48;
+        static constexpr size_t BucketCount = SubBuckets + (MaxBits - SubBits) * SubBuckets;
+
+        struct Snapshot
+        {
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t max = 0;
+            std::vector<uint64_t> buckets;
+
+            /**
+             * Highest value equivalent to the q-quantile (0 <= q <= 1), at
+             * most max; 0 when empty
+             */
+            uint64_t quantile(double q) const;
+        };
+
+        HdrHistogram() = default;
+        ~HdrHistogram();
+
+        HdrHistogram(const HdrHistogram &) = delete;
+        HdrHistogram &operator=(const HdrHistogram &) = delete;
+
+        void record(uint64_t value)
+        {
+            size_t index = MetricsDetail::threadShard();
+            Shard *current = shards[index].load(std::memory_order_acquire);
+            Shard &shard = current ? *current : allocate(index);
+            shard.buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(value, std::memory_order_relaxed);
+            uint64_t max = shard.max.load(std::memory_order_relaxed);
+            while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        /**
+         * Merge of the shards; concurrent records may be partly included
+         */
+        Snapshot snapshot() const;
+
+        static size_t bucketOf(uint64_t value)
+        {
+            if (value < SubBuckets)
+                return static_cast<size_t>(value);
+            unsigned exponent = highestBit(value);
+            if (exponent >= MaxBits)
+                return BucketCount - 1;
+            return SubBuckets + (exponent - SubBits) * SubBuckets + ((value >> (exponent - SubBits)) & (SubBuckets - 1));
+        }
+
+        /**
+         * Largest value counted in a bucket
+         */
+        static uint64_t highestEquivalent(size_t bucket);
+
+    private:
+        struct Shard
+        {
+            // The count is the sum of the buckets
+            alignas(64) std::atomic<uint64_t> sum{0};
+            std::atomic<uint64_t> max{0};
+            std::atomic<uint64_t> buckets[BucketCount];
+
+            Shard()
+            {
+                for (auto &bucket : buckets)
+                    bucket.store(0, std::memory_order_relaxed);
+            }
+        };
+
+        static unsigned highestBit(uint64_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+            unsigned bit = 0;
+            while (value >>= 1)
+                bit++;
+            return bit;
+#endif
+        }
+
+        Shard &allocate(size_t index);
+
+        std::array<std::atomic<Shard *>, MetricsDetail::Shards> shards{};
+    };
+
+    /**
+     * Records the nanoseconds from construction to destruction
+     */
+    class ScopedLatency
+    {
+    public:
+        explicit ScopedLatency(HdrHistogram &histogram)
+            : histogram(histogram), started(std::chrono::steady_clock::now()) {}
+        ~ScopedLatency()
+        {
+            histogram.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count()));
+        }
+
+        ScopedLatency(const ScopedLatency &) = delete;
+        ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+    private:
+        HdrHistogram &histogram;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    /**
+     * Process-wide named metrics, exported in the Prometheus text format.
+     * Registering takes a lock and is meant for startup; the returned
+     * metric lives as long as the process, so hot paths keep a reference
+     * and never look it up again. Registering a name and label set twice
+     * returns the same metric.
+     */
+    class MetricsRegistry
+    {
+    public:
+        static MetricsRegistry &global();
+
+        /**
+         * labels in Prometheus syntax without braces, e.g. call="verify"
+         */
+        Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+
+        /**
+         * Exported as a summary (quantiles, _sum, _count) plus a _max
+         * gauge, each value multiplied by scale (1e-9 for nanoseconds
+         * exported in seconds)
+         */
+        HdrHistogram &histogram(const std::string &name, const std::string &help, const std::string &labels = "",
+                                double scale = 1);
+
+        std::string prometheusText() const;
+
+        /**
+         * Helpers for exporters adding their own families
+         */
+        static void writeHeader(std::string &out, const std::string &name, const char *type, const std::string &help);
+        static void writeSample(std::string &out, const std::string &name, const std::string &labels, double value);
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            std::string help;
+            std::string labels;
+            double scale = 1;
+            std::unique_ptr<Counter> counter;
+            std::unique_ptr<HdrHistogram> histogram;
+        };
+
+        Entry *find(const std::string &name, const std::string &labels, bool counter);
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // METRICS_H
@@ -0,0 +1,190 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include "CompiledMachine.h"
+#include "MealyMachine.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Versioned binary model format (.rsm). All sections are 8-byte aligned
+     * little-endian arrays, so a mapped file is used in place:
+     *
+     *   header        ModelHeader
+     *   strings       u64 offsets[stringCount + 1], then the UTF-8 bytes
+     *   states        ModelState[stateCount]
+     *   edgeOffsets   u32[stateCount + 1] (CSR, as in CompiledMachine)
+     *   edgeTargets   u32[edgeCount]
+     *   edgeInputs    i32[edgeCount], index into inputs or -1
+     *   edgeOutputs   i32[edgeCount], index into outputs or -1
+     *   edgeLabels    ModelEdgeLabel[edgeCount]
+     *   inputs        u32[inputCount] string ids
+     *   outputs       u32[outputCount] string ids
+     *   variables     ModelVariable[variableCount]
+     *
+     * String id 0 is always the empty string.
+     */
+    struct ModelHeader
+    {
+        static constexpr char Magic[8] = {'R', 'S', 'M', 'O', 'D', 'E', 'L', '\0'};
+        static constexpr uint32_t CurrentVersion = 1;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t fileSize;
+
+        uint32_t machineId;
+        uint32_t machineName;
+        uint32_t machineType;
+        int32_t initialState;
+
+        uint32_t stringCount;
+        uint32_t stateCount;
+        uint32_t edgeCount;
+        uint32_t inputCount;
+        uint32_t outputCount;
+        uint32_t variableCount;
+
+        uint64_t stringsOffset;
+        uint64_t statesOffset;
+        uint64_t edgeOffsetsOffset;
+        uint64_t edgeTargetsOffset;
+        uint64_t edgeInputsOffset;
+        uint64_t edgeOutputsOffset;
+        uint64_t edgeLabelsOffset;
+        uint64_t inputsOffset;
+        uint64_t outputsOffset;
+        uint64_t variablesOffset;
+    };
+
+    /**
+     * parent is a string id (0 at top level). Initial is set on every state
+     * flagged isInitial, including the default child of a composite state;
+     * ModelHeader::initialState is the one the flat engines start in.
+     */
+    struct ModelState
+    {
+        static constexpr uint32_t Initial = 1;
+        static constexpr uint32_t Final = 2;
+        static constexpr uint32_t Parallel = 4;
+        static constexpr uint32_t History = 8;
+        static constexpr uint32_t DeepHistory = 16;
+
+        uint32_t id;
+        uint32_t name;
+        uint32_t flags;
+        uint32_t parent;
+    };
+
+    struct ModelEdgeLabel
+    {
+        uint32_t transitionId;
+        uint32_t guard;
+        uint32_t action;
+        uint32_t reserved;
+    };
+
+    struct ModelVariable
+    {
+        enum Role : uint32_t
+        {
+            Input,
+            Output,
+            StateVariable
+        };
+
+        uint32_t name;
+        uint32_t type;
+        uint32_t initialValue;
+        uint32_t role;
+        int64_t min;
+        int64_t max;
+        uint32_t hasRange;
+        uint32_t reserved;
+    };
+
+    /**
+     * A model file mapped read-only into memory. Accessors read the mapping
+     * directly; nothing is parsed or copied on open beyond validating the
+     * header and section bounds.
+     */
+    class MappedModel
+    {
+    public:
+        ~MappedModel();
+        MappedModel(const MappedModel &) = delete;
+        MappedModel &operator=(const MappedModel &) = delete;
+
+        /**
+         * Map a model file. Throws std::runtime_error when the file cannot be
+         * read and std::invalid_argument when it is not a valid model.
+         */
+        static std::unique_ptr<MappedModel> open(const std::string &path);
+
+        /**
+         * Write a machine in the binary format. Transitions whose endpoints
+         * do not exist are dropped, as in CompiledMachine.
+         */
+        static void save(const StateMachine &machine, const std::string &path);
+
+        const ModelHeader &header() const { return *head; }
+
+        std::string_view string(uint32_t id) const;
+
+        // Graph interface shared with CompiledMachine (see GraphAnalysis.h)
+        size_t stateCount() const { return head->stateCount; }
+        size_t edgeCount() const { return head->edgeCount; }
+        int32_t initial() const { return head->initialState; }
+        uint32_t edgeBegin(uint32_t state) const { return edgeOffsets[state]; }
+        uint32_t edgeEnd(uint32_t state) const { return edgeOffsets[state + 1]; }
+        uint32_t target(uint32_t edge) const { return edgeTargets[edge]; }
+        bool isFinal(uint32_t state) const { return (states[state].flags & ModelState::Final) != 0; }
+
+        std::string_view stateId(uint32_t state) const { return string(states[state].id); }
+        std::string_view stateName(uint32_t state) const { return string(states[state].name); }
+        int32_t edgeInput(uint32_t edge) const { return edgeInputs[edge]; }
+        int32_t edgeOutput(uint32_t edge) const { return edgeOutputs[edge]; }
+        std::string_view inputSymbol(uint32_t input) const { return string(inputs[input]); }
+        std::string_view outputSymbol(uint32_t output) const { return string(outputs[output]); }
+        const ModelEdgeLabel &edgeLabel(uint32_t edge) const { return edgeLabels[edge]; }
+
+        size_t variableCount() const { return head->variableCount; }
+        const ModelVariable &variable(size_t index) const { return variables[index]; }
+
+        size_t mappedBytes() const { return size; }
+
+        /**
+         * Materialize the machine for engines that need the object form
+         */
+        StateMachine toStateMachine() const;
+
+    private:
+        const uint8_t *base = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+
+        const ModelHeader *head = nullptr;
+        const uint64_t *stringOffsets = nullptr;
+        const ModelState *states = nullptr;
+        const uint32_t *edgeOffsets = nullptr;
+        const uint32_t *edgeTargets = nullptr;
+        const int32_t *edgeInputs = nullptr;
+        const int32_t *edgeOutputs = nullptr;
+        const ModelEdgeLabel *edgeLabels = nullptr;
+        const uint32_t *inputs = nullptr;
+        const uint32_t *outputs = nullptr;
+        const ModelVariable *variables = nullptr;
+
+        MappedModel() = default;
+        void validate();
+    };
+
+} // namespace ReactiveSystem
+
+#endif // MODEL_FILE_H
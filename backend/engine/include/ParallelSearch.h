@@ -0,0 +1,117 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include "AnalysisBudget.h"
+#include "Statechart.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    struct ParallelSearchOptions
+    {
+        static constexpr unsigned MaxThreads = 256;
+
+        // 0 = hardware concurrency; at most MaxThreads
+        unsigned threads = 0;
+        // Capacity of the shared visited set, reduced to fit the memory
+        // budget; the table is allocated up front
+        size_t maxStates = 1 << 22;
+        // Seeds the successor order of each cycle-detection worker
+        uint64_t seed = 1;
+        AnalysisBudget budget;
+    };
+
+    /**
+     * Counters common to both searches
+     */
+    struct ParallelSearchStatistics
+    {
+        unsigned threads = 0;
+        // Configurations stored in the visited set
+        uint64_t states = 0;
+        uint64_t transitions = 0;
+        // Configurations taken from another worker's deque
+        uint64_t steals = 0;
+        uint64_t divergentMacrosteps = 0;
+        double elapsedMs = 0;
+        bool complete = true;
+        StopReason stopReason = StopReason::None;
+    };
+
+    struct ParallelDeadlockReport : ParallelSearchStatistics
+    {
+        static constexpr size_t MaxReportedDeadlocks = 32;
+
+        uint64_t deadlockCount = 0;
+        // Active atomic states of each reported deadlocked configuration,
+        // shortest counterexamples first
+        std::vector<std::vector<std::string>> deadlocks;
+        // External events leading to each reported deadlock
+        std::vector<std::vector<std::string>> deadlockPaths;
+    };
+
+    /**
+     * Which infinite runs count as violations
+     */
+    enum class CycleProperty
+    {
+        // Some marked state stays active infinitely often (Buchi acceptance)
+        Acceptance,
+        // No marked (progress) state is ever active again
+        NonProgress
+    };
+
+    struct CycleReport : ParallelSearchStatistics
+    {
+        bool cycleFound = false;
+        // Events from the initial configuration to the cycle, then around it
+        std::vector<std::string> stem;
+        std::vector<std::string> cycle;
+        // Active atomic states where the cycle starts
+        std::vector<std::string> cycleEntry;
+    };
+
+    /**
+     * Multi-threaded exhaustive searches over the stable configurations of
+     * a statechart, sharing one lock-free visited set (ConcurrentStateSet).
+     *
+     * findDeadlocks is a work-stealing depth-first search: each worker keeps
+     * its pending configurations on a Chase-Lev deque, expands the newest
+     * itself and steals the oldest of another worker when it runs dry, so
+     * idle workers pick up large unexplored subtrees. Deadlocks are found
+     * exactly as StatechartExplorer::explore finds them.
+     *
+     * findCycle is CNDFS (Evangelista et al., "Improved Multi-Core Nested
+     * Depth-First Search"): every worker runs a nested DFS from the initial
+     * configurations in its own random successor order, sharing blue and red
+     * colours so that workers prune each other's work. A cycle through an
+     * accepting configuration is reported with its stem; the first worker to
+     * finish its blue search proves there is none. NonProgress searches the
+     * product with a one-bit monitor (Spin's non-progress check), accepting
+     * the runs that stay outside progress states.
+     *
+     * Both run with the calling thread's cancellation token and report
+     * progress through its sink. Stopping early (budget, capacity) leaves a
+     * partial report.
+     */
+    class ParallelSearch
+    {
+    public:
+        static ParallelDeadlockReport findDeadlocks(const Statechart &chart,
+                                                    const ParallelSearchOptions &options = ParallelSearchOptions());
+
+        /**
+         * Marked states are given by id; with none, NonProgress marks the
+         * states whose id starts with "progress", as Spin does with labels
+         */
+        static CycleReport findCycle(const Statechart &chart, CycleProperty property,
+                                     const std::vector<std::string> &markedStates,
+                                     const ParallelSearchOptions &options = ParallelSearchOptions());
+    };
+
+} // namespace ReactiveSystem
+
+#endif // PARALLEL_SEARCH_H
@@ -0,0 +1,141 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * One progress event of a running analysis
+     */
+    struct ProgressSnapshot
+    {
+        uint64_t explored = 0;
+        uint64_t frontier = 0;
+        // Breadth-first level being expanded
+        uint32_t depth = 0;
+        size_t bytes = 0;
+        double elapsedMs = 0;
+        double statesPerSecond = 0;
+        // Time to drain the current frontier at the current rate, a lower
+        // bound since the frontier keeps growing; -1 before any rate is known
+        double etaMs = -1;
+    };
+
+    /**
+     * Receives the progress of the analyses run on this thread while it is
+     * current (see ProgressScope). Called on the analysis thread, at most
+     * once per interval.
+     */
+    class ProgressSink
+    {
+    public:
+        using Callback = std::function<void(const ProgressSnapshot &)>;
+
+        explicit ProgressSink(Callback callback, std::chrono::milliseconds interval = std::chrono::milliseconds(200))
+            : callback(std::move(callback)), interval(interval) {}
+
+        void publish(const ProgressSnapshot &snapshot) const { callback(snapshot); }
+        std::chrono::milliseconds period() const { return interval; }
+
+        static const ProgressSink *current() { return active; }
+
+    private:
+        friend class ProgressScope;
+
+        Callback callback;
+        std::chrono::milliseconds interval;
+
+        static inline thread_local const ProgressSink *active = nullptr;
+    };
+
+    /**
+     * Makes a sink current on this thread for the scope's lifetime
+     */
+    class ProgressScope
+    {
+    public:
+        explicit ProgressScope(const ProgressSink *sink) : previous(ProgressSink::active)
+        {
+            ProgressSink::active = sink;
+        }
+        ~ProgressScope() { ProgressSink::active = previous; }
+
+        ProgressScope(const ProgressScope &) = delete;
+        ProgressScope &operator=(const ProgressScope &) = delete;
+
+    private:
+        const ProgressSink *previous;
+    };
+
+    /**
+     * Placed in an analysis loop and updated once per expanded state. Without
+     * a current sink an update is one branch; with one, the clock is read
+     * every Interval updates and the sink is called at most once per its
+     * period, so the loop never waits on the consumer.
+     */
+    class ProgressMeter
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr uint32_t Interval = 256;
+
+        ProgressMeter() : sink(ProgressSink::current()), started(Clock::now()), next(started) {}
+
+        void update(uint64_t explored, uint64_t frontier, uint32_t depth, size_t bytes)
+        {
+            if (sink && ++updates % Interval == 0)
+                poll(explored, frontier, depth, bytes);
+        }
+
+        /**
+         * Publish a last event regardless of the period, e.g. when the
+         * analysis ends
+         */
+        void finish(uint64_t explored, uint64_t frontier, uint32_t depth, size_t bytes)
+        {
+            if (sink)
+                sink->publish(snapshot(explored, frontier, depth, bytes, Clock::now()));
+        }
+
+    private:
+        const ProgressSink *sink;
+        Clock::time_point started;
+        Clock::time_point next;
+        uint32_t updates = 0;
+
+        void poll(uint64_t explored, uint64_t frontier, uint32_t depth, size_t bytes)
+        {
+            Clock::time_point now = Clock::now();
+            if (now < next)
+                return;
+            next = now + sink->period();
+            sink->publish(snapshot(explored, frontier, depth, bytes, now));
+        }
+
+        ProgressSnapshot snapshot(uint64_t explored, uint64_t frontier, uint32_t depth, size_t bytes,
+                                  Clock::time_point now) const
+        {
+            ProgressSnapshot snapshot;
+            snapshot.explored = explored;
+            snapshot.frontier = frontier;
+            snapshot.depth = depth;
+            snapshot.bytes = bytes;
+            snapshot.elapsedMs = std::chrono::duration<double, std::milli>(now - started).count();
+            if (snapshot.elapsedMs > 0 && explored > 0)
+            {
+                snapshot.statesPerSecond = explored * 1000.0 / snapshot.elapsedMs;
+                snapshot.etaMs = frontier * 1000.0 / snapshot.statesPerSecond;
+            }
+            return snapshot;
+        }
+    };
+
+} // namespace ReactiveSystem
+
+#endif // PROGRESS_H
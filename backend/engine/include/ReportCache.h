@@ -0,0 +1,122 @@
+#ifndef REPORT_CACHE_H
+#define REPORT_CACHE_H
+
+#include "MealyMachine.h"
+#include "Statechart.h"
+#include "Verifier.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * 128-bit content hash of a machine
+     */
+    struct MachineHash
+    {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        bool operator==(const MachineHash &other) const { return high == other.high && low == other.low; }
+        std::string hex() const;
+    };
+
+    /**
+     * For unordered containers; the hash bits are already uniform
+     */
+    struct MachineHashHasher
+    {
+        size_t operator()(const MachineHash &hash) const { return static_cast<size_t>(hash.low); }
+    };
+
+    /**
+     * Hash of the parts of a machine that verification reads: state ids,
+     * names, flags and hierarchy, transition endpoints and labels, and the
+     * variables. Machine and transition ids, and anything the editor keeps
+     * beside the machine (positions, notes, timestamps), are not part of
+     * it. Variables are hashed as multisets, and so are states and
+     * transitions of a flat machine with at most one initial state, so
+     * reordering them keeps the hash. Where order changes the result (a
+     * hierarchical machine resolves conflicts in document order, and the
+     * first of several initial states wins) states and transitions are
+     * hashed in order.
+     */
+    MachineHash canonicalHash(const StateMachine &machine);
+
+    /**
+     * Hash of everything a configuration exploration depends on. Node order
+     * fixes the bits of a configuration key, so unlike the machine hash it
+     * is order-sensitive.
+     */
+    MachineHash canonicalHash(const Statechart &chart);
+
+    /**
+     * Bounded LRU of verification reports keyed by canonical hash, with an
+     * optional directory holding one file per report that outlives the
+     * process. Reports for a reordered machine list their findings in the
+     * order of the first machine verified. Thread-safe.
+     */
+    class ReportCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t diskHits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            size_t entries = 0;
+            size_t capacity = 0;
+            std::string directory;
+        };
+
+        explicit ReportCache(size_t capacity = 256, const std::string &directory = "");
+
+        /**
+         * Change the bound (evicting as needed) and the disk directory, which
+         * is created if missing; an empty directory keeps reports in memory
+         */
+        void configure(size_t capacity, const std::string &directory);
+
+        bool lookup(const MachineHash &hash, Verifier::VerificationReport &report);
+
+        /**
+         * Partial reports are not stored: a later run with a larger budget
+         * must not be answered with one
+         */
+        void store(const MachineHash &hash, const Verifier::VerificationReport &report);
+
+        /**
+         * Verifier::generateReport through the cache; a cached report is
+         * complete, so it satisfies any budget
+         */
+        Verifier::VerificationReport verify(const StateMachine &machine, MachineHash *hash = nullptr, bool *cached = nullptr,
+                                            const AnalysisBudget &budget = AnalysisBudget());
+
+        void clear();
+        Stats stats() const;
+
+    private:
+        using Entry = std::pair<MachineHash, Verifier::VerificationReport>;
+
+        mutable std::mutex mutex;
+        size_t capacity;
+        std::string directory;
+        std::list<Entry> recent;
+        std::unordered_map<MachineHash, std::list<Entry>::iterator, MachineHashHasher> index;
+        Stats counters;
+
+        void insert(const MachineHash &hash, const Verifier::VerificationReport &report);
+        std::string pathFor(const MachineHash &hash) const;
+        bool readFile(const MachineHash &hash, Verifier::VerificationReport &report) const;
+        void writeFile(const MachineHash &hash, const Verifier::VerificationReport &report) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // REPORT_CACHE_H
@@ -0,0 +1,25 @@
+#ifndef SCXML_H
+#define SCXML_H
+
+#include "Statechart.h"
+#include <string>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Read an SCXML document into a Statechart without flattening it.
+     *
+     * Supported: <scxml>, <state>, <parallel>, <final>, <history type>,
+     * <initial>, <transition event cond target type>, and <raise> inside
+     * <onentry>, <onexit> and <transition>. The data model and all other
+     * executable content are skipped, so cond expressions are unknown to the
+     * explorer, except the literals "true" and "false".
+     *
+     * Throws std::invalid_argument naming the line of the problem.
+     */
+    Statechart statechartFromScxml(const std::string &document);
+
+} // namespace ReactiveSystem
+
+#endif // SCXML_H
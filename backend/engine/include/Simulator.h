@@ -0,0 +1,82 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "CompiledMachine.h"
+#include "Expression.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * A compiled machine together with the parsed and compiled guard/action
+     * of every edge (indexed like CompiledMachine::edgeTargets)
+     */
+    struct MachineProgram
+    {
+        CompiledMachine graph;
+        VariableTable variables;
+
+        std::vector<std::unique_ptr<ExprNode>> edgeGuardTrees;
+        std::vector<std::vector<Assignment>> edgeActionTrees;
+        std::vector<Bytecode> edgeGuards;
+        std::vector<Bytecode> edgeActions;
+
+        bool hasGuardsOrActions() const;
+
+        /**
+         * Throws std::invalid_argument naming the transition whose guard or
+         * action does not parse
+         */
+        static MachineProgram compile(const StateMachine &machine);
+    };
+
+    /**
+     * Reference deterministic simulator. On each input the first transition
+     * (in declaration order) leaving the current state with that input and a
+     * passing guard fires; its action runs and the machine moves to its target.
+     * When none is enabled the step fails and nothing changes.
+     */
+    class Simulator
+    {
+    public:
+        explicit Simulator(const MachineProgram &program);
+
+        void reset();
+
+        /**
+         * Returns the fired edge index, or -1 if no transition was enabled
+         */
+        int32_t step(int32_t input);
+
+        /**
+         * Stateless form of step() over caller-owned state and variables
+         */
+        static int32_t step(
+            const MachineProgram &program,
+            int32_t &state,
+            int64_t *variables,
+            int32_t input);
+
+        int32_t currentState() const { return state; }
+        const std::vector<int64_t> &variables() const { return values; }
+
+        /**
+         * Jump to a previously observed configuration
+         */
+        void restore(int32_t stateIndex, const std::vector<int64_t> &variableValues);
+
+        const MachineProgram &program() const { return machineProgram; }
+
+    private:
+        const MachineProgram &machineProgram;
+        int32_t state;
+        std::vector<int64_t> values;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // SIMULATOR_H
@@ -0,0 +1,130 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Coalesces concurrent computations of the same key: the first caller
+     * (the leader) computes, everyone who joins before it finishes receives
+     * the leader's result or exception. Waiters are callbacks rather than
+     * blocked threads, so a burst of identical requests holds no worker
+     * threads; they run on the thread that calls finish() or fail(), after
+     * the key has been released. Flights are numbered, so a leader that
+     * finishes after its flight was abandoned cannot answer a newer one.
+     * Thread-safe.
+     */
+    template <typename Key, typename Result, typename KeyHash = std::hash<Key>>
+    class SingleFlight
+    {
+    public:
+        /**
+         * Called with the result, or with nullptr and the leader's exception
+         */
+        using Waiter = std::function<void(const Result *result, std::exception_ptr error)>;
+
+        struct Stats
+        {
+            uint64_t leaders = 0;
+            uint64_t followers = 0;
+            uint64_t abandoned = 0;
+            size_t inFlight = 0;
+        };
+
+        struct Ticket
+        {
+            uint64_t flight;
+            bool leader;
+        };
+
+        /**
+         * Register a waiter for key. A leader ticket obliges the caller to
+         * eventually call finish() or fail() with its flight.
+         */
+        Ticket join(const Key &key, Waiter waiter)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto inserted = flights.emplace(key, Flight());
+            Flight &flight = inserted.first->second;
+            if (inserted.second)
+            {
+                flight.id = ++lastFlight;
+                counters.leaders++;
+            }
+            else
+                counters.followers++;
+            flight.waiters.push_back(std::move(waiter));
+            return {flight.id, inserted.second};
+        }
+
+        void finish(const Key &key, uint64_t flight, const Result &result)
+        {
+            for (auto &waiter : release(key, flight))
+                waiter(&result, nullptr);
+        }
+
+        void fail(const Key &key, uint64_t flight, std::exception_ptr error)
+        {
+            for (auto &waiter : release(key, flight))
+                waiter(nullptr, error);
+        }
+
+        /**
+         * Forget a flight nobody waits for any more: its waiters are dropped
+         * uncalled, its leader's result is discarded and the next join for
+         * key starts a new flight
+         */
+        void abandon(const Key &key, uint64_t flight)
+        {
+            if (!release(key, flight).empty())
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                counters.abandoned++;
+            }
+        }
+
+        Stats stats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Stats result = counters;
+            result.inFlight = flights.size();
+            return result;
+        }
+
+    private:
+        struct Flight
+        {
+            uint64_t id = 0;
+            std::vector<Waiter> waiters;
+        };
+
+        mutable std::mutex mutex;
+        std::unordered_map<Key, Flight, KeyHash> flights;
+        uint64_t lastFlight = 0;
+        Stats counters;
+
+        std::vector<Waiter> release(const Key &key, uint64_t flight)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Waiter> waiters;
+            auto it = flights.find(key);
+            if (it != flights.end() && it->second.id == flight)
+            {
+                waiters = std::move(it->second.waiters);
+                flights.erase(it);
+            }
+            return waiters;
+        }
+    };
+
+} // namespace ReactiveSystem
+
+#endif // SINGLE_FLIGHT_H
@@ -0,0 +1,355 @@
+#ifndef STATECHART_H
+#define STATECHART_H
+
+#include "AnalysisBudget.h"
+#include "MealyMachine.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Hierarchical state machine (SCXML semantics) kept unflattened.
+     * Nodes are stored in document order, so the descendants of node n are
+     * exactly the indices in (n, subtreeEnd[n]). Node 0 is the document root,
+     * which is never active itself.
+     */
+    struct Statechart
+    {
+        enum class Kind : uint8_t
+        {
+            Atomic,
+            Compound,
+            Parallel,
+            Final,
+            ShallowHistory,
+            DeepHistory
+        };
+
+        /**
+         * Guards are opaque; only the literals are decided statically
+         */
+        enum class Guard : uint8_t
+        {
+            Always,
+            Never,
+            Unknown
+        };
+
+        static constexpr uint32_t Root = 0;
+        static constexpr int32_t NoEvent = -1;
+        // Entry and the final-state test recurse once per level
+        static constexpr uint32_t MaxDepth = 256;
+
+        struct Node
+        {
+            std::string id;
+            Kind kind = Kind::Atomic;
+            uint32_t parent = Root;
+            uint32_t subtreeEnd = 0;
+            int32_t historySlot = -1;
+            int32_t doneEvent = NoEvent;
+            std::vector<uint32_t> children;
+            // Default entry: initial targets (compound/root) or the default
+            // transition targets (history)
+            std::vector<uint32_t> initial;
+            std::vector<uint32_t> transitions;
+            std::vector<int32_t> entryRaises;
+            std::vector<int32_t> exitRaises;
+        };
+
+        struct Transition
+        {
+            std::string id;
+            uint32_t source = Root;
+            std::vector<uint32_t> targets;
+            // Event descriptors; empty for eventless transitions
+            std::vector<std::string> events;
+            Guard guard = Guard::Always;
+            std::string condition;
+            bool internal = false;
+            std::vector<int32_t> raises;
+        };
+
+        std::string name;
+        std::vector<Node> nodes;
+        std::vector<Transition> transitions;
+        std::vector<std::string> events;
+        // Events the environment may send: those transitions name, but
+        // neither done.* nor events only raised within the chart
+        std::vector<int32_t> externalEvents;
+        uint32_t historyCount = 0;
+
+        // Row e holds one bit per transition whose descriptors match event e
+        std::vector<uint64_t> eventMatches;
+        size_t matchWords = 0;
+        // Row e (last row: eventless) holds one bit per node that has, or
+        // inherits from an ancestor, a transition matching e
+        std::vector<uint64_t> eventScopes;
+        size_t nodeWords = 0;
+
+        std::unordered_map<std::string, uint32_t> nodeIndex;
+        std::unordered_map<std::string, uint32_t> eventIndex;
+
+        Statechart();
+
+        /**
+         * Append a node; nodes must be added in document order (every
+         * parent before its children, siblings' subtrees contiguous)
+         */
+        uint32_t addNode(const std::string &id, Kind kind, uint32_t parent);
+
+        uint32_t addTransition(Transition transition);
+
+        int32_t findNode(const std::string &id) const;
+        int32_t internEvent(const std::string &name);
+
+        bool isDescendant(uint32_t node, uint32_t ancestor) const
+        {
+            return node > ancestor && node < nodes[ancestor].subtreeEnd;
+        }
+
+        bool isAtomic(uint32_t node) const
+        {
+            return nodes[node].kind == Kind::Atomic || nodes[node].kind == Kind::Final;
+        }
+
+        bool isHistory(uint32_t node) const
+        {
+            return nodes[node].kind == Kind::ShallowHistory || nodes[node].kind == Kind::DeepHistory;
+        }
+
+        bool matches(uint32_t transition, int32_t event) const
+        {
+            if (event == NoEvent)
+                return transitions[transition].events.empty();
+            return (eventMatches[event * matchWords + transition / 64] >> (transition % 64)) & 1;
+        }
+
+        const uint64_t *scope(int32_t event) const
+        {
+            return eventScopes.data() + (event == NoEvent ? events.size() : static_cast<size_t>(event)) * nodeWords;
+        }
+
+        /**
+         * Resolve default entries, subtree ranges, history slots and the
+         * event match table. Throws std::invalid_argument on malformed charts.
+         */
+        void finalize();
+
+        /**
+         * Nested states and orthogonal regions of a StateMachine. Transitions
+         * read their input as the event (no input = eventless) and a
+         * non-literal guard as unknown; transitions out of a history state
+         * give its default entry. Transitions with unknown endpoints are
+         * skipped, as in CompiledMachine::compile.
+         */
+        static Statechart fromStateMachine(const StateMachine &machine);
+
+        /**
+         * Any state has a parent or a kind, so the flat analyses do not apply
+         */
+        static bool isHierarchical(const StateMachine &machine);
+
+        /**
+         * Configurations of the equivalent flat machine (sum over compound
+         * children, product over parallel regions), for comparison
+         */
+        double flattenedSize() const;
+    };
+
+    /**
+     * Result of exploring the reachable stable configurations
+     */
+    struct StatechartReport
+    {
+        static constexpr size_t MaxReportedDeadlocks = 32;
+
+        uint64_t configurations = 0;
+        uint64_t macrosteps = 0;
+        uint64_t terminalConfigurations = 0;
+        uint64_t divergentMacrosteps = 0;
+        uint64_t deadlockCount = 0;
+        bool complete = true;
+        StopReason stopReason = StopReason::None;
+        // Configurations whose successors were computed
+        uint64_t expanded = 0;
+        // Configurations found but not expanded, plus successors dropped at
+        // the configuration limit
+        uint64_t frontier = 0;
+        double elapsedMs = 0;
+        double flattenedSize = 0;
+        // Size of the visited table and parent links when the search
+        // stopped, their peak since they only grow
+        uint64_t peakBytes = 0;
+        // Estimate of the key bytes read and written by the search
+        uint64_t bytesTouched = 0;
+        std::vector<std::string> unreachableStates;
+        // Active atomic states of each reported deadlocked configuration
+        std::vector<std::vector<std::string>> deadlocks;
+        // Atomic states active in any deadlocked configuration, in document
+        // order; unlike deadlocks, never truncated
+        std::vector<std::string> deadlockedStates;
+        // External events leading to the first deadlock
+        std::vector<std::string> deadlockPath;
+    };
+
+    /**
+     * Where and how often explore() checkpoints (see ExplorationCheckpoint);
+     * an empty directory disables checkpoints
+     */
+    struct CheckpointOptions
+    {
+        // A week, far enough below the clock's range to add to now()
+        static constexpr uint64_t MaxIntervalMs = 7 * 24 * 3600 * 1000ull;
+
+        std::string directory;
+        std::chrono::milliseconds interval = std::chrono::seconds(60);
+    };
+
+    /**
+     * On-the-fly successor function over configurations. A configuration key
+     * is the active-state bitset followed by one bitset per history node
+     * (empty while no history has been recorded). Every external event runs
+     * a full macrostep: the event's microstep, then eventless transitions and
+     * raised/done events until the configuration is stable. Unknown guards
+     * branch both ways, so successors over-approximate the real behaviour.
+     */
+    class StatechartExplorer
+    {
+    public:
+        static constexpr uint32_t MaxMicrosteps = 1024;
+        // Configurations are numbered by uint32_t, UINT32_MAX standing for
+        // "no parent"
+        static constexpr size_t MaxConfigurations = UINT32_MAX - 1;
+
+        explicit StatechartExplorer(const Statechart &chart);
+
+        size_t keyWords() const { return words * (1 + chart.historyCount); }
+
+        /**
+         * Stable configurations after entering the initial states; keys are
+         * appended to out
+         */
+        void initial(std::vector<uint64_t> &out);
+
+        /**
+         * Stable successors of a configuration for one external event.
+         * Returns false when no transition is enabled by the event.
+         */
+        bool step(const uint64_t *key, int32_t event, std::vector<uint64_t> &out);
+
+        /**
+         * A top-level final state is active: the chart has terminated
+         */
+        bool terminated(const uint64_t *key) const;
+
+        void activeAtomicStates(const uint64_t *key, std::vector<uint32_t> &out) const;
+
+        uint64_t divergentMacrosteps() const { return divergent; }
+
+        /**
+         * Poll meter for time within macrosteps too. Once it is exhausted,
+         * initial() and step() return early and interrupted() is true
+         * until the next call; their successors are then incomplete.
+         */
+        void useBudget(BudgetMeter *meter) { budget = meter; }
+
+        bool interrupted() const { return stopped; }
+
+        /**
+         * Continue the counts of an earlier run resumed from a checkpoint
+         */
+        void restore(const std::vector<uint64_t> &enteredStates, uint64_t divergentMacrosteps);
+
+        /**
+         * States entered so far, including those only passed through
+         * within a macrostep
+         */
+        const std::vector<uint64_t> &enteredStates() const { return entered; }
+
+        /**
+         * Breadth-first search of the stable configurations. Stops adding
+         * configurations after maxConfigurations, and stops expanding them
+         * once the budget is exhausted; either way the report is partial
+         * (complete == false) but covers everything explored so far. With
+         * checkpoints, the search resumes from the chart's last checkpoint,
+         * saves one every interval and when it stops short, and removes it
+         * once complete; it runs without one while another search of the
+         * same chart holds it. Once the limit drops a successor, checkpoints
+         * resume from the configuration that dropped it.
+         */
+        static StatechartReport explore(const Statechart &chart, size_t maxConfigurations,
+                                        const AnalysisBudget &budget = AnalysisBudget(),
+                                        const CheckpointOptions &checkpoint = CheckpointOptions());
+
+    private:
+        struct Pending
+        {
+            std::vector<uint64_t> key;
+            std::vector<int32_t> queue;
+            size_t head;
+            uint32_t microsteps;
+            // No eventless transition is enabled in key
+            bool eventlessStable;
+        };
+
+        // Children of an item still being visited within one macrostep;
+        // entry is the item's identity in seen
+        struct Frame
+        {
+            std::vector<Pending> children;
+            size_t next;
+            std::map<std::vector<uint64_t>, bool>::iterator entry;
+        };
+
+        const Statechart &chart;
+        size_t words;
+        uint64_t divergent = 0;
+        BudgetMeter *budget = nullptr;
+        bool stopped = false;
+        std::vector<uint64_t> entered;
+        std::vector<uint64_t> candidates;
+
+        // Scratch space reused across microsteps
+        std::vector<std::vector<uint32_t>> options;
+        std::vector<uint32_t> selected;
+        std::vector<uint32_t> filtered;
+        std::vector<uint32_t> effective;
+        std::vector<uint32_t> historyStack;
+        std::vector<uint8_t> preemptedBy;
+        std::vector<std::vector<uint64_t>> exitSets;
+        std::vector<uint64_t> exitSet;
+        std::vector<uint64_t> entrySet;
+        std::vector<Pending> work;
+        // Items of the current macrostep: key, pending events and whether
+        // eventless transitions were checked, mapped to "on the DFS path"
+        std::map<std::vector<uint64_t>, bool> seen;
+        std::vector<uint64_t> identity;
+        std::vector<Frame> frames;
+
+        bool select(const uint64_t *key, int32_t event);
+        bool nextCombination(std::vector<size_t> &choice) const;
+        void branch(const Pending &item, bool eventless);
+        void settle(std::vector<uint64_t> &out);
+        Pending microstep(const Pending &item);
+
+        void enter(Pending &next);
+        void effectiveTargets(const uint64_t *key, uint32_t transition);
+        int32_t domain(const uint64_t *key, uint32_t transition);
+        void computeExitSet(const uint64_t *key, uint32_t transition, std::vector<uint64_t> &out);
+        void removeConflicts(const uint64_t *key);
+        void addDescendants(const uint64_t *key, uint32_t node);
+        void addAncestors(const uint64_t *key, uint32_t node, uint32_t ancestor);
+        bool inFinalState(const uint64_t *active, uint32_t node) const;
+        bool anyInRange(const std::vector<uint64_t> &bits, uint32_t begin, uint32_t end) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // STATECHART_H
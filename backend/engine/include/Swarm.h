@@ -0,0 +1,95 @@
+#ifndef SWARM_H
+#define SWARM_H
+
+#include "AnalysisBudget.h"
+#include "Statechart.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    struct SwarmOptions
+    {
+        static constexpr unsigned MaxSearches = 4096;
+        static constexpr unsigned MaxThreads = 256;
+        static constexpr size_t MaxBitstateBytes = size_t(1) << 26;
+        // Tables held at once by the searches running concurrently
+        static constexpr size_t MaxTotalBitstateBytes = size_t(1) << 30;
+
+        // 0 = one per thread; at most MaxSearches
+        unsigned searches = 0;
+        // 0 = hardware concurrency; at most MaxThreads, and lowered until
+        // the concurrent searches' tables fit in MaxTotalBitstateBytes
+        unsigned threads = 0;
+        // Private bitstate table of each search, rounded down to a power
+        // of two and clamped to [8, MaxBitstateBytes] and to half the
+        // memory budget
+        size_t bitstateBytes = 1 << 20;
+        uint32_t maxDepth = 10000;
+        uint64_t seed = 1;
+        // Applies to each search separately
+        AnalysisBudget budget;
+    };
+
+    /**
+     * A deadlocked configuration found by at least one search
+     */
+    struct SwarmFinding
+    {
+        std::vector<std::string> configuration;
+        // Shortest event sequence any search reached it by
+        std::vector<std::string> path;
+        unsigned foundBy = 0;
+    };
+
+    struct SwarmReport
+    {
+        static constexpr size_t MaxReportedDeadlocks = 32;
+
+        unsigned searches = 0;
+        // Threads the searches ran on, and the bitstate bytes their
+        // tables held at once: at most MaxTotalBitstateBytes
+        unsigned threads = 0;
+        size_t bitstateBytes = 0;
+        uint64_t statesVisited = 0;
+        uint64_t transitions = 0;
+        // Configurations left unexpanded at the depth bound
+        uint64_t truncated = 0;
+        uint64_t divergentMacrosteps = 0;
+        // Mean fraction of bitstate bits set; the chance that a search
+        // wrongly takes a new configuration for visited grows with it
+        double bitstateFill = 0;
+        double elapsedMs = 0;
+
+        // Distinct deadlocked configurations, shortest paths first
+        uint64_t deadlockCount = 0;
+        std::vector<SwarmFinding> deadlocks;
+
+        // States entered by some search, out of all non-history states
+        uint32_t statesCovered = 0;
+        uint32_t stateCount = 0;
+        std::vector<std::string> unreachedStates;
+    };
+
+    /**
+     * Swarm verification for charts too large to explore exhaustively:
+     * many independent depth-first searches, each bounded in depth and
+     * budget, each with its own seed, event order, successor shuffling and
+     * bitstate hash, run across threads. Bitstate tables may skip
+     * configurations, so nothing is proved; the diversity makes the searches
+     * cover different parts of the space, which finds deadlocks far sooner
+     * than one large search. Findings are merged by configuration.
+     *
+     * Searches run with the calling thread's cancellation token.
+     */
+    class Swarm
+    {
+    public:
+        static SwarmReport run(const Statechart &chart, const SwarmOptions &options = SwarmOptions());
+    };
+
+} // namespace ReactiveSystem
+
+#endif // SWARM_H
@@ -0,0 +1,161 @@
+#ifndef THREADED_MACHINE_H
+#define THREADED_MACHINE_H
+
+#include "Simulator.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * A MachineProgram compiled to direct-threaded code.
+     *
+     * Every state starts with a dispatch op that reads the next input and
+     * jumps straight to the candidate transitions for (state, input). Guard
+     * and action bytecode is inlined into those blocks and a transition ends
+     * by jumping to the target state's dispatch op, so a whole input batch
+     * runs without returning to an interpreter loop. With GCC/Clang each op
+     * stores the address of its handler (computed goto); other compilers use
+     * a switch over the same ops.
+     */
+    class ThreadedMachine
+    {
+    public:
+        // Dense (state, input) entry tables above this size are not compiled
+        static constexpr size_t MaxDispatchEntries = size_t(1) << 24;
+
+        struct RunResult
+        {
+            size_t steps;
+            bool failed;
+        };
+
+        /**
+         * Returns nullptr when the machine is too large for dense dispatch
+         */
+        static std::unique_ptr<ThreadedMachine> compile(const MachineProgram &program);
+
+        /**
+         * Consume inputs starting in state with the given variables (both are
+         * updated in place). Stops at the end of the batch or at the first
+         * input with no enabled transition; edgeTrace, when non-null, receives
+         * the fired edge of every step.
+         */
+        RunResult run(
+            int32_t &state,
+            int64_t *variables,
+            const int32_t *inputs,
+            size_t count,
+            int32_t *edgeTrace) const;
+
+        size_t codeSize() const { return code.size(); }
+
+    private:
+        enum class OpCode : uint8_t
+        {
+            Dispatch,
+            PushConst,
+            Load,
+            Store,
+            Add,
+            Sub,
+            Mul,
+            Div,
+            Mod,
+            Neg,
+            Not,
+            Eq,
+            Ne,
+            Lt,
+            Le,
+            Gt,
+            Ge,
+            ToBool,
+            Jump,
+            JumpIfZero,
+            JumpIfNonZero,
+            Fire,
+            Fail
+        };
+
+        struct Op
+        {
+            const void *handler;
+            int64_t operand;
+            int32_t edge;
+            OpCode code;
+        };
+
+        std::vector<Op> code;
+        std::vector<int32_t> entries; // [state * inputCount + input] -> op index or -1
+        size_t inputCount = 0;
+
+        ThreadedMachine() = default;
+
+        void append(OpCode op, int64_t operand, int32_t edge = -1);
+
+        /**
+         * The interpreter; with handlerTable set it only reports the handler
+         * addresses used to thread the code
+         */
+        RunResult execute(
+            int32_t &state,
+            int64_t *variables,
+            const int32_t *inputs,
+            size_t count,
+            int32_t *edgeTrace,
+            const void *const **handlerTable) const;
+    };
+
+    /**
+     * Simulator that interprets bytecode until a machine has taken
+     * tierUpSteps steps, then switches to its threaded compilation
+     */
+    class TieredSimulator
+    {
+    public:
+        static constexpr uint64_t DefaultTierUpSteps = 4096;
+
+        explicit TieredSimulator(const MachineProgram &program, uint64_t tierUpSteps = DefaultTierUpSteps);
+
+        void reset();
+
+        /**
+         * Returns the fired edge, or -1 when no transition was enabled
+         */
+        int32_t step(int32_t input);
+
+        /**
+         * Run a batch; same contract as ThreadedMachine::run
+         */
+        ThreadedMachine::RunResult run(const int32_t *inputs, size_t count, int32_t *edgeTrace);
+
+        /**
+         * Adopt a configuration reached by running the program outside this
+         * simulator; stepsTaken counts toward the tier-up threshold
+         */
+        void restore(int32_t stateIndex, const std::vector<int64_t> &variableValues, uint64_t stepsTaken);
+
+        int32_t currentState() const { return state; }
+        const std::vector<int64_t> &variables() const { return values; }
+        bool isCompiled() const { return compiled != nullptr; }
+        const ThreadedMachine *threaded() const { return compiled.get(); }
+        uint64_t totalSteps() const { return stepCount; }
+
+    private:
+        const MachineProgram &program;
+        int32_t state;
+        std::vector<int64_t> values;
+        std::unique_ptr<ThreadedMachine> compiled;
+        uint64_t tierUpSteps;
+        uint64_t stepCount = 0;
+        bool compileAttempted = false;
+
+        void maybeTierUp();
+    };
+
+} // namespace ReactiveSystem
+
+#endif // THREADED_MACHINE_H
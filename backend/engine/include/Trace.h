@@ -0,0 +1,143 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Spans are compiled in unless built with -DRSM_TRACING=0; compiled in,
+// a span costs one flag test while tracing is off
+#ifndef RSM_TRACING
+#define RSM_TRACING 1
+#endif
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Engine tracing. Each thread records completed spans into its own ring
+     * buffer of the last RingCapacity spans, with no lock or allocation
+     * after its first span; timestamps are TSC ticks where available,
+     * converted when the trace is dumped. Spans are recorded while tracing
+     * is enabled for the process, or on a thread inside a TraceRequestScope,
+     * and dumped as Chrome trace-event JSON (chrome://tracing, Perfetto).
+     *
+     * Span names must be string literals: only the pointer is stored.
+     */
+    class Tracer
+    {
+    public:
+        static constexpr size_t RingCapacity = 8192;
+
+        static bool active()
+        {
+#if RSM_TRACING
+            return currentRequest != 0 || enabledFlag.load(std::memory_order_relaxed);
+#else
+            return false;
+#endif
+        }
+
+        static uint64_t now()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        /**
+         * Record a span of the calling thread, under its current request
+         */
+        static void record(const char *name, uint64_t begin, uint64_t end);
+
+        static void setEnabled(bool enabled);
+        static bool enabled();
+
+        /**
+         * Whether spans are compiled in
+         */
+        static bool available() { return RSM_TRACING != 0; }
+
+        /**
+         * Id for a TraceRequestScope, never 0
+         */
+        static uint32_t newRequest();
+
+        /**
+         * The buffered spans of one request, or of everything when request
+         * is 0, as a Chrome trace-event JSON document
+         */
+        static std::string chromeJson(uint32_t request = 0);
+
+        /**
+         * Drop the spans buffered so far from later dumps
+         */
+        static void clear();
+
+    private:
+        friend class TraceRequestScope;
+
+        static inline std::atomic<bool> enabledFlag{false};
+        static inline thread_local uint32_t currentRequest = 0;
+    };
+
+    /**
+     * Records the spans of this thread under a request for the scope's
+     * lifetime, whether or not tracing is enabled; 0 records nothing extra
+     */
+    class TraceRequestScope
+    {
+    public:
+        explicit TraceRequestScope(uint32_t request) : previous(Tracer::currentRequest)
+        {
+            Tracer::currentRequest = request;
+        }
+        ~TraceRequestScope() { Tracer::currentRequest = previous; }
+
+        TraceRequestScope(const TraceRequestScope &) = delete;
+        TraceRequestScope &operator=(const TraceRequestScope &) = delete;
+
+    private:
+        uint32_t previous;
+    };
+
+    /**
+     * A span from construction to destruction; use RSM_TRACE_SPAN
+     */
+    class TraceSpan
+    {
+    public:
+        explicit TraceSpan(const char *name) : name(name), begin(Tracer::active() ? Tracer::now() : 0) {}
+        ~TraceSpan()
+        {
+            if (begin)
+                Tracer::record(name, begin, Tracer::now());
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+    private:
+        const char *name;
+        uint64_t begin;
+    };
+
+} // namespace ReactiveSystem
+
+#define RSM_TRACE_JOIN_(a, b) a##b
+#define RSM_TRACE_JOIN(a, b) RSM_TRACE_JOIN_(a, b)
+
+#if RSM_TRACING
+#define RSM_TRACE_SPAN(name) ::ReactiveSystem::TraceSpan RSM_TRACE_JOIN(traceSpan, __LINE__)(name)
+#else
+#define RSM_TRACE_SPAN(name) ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,125 @@
+#ifndef TRACE_CODEC_H
+#define TRACE_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * One simulation step as shipped to the playback UI
+     */
+    struct TraceRecord
+    {
+        uint64_t step = 0;
+        std::string currentState;
+        std::string nextState;
+        std::string input;
+        std::string output;
+        std::string transitionId;
+    };
+
+    /**
+     * A decoded record with strings replaced by ids into TraceReader::strings()
+     * (-1 = empty)
+     */
+    struct EncodedRecord
+    {
+        uint64_t step;
+        int32_t currentState;
+        int32_t nextState;
+        int32_t input;
+        int32_t output;
+        int32_t transitionId;
+    };
+
+    /**
+     * Streaming encoder for the compact binary trace format:
+     *
+     *   body     records grouped into blocks of blockRecords records
+     *   strings  varint count, then varint length + bytes per string
+     *   edges    varint count, then (transition, from, to, input, output) ids
+     *   index    per block: u64 body offset, u64 step of its first record
+     *   footer   u64 record count, u32 block size, u64 offset of the string
+     *            table, magic "RST1"
+     *
+     * All strings are interned. A record whose fields match the first record
+     * seen for its transition id is stored as a reference to that edge; step
+     * numbers are zigzag varint deltas (implicit when +1); and a record that
+     * repeats the previous one with the next step (a self-loop) extends a run
+     * length instead. Runs never cross blocks and every block starts from a
+     * reset predictor, so decoding can start at any block.
+     */
+    class TraceEncoder
+    {
+    public:
+        static constexpr uint32_t DefaultBlockRecords = 1024;
+
+        explicit TraceEncoder(uint32_t blockRecords = DefaultBlockRecords);
+
+        void append(const TraceRecord &record);
+
+        /**
+         * Flush and return the encoded trace; the encoder is left empty
+         */
+        std::vector<uint8_t> finish();
+
+        uint64_t recordCount() const { return records; }
+
+    private:
+        uint32_t blockRecords;
+        uint64_t records = 0;
+
+        std::vector<uint8_t> body;
+        std::vector<std::pair<uint64_t, uint64_t>> index;
+
+        std::vector<std::string> strings;
+        std::unordered_map<std::string, int32_t> stringIds;
+        std::vector<EncodedRecord> edges; // step unused
+        std::unordered_map<int32_t, uint32_t> edgeIds; // transition string id -> edge
+
+        // Pending run: pending and its runLength - 1 successors
+        EncodedRecord pending{};
+        uint64_t runLength = 0;
+        uint64_t previousStep = 0;
+
+        int32_t intern(const std::string &value);
+        void flushRun();
+    };
+
+    /**
+     * Random-access decoder over an encoded trace. The buffer must outlive
+     * the reader. Throws std::invalid_argument on malformed input.
+     */
+    class TraceReader
+    {
+    public:
+        TraceReader(const uint8_t *data, size_t size);
+
+        uint64_t size() const { return records; }
+        const std::vector<std::string> &strings() const { return stringTable; }
+
+        /**
+         * Records [from, from + count), clamped to size()
+         */
+        std::vector<EncodedRecord> read(uint64_t from, uint64_t count) const;
+
+        std::vector<TraceRecord> readRecords(uint64_t from, uint64_t count) const;
+
+    private:
+        const uint8_t *data;
+        size_t bodySize;
+        uint64_t records;
+        uint32_t blockRecords;
+
+        std::vector<std::string> stringTable;
+        std::vector<EncodedRecord> edges; // step unused
+        std::vector<std::pair<uint64_t, uint64_t>> index;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // TRACE_CODEC_H
@@ -0,0 +1,107 @@
+#ifndef TRACE_STORE_H
+#define TRACE_STORE_H
+
+#include "Simulator.h"
+#include <cstdint>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Configuration of one simulation step, as reconstructed by TraceStore
+     */
+    struct TraceFrame
+    {
+        uint64_t step;  // number of inputs consumed; 0 is the initial configuration
+        int32_t state;  // state after the step
+        int32_t edge;   // edge fired by the step, -1 for step 0
+        std::vector<int64_t> variables;
+    };
+
+    struct TraceStoreOptions
+    {
+        // Replay budget a seek should stay within; drives the snapshot interval
+        uint64_t targetSeekNanos = 200000;
+        uint32_t minInterval = 16;
+        uint32_t maxInterval = 1u << 16;
+    };
+
+    /**
+     * Time-travel store for long simulations. Only the consumed input log is
+     * kept per step, plus a snapshot of (state, variables) every k steps.
+     * Seeking replays from the nearest earlier snapshot, so random access
+     * costs O(k) steps and memory is O(steps + steps / k * variables).
+     *
+     * k adapts to the measured cost of a step: it is the number of steps that
+     * fit in targetSeekNanos, rounded to a power of two and clamped.
+     */
+    class TraceStore
+    {
+    public:
+        explicit TraceStore(const MachineProgram &program, const TraceStoreOptions &options = TraceStoreOptions());
+
+        /**
+         * Append inputs to the trace, simulating from its last configuration.
+         * Stops at the first input with no enabled transition; returns the
+         * number of inputs consumed.
+         */
+        size_t record(const int32_t *inputs, size_t count);
+
+        /**
+         * Configuration after the given number of steps (clamped to length())
+         */
+        TraceFrame seek(uint64_t step) const;
+
+        /**
+         * Consecutive frames [from, from + count), replayed in one pass
+         */
+        std::vector<TraceFrame> frames(uint64_t from, size_t count) const;
+
+        uint64_t length() const { return inputLog.size(); }
+        size_t snapshotCount() const { return snapshots.size(); }
+        uint32_t snapshotInterval() const { return interval; }
+        size_t memoryBytes() const;
+
+    private:
+        struct Snapshot
+        {
+            uint64_t step;
+            int32_t state;
+            int32_t edge;
+            size_t valuesOffset;
+        };
+
+        const MachineProgram &program;
+        TraceStoreOptions options;
+
+        std::vector<int32_t> inputLog;
+        std::vector<Snapshot> snapshots;
+        std::vector<int64_t> snapshotValues;
+
+        // Live configuration at the end of the trace
+        int32_t state;
+        int32_t lastEdge = -1;
+        std::vector<int64_t> values;
+
+        uint32_t interval;
+        uint64_t nextSnapshot;
+
+        // Steps recorded, and the time spent recording them, since the
+        // interval was last adapted; carried across record() calls so
+        // small batches still recalibrate
+        uint64_t calibrationSteps = 0;
+        uint64_t calibrationNanos = 0;
+
+        void takeSnapshot();
+        void adaptInterval(uint64_t steps, uint64_t nanos);
+
+        /**
+         * Restore the snapshot at or before step into a frame
+         */
+        TraceFrame restore(uint64_t step) const;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // TRACE_STORE_H
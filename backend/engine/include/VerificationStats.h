@@ -0,0 +1,125 @@
+#ifndef VERIFICATION_STATS_H
+#define VERIFICATION_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Wall and CPU time of one phase of a run
+     */
+    struct PhaseStats
+    {
+        std::string name;
+        double wallMs = 0;
+        // CPU time of the thread that ran the phase
+        double cpuMs = 0;
+    };
+
+    /**
+     * Where one verification spent its time, and how much it touched
+     */
+    struct VerificationStats
+    {
+        // In the order they ran
+        std::vector<PhaseStats> phases;
+        // States or configurations expanded
+        uint64_t states = 0;
+        // Edges or macrosteps followed
+        uint64_t edges = 0;
+        // Estimate of the bytes read and written by the analysis' own
+        // tables, not counting the input
+        uint64_t bytesTouched = 0;
+        // Largest size of those tables, as charged to the memory budget
+        uint64_t peakBytes = 0;
+
+        double wallMs() const;
+        double cpuMs() const;
+    };
+
+    /**
+     * Times consecutive phases on the calling thread: next() ends the
+     * current phase, if any, and starts the named one; stop() or the
+     * destructor ends the last. Phases with the same name accumulate.
+     * While tracing is active each phase is also recorded as a span, so
+     * names must be string literals.
+     */
+    class PhaseClock
+    {
+    public:
+        explicit PhaseClock(VerificationStats &stats) : stats(stats) {}
+        ~PhaseClock() { stop(); }
+
+        PhaseClock(const PhaseClock &) = delete;
+        PhaseClock &operator=(const PhaseClock &) = delete;
+
+        void next(const char *name);
+        void stop();
+
+        /**
+         * CPU time of the calling thread
+         */
+        static double threadCpuMs();
+        static double wallClockMs();
+
+    private:
+        VerificationStats &stats;
+        const char *current = nullptr;
+        double wallStart = 0;
+        double cpuStart = 0;
+        uint64_t traceStart = 0;
+    };
+
+    /**
+     * Totals of many runs, per phase name. Thread-safe.
+     */
+    class VerificationStatsTotals
+    {
+    public:
+        struct Phase
+        {
+            uint64_t count = 0;
+            double wallMs = 0;
+            double cpuMs = 0;
+            double maxWallMs = 0;
+        };
+
+        struct Snapshot
+        {
+            uint64_t runs = 0;
+            std::map<std::string, Phase> phases;
+            uint64_t states = 0;
+            uint64_t edges = 0;
+            uint64_t bytesTouched = 0;
+            uint64_t peakBytes = 0;
+        };
+
+        /**
+         * One run; its peak is kept if it is the largest seen
+         */
+        void record(const VerificationStats &stats);
+
+        /**
+         * A phase timed outside a run, such as converting the input
+         */
+        void record(const PhaseStats &phase);
+
+        Snapshot snapshot() const;
+        void reset();
+
+    private:
+        void add(const PhaseStats &phase);
+
+        mutable std::mutex mutex;
+        Snapshot totals;
+    };
+
+} // namespace ReactiveSystem
+
+#endif // VERIFICATION_STATS_H
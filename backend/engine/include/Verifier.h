@@ -1,6 +1,8 @@
 #ifndef VERIFIER_H
 #define VERIFIER_H
 
+#include "AnalysisBudget.h"
+#include "VerificationStats.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -65,7 +67,9 @@ namespace ReactiveSystem
             const std::string &stateId);
 
         /**
-         * Find all deadlock states
+         * Find all deadlock states. For a statechart whose exploration
+         * stops short this throws std::runtime_error rather than return
+         * a partial list
          */
         static std::vector<std::string> findDeadlocks(
             const StateMachine &machine);
@@ -104,14 +108,41 @@ namespace ReactiveSystem
             int totalStates;
             std::vector<std::string> deadlocks;
             std::string summary;
+
+            // Completeness: a report cut short by its budget covers only
+            // the states (or configurations) explored so far
+            bool complete = true;
+            std::string stopReason;
+            uint64_t statesExplored = 0;
+            uint64_t frontierSize = 0;
+            // Explored fraction of everything discovered so far, an upper
+            // bound on the true coverage
+            double coverage = 1;
+
+            // Per-phase times and work of the run that produced the report
+            VerificationStats stats;
         };
 
         static VerificationReport generateReport(
-            const StateMachine &machine);
+            const StateMachine &machine,
+            const AnalysisBudget &budget = AnalysisBudget());
 
     private:
         /**
-         * BFS helper for reachability
+         * Bound on the configurations explored for hierarchical machines
+         */
+        static constexpr size_t MaxConfigurations = 1000000;
+
+        /**
+         * generateReport for machines with nested or parallel states
+         */
+        static VerificationReport generateHierarchicalReport(
+            const StateMachine &machine,
+            const AnalysisBudget &budget);
+
+        /**
+         * BFS helper for reachability; throws std::runtime_error when a
+         * statechart's exploration stops short, as findDeadlocks does
          */
         static std::set<std::string> reachableStatesBFS(
             const StateMachine &machine);
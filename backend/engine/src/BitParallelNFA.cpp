@@ -0,0 +1,231 @@
+#include "../include/BitParallelNFA.h"
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        /**
+         * Set-of-states simulation for machines too large for the word tables
+         */
+        class SparseNFA
+        {
+        public:
+            explicit SparseNFA(const CompiledMachine &machine)
+                : machine(machine), marked(machine.stateCount(), 0) {}
+
+            std::vector<uint32_t> initial()
+            {
+                std::vector<uint32_t> active;
+                if (machine.initialState >= 0)
+                {
+                    active.push_back(static_cast<uint32_t>(machine.initialState));
+                }
+                return close(active);
+            }
+
+            std::vector<uint32_t> step(const std::vector<uint32_t> &active, int32_t input)
+            {
+                std::vector<uint32_t> next;
+                if (input < 0)
+                {
+                    return next;
+                }
+                for (uint32_t s : active)
+                {
+                    for (uint32_t e = machine.edgeOffsets[s]; e < machine.edgeOffsets[s + 1]; e++)
+                    {
+                        uint32_t target = machine.edgeTargets[e];
+                        if (machine.edgeInputs[e] == input && !marked[target])
+                        {
+                            marked[target] = 1;
+                            next.push_back(target);
+                        }
+                    }
+                }
+                clearMarks(next);
+                return close(next);
+            }
+
+            bool accepts(const std::vector<uint32_t> &active) const
+            {
+                for (uint32_t s : active)
+                {
+                    if (machine.finalStates[s])
+                        return true;
+                }
+                return false;
+            }
+
+            /**
+             * Union of two sets, used by the unanchored search
+             */
+            std::vector<uint32_t> merge(std::vector<uint32_t> active, const std::vector<uint32_t> &extra)
+            {
+                for (uint32_t s : active)
+                {
+                    marked[s] = 1;
+                }
+                for (uint32_t s : extra)
+                {
+                    if (!marked[s])
+                    {
+                        marked[s] = 1;
+                        active.push_back(s);
+                    }
+                }
+                clearMarks(active);
+                return active;
+            }
+
+        private:
+            const CompiledMachine &machine;
+            std::vector<uint8_t> marked;
+
+            std::vector<uint32_t> close(std::vector<uint32_t> active)
+            {
+                for (uint32_t s : active)
+                {
+                    marked[s] = 1;
+                }
+                for (size_t i = 0; i < active.size(); i++)
+                {
+                    uint32_t s = active[i];
+                    for (uint32_t e = machine.edgeOffsets[s]; e < machine.edgeOffsets[s + 1]; e++)
+                    {
+                        uint32_t target = machine.edgeTargets[e];
+                        if (machine.edgeInputs[e] == CompiledMachine::NoInput && !marked[target])
+                        {
+                            marked[target] = 1;
+                            active.push_back(target);
+                        }
+                    }
+                }
+                clearMarks(active);
+                return active;
+            }
+
+            void clearMarks(const std::vector<uint32_t> &states)
+            {
+                for (uint32_t s : states)
+                {
+                    marked[s] = 0;
+                }
+            }
+        };
+
+        template <size_t Words>
+        NondeterministicRunResult runBitParallel(
+            const CompiledMachine &machine,
+            const std::vector<int32_t> &inputs)
+        {
+            BitParallelNFA<Words> nfa(machine);
+            typename BitParallelNFA<Words>::StateSet active;
+
+            NondeterministicRunResult result;
+            result.stepsConsumed = nfa.run(inputs, active);
+            result.accepted = nfa.accepts(active);
+            for (size_t s = 0; s < machine.stateCount(); s++)
+            {
+                if (BitParallelNFA<Words>::contains(active, s))
+                {
+                    result.activeStates.push_back(machine.stateIds[s]);
+                }
+            }
+            return result;
+        }
+    } // namespace
+
+    std::vector<int32_t> NondeterministicSimulator::encodeInputs(
+        const CompiledMachine &machine,
+        const std::vector<std::string> &inputs)
+    {
+        std::vector<int32_t> encoded;
+        encoded.reserve(inputs.size());
+        for (const auto &input : inputs)
+        {
+            encoded.push_back(machine.findInput(input));
+        }
+        return encoded;
+    }
+
+    /**
+     * Run an input sequence and report the final active set
+     */
+    NondeterministicRunResult NondeterministicSimulator::run(
+        const CompiledMachine &machine,
+        const std::vector<std::string> &inputs)
+    {
+        std::vector<int32_t> encoded = encodeInputs(machine, inputs);
+
+        if (machine.stateCount() <= BitParallelNFA<1>::MaxStates)
+        {
+            return runBitParallel<1>(machine, encoded);
+        }
+        if (machine.stateCount() <= BitParallelNFA<2>::MaxStates)
+        {
+            return runBitParallel<2>(machine, encoded);
+        }
+
+        SparseNFA nfa(machine);
+        std::vector<uint32_t> active = nfa.initial();
+
+        NondeterministicRunResult result;
+        result.stepsConsumed = encoded.size();
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            if (active.empty())
+            {
+                result.stepsConsumed = i;
+                break;
+            }
+            active = nfa.step(active, encoded[i]);
+        }
+        result.accepted = nfa.accepts(active);
+        for (uint32_t s : active)
+        {
+            result.activeStates.push_back(machine.stateIds[s]);
+        }
+        return result;
+    }
+
+    /**
+     * Report every input position at which the machine accepts, treating the
+     * machine as a pattern that may start anywhere in the sequence
+     */
+    std::vector<size_t> NondeterministicSimulator::findMatches(
+        const CompiledMachine &machine,
+        const std::vector<std::string> &inputs)
+    {
+        std::vector<int32_t> encoded = encodeInputs(machine, inputs);
+
+        if (machine.stateCount() <= BitParallelNFA<1>::MaxStates)
+        {
+            return BitParallelNFA<1>(machine).findMatches(encoded);
+        }
+        if (machine.stateCount() <= BitParallelNFA<2>::MaxStates)
+        {
+            return BitParallelNFA<2>(machine).findMatches(encoded);
+        }
+
+        SparseNFA nfa(machine);
+        const std::vector<uint32_t> start = nfa.initial();
+        std::vector<uint32_t> active = start;
+
+        std::vector<size_t> ends;
+        if (nfa.accepts(active))
+        {
+            ends.push_back(0);
+        }
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            active = nfa.merge(nfa.step(active, encoded[i]), start);
+            if (nfa.accepts(active))
+            {
+                ends.push_back(i + 1);
+            }
+        }
+        return ends;
+    }
+
+} // namespace ReactiveSystem
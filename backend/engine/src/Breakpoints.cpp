@@ -0,0 +1,382 @@
+#include "../include/Breakpoints.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    bool BreakpointSet::edgeOnly() const
+    {
+        if (!stepBreakpoints.empty())
+            return false;
+        for (const auto &condition : conditions)
+        {
+            if (!condition.empty())
+                return false;
+        }
+        return true;
+    }
+
+    namespace
+    {
+        /**
+         * Compile a condition without declaring new variables in the program
+         */
+        Bytecode compileCondition(const std::string &text, const VariableTable &programVariables)
+        {
+            VariableTable variables = programVariables;
+            auto tree = Expression::parseGuard(text, variables);
+            if (variables.size() != programVariables.size())
+            {
+                throw std::invalid_argument("unknown variable " + variables.name(programVariables.size()));
+            }
+            return Expression::compileGuard(tree.get());
+        }
+    }
+
+    BreakpointSet BreakpointSet::compile(
+        const StateMachine &machine,
+        const MachineProgram &program,
+        const std::vector<BreakpointSpec> &specs)
+    {
+        const CompiledMachine &graph = program.graph;
+        BreakpointSet set;
+        set.edgeFlags.assign(graph.edgeCount(), 0);
+        set.edgeBreakpoints.resize(graph.edgeCount());
+
+        for (uint32_t b = 0; b < specs.size(); b++)
+        {
+            const BreakpointSpec &spec = specs[b];
+            set.kinds.push_back(spec.kind);
+            set.watchSlots.push_back(-1);
+
+            try
+            {
+                set.conditions.push_back(compileCondition(spec.condition, program.variables));
+
+                // Edge predicate for the location kinds
+                std::function<bool(size_t)> onEdge;
+                switch (spec.kind)
+                {
+                case BreakpointSpec::Kind::State:
+                {
+                    int32_t state = graph.findState(spec.target);
+                    if (state < 0)
+                        throw std::invalid_argument("unknown state " + spec.target);
+                    onEdge = [&graph, state](size_t e)
+                    { return graph.edgeTargets[e] == static_cast<uint32_t>(state); };
+                    break;
+                }
+                case BreakpointSpec::Kind::Transition:
+                {
+                    bool known = std::any_of(
+                        machine.transitions.begin(), machine.transitions.end(),
+                        [&spec](const Transition &transition)
+                        { return transition.id == spec.target; });
+                    if (!known)
+                        throw std::invalid_argument("unknown transition " + spec.target);
+                    onEdge = [&machine, &graph, &spec](size_t e)
+                    { return machine.transitions[graph.edgeTransitions[e]].id == spec.target; };
+                    break;
+                }
+                case BreakpointSpec::Kind::Input:
+                {
+                    int32_t input = graph.findInput(spec.target);
+                    if (input < 0)
+                        throw std::invalid_argument("unknown input " + spec.target);
+                    onEdge = [&graph, input](size_t e)
+                    { return graph.edgeInputs[e] == input; };
+                    break;
+                }
+                case BreakpointSpec::Kind::Output:
+                {
+                    auto output = graph.outputIndex.find(spec.target);
+                    if (output == graph.outputIndex.end())
+                        throw std::invalid_argument("unknown output " + spec.target);
+                    int32_t index = static_cast<int32_t>(output->second);
+                    onEdge = [&graph, index](size_t e)
+                    { return graph.edgeOutputs[e] == index; };
+                    break;
+                }
+                case BreakpointSpec::Kind::Variable:
+                    set.watchSlots[b] = program.variables.find(spec.target);
+                    if (set.watchSlots[b] < 0)
+                        throw std::invalid_argument("unknown variable " + spec.target);
+                    set.stepBreakpoints.push_back(b);
+                    break;
+                case BreakpointSpec::Kind::Predicate:
+                    if (set.conditions[b].empty())
+                        throw std::invalid_argument("predicate breakpoint needs a condition");
+                    set.stepBreakpoints.push_back(b);
+                    break;
+                }
+
+                if (onEdge)
+                {
+                    for (size_t e = 0; e < graph.edgeCount(); e++)
+                    {
+                        if (onEdge(e))
+                        {
+                            set.edgeFlags[e] = 1;
+                            set.edgeBreakpoints[e].push_back(b);
+                        }
+                    }
+                }
+            }
+            catch (const std::invalid_argument &e)
+            {
+                throw std::invalid_argument("Breakpoint " + std::to_string(b) + ": " + e.what());
+            }
+        }
+
+        return set;
+    }
+
+    BreakpointRunner::BreakpointRunner(const MachineProgram &program, TieredSimulator &simulator)
+        : program(program), simulator(simulator)
+    {
+        reset();
+    }
+
+    void BreakpointRunner::reset()
+    {
+        consumed = 0;
+        lastEdge = -1;
+        resync();
+    }
+
+    /**
+     * Restart the replay history at the simulator's current configuration
+     */
+    void BreakpointRunner::resync()
+    {
+        older = {consumed, simulator.currentState(), lastEdge, simulator.variables()};
+        hasNewer = false;
+        history.clear();
+        syncedSteps = simulator.totalSteps();
+    }
+
+    /**
+     * Append consumed inputs to the history; at every chunk boundary take a
+     * checkpoint and drop the inputs before the previous one
+     */
+    void BreakpointRunner::commit(const int32_t *inputs, size_t count, int32_t state, const std::vector<int64_t> &values)
+    {
+        history.insert(history.end(), inputs, inputs + count);
+        consumed += count;
+
+        if (count > 0 && consumed % ChunkSteps == 0)
+        {
+            if (hasNewer)
+            {
+                history.erase(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(newer.step - older.step));
+                older = std::move(newer);
+            }
+            newer = {consumed, state, lastEdge, values};
+            hasNewer = true;
+        }
+    }
+
+    /**
+     * Breakpoint hit by the step that fired edge, lowest index first; -1 if none.
+     * Watchpoint and predicate trackers are updated on every call.
+     */
+    int32_t BreakpointRunner::check(const BreakpointSet &breakpoints, int32_t edge, int64_t *values)
+    {
+        int32_t hit = -1;
+
+        if (breakpoints.edgeFlags[edge])
+        {
+            for (uint32_t b : breakpoints.edgeBreakpoints[edge])
+            {
+                if (breakpoints.conditions[b].empty() || Expression::execute(breakpoints.conditions[b], values) != 0)
+                {
+                    hit = static_cast<int32_t>(b);
+                    break;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < breakpoints.stepBreakpoints.size(); i++)
+        {
+            uint32_t b = breakpoints.stepBreakpoints[i];
+            bool matched;
+            if (breakpoints.kinds[b] == BreakpointSpec::Kind::Variable)
+            {
+                int64_t value = values[breakpoints.watchSlots[b]];
+                matched = value != tracked[i] &&
+                          (breakpoints.conditions[b].empty() || Expression::execute(breakpoints.conditions[b], values) != 0);
+                tracked[i] = value;
+            }
+            else
+            {
+                int64_t value = Expression::execute(breakpoints.conditions[b], values) != 0;
+                matched = value && !tracked[i];
+                tracked[i] = value;
+            }
+
+            if (matched && (hit < 0 || static_cast<int32_t>(b) < hit))
+            {
+                hit = static_cast<int32_t>(b);
+            }
+        }
+
+        return hit;
+    }
+
+    BreakpointRunResult BreakpointRunner::run(
+        const BreakpointSet &breakpoints,
+        const int32_t *inputs,
+        size_t count,
+        const BreakpointWindow &window)
+    {
+        if (breakpoints.edgeFlags.size() != program.graph.edgeCount())
+        {
+            throw std::invalid_argument("Breakpoints were compiled for a different machine");
+        }
+        if (simulator.totalSteps() != syncedSteps)
+        {
+            // The simulator moved on without us
+            resync();
+        }
+
+        BreakpointRunResult result{0, false, -1, {}, 0};
+        int32_t state = simulator.currentState();
+        std::vector<int64_t> values = simulator.variables();
+
+        tracked.assign(breakpoints.stepBreakpoints.size(), 0);
+        for (size_t i = 0; i < breakpoints.stepBreakpoints.size(); i++)
+        {
+            uint32_t b = breakpoints.stepBreakpoints[i];
+            tracked[i] = breakpoints.kinds[b] == BreakpointSpec::Kind::Variable
+                             ? values[breakpoints.watchSlots[b]]
+                             : Expression::execute(breakpoints.conditions[b], values.data()) != 0;
+        }
+
+        const ThreadedMachine *threaded = breakpoints.edgeOnly() ? simulator.threaded() : nullptr;
+        std::vector<int32_t> edges(threaded ? ChunkSteps : 0);
+
+        while (result.steps < count && result.breakpoint < 0 && !result.failed)
+        {
+            // Chunks end on checkpoint boundaries
+            const int32_t *chunkInputs = inputs + result.steps;
+            size_t chunk = std::min<size_t>(count - result.steps, ChunkSteps - consumed % ChunkSteps);
+            size_t taken = 0;
+
+            if (threaded)
+            {
+                int32_t chunkState = state;
+                std::vector<int64_t> chunkValues = values;
+                auto run = threaded->run(chunkState, chunkValues.data(), chunkInputs, chunk, edges.data());
+
+                for (; taken < run.steps; taken++)
+                {
+                    if (breakpoints.edgeFlags[edges[taken]])
+                    {
+                        result.breakpoint = static_cast<int32_t>(breakpoints.edgeBreakpoints[edges[taken]].front());
+                        break;
+                    }
+                }
+
+                if (result.breakpoint >= 0 && taken + 1 < run.steps)
+                {
+                    // Overshot the hit: redo the chunk up to it
+                    threaded->run(state, values.data(), chunkInputs, taken + 1, nullptr);
+                }
+                else
+                {
+                    state = chunkState;
+                    values.swap(chunkValues);
+                    result.failed = result.breakpoint < 0 && run.failed;
+                }
+                if (result.breakpoint >= 0)
+                {
+                    taken++;
+                }
+                if (taken > 0)
+                {
+                    lastEdge = edges[taken - 1];
+                }
+            }
+            else
+            {
+                for (; taken < chunk; taken++)
+                {
+                    int32_t edge = Simulator::step(program, state, values.data(), chunkInputs[taken]);
+                    if (edge < 0)
+                    {
+                        result.failed = true;
+                        break;
+                    }
+                    lastEdge = edge;
+
+                    result.breakpoint = check(breakpoints, edge, values.data());
+                    if (result.breakpoint >= 0)
+                    {
+                        taken++;
+                        break;
+                    }
+                }
+            }
+
+            commit(chunkInputs, taken, state, values);
+            result.steps += taken;
+        }
+
+        simulator.restore(state, values, result.steps + (result.failed ? 1 : 0));
+        syncedSteps = simulator.totalSteps();
+
+        if (result.breakpoint >= 0)
+        {
+            result.context = context(
+                std::min(window.before, ChunkSteps),
+                std::min(window.after, ChunkSteps),
+                inputs + result.steps,
+                count - result.steps,
+                result.hitFrame);
+        }
+        return result;
+    }
+
+    /**
+     * Frames [hit - before, hit + after], replayed from the older checkpoint
+     * and, after the hit, from the inputs left in the batch
+     */
+    std::vector<TraceFrame> BreakpointRunner::context(
+        uint32_t before,
+        uint32_t after,
+        const int32_t *remaining,
+        size_t remainingCount,
+        size_t &hitFrame) const
+    {
+        std::vector<TraceFrame> frames;
+        const uint64_t first = consumed - std::min<uint64_t>(before, consumed - older.step);
+
+        TraceFrame frame{older.step, older.state, older.edge, older.values};
+        for (size_t i = 0;; i++)
+        {
+            if (frame.step >= first)
+            {
+                frames.push_back(frame);
+            }
+            if (i == history.size())
+                break;
+            frame.edge = Simulator::step(program, frame.state, frame.variables.data(), history[i]);
+            frame.step++;
+        }
+        hitFrame = frames.size() - 1;
+
+        for (size_t i = 0; i < std::min<size_t>(after, remainingCount); i++)
+        {
+            int32_t edge = Simulator::step(program, frame.state, frame.variables.data(), remaining[i]);
+            if (edge < 0)
+                break;
+            frame.edge = edge;
+            frame.step++;
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,416 @@
+#include "../include/Checkpoint.h"
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <fstream>
+#include <io.h>
+#include <iterator>
+#include <process.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        constexpr char RecordsMagic[8] = {'R', 'S', 'C', 'K', 'P', 'T', '0', '1'};
+        constexpr char MetaMagic[8] = {'R', 'S', 'C', 'K', 'M', 'E', 'T', '2'};
+
+        // Records file header: magic, model hash, key words
+        constexpr size_t RecordsHeaderSize = 32;
+
+        void putWord(std::string &out, uint64_t value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        void putString(std::string &out, const std::string &value)
+        {
+            putWord(out, value.size());
+            out += value;
+        }
+
+        void putStrings(std::string &out, const std::vector<std::string> &values)
+        {
+            putWord(out, values.size());
+            for (const auto &value : values)
+                putString(out, value);
+        }
+
+        class MetaReader
+        {
+        public:
+            explicit MetaReader(const std::string &data) : data(data) {}
+
+            bool word(uint64_t &value)
+            {
+                if (data.size() - pos < sizeof(value))
+                    return false;
+                std::memcpy(&value, data.data() + pos, sizeof(value));
+                pos += sizeof(value);
+                return true;
+            }
+
+            bool string(std::string &value)
+            {
+                uint64_t length;
+                if (!word(length) || data.size() - pos < length)
+                    return false;
+                value.assign(data, pos, length);
+                pos += length;
+                return true;
+            }
+
+            bool strings(std::vector<std::string> &values)
+            {
+                uint64_t count;
+                if (!word(count) || count > data.size() - pos)
+                    return false;
+                values.resize(count);
+                for (auto &value : values)
+                {
+                    if (!string(value))
+                        return false;
+                }
+                return true;
+            }
+
+            bool done() const { return pos == data.size(); }
+
+        private:
+            const std::string &data;
+            size_t pos = sizeof(MetaMagic);
+        };
+
+        bool readWhole(const std::string &path, std::string &data)
+        {
+            FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                return false;
+            char buffer[65536];
+            size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+                data.append(buffer, read);
+            std::fclose(file);
+            return true;
+        }
+
+        /**
+         * Push written data to the disk, so a commit never precedes its data
+         */
+        bool flush(FILE *file)
+        {
+            if (std::fflush(file) != 0)
+                return false;
+#ifndef _WIN32
+            return fsync(fileno(file)) == 0;
+#else
+            return true;
+#endif
+        }
+
+        /**
+         * Descriptor holding an exclusive lock on path, or -1 when another
+         * holder has it. The lock dies with its process, so a crash leaves
+         * no stale lock behind.
+         */
+        int acquireLock(const std::string &path)
+        {
+#ifndef _WIN32
+            for (;;)
+            {
+                int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+                if (fd < 0)
+                    throw std::runtime_error("Cannot open checkpoint lock " + path);
+                if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+                {
+                    ::close(fd);
+                    return -1;
+                }
+                // The previous holder may have unlinked the file before we locked it
+                struct stat held, current;
+                if (fstat(fd, &held) == 0 && stat(path.c_str(), &current) == 0 && held.st_dev == current.st_dev &&
+                    held.st_ino == current.st_ino)
+                    return fd;
+                ::close(fd);
+            }
+#else
+            // Opened without sharing: nobody else can open it until it is closed
+            int fd = -1;
+            if (_sopen_s(&fd, path.c_str(), _O_RDWR | _O_CREAT, _SH_DENYRW, _S_IREAD | _S_IWRITE) != 0)
+                return -1;
+            return fd;
+#endif
+        }
+
+        void releaseLock(const std::string &path, int fd)
+        {
+            // Unlinked while still held, so the next holder's check sees a new file
+#ifndef _WIN32
+            ::unlink(path.c_str());
+            ::close(fd);
+#else
+            _close(fd);
+            std::remove(path.c_str());
+#endif
+        }
+
+        /**
+         * Unique within the host, for temporary files beside shared ones
+         */
+        std::string uniqueSuffix()
+        {
+            static std::atomic<uint64_t> counter{0};
+#ifndef _WIN32
+            const long pid = static_cast<long>(getpid());
+#else
+            const long pid = static_cast<long>(_getpid());
+#endif
+            return std::to_string(pid) + "-" + std::to_string(counter++);
+        }
+    } // namespace
+
+    ExplorationCheckpoint::ExplorationCheckpoint(const CheckpointOptions &options, const MachineHash &model, uint32_t keyWords,
+                                                 uint32_t eventCount)
+        : model(model), keyWords(keyWords), eventCount(eventCount), interval(options.interval),
+          recordsPath(options.directory + "/" + model.hex() + ".ckpt"), metaPath(recordsPath + ".meta"),
+          lockPath(recordsPath + ".lock"), lock(acquireLock(lockPath)), next(Clock::now() + options.interval)
+    {
+    }
+
+    ExplorationCheckpoint::~ExplorationCheckpoint()
+    {
+        if (records)
+            std::fclose(records);
+        if (lock >= 0)
+            releaseLock(lockPath, lock);
+    }
+
+    void ExplorationCheckpoint::discard()
+    {
+        if (records)
+        {
+            std::fclose(records);
+            records = nullptr;
+        }
+        // Meta first: records without a commit are ignored by load
+        std::remove(metaPath.c_str());
+        std::remove(recordsPath.c_str());
+    }
+
+    bool ExplorationCheckpoint::load(State &state, const Visit &visit)
+    {
+        if (!readMeta(state))
+        {
+            // Records without a commit are from a run that never saved
+            openRecords(true);
+            return false;
+        }
+
+        const size_t size = RecordsHeaderSize + state.committed * recordSize();
+        const uint8_t *base = nullptr;
+#ifndef _WIN32
+        int fd = ::open(recordsPath.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < size)
+        {
+            if (fd >= 0)
+                ::close(fd);
+            throw std::runtime_error("Checkpoint records missing or truncated: " + recordsPath);
+        }
+        void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED)
+            throw std::runtime_error("Cannot map checkpoint " + recordsPath);
+        base = static_cast<const uint8_t *>(address);
+#else
+        std::ifstream file(recordsPath, std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (contents.size() < size)
+            throw std::runtime_error("Checkpoint records missing or truncated: " + recordsPath);
+        base = reinterpret_cast<const uint8_t *>(contents.data());
+#endif
+
+        uint64_t header[4];
+        std::memcpy(header, base, sizeof(header));
+        bool valid = std::memcmp(base, RecordsMagic, sizeof(RecordsMagic)) == 0 && header[1] == model.high &&
+                     header[2] == model.low && header[3] == keyWords;
+        bool linked = true;
+        if (valid)
+        {
+            std::vector<uint64_t> key(keyWords);
+            for (uint64_t i = 0; i < state.committed; i++)
+            {
+                const uint8_t *record = base + RecordsHeaderSize + i * recordSize();
+                uint32_t parent;
+                int32_t event;
+                std::memcpy(key.data(), record, keyWords * sizeof(uint64_t));
+                std::memcpy(&parent, record + keyWords * sizeof(uint64_t), sizeof(parent));
+                std::memcpy(&event, record + keyWords * sizeof(uint64_t) + sizeof(parent), sizeof(event));
+                // Initial configurations have no parent and no event; any
+                // other record continues an earlier one by one of the events
+                linked = parent == UINT32_MAX ? event == Statechart::NoEvent
+                                              : parent < i && event >= 0 && static_cast<uint32_t>(event) < eventCount;
+                if (!linked)
+                    break;
+                visit(key.data(), parent, event);
+            }
+        }
+#ifndef _WIN32
+        munmap(const_cast<uint8_t *>(base), size);
+#endif
+        if (!valid)
+            throw std::runtime_error("Checkpoint records belong to another model: " + recordsPath);
+        if (!linked)
+            throw std::runtime_error("Corrupt checkpoint: " + recordsPath);
+
+        openRecords(false);
+        return true;
+    }
+
+    void ExplorationCheckpoint::save(State &state, size_t count, const uint64_t *keys, const uint32_t *parents,
+                                     const int32_t *events)
+    {
+        std::string out;
+        out.reserve((count - state.committed) * recordSize());
+        for (size_t i = state.committed; i < count; i++)
+        {
+            out.append(reinterpret_cast<const char *>(keys + i * keyWords), keyWords * sizeof(uint64_t));
+            out.append(reinterpret_cast<const char *>(parents + i), sizeof(uint32_t));
+            out.append(reinterpret_cast<const char *>(events + i), sizeof(int32_t));
+        }
+
+        const long offset = static_cast<long>(RecordsHeaderSize + state.committed * recordSize());
+        if (!records || std::fseek(records, offset, SEEK_SET) != 0 ||
+            std::fwrite(out.data(), 1, out.size(), records) != out.size() || !flush(records))
+        {
+            throw std::runtime_error("Cannot write checkpoint " + recordsPath);
+        }
+
+        state.committed = count;
+        writeMeta(state);
+        next = Clock::now() + interval;
+    }
+
+    /**
+     * Open the records file for appending, writing a fresh header when
+     * truncating
+     */
+    void ExplorationCheckpoint::openRecords(bool truncate)
+    {
+        records = std::fopen(recordsPath.c_str(), truncate ? "w+b" : "r+b");
+        if (!records)
+            throw std::runtime_error("Cannot open checkpoint " + recordsPath);
+        if (truncate)
+        {
+            std::string header(RecordsMagic, sizeof(RecordsMagic));
+            putWord(header, model.high);
+            putWord(header, model.low);
+            putWord(header, keyWords);
+            if (std::fwrite(header.data(), 1, header.size(), records) != header.size() || !flush(records))
+                throw std::runtime_error("Cannot write checkpoint " + recordsPath);
+        }
+    }
+
+    /**
+     * A missing meta file means no checkpoint; a foreign or damaged one is
+     * an error, since silently starting over would discard hours of work
+     */
+    bool ExplorationCheckpoint::readMeta(State &state) const
+    {
+        std::string data;
+        if (!readWhole(metaPath, data))
+            return false;
+        if (data.size() < sizeof(MetaMagic) || std::memcmp(data.data(), MetaMagic, sizeof(MetaMagic)) != 0)
+            throw std::runtime_error("Not a checkpoint: " + metaPath);
+
+        MetaReader reader(data);
+        uint64_t high, low, words, elapsed, complete, stopReason, enteredCount, deadlockCount;
+        State loaded;
+        StatechartReport &report = loaded.report;
+        bool ok = reader.word(high) && reader.word(low) && reader.word(words) && reader.word(loaded.committed) &&
+                  reader.word(loaded.expanded) && reader.word(loaded.divergent) && reader.word(elapsed) &&
+                  reader.word(report.macrosteps) && reader.word(report.terminalConfigurations) &&
+                  reader.word(report.deadlockCount) && reader.word(complete) && reader.word(stopReason) &&
+                  reader.word(report.frontier) && reader.word(enteredCount) && enteredCount <= data.size();
+        if (ok && (high != model.high || low != model.low || words != keyWords))
+            throw std::runtime_error("Checkpoint belongs to another model: " + metaPath);
+
+        loaded.entered.resize(ok ? enteredCount : 0);
+        for (size_t i = 0; ok && i < loaded.entered.size(); i++)
+            ok = reader.word(loaded.entered[i]);
+        ok = ok && reader.word(deadlockCount) && deadlockCount <= data.size();
+        report.deadlocks.resize(ok ? deadlockCount : 0);
+        for (size_t i = 0; ok && i < report.deadlocks.size(); i++)
+            ok = reader.strings(report.deadlocks[i]);
+        ok = ok && reader.strings(report.deadlockPath) && reader.strings(report.deadlockedStates) && reader.done() &&
+             loaded.expanded <= loaded.committed &&
+             stopReason <= static_cast<uint64_t>(StopReason::ConfigurationLimit);
+        if (!ok)
+            throw std::runtime_error("Corrupt checkpoint: " + metaPath);
+
+        std::memcpy(&loaded.elapsedMs, &elapsed, sizeof(elapsed));
+        report.complete = complete != 0;
+        report.stopReason = static_cast<StopReason>(stopReason);
+        state = std::move(loaded);
+        return true;
+    }
+
+    /**
+     * Written beside the target and renamed, so a crash leaves the previous
+     * commit in place
+     */
+    void ExplorationCheckpoint::writeMeta(const State &state) const
+    {
+        const StatechartReport &report = state.report;
+        uint64_t elapsed;
+        std::memcpy(&elapsed, &state.elapsedMs, sizeof(elapsed));
+
+        std::string out(MetaMagic, sizeof(MetaMagic));
+        putWord(out, model.high);
+        putWord(out, model.low);
+        putWord(out, keyWords);
+        putWord(out, state.committed);
+        putWord(out, state.expanded);
+        putWord(out, state.divergent);
+        putWord(out, elapsed);
+        putWord(out, report.macrosteps);
+        putWord(out, report.terminalConfigurations);
+        putWord(out, report.deadlockCount);
+        putWord(out, report.complete ? 1 : 0);
+        putWord(out, static_cast<uint64_t>(report.stopReason));
+        putWord(out, report.frontier);
+        putWord(out, state.entered.size());
+        for (uint64_t word : state.entered)
+            putWord(out, word);
+        putWord(out, report.deadlocks.size());
+        for (const auto &deadlock : report.deadlocks)
+            putStrings(out, deadlock);
+        putStrings(out, report.deadlockPath);
+        putStrings(out, report.deadlockedStates);
+
+        const std::string temporary = metaPath + "." + uniqueSuffix() + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file)
+            throw std::runtime_error("Cannot write checkpoint " + metaPath);
+        bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size() && flush(file);
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(temporary.c_str(), metaPath.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write checkpoint " + metaPath);
+        }
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,479 @@
+#include "../include/CodeGenerator.h"
+#include "../include/Simulator.h"
+#include <cctype>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        const std::unordered_set<std::string> &reservedWords()
+        {
+            static const std::unordered_set<std::string> words = {
+                "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+                "case", "catch", "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr",
+                "const_cast", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+                "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+                "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+                "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register",
+                "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert",
+                "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true",
+                "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+                "volatile", "wchar_t", "while", "xor", "xor_eq", "NULL", "INT64_C", "INT64_MIN"};
+            return words;
+        }
+
+        /**
+         * Assigns unique identifiers within one scope (enum or struct)
+         */
+        class IdentifierScope
+        {
+        public:
+            explicit IdentifierScope(std::initializer_list<std::string> taken = {})
+                : used(taken) {}
+
+            std::string add(const std::string &label, const std::string &fallback)
+            {
+                std::string base = CodeGenerator::toIdentifier(label, fallback);
+                std::string name = base;
+                for (int suffix = 2; !used.insert(name).second; suffix++)
+                {
+                    name = base + "_" + std::to_string(suffix);
+                }
+                return name;
+            }
+
+        private:
+            std::unordered_set<std::string> used;
+        };
+
+        std::string int64Literal(int64_t value)
+        {
+            return value == INT64_MIN ? "INT64_MIN" : "INT64_C(" + std::to_string(value) + ")";
+        }
+
+        std::string quoteComment(const std::string &text)
+        {
+            std::string quoted;
+            for (char c : text)
+            {
+                quoted += (c == '\n' || c == '\r') ? ' ' : c;
+            }
+            return quoted;
+        }
+
+        /**
+         * Random walks through the reference simulator, biased towards inputs
+         * that have a transition from the current state
+         */
+        struct ConformanceTrace
+        {
+            std::vector<uint32_t> inputs;
+            std::vector<uint8_t> fired;
+            std::vector<uint32_t> states;
+            std::vector<uint32_t> outputs;
+            std::vector<uint32_t> sequenceEnds;
+            std::vector<int64_t> finalVariables;
+        };
+
+        ConformanceTrace recordConformanceTrace(const MachineProgram &program, const CodeGenOptions &options)
+        {
+            ConformanceTrace trace;
+            const CompiledMachine &graph = program.graph;
+            if (graph.inputCount() == 0 || graph.initialState < 0)
+            {
+                return trace;
+            }
+
+            std::mt19937 rng(options.conformanceSeed);
+            Simulator simulator(program);
+
+            for (uint32_t sequence = 0; sequence < options.conformanceSequences; sequence++)
+            {
+                simulator.reset();
+                for (uint32_t i = 0; i < options.conformanceLength; i++)
+                {
+                    int32_t state = simulator.currentState();
+                    uint32_t first = graph.edgeOffsets[state];
+                    uint32_t degree = graph.edgeOffsets[state + 1] - first;
+
+                    int32_t input = -1;
+                    if (degree > 0 && rng() % 4 != 0)
+                    {
+                        input = graph.edgeInputs[first + rng() % degree];
+                    }
+                    if (input < 0)
+                    {
+                        input = static_cast<int32_t>(rng() % graph.inputCount());
+                    }
+
+                    int32_t edge = simulator.step(input);
+                    trace.inputs.push_back(static_cast<uint32_t>(input));
+                    trace.fired.push_back(edge >= 0 ? 1 : 0);
+                    trace.states.push_back(static_cast<uint32_t>(simulator.currentState()));
+                    trace.outputs.push_back(edge >= 0 ? static_cast<uint32_t>(graph.edgeOutputs[edge] + 1) : 0);
+                }
+                trace.sequenceEnds.push_back(static_cast<uint32_t>(trace.inputs.size()));
+                const auto &values = simulator.variables();
+                trace.finalVariables.insert(trace.finalVariables.end(), values.begin(), values.end());
+            }
+            return trace;
+        }
+
+        template <typename T>
+        void writeArray(std::ostringstream &out, const char *type, const char *name, const std::vector<T> &values)
+        {
+            out << "    static const " << type << " " << name << "[] = {";
+            if (values.empty())
+            {
+                out << "0";
+            }
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                out << (i % 16 == 0 ? "\n        " : " ");
+                if (std::is_same<T, int64_t>::value)
+                    out << int64Literal(static_cast<int64_t>(values[i]));
+                else
+                    out << +values[i];
+                out << ",";
+            }
+            out << "};\n";
+        }
+    } // namespace
+
+    std::string CodeGenerator::toIdentifier(const std::string &label, const std::string &fallback)
+    {
+        std::string identifier;
+        bool pendingUnderscore = false;
+        for (char c : label)
+        {
+            if (std::isalnum(static_cast<unsigned char>(c)))
+            {
+                if (pendingUnderscore && !identifier.empty())
+                {
+                    identifier += '_';
+                }
+                pendingUnderscore = false;
+                identifier += c;
+            }
+            else
+            {
+                pendingUnderscore = true;
+            }
+        }
+
+        if (identifier.empty())
+        {
+            return fallback;
+        }
+        if (std::isdigit(static_cast<unsigned char>(identifier[0])))
+        {
+            identifier = fallback + "_" + identifier;
+        }
+        if (reservedWords().count(identifier))
+        {
+            identifier += "_";
+        }
+        return identifier;
+    }
+
+    /**
+     * Emit the header and conformance test
+     */
+    GeneratedCode CodeGenerator::generate(const StateMachine &machine, const CodeGenOptions &options)
+    {
+        MachineProgram program = MachineProgram::compile(machine);
+        const CompiledMachine &graph = program.graph;
+
+        if (graph.stateCount() == 0)
+        {
+            throw std::invalid_argument("Cannot generate code for a machine without states");
+        }
+        if (graph.initialState < 0)
+        {
+            throw std::invalid_argument("Cannot generate code for a machine without an initial state");
+        }
+
+        const std::string className = options.className.empty()
+                                          ? toIdentifier(machine.name, "Machine")
+                                          : toIdentifier(options.className, "Machine");
+        const std::string namespaceName = toIdentifier(options.namespaceName, "generated");
+        if (className == "State" || className == "Input" || className == "Output" || className == "Variables")
+        {
+            throw std::invalid_argument("Class name '" + className + "' clashes with a generated member");
+        }
+
+        // Identifiers for every enum member and variable
+        IdentifierScope stateScope, inputScope;
+        IdentifierScope variableScope({"Variables"});
+        IdentifierScope outputScope({"None"});
+        std::vector<std::string> stateNames, inputNames, outputNames, variableNames;
+        for (size_t s = 0; s < graph.stateCount(); s++)
+            stateNames.push_back(stateScope.add(graph.stateNames[s], "State"));
+        for (const auto &input : graph.inputSymbols)
+            inputNames.push_back(inputScope.add(input, "Input"));
+        for (const auto &output : graph.outputSymbols)
+            outputNames.push_back(outputScope.add(output, "Output"));
+        for (size_t v = 0; v < program.variables.size(); v++)
+            variableNames.push_back(variableScope.add(program.variables.name(v), "var"));
+
+        bool useTable = graph.inputCount() > 0 && !program.hasGuardsOrActions();
+        if (options.dispatch == CodeGenOptions::Dispatch::Switch || graph.inputCount() == 0)
+        {
+            useTable = false;
+        }
+        else if (options.dispatch == CodeGenOptions::Dispatch::Table && program.hasGuardsOrActions())
+        {
+            throw std::invalid_argument("Table dispatch requires a machine without guards or actions");
+        }
+
+        std::ostringstream out;
+        out << "// Generated by Reactive System Modeler from machine \"" << quoteComment(machine.name) << "\" ("
+            << quoteComment(machine.id) << ").\n"
+            << "// Do not edit: regenerate from the model instead.\n"
+            << "#pragma once\n\n"
+            << "#include <cstdint>\n\n"
+            << "#ifndef RSM_GENERATED_ARITHMETIC\n"
+            << "#define RSM_GENERATED_ARITHMETIC\n"
+            << "namespace rsm_detail\n{\n"
+            << "    // Wrapping arithmetic; division and modulo by zero yield 0\n"
+            << "    constexpr int64_t add(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }\n"
+            << "    constexpr int64_t sub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }\n"
+            << "    constexpr int64_t mul(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)); }\n"
+            << "    constexpr int64_t div(int64_t a, int64_t b) { return b == 0 ? 0 : (b == -1 ? sub(0, a) : a / b); }\n"
+            << "    constexpr int64_t mod(int64_t a, int64_t b) { return (b == 0 || b == -1) ? 0 : a % b; }\n"
+            << "} // namespace rsm_detail\n"
+            << "#endif\n\n"
+            << "namespace " << namespaceName << "\n{\n"
+            << "    namespace detail = ::rsm_detail;\n\n"
+            << "    class " << className << "\n    {\n    public:\n";
+
+        out << "        enum class State : uint32_t\n        {\n";
+        for (const auto &name : stateNames)
+            out << "            " << name << ",\n";
+        out << "        };\n\n";
+
+        out << "        enum class Input : uint32_t\n        {\n";
+        for (const auto &name : inputNames)
+            out << "            " << name << ",\n";
+        out << "        };\n\n";
+
+        out << "        enum class Output : uint32_t\n        {\n            None,\n";
+        for (const auto &name : outputNames)
+            out << "            " << name << ",\n";
+        out << "        };\n\n";
+
+        out << "        static constexpr uint32_t StateCount = " << graph.stateCount() << ";\n"
+            << "        static constexpr uint32_t InputCount = " << graph.inputCount() << ";\n"
+            << "        static constexpr uint32_t OutputCount = " << graph.outputCount() + 1 << ";\n\n";
+
+        out << "        struct Variables\n        {\n";
+        for (size_t v = 0; v < variableNames.size(); v++)
+        {
+            out << "            int64_t " << variableNames[v] << " = " << int64Literal(program.variables.initialValues()[v]) << ";\n";
+        }
+        out << "        };\n\n";
+
+        out << "        constexpr " << className << "() = default;\n\n"
+            << "        constexpr void reset() { *this = " << className << "(); }\n"
+            << "        constexpr State state() const { return state_; }\n"
+            << "        constexpr const Variables &variables() const { return vars_; }\n\n"
+            << "        constexpr bool isFinal() const\n        {\n"
+            << "            switch (state_)\n            {\n";
+        bool anyFinal = false;
+        for (size_t s = 0; s < graph.stateCount(); s++)
+        {
+            if (graph.finalStates[s])
+            {
+                out << "            case State::" << stateNames[s] << ":\n";
+                anyFinal = true;
+            }
+        }
+        if (anyFinal)
+            out << "                return true;\n";
+        out << "            default:\n                return false;\n            }\n        }\n\n";
+
+        out << "        /**\n"
+            << "         * Fire the first enabled transition for input. Returns false and\n"
+            << "         * leaves the machine unchanged when none is enabled.\n"
+            << "         */\n"
+            << "        constexpr bool step(Input input, [[maybe_unused]] Output *output = nullptr) noexcept\n        {\n";
+
+        if (useTable)
+        {
+            out << "            if (static_cast<uint32_t>(input) >= InputCount)\n"
+                << "                return false;\n"
+                << "            const Entry &entry = kTransitions[static_cast<uint32_t>(state_)][static_cast<uint32_t>(input)];\n"
+                << "            if (entry.next == StateCount)\n"
+                << "                return false;\n"
+                << "            state_ = static_cast<State>(entry.next);\n"
+                << "            if (output)\n"
+                << "                *output = static_cast<Output>(entry.output);\n"
+                << "            return true;\n"
+                << "        }\n\n";
+        }
+        else
+        {
+            out << "            switch (state_)\n            {\n";
+            for (size_t s = 0; s < graph.stateCount(); s++)
+            {
+                out << "            case State::" << stateNames[s] << ":\n"
+                    << "                switch (input)\n                {\n";
+
+                // Group edges by input, keeping declaration order within a group
+                std::vector<std::vector<uint32_t>> byInput(graph.inputCount());
+                std::vector<int32_t> inputOrder;
+                for (uint32_t e = graph.edgeOffsets[s]; e < graph.edgeOffsets[s + 1]; e++)
+                {
+                    int32_t input = graph.edgeInputs[e];
+                    if (input == CompiledMachine::NoInput)
+                        continue;
+                    if (byInput[input].empty())
+                        inputOrder.push_back(input);
+                    byInput[input].push_back(e);
+                }
+
+                for (int32_t input : inputOrder)
+                {
+                    out << "                case Input::" << inputNames[input] << ":\n";
+                    bool terminated = false;
+                    for (uint32_t e : byInput[input])
+                    {
+                        const bool guarded = program.edgeGuardTrees[e] != nullptr;
+                        const std::string indent = guarded ? "                    " : "                ";
+                        const Transition &transition = machine.transitions[graph.edgeTransitions[e]];
+
+                        out << "                    // " << quoteComment(transition.id) << "\n";
+                        if (guarded)
+                        {
+                            out << "                    if ("
+                                << Expression::toCpp(program.edgeGuardTrees[e].get(), variableNames, "vars_.")
+                                << " != 0)\n                    {\n";
+                        }
+                        for (const auto &assignment : program.edgeActionTrees[e])
+                        {
+                            out << indent << "    vars_." << variableNames[assignment.variable] << " = "
+                                << Expression::toCpp(assignment.value.get(), variableNames, "vars_.") << ";\n";
+                        }
+                        int32_t outputIndex = graph.edgeOutputs[e];
+                        out << indent << "    state_ = State::" << stateNames[graph.edgeTargets[e]] << ";\n"
+                            << indent << "    if (output)\n"
+                            << indent << "        *output = Output::"
+                            << (outputIndex < 0 ? std::string("None") : outputNames[outputIndex]) << ";\n"
+                            << indent << "    return true;\n";
+                        if (!guarded)
+                        {
+                            // Later transitions for this input can never fire
+                            terminated = true;
+                            break;
+                        }
+                        out << "                    }\n";
+                    }
+                    if (!terminated)
+                    {
+                        out << "                    return false;\n";
+                    }
+                }
+                out << "                default:\n                    return false;\n                }\n";
+            }
+            out << "            }\n            return false;\n        }\n\n";
+        }
+
+        out << "    private:\n";
+        if (useTable)
+        {
+            out << "        struct Entry\n        {\n            uint32_t next;\n            uint32_t output;\n        };\n\n"
+                << "        // kTransitions[state][input]; next == StateCount means no transition\n"
+                << "        static constexpr Entry kTransitions[StateCount][InputCount] = {\n";
+            for (size_t s = 0; s < graph.stateCount(); s++)
+            {
+                std::vector<int64_t> next(graph.inputCount(), -1);
+                std::vector<uint32_t> output(graph.inputCount(), 0);
+                for (uint32_t e = graph.edgeOffsets[s]; e < graph.edgeOffsets[s + 1]; e++)
+                {
+                    int32_t input = graph.edgeInputs[e];
+                    if (input != CompiledMachine::NoInput && next[input] < 0)
+                    {
+                        next[input] = graph.edgeTargets[e];
+                        output[input] = static_cast<uint32_t>(graph.edgeOutputs[e] + 1);
+                    }
+                }
+                out << "            {";
+                for (size_t i = 0; i < graph.inputCount(); i++)
+                {
+                    out << (i ? ", " : "") << "{" << (next[i] < 0 ? graph.stateCount() : static_cast<size_t>(next[i]))
+                        << ", " << output[i] << "}";
+                }
+                out << "}, // " << stateNames[s] << "\n";
+            }
+            out << "        };\n\n";
+        }
+        out << "        State state_ = State::" << stateNames[graph.initialState] << ";\n"
+            << "        Variables vars_{};\n"
+            << "    };\n\n"
+            << "} // namespace " << namespaceName << "\n";
+
+        GeneratedCode code;
+        code.headerName = className + ".h";
+        code.header = out.str();
+
+        // Conformance harness
+        ConformanceTrace trace = recordConformanceTrace(program, options);
+        std::ostringstream test;
+        test << "// Conformance test for " << code.headerName << ", recorded from the reference simulator.\n"
+             << "#include \"" << code.headerName << "\"\n"
+             << "#include <cstdio>\n\n"
+             << "int main()\n{\n";
+        if (trace.sequenceEnds.empty())
+        {
+            // Without inputs there is nothing to replay
+            test << "    std::printf(\"" << code.headerName << ": 0 steps conform\\n\");\n"
+                 << "    return 0;\n}\n";
+            code.conformanceTest = test.str();
+            return code;
+        }
+
+        test << "    using Machine = " << namespaceName << "::" << className << ";\n\n";
+        writeArray(test, "uint32_t", "kInputs", trace.inputs);
+        writeArray(test, "uint8_t", "kFired", trace.fired);
+        writeArray(test, "uint32_t", "kStates", trace.states);
+        writeArray(test, "uint32_t", "kOutputs", trace.outputs);
+        writeArray(test, "uint32_t", "kSequenceEnds", trace.sequenceEnds);
+        if (!variableNames.empty())
+            writeArray(test, "int64_t", "kFinalVariables", trace.finalVariables);
+        test << "\n    size_t position = 0;\n"
+             << "    for (size_t sequence = 0; sequence < " << trace.sequenceEnds.size() << "; sequence++)\n    {\n"
+             << "        Machine machine;\n"
+             << "        for (; position < kSequenceEnds[sequence]; position++)\n        {\n"
+             << "            Machine::Output output = Machine::Output::None;\n"
+             << "            bool fired = machine.step(static_cast<Machine::Input>(kInputs[position]), &output);\n"
+             << "            if (fired != (kFired[position] != 0) ||\n"
+             << "                static_cast<uint32_t>(machine.state()) != kStates[position] ||\n"
+             << "                static_cast<uint32_t>(output) != kOutputs[position])\n            {\n"
+             << "                std::printf(\"Mismatch at sequence %zu, step %zu\\n\", sequence, position);\n"
+             << "                return 1;\n            }\n        }\n";
+        if (!variableNames.empty())
+        {
+            test << "\n        const Machine::Variables &variables = machine.variables();\n"
+                 << "        const int64_t *expected = &kFinalVariables[sequence * " << variableNames.size() << "];\n";
+        }
+        for (size_t v = 0; v < variableNames.size(); v++)
+        {
+            test << "        if (variables." << variableNames[v] << " != expected[" << v << "])\n        {\n"
+                 << "            std::printf(\"Variable " << variableNames[v] << " differs after sequence %zu\\n\", sequence);\n"
+                 << "            return 1;\n        }\n";
+        }
+        test << "    }\n\n"
+             << "    std::printf(\"" << code.headerName << ": %zu steps conform\\n\", position);\n"
+             << "    return 0;\n}\n";
+        code.conformanceTest = test.str();
+
+        return code;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,128 @@
+#include "../include/CompiledMachine.h"
+#include "../include/Trace.h"
+
+namespace ReactiveSystem
+{
+
+    int32_t CompiledMachine::findState(const std::string &stateId) const
+    {
+        auto it = stateIndex.find(stateId);
+        return it == stateIndex.end() ? -1 : static_cast<int32_t>(it->second);
+    }
+
+    int32_t CompiledMachine::findInput(const std::string &input) const
+    {
+        auto it = inputIndex.find(input);
+        return it == inputIndex.end() ? -1 : static_cast<int32_t>(it->second);
+    }
+
+    namespace
+    {
+        int32_t intern(
+            const std::string &symbol,
+            std::vector<std::string> &symbols,
+            std::unordered_map<std::string, uint32_t> &index)
+        {
+            auto inserted = index.emplace(symbol, static_cast<uint32_t>(symbols.size()));
+            if (inserted.second)
+            {
+                symbols.push_back(symbol);
+            }
+            return static_cast<int32_t>(inserted.first->second);
+        }
+    } // namespace
+
+    /**
+     * Intern states and labels, then bucket transitions by source state
+     */
+    CompiledMachine CompiledMachine::compile(const StateMachine &machine)
+    {
+        RSM_TRACE_SPAN("CompiledMachine::compile");
+        CompiledMachine compiled;
+        const size_t stateCount = machine.states.size();
+
+        compiled.stateIds.reserve(stateCount);
+        compiled.stateNames.reserve(stateCount);
+        compiled.finalStates.reserve(stateCount);
+        compiled.stateIndex.reserve(stateCount);
+
+        for (const auto &state : machine.states)
+        {
+            // Duplicate ids keep the first occurrence, like the JS lookups do
+            if (!compiled.stateIndex.emplace(state.id, static_cast<uint32_t>(compiled.stateIds.size())).second)
+            {
+                continue;
+            }
+            if (state.isInitial && compiled.initialState < 0)
+            {
+                compiled.initialState = static_cast<int32_t>(compiled.stateIds.size());
+            }
+            compiled.stateIds.push_back(state.id);
+            compiled.stateNames.push_back(state.name);
+            compiled.finalStates.push_back(state.isFinal ? 1 : 0);
+        }
+
+        // First pass: resolve endpoints and count out-degrees
+        struct ResolvedEdge
+        {
+            uint32_t from;
+            uint32_t to;
+            int32_t input;
+            int32_t output;
+        };
+        std::vector<ResolvedEdge> resolved(machine.transitions.size());
+        std::vector<uint8_t> valid(machine.transitions.size(), 0);
+        compiled.edgeOffsets.assign(compiled.stateIds.size() + 1, 0);
+
+        for (size_t i = 0; i < machine.transitions.size(); i++)
+        {
+            const auto &transition = machine.transitions[i];
+            int32_t from = compiled.findState(transition.from);
+            int32_t to = compiled.findState(transition.to);
+            if (from < 0 || to < 0)
+            {
+                continue;
+            }
+
+            int32_t input = transition.input.empty()
+                                ? NoInput
+                                : intern(transition.input, compiled.inputSymbols, compiled.inputIndex);
+            int32_t output = transition.output.empty()
+                                 ? NoOutput
+                                 : intern(transition.output, compiled.outputSymbols, compiled.outputIndex);
+
+            resolved[i] = {static_cast<uint32_t>(from), static_cast<uint32_t>(to), input, output};
+            valid[i] = 1;
+            compiled.edgeOffsets[from + 1]++;
+        }
+
+        for (size_t s = 0; s < compiled.stateIds.size(); s++)
+        {
+            compiled.edgeOffsets[s + 1] += compiled.edgeOffsets[s];
+        }
+
+        // Second pass: scatter edges, preserving declaration order per state
+        const size_t edgeCount = compiled.edgeOffsets.back();
+        compiled.edgeTargets.resize(edgeCount);
+        compiled.edgeInputs.resize(edgeCount);
+        compiled.edgeOutputs.resize(edgeCount);
+        compiled.edgeTransitions.resize(edgeCount);
+
+        std::vector<uint32_t> cursor(compiled.edgeOffsets.begin(), compiled.edgeOffsets.end() - 1);
+        for (size_t i = 0; i < resolved.size(); i++)
+        {
+            if (!valid[i])
+            {
+                continue;
+            }
+            uint32_t slot = cursor[resolved[i].from]++;
+            compiled.edgeTargets[slot] = resolved[i].to;
+            compiled.edgeInputs[slot] = resolved[i].input;
+            compiled.edgeOutputs[slot] = resolved[i].output;
+            compiled.edgeTransitions[slot] = static_cast<uint32_t>(i);
+        }
+
+        return compiled;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,87 @@
+#include "../include/ConcurrentStateSet.h"
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        uint64_t hashKey(const uint64_t *key, size_t keyWords)
+        {
+            uint64_t h = 0x9E3779B97F4A7C15ull;
+            for (size_t w = 0; w < keyWords; w++)
+            {
+                h = (h ^ key[w]) * 0xBF58476D1CE4E5B9ull;
+                h ^= h >> 29;
+            }
+            return h;
+        }
+    } // namespace
+
+    ConcurrentStateSet::ConcurrentStateSet(size_t keyWords, size_t capacity)
+        : keyWords(keyWords), maxStates(capacity), slotCount(16)
+    {
+        // Checked before sizing, as doubling a larger capacity could overflow
+        if (capacity > MaxCapacity)
+            throw std::invalid_argument("State set capacity too large");
+
+        // At most half full, so probe sequences stay short
+        while (slotCount < capacity * 2)
+            slotCount *= 2;
+
+        // Empty and uncoloured are all-zero
+        tags.reset(static_cast<std::atomic<uint64_t> *>(std::calloc(slotCount, sizeof(std::atomic<uint64_t>))));
+        colors.reset(static_cast<std::atomic<uint8_t> *>(std::calloc(slotCount, sizeof(std::atomic<uint8_t>))));
+        if (!tags || !colors)
+            throw std::bad_alloc();
+        keys.reset(new uint64_t[slotCount * keyWords]);
+        parents.reset(new uint32_t[slotCount]);
+        events.reset(new int32_t[slotCount]);
+    }
+
+    size_t ConcurrentStateSet::bytesPerState(size_t keyWords)
+    {
+        return 2 * (sizeof(uint64_t) * (keyWords + 1) + sizeof(uint32_t) + sizeof(int32_t) + sizeof(uint8_t));
+    }
+
+    ConcurrentStateSet::Insertion ConcurrentStateSet::insert(const uint64_t *key, uint32_t parent, int32_t event)
+    {
+        const uint64_t h = hashKey(key, keyWords);
+        // Never Empty or Busy
+        const uint64_t tag = h | 2;
+        const size_t mask = slotCount - 1;
+        const size_t keyBytes = keyWords * sizeof(uint64_t);
+
+        for (size_t slot = h & mask, probes = 0; probes < slotCount; slot = (slot + 1) & mask, probes++)
+        {
+            std::atomic<uint64_t> &cell = tags[slot];
+            uint64_t current = cell.load(std::memory_order_acquire);
+            if (current == Empty)
+            {
+                if (count.load(std::memory_order_relaxed) >= maxStates)
+                    throw StateSetFull();
+                if (cell.compare_exchange_strong(current, Busy, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    std::memcpy(keys.get() + slot * keyWords, key, keyBytes);
+                    parents[slot] = parent;
+                    events[slot] = event;
+                    count.fetch_add(1, std::memory_order_relaxed);
+                    cell.store(tag, std::memory_order_release);
+                    return {static_cast<uint32_t>(slot), true};
+                }
+                // Lost the slot; current holds the winner's tag
+            }
+            while (current == Busy)
+            {
+                std::this_thread::yield();
+                current = cell.load(std::memory_order_acquire);
+            }
+            if (current == tag && std::memcmp(keys.get() + slot * keyWords, key, keyBytes) == 0)
+                return {static_cast<uint32_t>(slot), false};
+        }
+        throw StateSetFull();
+    }
+
+} // namespace ReactiveSystem
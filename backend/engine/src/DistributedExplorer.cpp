@@ -0,0 +1,616 @@
+#include "../include/DistributedExplorer.h"
+#include "../include/Cancellation.h"
+#include "../include/ConcurrentStateSet.h"
+#include "../include/Progress.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace ReactiveSystem
+{
+
+#ifndef _WIN32
+    namespace
+    {
+        constexpr int Running = -1;
+        constexpr size_t ErrorLength = 256;
+        // Configurations a worker expands between looking at its inbox
+        constexpr int ExpandBatch = 64;
+        constexpr auto CoordinatorPoll = std::chrono::milliseconds(1);
+        constexpr auto IdlePause = std::chrono::microseconds(50);
+
+        /**
+         * Owner of a configuration. Seeded apart from ConcurrentStateSet's
+         * hash, so a partition does not crowd into a fraction of its table.
+         */
+        uint32_t ownerOf(const uint64_t *key, size_t keyWords, unsigned workers)
+        {
+            uint64_t h = 0xD6E8FEB86659FD93ull;
+            for (size_t w = 0; w < keyWords; w++)
+            {
+                h = (h ^ key[w]) * 0x94D049BB133111EBull;
+                h ^= h >> 32;
+            }
+            return static_cast<uint32_t>(h % workers);
+        }
+
+        struct Control
+        {
+            // Running, or the StopReason all workers stop for (None once
+            // termination is detected)
+            std::atomic<int> stop;
+            std::atomic<uint64_t> configurations;
+        };
+
+        /**
+         * One worker's counters, read by the coordinator while it runs,
+         * then its results, written once before it exits
+         */
+        struct alignas(64) WorkerSlot
+        {
+            std::atomic<uint32_t> idle;
+            std::atomic<uint64_t> sent;
+            std::atomic<uint64_t> received;
+            std::atomic<uint64_t> owned;
+            std::atomic<uint64_t> expanded;
+            std::atomic<uint64_t> bytes;
+
+            uint64_t macrosteps;
+            uint64_t terminal;
+            uint64_t deadlockCount;
+            uint64_t divergent;
+            uint64_t frontier;
+            uint32_t reportedDeadlocks;
+            char error[ErrorLength];
+        };
+
+        /**
+         * Single-producer single-consumer ring of key words in shared
+         * memory. Batches are pushed whole or not at all.
+         */
+        class Ring
+        {
+        public:
+            Ring(void *at, size_t words) : header(static_cast<Header *>(at)), mask(words - 1),
+                                           words(reinterpret_cast<uint64_t *>(header + 1)) {}
+
+            static size_t bytesFor(size_t words) { return sizeof(Header) + words * sizeof(uint64_t); }
+
+            void init() { new (header) Header(); }
+
+            bool push(const uint64_t *data, size_t count)
+            {
+                uint64_t tail = header->tail.load(std::memory_order_relaxed);
+                uint64_t head = header->head.load(std::memory_order_acquire);
+                if (mask + 1 - (tail - head) < count)
+                    return false;
+                for (size_t i = 0; i < count; i++)
+                    words[(tail + i) & mask] = data[i];
+                header->tail.store(tail + count, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * Append everything queued to out; returns the words taken
+             */
+            size_t pop(std::vector<uint64_t> &out)
+            {
+                uint64_t head = header->head.load(std::memory_order_relaxed);
+                uint64_t tail = header->tail.load(std::memory_order_acquire);
+                for (uint64_t i = head; i < tail; i++)
+                    out.push_back(words[i & mask]);
+                header->head.store(tail, std::memory_order_release);
+                return tail - head;
+            }
+
+            bool empty() const
+            {
+                return header->head.load(std::memory_order_relaxed) == header->tail.load(std::memory_order_acquire);
+            }
+
+        private:
+            struct Header
+            {
+                alignas(64) std::atomic<uint64_t> head{0};
+                alignas(64) std::atomic<uint64_t> tail{0};
+            };
+
+            Header *header;
+            uint64_t mask;
+            uint64_t *words;
+        };
+
+        /**
+         * Anonymous shared mapping holding the control block, the worker
+         * slots with their entered-state, deadlocked-state and deadlock key
+         * areas, and the rings
+         */
+        class SharedRegion
+        {
+        public:
+            SharedRegion(unsigned workers, size_t keyWords, size_t nodeWords, size_t ringWords)
+                : workers(workers), nodeWords(nodeWords), ringWords(ringWords)
+            {
+                extrasWords = 2 * nodeWords + StatechartReport::MaxReportedDeadlocks * keyWords;
+                slotsAt = align(sizeof(Control));
+                extrasAt = align(slotsAt + workers * sizeof(WorkerSlot));
+                ringsAt = align(extrasAt + workers * extrasWords * sizeof(uint64_t));
+                size = ringsAt + static_cast<size_t>(workers) * workers * align(Ring::bytesFor(ringWords));
+
+                void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (address == MAP_FAILED)
+                    throw std::runtime_error("Cannot map shared memory for distributed exploration");
+                base = static_cast<uint8_t *>(address);
+
+                Control *controlBlock = new (base) Control();
+                controlBlock->stop.store(Running);
+                controlBlock->configurations.store(0);
+                for (unsigned w = 0; w < workers; w++)
+                {
+                    WorkerSlot *workerSlot = new (base + slotsAt + w * sizeof(WorkerSlot)) WorkerSlot();
+                    workerSlot->idle.store(0);
+                    workerSlot->sent.store(0);
+                    workerSlot->received.store(0);
+                    workerSlot->owned.store(0);
+                    workerSlot->expanded.store(0);
+                    workerSlot->bytes.store(0);
+                    for (unsigned to = 0; to < workers; to++)
+                        ring(w, to).init();
+                }
+            }
+
+            ~SharedRegion() { munmap(base, size); }
+
+            SharedRegion(const SharedRegion &) = delete;
+            SharedRegion &operator=(const SharedRegion &) = delete;
+
+            Control &control() { return *reinterpret_cast<Control *>(base); }
+            WorkerSlot &slot(unsigned w) { return *reinterpret_cast<WorkerSlot *>(base + slotsAt + w * sizeof(WorkerSlot)); }
+            uint64_t *entered(unsigned w) { return extras(w); }
+            uint64_t *deadlocked(unsigned w) { return extras(w) + nodeWords; }
+            uint64_t *deadlockKeys(unsigned w) { return extras(w) + 2 * nodeWords; }
+
+            Ring ring(unsigned from, unsigned to)
+            {
+                return Ring(base + ringsAt + (static_cast<size_t>(from) * workers + to) * align(Ring::bytesFor(ringWords)),
+                            ringWords);
+            }
+
+            void raise(StopReason why)
+            {
+                int expected = Running;
+                control().stop.compare_exchange_strong(expected, static_cast<int>(why));
+            }
+
+            bool stopped() { return control().stop.load() != Running; }
+
+        private:
+            unsigned workers;
+            size_t nodeWords;
+            size_t ringWords;
+            size_t extrasWords;
+            size_t slotsAt, extrasAt, ringsAt, size;
+            uint8_t *base;
+
+            static size_t align(size_t offset) { return (offset + 63) & ~size_t(63); }
+            uint64_t *extras(unsigned w)
+            {
+                return reinterpret_cast<uint64_t *>(base + extrasAt) + static_cast<size_t>(w) * extrasWords;
+            }
+        };
+
+        /**
+         * Body of one worker process
+         */
+        void runWorker(const Statechart &chart, const DistributedOptions &options, SharedRegion &shared, unsigned self,
+                       size_t capacity, StopReason limit)
+        {
+            const unsigned workers = options.workers;
+            StatechartExplorer explorer(chart);
+            const size_t keyWords = explorer.keyWords();
+            ConcurrentStateSet table(keyWords, capacity);
+            Control &control = shared.control();
+            WorkerSlot &slot = shared.slot(self);
+
+            std::vector<uint32_t> queue;
+            size_t head = 0;
+            std::vector<std::vector<uint64_t>> outgoing(workers);
+            std::vector<uint64_t> inbox;
+            std::vector<uint64_t> successors;
+            uint64_t macrosteps = 0, terminal = 0, deadlockCount = 0;
+            uint32_t reported = 0;
+
+            auto accept = [&](const uint64_t *key)
+            {
+                auto insertion = table.insert(key, ConcurrentStateSet::NoParent, Statechart::NoEvent);
+                if (!insertion.inserted)
+                    return;
+                if (control.configurations.fetch_add(1) >= options.maxConfigurations)
+                {
+                    shared.raise(StopReason::ConfigurationLimit);
+                    return;
+                }
+                queue.push_back(insertion.id);
+                slot.owned.fetch_add(1, std::memory_order_relaxed);
+            };
+            auto drain = [&]()
+            {
+                for (unsigned from = 0; from < workers; from++)
+                {
+                    if (from == self)
+                        continue;
+                    inbox.clear();
+                    size_t taken = shared.ring(from, self).pop(inbox);
+                    for (size_t i = 0; i < taken; i += keyWords)
+                        accept(inbox.data() + i);
+                    slot.received.fetch_add(taken / keyWords);
+                }
+            };
+            // Blocks while the receiver's ring is full, draining our own
+            // inbox meanwhile so that no cycle of full rings can stall
+            auto flush = [&](unsigned to)
+            {
+                std::vector<uint64_t> &batch = outgoing[to];
+                if (batch.empty())
+                    return;
+                Ring ring = shared.ring(self, to);
+                while (!ring.push(batch.data(), batch.size()))
+                {
+                    if (shared.stopped())
+                        return;
+                    drain();
+                    std::this_thread::yield();
+                }
+                slot.sent.fetch_add(batch.size() / keyWords);
+                batch.clear();
+            };
+            auto route = [&](const uint64_t *key)
+            {
+                uint32_t owner = ownerOf(key, keyWords, workers);
+                if (owner == self)
+                {
+                    accept(key);
+                    return;
+                }
+                outgoing[owner].insert(outgoing[owner].end(), key, key + keyWords);
+                if (outgoing[owner].size() >= options.batchSize * keyWords)
+                    flush(owner);
+            };
+
+            try
+            {
+                // Every worker computes the initial configurations and
+                // keeps the ones it owns
+                explorer.initial(successors);
+                for (size_t i = 0; i < successors.size(); i += keyWords)
+                {
+                    if (ownerOf(successors.data() + i, keyWords, workers) == self)
+                        accept(successors.data() + i);
+                }
+
+                while (!shared.stopped())
+                {
+                    bool pending = head < queue.size();
+                    for (unsigned w = 0; w < workers && !pending; w++)
+                        pending = !outgoing[w].empty() || (w != self && !shared.ring(w, self).empty());
+                    if (!pending)
+                    {
+                        slot.idle.store(1);
+                        std::this_thread::sleep_for(IdlePause);
+                        continue;
+                    }
+                    // Idle is cleared before anything is received or sent,
+                    // as the four-counter method requires
+                    slot.idle.store(0);
+                    drain();
+
+                    for (int n = 0; n < ExpandBatch && head < queue.size() && !shared.stopped(); n++)
+                    {
+                        const uint64_t *key = table.key(queue[head++]);
+                        if (explorer.terminated(key))
+                        {
+                            terminal++;
+                            continue;
+                        }
+                        bool enabled = false;
+                        for (int32_t event : chart.externalEvents)
+                        {
+                            successors.clear();
+                            if (!explorer.step(key, event, successors))
+                                continue;
+                            enabled = true;
+                            for (size_t i = 0; i < successors.size(); i += keyWords)
+                            {
+                                macrosteps++;
+                                route(successors.data() + i);
+                            }
+                        }
+                        if (enabled)
+                            continue;
+                        deadlockCount++;
+                        for (size_t w = 0; w < chart.nodeWords; w++)
+                            shared.deadlocked(self)[w] |= key[w];
+                        if (reported < StatechartReport::MaxReportedDeadlocks)
+                            std::memcpy(shared.deadlockKeys(self) + reported++ * keyWords, key,
+                                        keyWords * sizeof(uint64_t));
+                    }
+                    if (head == queue.size())
+                    {
+                        for (unsigned w = 0; w < workers; w++)
+                            flush(w);
+                    }
+                    slot.expanded.store(head, std::memory_order_relaxed);
+                    slot.bytes.store(table.size() * ConcurrentStateSet::bytesPerState(keyWords) +
+                                         queue.capacity() * sizeof(uint32_t),
+                                     std::memory_order_relaxed);
+                }
+            }
+            catch (const StateSetFull &)
+            {
+                shared.raise(limit);
+            }
+
+            uint64_t unsent = 0;
+            for (const auto &batch : outgoing)
+                unsent += batch.size() / keyWords;
+            slot.macrosteps = macrosteps;
+            slot.terminal = terminal;
+            slot.deadlockCount = deadlockCount;
+            slot.divergent = explorer.divergentMacrosteps();
+            slot.frontier = queue.size() - head + unsent;
+            slot.reportedDeadlocks = reported;
+            slot.expanded.store(head);
+            const auto &entered = explorer.enteredStates();
+            std::copy(entered.begin(), entered.end(), shared.entered(self));
+        }
+
+        /**
+         * Forked worker processes; any still running when the group is
+         * destroyed (on an error or cancellation) are killed
+         */
+        class WorkerGroup
+        {
+        public:
+            ~WorkerGroup()
+            {
+                for (pid_t pid : pids)
+                {
+                    if (pid > 0)
+                    {
+                        kill(pid, SIGKILL);
+                        waitpid(pid, nullptr, 0);
+                    }
+                }
+            }
+
+            std::vector<pid_t> pids;
+        };
+
+        struct Wave
+        {
+            bool idle = true;
+            uint64_t sent = 0;
+            uint64_t received = 0;
+        };
+    } // namespace
+#endif
+
+    DistributedReport DistributedExplorer::explore(const Statechart &chart, const DistributedOptions &options)
+    {
+        RSM_TRACE_SPAN("DistributedExplorer::explore");
+#ifdef _WIN32
+        (void)chart;
+        (void)options;
+        throw std::runtime_error("Distributed exploration needs POSIX processes");
+#else
+        if (options.workers == 0 || options.workers > DistributedOptions::MaxWorkers)
+            throw std::invalid_argument("Between 1 and " + std::to_string(DistributedOptions::MaxWorkers) +
+                                        " workers expected");
+
+        const unsigned workers = options.workers;
+        StatechartExplorer explorer(chart);
+        const size_t keyWords = explorer.keyWords();
+        BudgetMeter meter(options.budget);
+        ProgressMeter progress;
+        const CancellationToken *token = CancellationToken::current();
+
+        // Rings hold at least two whole batches; both sizes are clamped
+        // first, so the doubling cannot overflow
+        const size_t ringBytes = std::min(options.ringBytes, DistributedOptions::MaxRingBytes);
+        DistributedOptions bounded = options;
+        bounded.batchSize = std::min(std::max<size_t>(options.batchSize, 1), DistributedOptions::MaxBatchSize);
+        const size_t batchWords = 2 * bounded.batchSize * keyWords;
+        size_t ringWords = 64;
+        while (ringWords <= ringBytes / sizeof(uint64_t) / 2 || ringWords < batchWords)
+            ringWords *= 2;
+
+        // Each worker's table fits its share of the memory budget
+        StopReason limit = StopReason::ConfigurationLimit;
+        size_t capacity = std::min(std::max<size_t>(options.maxConfigurations, 1), ConcurrentStateSet::MaxCapacity);
+        if (options.budget.memoryBytes != std::numeric_limits<size_t>::max())
+        {
+            size_t fit = 8;
+            const size_t share = options.budget.memoryBytes / workers;
+            while (fit < capacity && fit * 2 * ConcurrentStateSet::bytesPerState(keyWords) <= share)
+                fit *= 2;
+            if (fit < capacity)
+            {
+                capacity = fit;
+                limit = StopReason::MemoryBudget;
+            }
+        }
+
+        SharedRegion shared(workers, keyWords, chart.nodeWords, ringWords);
+        WorkerGroup group;
+        for (unsigned w = 0; w < workers; w++)
+        {
+            pid_t pid = fork();
+            if (pid < 0)
+            {
+                shared.raise(StopReason::None);
+                throw std::runtime_error("Cannot start exploration worker");
+            }
+            if (pid == 0)
+            {
+                int status = 0;
+                try
+                {
+                    runWorker(chart, bounded, shared, w, capacity, limit);
+                }
+                catch (const std::exception &e)
+                {
+                    std::strncpy(shared.slot(w).error, e.what(), ErrorLength - 1);
+                    shared.raise(StopReason::None);
+                    status = 1;
+                }
+                _exit(status);
+            }
+            group.pids.push_back(pid);
+        }
+
+        // Coordinate until termination, a stop, or a failed worker
+        std::vector<int> statuses(workers, 0);
+        Wave previous;
+        bool havePrevious = false;
+        while (!shared.stopped())
+        {
+            std::this_thread::sleep_for(CoordinatorPoll);
+            for (unsigned w = 0; w < workers; w++)
+            {
+                // Workers only exit once stopped, so this one failed
+                if (group.pids[w] > 0 && waitpid(group.pids[w], &statuses[w], WNOHANG) == group.pids[w])
+                {
+                    group.pids[w] = -1;
+                    shared.raise(StopReason::None);
+                }
+            }
+            if (token && token->cancelled())
+            {
+                shared.raise(StopReason::None);
+                token->throwIfCancelled();
+            }
+
+            uint64_t owned = 0, expanded = 0, bytes = 0;
+            for (unsigned w = 0; w < workers; w++)
+            {
+                owned += shared.slot(w).owned.load(std::memory_order_relaxed);
+                expanded += shared.slot(w).expanded.load(std::memory_order_relaxed);
+                bytes += shared.slot(w).bytes.load(std::memory_order_relaxed);
+            }
+            progress.update(expanded, owned - std::min(owned, expanded), 0, bytes);
+            if (meter.exhausted(bytes))
+            {
+                shared.raise(meter.reason());
+                break;
+            }
+
+            Wave wave;
+            for (unsigned w = 0; w < workers; w++)
+            {
+                WorkerSlot &slot = shared.slot(w);
+                wave.idle = wave.idle && slot.idle.load() != 0;
+                wave.received += slot.received.load();
+                wave.sent += slot.sent.load();
+            }
+            if (havePrevious && previous.idle && wave.idle && previous.sent == previous.received &&
+                wave.sent == wave.received && wave.sent == previous.sent)
+            {
+                shared.raise(StopReason::None);
+                break;
+            }
+            previous = wave;
+            havePrevious = true;
+        }
+
+        std::string failure;
+        for (unsigned w = 0; w < workers; w++)
+        {
+            int &status = statuses[w];
+            if (group.pids[w] > 0)
+            {
+                waitpid(group.pids[w], &status, 0);
+                group.pids[w] = -1;
+            }
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                const char *error = shared.slot(w).error;
+                if (failure.empty())
+                    failure = "Exploration worker " + std::to_string(w) + " failed" +
+                              (error[0] ? std::string(": ") + error : std::string());
+            }
+        }
+        if (!failure.empty())
+            throw std::runtime_error(failure);
+
+        DistributedReport report;
+        report.workers = workers;
+        report.stopReason = static_cast<StopReason>(shared.control().stop.load());
+        report.complete = report.stopReason == StopReason::None;
+        report.flattenedSize = chart.flattenedSize();
+        std::vector<uint64_t> entered(chart.nodeWords, 0);
+        std::vector<uint64_t> deadlocked(chart.nodeWords, 0);
+        std::vector<uint32_t> atomics;
+        uint64_t sent = 0, received = 0;
+        for (unsigned w = 0; w < workers; w++)
+        {
+            WorkerSlot &slot = shared.slot(w);
+            uint64_t owned = slot.owned.load();
+            report.partitionSizes.push_back(owned);
+            report.configurations += owned;
+            report.expanded += slot.expanded.load();
+            report.macrosteps += slot.macrosteps;
+            report.terminalConfigurations += slot.terminal;
+            report.deadlockCount += slot.deadlockCount;
+            report.divergentMacrosteps += slot.divergent;
+            report.frontier += slot.frontier;
+            sent += slot.sent.load();
+            received += slot.received.load();
+            for (size_t i = 0; i < chart.nodeWords; i++)
+            {
+                entered[i] |= shared.entered(w)[i];
+                deadlocked[i] |= shared.deadlocked(w)[i];
+            }
+            for (uint32_t d = 0; d < slot.reportedDeadlocks; d++)
+            {
+                if (report.deadlocks.size() == StatechartReport::MaxReportedDeadlocks)
+                    break;
+                atomics.clear();
+                explorer.activeAtomicStates(shared.deadlockKeys(w) + d * keyWords, atomics);
+                std::vector<std::string> names;
+                for (uint32_t s : atomics)
+                    names.push_back(chart.nodes[s].id);
+                report.deadlocks.push_back(names);
+            }
+        }
+        // Batches still in the rings when the search stopped
+        report.frontier += sent - received;
+        report.messages = sent;
+
+        for (uint32_t n = 1; n < chart.nodes.size(); n++)
+        {
+            if (!chart.isHistory(n) && !((entered[n / 64] >> (n % 64)) & 1))
+                report.unreachableStates.push_back(chart.nodes[n].id);
+            if (chart.isAtomic(n) && ((deadlocked[n / 64] >> (n % 64)) & 1))
+                report.deadlockedStates.push_back(chart.nodes[n].id);
+        }
+        report.elapsedMs = meter.elapsedMs();
+        progress.finish(report.expanded, report.frontier, 0, 0);
+        return report;
+#endif
+    }
+
+} // namespace ReactiveSystem
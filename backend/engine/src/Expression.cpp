@@ -0,0 +1,677 @@
+#include "../include/Expression.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    /**
+     * Variable table
+     */
+    VariableTable VariableTable::fromMachine(const StateMachine &machine)
+    {
+        VariableTable table;
+        for (const auto *group : {&machine.inputVariables, &machine.outputVariables, &machine.stateVariables})
+        {
+            for (const auto &variable : *group)
+            {
+                if (table.find(variable.name) < 0)
+                {
+                    table.declare(variable.name, Expression::parseLiteral(variable.initialValue));
+                }
+            }
+        }
+        return table;
+    }
+
+    int32_t VariableTable::find(const std::string &name) const
+    {
+        auto it = index.find(name);
+        return it == index.end() ? -1 : it->second;
+    }
+
+    int32_t VariableTable::declare(const std::string &name, int64_t initialValue)
+    {
+        int32_t slot = static_cast<int32_t>(names.size());
+        index.emplace(name, slot);
+        names.push_back(name);
+        initial.push_back(initialValue);
+        return slot;
+    }
+
+    int32_t VariableTable::resolve(const std::string &name)
+    {
+        int32_t slot = find(name);
+        return slot >= 0 ? slot : declare(name, 0);
+    }
+
+    namespace
+    {
+        constexpr int MaxNesting = 24;
+
+        struct Token
+        {
+            enum class Type
+            {
+                Identifier,
+                Number,
+                Operator,
+                End
+            };
+
+            Type type;
+            std::string text;
+            int64_t number = 0;
+        };
+
+        std::vector<Token> tokenize(const std::string &text)
+        {
+            static const char *const twoCharOperators[] = {
+                "==", "!=", "<=", ">=", "&&", "||", "+=", "-=", "++", "--"};
+
+            std::vector<Token> tokens;
+            size_t i = 0;
+            while (i < text.size())
+            {
+                char c = text[i];
+                if (std::isspace(static_cast<unsigned char>(c)))
+                {
+                    i++;
+                    continue;
+                }
+                if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+                {
+                    size_t start = i;
+                    while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_'))
+                        i++;
+                    tokens.push_back({Token::Type::Identifier, text.substr(start, i - start)});
+                    continue;
+                }
+                if (std::isdigit(static_cast<unsigned char>(c)))
+                {
+                    uint64_t value = 0;
+                    size_t start = i;
+                    while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])))
+                    {
+                        value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+                        i++;
+                    }
+                    Token token{Token::Type::Number, text.substr(start, i - start)};
+                    token.number = static_cast<int64_t>(value);
+                    tokens.push_back(token);
+                    continue;
+                }
+
+                bool matched = false;
+                for (const char *op : twoCharOperators)
+                {
+                    if (text.compare(i, 2, op) == 0)
+                    {
+                        tokens.push_back({Token::Type::Operator, op});
+                        i += 2;
+                        matched = true;
+                        break;
+                    }
+                }
+                if (matched)
+                    continue;
+
+                if (std::string("+-*/%<>=!()&|;,").find(c) == std::string::npos)
+                {
+                    throw std::invalid_argument(std::string("Unexpected character '") + c + "'");
+                }
+                tokens.push_back({Token::Type::Operator, std::string(1, c)});
+                i++;
+            }
+            tokens.push_back({Token::Type::End, ""});
+            return tokens;
+        }
+
+        /**
+         * Recursive descent parser, lowest precedence first
+         */
+        class Parser
+        {
+        public:
+            Parser(const std::string &text, VariableTable &variables)
+                : tokens(tokenize(text)), variables(variables) {}
+
+            bool atEnd() const { return peek().type == Token::Type::End; }
+
+            std::unique_ptr<ExprNode> parseExpression()
+            {
+                if (++depth > MaxNesting)
+                {
+                    throw std::invalid_argument("Expression nested too deeply");
+                }
+                auto node = parseOr();
+                depth--;
+                return node;
+            }
+
+            std::vector<Assignment> parseStatements()
+            {
+                std::vector<Assignment> statements;
+                while (!atEnd())
+                {
+                    if (accept(";") || accept(","))
+                        continue;
+
+                    const Token &target = next();
+                    if (target.type != Token::Type::Identifier)
+                    {
+                        throw std::invalid_argument("Expected variable name, got '" + target.text + "'");
+                    }
+                    int32_t slot = variables.resolve(target.text);
+
+                    std::unique_ptr<ExprNode> value;
+                    if (accept("="))
+                    {
+                        value = parseExpression();
+                    }
+                    else if (accept("+=") || accept("-="))
+                    {
+                        std::string op = previous().text.substr(0, 1);
+                        value = binary(op, variableNode(slot), parseExpression());
+                    }
+                    else if (accept("++") || accept("--"))
+                    {
+                        std::string op = previous().text.substr(0, 1);
+                        value = binary(op, variableNode(slot), literal(1));
+                    }
+                    else
+                    {
+                        throw std::invalid_argument("Expected assignment to '" + target.text + "'");
+                    }
+                    statements.push_back({slot, std::move(value)});
+
+                    if (!atEnd() && !accept(";") && !accept(","))
+                    {
+                        throw std::invalid_argument("Expected ';' after assignment, got '" + peek().text + "'");
+                    }
+                }
+                return statements;
+            }
+
+        private:
+            std::vector<Token> tokens;
+            VariableTable &variables;
+            size_t position = 0;
+            int depth = 0;
+
+            const Token &peek() const { return tokens[position]; }
+            const Token &previous() const { return tokens[position - 1]; }
+            const Token &next() { return tokens[position < tokens.size() - 1 ? position++ : position]; }
+
+            bool accept(const char *op)
+            {
+                if (peek().type == Token::Type::Operator && peek().text == op)
+                {
+                    position++;
+                    return true;
+                }
+                return false;
+            }
+
+            bool acceptWord(const char *word)
+            {
+                if (peek().type == Token::Type::Identifier && peek().text == word)
+                {
+                    position++;
+                    return true;
+                }
+                return false;
+            }
+
+            static std::unique_ptr<ExprNode> literal(int64_t value)
+            {
+                auto node = std::make_unique<ExprNode>();
+                node->kind = ExprNode::Kind::Literal;
+                node->value = value;
+                return node;
+            }
+
+            static std::unique_ptr<ExprNode> variableNode(int32_t slot)
+            {
+                auto node = std::make_unique<ExprNode>();
+                node->kind = ExprNode::Kind::Variable;
+                node->variable = slot;
+                return node;
+            }
+
+            static std::unique_ptr<ExprNode> binary(
+                const std::string &op,
+                std::unique_ptr<ExprNode> lhs,
+                std::unique_ptr<ExprNode> rhs)
+            {
+                auto node = std::make_unique<ExprNode>();
+                node->kind = ExprNode::Kind::Binary;
+                node->op = op;
+                node->lhs = std::move(lhs);
+                node->rhs = std::move(rhs);
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseOr()
+            {
+                auto node = parseAnd();
+                while (accept("||") || accept("|") || acceptWord("or"))
+                {
+                    node = binary("||", std::move(node), parseAnd());
+                }
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseAnd()
+            {
+                auto node = parseEquality();
+                while (accept("&&") || accept("&") || acceptWord("and"))
+                {
+                    node = binary("&&", std::move(node), parseEquality());
+                }
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseEquality()
+            {
+                auto node = parseRelational();
+                while (true)
+                {
+                    if (accept("==") || accept("="))
+                        node = binary("==", std::move(node), parseRelational());
+                    else if (accept("!="))
+                        node = binary("!=", std::move(node), parseRelational());
+                    else
+                        return node;
+                }
+            }
+
+            std::unique_ptr<ExprNode> parseRelational()
+            {
+                auto node = parseAdditive();
+                while (accept("<") || accept("<=") || accept(">") || accept(">="))
+                {
+                    std::string op = previous().text;
+                    node = binary(op, std::move(node), parseAdditive());
+                }
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseAdditive()
+            {
+                auto node = parseMultiplicative();
+                while (accept("+") || accept("-"))
+                {
+                    std::string op = previous().text;
+                    node = binary(op, std::move(node), parseMultiplicative());
+                }
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseMultiplicative()
+            {
+                auto node = parseUnary();
+                while (accept("*") || accept("/") || accept("%"))
+                {
+                    std::string op = previous().text;
+                    node = binary(op, std::move(node), parseUnary());
+                }
+                return node;
+            }
+
+            std::unique_ptr<ExprNode> parseUnary()
+            {
+                if (accept("!") || acceptWord("not") || accept("-"))
+                {
+                    std::string op = previous().text == "-" ? "-" : "!";
+                    if (++depth > MaxNesting)
+                    {
+                        throw std::invalid_argument("Expression nested too deeply");
+                    }
+                    auto node = std::make_unique<ExprNode>();
+                    node->kind = ExprNode::Kind::Unary;
+                    node->op = op;
+                    node->lhs = parseUnary();
+                    depth--;
+                    return node;
+                }
+                return parsePrimary();
+            }
+
+            std::unique_ptr<ExprNode> parsePrimary()
+            {
+                const Token &token = next();
+                switch (token.type)
+                {
+                case Token::Type::Number:
+                    return literal(token.number);
+                case Token::Type::Identifier:
+                    if (token.text == "true")
+                        return literal(1);
+                    if (token.text == "false")
+                        return literal(0);
+                    return variableNode(variables.resolve(token.text));
+                case Token::Type::Operator:
+                    if (token.text == "(")
+                    {
+                        auto node = parseExpression();
+                        if (!accept(")"))
+                        {
+                            throw std::invalid_argument("Expected ')'");
+                        }
+                        return node;
+                    }
+                    break;
+                case Token::Type::End:
+                    throw std::invalid_argument("Unexpected end of expression");
+                }
+                throw std::invalid_argument("Unexpected '" + token.text + "'");
+            }
+        };
+
+        OpCode binaryOpCode(const std::string &op)
+        {
+            if (op == "+")
+                return OpCode::Add;
+            if (op == "-")
+                return OpCode::Sub;
+            if (op == "*")
+                return OpCode::Mul;
+            if (op == "/")
+                return OpCode::Div;
+            if (op == "%")
+                return OpCode::Mod;
+            if (op == "==")
+                return OpCode::Eq;
+            if (op == "!=")
+                return OpCode::Ne;
+            if (op == "<")
+                return OpCode::Lt;
+            if (op == "<=")
+                return OpCode::Le;
+            if (op == ">")
+                return OpCode::Gt;
+            return OpCode::Ge;
+        }
+
+        /**
+         * Emit code for a node; tracks stack height to size the evaluation stack
+         */
+        class Compiler
+        {
+        public:
+            Bytecode bytecode;
+
+            void emit(OpCode op, int64_t operand, int stackDelta)
+            {
+                bytecode.code.push_back({op, operand});
+                height += stackDelta;
+                if (height > static_cast<int>(bytecode.maxStack))
+                {
+                    bytecode.maxStack = static_cast<uint32_t>(height);
+                }
+            }
+
+            void patch(size_t at)
+            {
+                bytecode.code[at].operand = static_cast<int64_t>(bytecode.code.size());
+            }
+
+            void compile(const ExprNode &node)
+            {
+                switch (node.kind)
+                {
+                case ExprNode::Kind::Literal:
+                    emit(OpCode::PushConst, node.value, 1);
+                    return;
+                case ExprNode::Kind::Variable:
+                    emit(OpCode::Load, node.variable, 1);
+                    return;
+                case ExprNode::Kind::Unary:
+                    compile(*node.lhs);
+                    emit(node.op == "-" ? OpCode::Neg : OpCode::Not, 0, 0);
+                    return;
+                case ExprNode::Kind::Binary:
+                    if (node.op == "&&" || node.op == "||")
+                    {
+                        // Short circuit: a && b -> a ? bool(b) : 0
+                        bool isAnd = node.op == "&&";
+                        compile(*node.lhs);
+                        size_t shortJump = bytecode.code.size();
+                        emit(isAnd ? OpCode::JumpIfZero : OpCode::JumpIfNonZero, 0, -1);
+                        compile(*node.rhs);
+                        emit(OpCode::ToBool, 0, 0);
+                        size_t endJump = bytecode.code.size();
+                        emit(OpCode::Jump, 0, 0);
+                        patch(shortJump);
+                        height--;
+                        emit(OpCode::PushConst, isAnd ? 0 : 1, 1);
+                        patch(endJump);
+                        return;
+                    }
+                    compile(*node.lhs);
+                    compile(*node.rhs);
+                    emit(binaryOpCode(node.op), 0, -1);
+                    return;
+                }
+            }
+
+            void finish()
+            {
+                if (bytecode.maxStack > Bytecode::MaxStack)
+                {
+                    throw std::invalid_argument("Expression too complex");
+                }
+            }
+
+        private:
+            int height = 0;
+        };
+
+        std::string cppOperatorHelper(const std::string &op)
+        {
+            if (op == "+")
+                return "add";
+            if (op == "-")
+                return "sub";
+            if (op == "*")
+                return "mul";
+            if (op == "/")
+                return "div";
+            return "mod";
+        }
+    } // namespace
+
+    std::unique_ptr<ExprNode> Expression::parseGuard(const std::string &text, VariableTable &variables)
+    {
+        Parser parser(text, variables);
+        if (parser.atEnd())
+        {
+            return nullptr;
+        }
+        auto node = parser.parseExpression();
+        if (!parser.atEnd())
+        {
+            throw std::invalid_argument("Unexpected trailing input in guard '" + text + "'");
+        }
+        return node;
+    }
+
+    std::vector<Assignment> Expression::parseAction(const std::string &text, VariableTable &variables)
+    {
+        Parser parser(text, variables);
+        return parser.parseStatements();
+    }
+
+    Bytecode Expression::compileGuard(const ExprNode *guard)
+    {
+        Compiler compiler;
+        if (guard)
+        {
+            compiler.compile(*guard);
+        }
+        compiler.finish();
+        return compiler.bytecode;
+    }
+
+    Bytecode Expression::compileAction(const std::vector<Assignment> &action)
+    {
+        Compiler compiler;
+        for (const auto &assignment : action)
+        {
+            compiler.compile(*assignment.value);
+            compiler.emit(OpCode::Store, assignment.variable, -1);
+        }
+        compiler.finish();
+        return compiler.bytecode;
+    }
+
+    int64_t Expression::applyBinary(OpCode op, int64_t lhs, int64_t rhs)
+    {
+        const uint64_t a = static_cast<uint64_t>(lhs);
+        const uint64_t b = static_cast<uint64_t>(rhs);
+        switch (op)
+        {
+        case OpCode::Add:
+            return static_cast<int64_t>(a + b);
+        case OpCode::Sub:
+            return static_cast<int64_t>(a - b);
+        case OpCode::Mul:
+            return static_cast<int64_t>(a * b);
+        case OpCode::Div:
+            if (rhs == 0)
+                return 0;
+            return rhs == -1 ? static_cast<int64_t>(0 - a) : lhs / rhs;
+        case OpCode::Mod:
+            if (rhs == 0 || rhs == -1)
+                return 0;
+            return lhs % rhs;
+        case OpCode::Eq:
+            return lhs == rhs;
+        case OpCode::Ne:
+            return lhs != rhs;
+        case OpCode::Lt:
+            return lhs < rhs;
+        case OpCode::Le:
+            return lhs <= rhs;
+        case OpCode::Gt:
+            return lhs > rhs;
+        case OpCode::Ge:
+            return lhs >= rhs;
+        default:
+            return 0;
+        }
+    }
+
+    int64_t Expression::execute(const Bytecode &bytecode, int64_t *variables)
+    {
+        if (bytecode.code.empty())
+        {
+            return 1;
+        }
+
+        int64_t stack[Bytecode::MaxStack];
+        int top = -1;
+        const Instruction *code = bytecode.code.data();
+        const size_t length = bytecode.code.size();
+
+        for (size_t pc = 0; pc < length; pc++)
+        {
+            const Instruction &instruction = code[pc];
+            switch (instruction.op)
+            {
+            case OpCode::PushConst:
+                stack[++top] = instruction.operand;
+                break;
+            case OpCode::Load:
+                stack[++top] = variables[instruction.operand];
+                break;
+            case OpCode::Store:
+                variables[instruction.operand] = stack[top--];
+                break;
+            case OpCode::Neg:
+                stack[top] = static_cast<int64_t>(0 - static_cast<uint64_t>(stack[top]));
+                break;
+            case OpCode::Not:
+                stack[top] = stack[top] == 0;
+                break;
+            case OpCode::ToBool:
+                stack[top] = stack[top] != 0;
+                break;
+            case OpCode::Jump:
+                pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            case OpCode::JumpIfZero:
+                if (stack[top--] == 0)
+                    pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            case OpCode::JumpIfNonZero:
+                if (stack[top--] != 0)
+                    pc = static_cast<size_t>(instruction.operand) - 1;
+                break;
+            default:
+                stack[top - 1] = applyBinary(instruction.op, stack[top - 1], stack[top]);
+                top--;
+                break;
+            }
+        }
+
+        return top >= 0 ? stack[top] : 0;
+    }
+
+    std::string Expression::toCpp(
+        const ExprNode *node,
+        const std::vector<std::string> &variableNames,
+        const std::string &prefix)
+    {
+        if (!node)
+        {
+            return "true";
+        }
+
+        switch (node->kind)
+        {
+        case ExprNode::Kind::Literal:
+            if (node->value == INT64_MIN)
+                return "INT64_MIN";
+            return "INT64_C(" + std::to_string(node->value) + ")";
+        case ExprNode::Kind::Variable:
+            return prefix + variableNames[node->variable];
+        case ExprNode::Kind::Unary:
+            if (node->op == "-")
+                return "detail::sub(0, " + toCpp(node->lhs.get(), variableNames, prefix) + ")";
+            return "static_cast<int64_t>(" + toCpp(node->lhs.get(), variableNames, prefix) + " == 0)";
+        case ExprNode::Kind::Binary:
+            break;
+        }
+
+        std::string lhs = toCpp(node->lhs.get(), variableNames, prefix);
+        std::string rhs = toCpp(node->rhs.get(), variableNames, prefix);
+        if (node->op == "&&" || node->op == "||")
+        {
+            return "static_cast<int64_t>((" + lhs + " != 0) " + node->op + " (" + rhs + " != 0))";
+        }
+        if (node->op == "+" || node->op == "-" || node->op == "*" || node->op == "/" || node->op == "%")
+        {
+            return "detail::" + cppOperatorHelper(node->op) + "(" + lhs + ", " + rhs + ")";
+        }
+        return "static_cast<int64_t>(" + lhs + " " + node->op + " " + rhs + ")";
+    }
+
+    int64_t Expression::parseLiteral(const std::string &text)
+    {
+        if (text == "true")
+            return 1;
+        if (text == "false" || text.empty())
+            return 0;
+        try
+        {
+            return static_cast<int64_t>(std::stoll(text));
+        }
+        catch (const std::exception &)
+        {
+            return 0;
+        }
+    }
+
+} // namespace ReactiveSystem
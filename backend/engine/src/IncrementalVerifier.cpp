@@ -0,0 +1,856 @@
+#include "../include/IncrementalVerifier.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    IncrementalVerifier::IncrementalVerifier(const StateMachine &machine)
+    {
+        nodes.reserve(machine.states.size());
+        edges.reserve(machine.transitions.size());
+        for (const auto &state : machine.states)
+        {
+            if (nodeIndex.count(state.id) == 0)
+                appendNode(state);
+        }
+        for (const auto &transition : machine.transitions)
+        {
+            if (edgeIndex.count(transition.id) == 0 && nodeIndex.count(transition.from) && nodeIndex.count(transition.to))
+                appendEdge(transition);
+        }
+        updateRoot();
+        rebuildComponents();
+        work = 0;
+    }
+
+    uint32_t IncrementalVerifier::node(const std::string &stateId) const
+    {
+        auto it = nodeIndex.find(stateId);
+        if (it == nodeIndex.end())
+            throw std::invalid_argument("Unknown state: " + stateId);
+        return it->second;
+    }
+
+    // ---------------------------------------------------------------
+    // Graph storage
+    // ---------------------------------------------------------------
+
+    uint32_t IncrementalVerifier::appendNode(const State &state)
+    {
+        if (!state.parent.empty() || !state.kind.empty())
+            throw std::invalid_argument("Incremental verification needs a flat machine: " + state.id);
+        if (nodeIndex.count(state.id))
+            throw std::invalid_argument("Duplicate state: " + state.id);
+
+        uint32_t n = static_cast<uint32_t>(nodes.size());
+        Node added;
+        added.id = state.id;
+        added.name = state.name;
+        added.isInitial = state.isInitial;
+        added.isFinal = state.isFinal;
+        nodes.push_back(std::move(added));
+        nodeIndex.emplace(state.id, n);
+        reachable.push_back(0);
+        parentEdge.push_back(None);
+        visitStamp.push_back(0);
+        visitIndex.push_back(0);
+        lowLink.push_back(0);
+        onStack.push_back(0);
+        liveStates++;
+
+        uint32_t c = newComponent();
+        members[c].push_back(n);
+        component.push_back(c);
+        finals[c] = state.isFinal ? 1 : 0;
+        position[c] = static_cast<uint32_t>(order.size());
+        order.push_back(c);
+
+        if (state.isInitial)
+            initialNodes.insert(n);
+        countState(n, +1);
+        return n;
+    }
+
+    uint32_t IncrementalVerifier::appendEdge(const Transition &transition)
+    {
+        if (edgeIndex.count(transition.id))
+            throw std::invalid_argument("Duplicate transition: " + transition.id);
+        uint32_t from = node(transition.from);
+        uint32_t to = node(transition.to);
+
+        int32_t input = -1;
+        if (!transition.input.empty())
+        {
+            auto inserted = inputIndex.emplace(transition.input, static_cast<int32_t>(inputEdges.size()));
+            if (inserted.second)
+                inputEdges.push_back(0);
+            input = inserted.first->second;
+        }
+
+        uint32_t e = static_cast<uint32_t>(edges.size());
+        edges.push_back({transition.id, from, to, input, true});
+        edgeIndex.emplace(transition.id, e);
+
+        countState(from, -1);
+        nodes[from].out.push_back(e);
+        countInput(from, input, +1);
+        countState(from, +1);
+        nodes[to].in.push_back(e);
+        setAlphabet(input, +1);
+        if (from == to)
+        {
+            nodes[from].selfLoops++;
+            loops[component[from]]++;
+        }
+        liveEdges++;
+        return e;
+    }
+
+    void IncrementalVerifier::unlinkEdge(uint32_t e)
+    {
+        Edge &edge = edges[e];
+        auto erase = [](std::vector<uint32_t> &list, uint32_t value)
+        {
+            auto it = std::find(list.begin(), list.end(), value);
+            *it = list.back();
+            list.pop_back();
+        };
+
+        countState(edge.from, -1);
+        erase(nodes[edge.from].out, e);
+        countInput(edge.from, edge.input, -1);
+        countState(edge.from, +1);
+        erase(nodes[edge.to].in, e);
+        setAlphabet(edge.input, -1);
+        if (edge.from == edge.to)
+        {
+            nodes[edge.from].selfLoops--;
+            loops[component[edge.from]]--;
+        }
+        edge.alive = false;
+        edgeIndex.erase(edge.id);
+        liveEdges--;
+    }
+
+    /**
+     * Unlink an edge and repair reachability and components around it
+     */
+    void IncrementalVerifier::dropEdge(uint32_t e)
+    {
+        uint32_t from = edges[e].from;
+        uint32_t to = edges[e].to;
+        unlinkEdge(e);
+
+        if (component[from] != component[to])
+            exits[component[from]]--;
+        else if (from != to && !connected(from, to))
+            split(component[from]);
+
+        if (parentEdge[to] == e)
+            repairReachability(to);
+    }
+
+    // ---------------------------------------------------------------
+    // Deadlock and completeness counters
+    // ---------------------------------------------------------------
+
+    /**
+     * Add or remove a state's contribution; called around every change to
+     * its outgoing transitions or final flag
+     */
+    void IncrementalVerifier::countState(uint32_t n, int delta)
+    {
+        const Node &state = nodes[n];
+        if (!state.alive || state.isFinal)
+            return;
+        size_t distinct = state.inputs.size();
+        if (distinct >= distinctHistogram.size())
+            distinctHistogram.resize(distinct + 1, 0);
+        distinctHistogram[distinct] += delta;
+        liveNonFinal += delta;
+        if (state.out.empty())
+            deadlockCount += delta;
+    }
+
+    void IncrementalVerifier::countInput(uint32_t n, int32_t input, int delta)
+    {
+        if (input < 0)
+            return;
+        auto &inputs = nodes[n].inputs;
+        auto it = std::lower_bound(inputs.begin(), inputs.end(), std::make_pair(input, 0u));
+        if (delta > 0)
+        {
+            if (it != inputs.end() && it->first == input)
+                it->second++;
+            else
+                inputs.insert(it, {input, 1u});
+        }
+        else if (--it->second == 0)
+            inputs.erase(it);
+    }
+
+    void IncrementalVerifier::setAlphabet(int32_t input, int delta)
+    {
+        if (input < 0)
+            return;
+        uint32_t &count = inputEdges[input];
+        if (delta > 0 && count++ == 0)
+            alphabet++;
+        else if (delta < 0 && --count == 0)
+            alphabet--;
+    }
+
+    // ---------------------------------------------------------------
+    // Reachability
+    // ---------------------------------------------------------------
+
+    void IncrementalVerifier::rebuildReachability()
+    {
+        std::fill(reachable.begin(), reachable.end(), 0);
+        std::fill(parentEdge.begin(), parentEdge.end(), None);
+        reachableCount = 0;
+        work += nodes.size();
+        if (root != None)
+            reach(root, None);
+    }
+
+    /**
+     * Attach an unreachable state to the tree and search from it
+     */
+    void IncrementalVerifier::reach(uint32_t from, uint32_t edge)
+    {
+        reachable[from] = 1;
+        parentEdge[from] = edge;
+        reachableCount++;
+        std::vector<uint32_t> queue{from};
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            for (uint32_t e : nodes[queue[head]].out)
+            {
+                uint32_t to = edges[e].to;
+                work++;
+                if (!reachable[to])
+                {
+                    reachable[to] = 1;
+                    parentEdge[to] = e;
+                    reachableCount++;
+                    queue.push_back(to);
+                }
+            }
+        }
+    }
+
+    /**
+     * The tree edge into target is gone: detach its subtree, re-attach the
+     * states that still have a reachable predecessor outside it and search
+     * onward from those. Only states of the subtree can change.
+     */
+    void IncrementalVerifier::repairReachability(uint32_t target)
+    {
+        std::vector<uint32_t> subtree{target};
+        for (size_t i = 0; i < subtree.size(); i++)
+        {
+            for (uint32_t e : nodes[subtree[i]].out)
+            {
+                uint32_t to = edges[e].to;
+                work++;
+                if (reachable[to] && parentEdge[to] == e)
+                    subtree.push_back(to);
+            }
+        }
+        for (uint32_t n : subtree)
+        {
+            reachable[n] = 0;
+            parentEdge[n] = None;
+        }
+        reachableCount -= static_cast<uint32_t>(subtree.size());
+
+        std::vector<uint32_t> queue;
+        for (uint32_t n : subtree)
+        {
+            for (uint32_t e : nodes[n].in)
+            {
+                work++;
+                if (reachable[edges[e].from])
+                {
+                    reachable[n] = 1;
+                    parentEdge[n] = e;
+                    reachableCount++;
+                    queue.push_back(n);
+                    break;
+                }
+            }
+        }
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            for (uint32_t e : nodes[queue[head]].out)
+            {
+                uint32_t to = edges[e].to;
+                work++;
+                if (!reachable[to])
+                {
+                    reachable[to] = 1;
+                    parentEdge[to] = e;
+                    reachableCount++;
+                    queue.push_back(to);
+                }
+            }
+        }
+    }
+
+    /**
+     * The tree is rooted at the first live initial state; changing the
+     * root is rare enough to rebuild
+     */
+    void IncrementalVerifier::updateRoot()
+    {
+        uint32_t first = initialNodes.empty() ? None : *initialNodes.begin();
+        if (first != root)
+        {
+            root = first;
+            rebuildReachability();
+        }
+    }
+
+    // ---------------------------------------------------------------
+    // Strongly connected components
+    // ---------------------------------------------------------------
+
+    uint32_t IncrementalVerifier::newComponent()
+    {
+        if (!freeComponents.empty())
+        {
+            uint32_t c = freeComponents.back();
+            freeComponents.pop_back();
+            exits[c] = finals[c] = loops[c] = 0;
+            return c;
+        }
+        uint32_t c = static_cast<uint32_t>(members.size());
+        members.emplace_back();
+        exits.push_back(0);
+        finals.push_back(0);
+        loops.push_back(0);
+        position.push_back(None);
+        forwardMark.push_back(0);
+        backwardMark.push_back(0);
+        return c;
+    }
+
+    void IncrementalVerifier::recount(uint32_t c)
+    {
+        exits[c] = finals[c] = loops[c] = 0;
+        for (uint32_t n : members[c])
+        {
+            finals[c] += nodes[n].isFinal ? 1 : 0;
+            loops[c] += nodes[n].selfLoops;
+            for (uint32_t e : nodes[n].out)
+            {
+                work++;
+                if (component[edges[e].to] != c)
+                    exits[c]++;
+            }
+        }
+    }
+
+    void IncrementalVerifier::renumber(size_t from)
+    {
+        for (size_t i = from; i < order.size(); i++)
+        {
+            position[order[i]] = static_cast<uint32_t>(i);
+            work++;
+        }
+    }
+
+    /**
+     * Iterative Tarjan over scope, following only edges that stay inside
+     * the component within (or all edges when within is None). Components
+     * come out in reverse topological order.
+     */
+    void IncrementalVerifier::tarjan(const std::vector<uint32_t> &scope, uint32_t within, std::vector<std::vector<uint32_t>> &out)
+    {
+        visit++;
+        uint32_t counter = 0;
+        std::vector<uint32_t> stack;
+        std::vector<std::pair<uint32_t, size_t>> calls;
+
+        auto open = [&](uint32_t n)
+        {
+            visitStamp[n] = visit;
+            visitIndex[n] = lowLink[n] = counter++;
+            stack.push_back(n);
+            onStack[n] = 1;
+            calls.push_back({n, 0});
+        };
+
+        for (uint32_t start : scope)
+        {
+            if (visitStamp[start] == visit)
+                continue;
+            open(start);
+            while (!calls.empty())
+            {
+                uint32_t n = calls.back().first;
+                size_t next = calls.back().second;
+                if (next < nodes[n].out.size())
+                {
+                    calls.back().second++;
+                    uint32_t to = edges[nodes[n].out[next]].to;
+                    work++;
+                    if (within != None && component[to] != within)
+                        continue;
+                    if (visitStamp[to] != visit)
+                        open(to);
+                    else if (onStack[to])
+                        lowLink[n] = std::min(lowLink[n], visitIndex[to]);
+                    continue;
+                }
+
+                calls.pop_back();
+                if (!calls.empty())
+                {
+                    uint32_t caller = calls.back().first;
+                    lowLink[caller] = std::min(lowLink[caller], lowLink[n]);
+                }
+                if (lowLink[n] == visitIndex[n])
+                {
+                    std::vector<uint32_t> piece;
+                    uint32_t member;
+                    do
+                    {
+                        member = stack.back();
+                        stack.pop_back();
+                        onStack[member] = 0;
+                        piece.push_back(member);
+                    } while (member != n);
+                    out.push_back(std::move(piece));
+                }
+            }
+        }
+    }
+
+    void IncrementalVerifier::rebuildComponents()
+    {
+        std::vector<uint32_t> scope;
+        scope.reserve(liveStates);
+        for (uint32_t n = 0; n < nodes.size(); n++)
+        {
+            if (nodes[n].alive)
+                scope.push_back(n);
+        }
+        std::vector<std::vector<uint32_t>> pieces;
+        tarjan(scope, None, pieces);
+
+        members.clear();
+        exits.clear();
+        finals.clear();
+        loops.clear();
+        position.clear();
+        forwardMark.clear();
+        backwardMark.clear();
+        freeComponents.clear();
+        order.clear();
+
+        for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece)
+        {
+            uint32_t c = newComponent();
+            for (uint32_t n : *piece)
+                component[n] = c;
+            members[c] = std::move(*piece);
+            position[c] = static_cast<uint32_t>(order.size());
+            order.push_back(c);
+        }
+        for (uint32_t c : order)
+            recount(c);
+    }
+
+    /**
+     * Merge into the largest component and release the others
+     */
+    uint32_t IncrementalVerifier::merge(const std::vector<uint32_t> &components)
+    {
+        uint32_t target = components.front();
+        for (uint32_t c : components)
+        {
+            if (members[c].size() > members[target].size())
+                target = c;
+        }
+        for (uint32_t c : components)
+        {
+            if (c == target)
+                continue;
+            for (uint32_t n : members[c])
+            {
+                component[n] = target;
+                members[target].push_back(n);
+            }
+            members[c].clear();
+            members[c].shrink_to_fit();
+            position[c] = None;
+            freeComponents.push_back(c);
+        }
+        recount(target);
+        return target;
+    }
+
+    /**
+     * Pearce-Kelly insertion of an edge between two components. Only the
+     * components positioned between the two endpoints are searched.
+     */
+    void IncrementalVerifier::insertComponentEdge(uint32_t from, uint32_t to)
+    {
+        uint32_t lower = position[to];
+        uint32_t upper = position[from];
+        if (lower > upper)
+            return;
+
+        stamp++;
+        bool cycle = false;
+        std::vector<uint32_t> forward{to};
+        forwardMark[to] = stamp;
+        for (size_t i = 0; i < forward.size(); i++)
+        {
+            for (uint32_t n : members[forward[i]])
+            {
+                for (uint32_t e : nodes[n].out)
+                {
+                    uint32_t c = component[edges[e].to];
+                    work++;
+                    if (forwardMark[c] != stamp && position[c] <= upper)
+                    {
+                        forwardMark[c] = stamp;
+                        forward.push_back(c);
+                        cycle = cycle || c == from;
+                    }
+                }
+            }
+        }
+
+        std::vector<uint32_t> backward{from};
+        backwardMark[from] = stamp;
+        for (size_t i = 0; i < backward.size(); i++)
+        {
+            for (uint32_t n : members[backward[i]])
+            {
+                for (uint32_t e : nodes[n].in)
+                {
+                    uint32_t c = component[edges[e].from];
+                    work++;
+                    if (backwardMark[c] != stamp && position[c] >= lower)
+                    {
+                        backwardMark[c] = stamp;
+                        backward.push_back(c);
+                    }
+                }
+            }
+        }
+
+        // The affected slots, reassigned as backward, merged, forward: the
+        // components only one search reached keep the lowest and highest
+        // slots, so none moves past a component with an edge into it, and
+        // the slots the merge frees come out of the middle
+        std::vector<uint32_t> slots;
+        for (uint32_t c : backward)
+            slots.push_back(position[c]);
+        for (uint32_t c : forward)
+        {
+            if (backwardMark[c] != stamp)
+                slots.push_back(position[c]);
+        }
+        std::sort(slots.begin(), slots.end());
+
+        auto byPosition = [this](uint32_t a, uint32_t b)
+        { return position[a] < position[b]; };
+        std::sort(forward.begin(), forward.end(), byPosition);
+        std::sort(backward.begin(), backward.end(), byPosition);
+
+        std::vector<uint32_t> before;
+        std::vector<uint32_t> cycleMembers;
+        for (uint32_t c : backward)
+        {
+            if (forwardMark[c] == stamp)
+                cycleMembers.push_back(c);
+            else
+                before.push_back(c);
+        }
+        std::vector<uint32_t> after;
+        for (uint32_t c : forward)
+        {
+            if (backwardMark[c] != stamp)
+                after.push_back(c);
+        }
+
+        auto place = [this](uint32_t c, uint32_t slot)
+        {
+            order[slot] = c;
+            position[c] = slot;
+        };
+        for (size_t i = 0; i < before.size(); i++)
+            place(before[i], slots[i]);
+        for (size_t i = 0; i < after.size(); i++)
+            place(after[i], slots[slots.size() - after.size() + i]);
+        if (!cycle)
+            return;
+
+        place(merge(cycleMembers), slots[before.size()]);
+        const size_t surplus = before.size() + 1;
+        const size_t surplusEnd = slots.size() - after.size();
+        if (surplus < surplusEnd)
+        {
+            for (size_t i = surplus; i < surplusEnd; i++)
+                order[slots[i]] = None;
+            order.erase(std::remove(order.begin() + slots[surplus], order.end(), None), order.end());
+            renumber(slots[surplus]);
+        }
+    }
+
+    /**
+     * Whether to is still reachable from from inside their component. If
+     * so, removing the edge between them cannot split the component.
+     */
+    bool IncrementalVerifier::connected(uint32_t from, uint32_t to)
+    {
+        uint32_t c = component[from];
+        visit++;
+        visitStamp[from] = visit;
+        std::vector<uint32_t> queue{from};
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            for (uint32_t e : nodes[queue[head]].out)
+            {
+                uint32_t next = edges[e].to;
+                work++;
+                if (next == to)
+                    return true;
+                if (visitStamp[next] != visit && component[next] == c)
+                {
+                    visitStamp[next] = visit;
+                    queue.push_back(next);
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * An edge inside c is gone; re-run Tarjan on c alone and put the
+     * pieces at its position in topological order
+     */
+    void IncrementalVerifier::split(uint32_t c)
+    {
+        std::vector<uint32_t> scope = members[c];
+        std::vector<std::vector<uint32_t>> pieces;
+        tarjan(scope, c, pieces);
+        if (pieces.size() == 1)
+            return;
+
+        std::reverse(pieces.begin(), pieces.end());
+        std::vector<uint32_t> ids{c};
+        for (size_t i = 1; i < pieces.size(); i++)
+            ids.push_back(newComponent());
+        for (size_t i = 0; i < pieces.size(); i++)
+        {
+            for (uint32_t n : pieces[i])
+                component[n] = ids[i];
+            members[ids[i]] = std::move(pieces[i]);
+        }
+        for (uint32_t id : ids)
+            recount(id);
+
+        uint32_t at = position[c];
+        order.insert(order.begin() + at + 1, ids.begin() + 1, ids.end());
+        renumber(at);
+    }
+
+    // ---------------------------------------------------------------
+    // Edits
+    // ---------------------------------------------------------------
+
+    void IncrementalVerifier::addState(const State &state)
+    {
+        work = 0;
+        uint32_t n = appendNode(state);
+        edits++;
+        if (nodes[n].isInitial)
+            updateRoot();
+    }
+
+    void IncrementalVerifier::removeState(const std::string &stateId)
+    {
+        uint32_t n = node(stateId);
+        work = 0;
+        edits++;
+
+        std::vector<uint32_t> incident = nodes[n].out;
+        for (uint32_t e : nodes[n].in)
+        {
+            if (edges[e].from != n)
+                incident.push_back(e);
+        }
+        for (uint32_t e : incident)
+            dropEdge(e);
+
+        countState(n, -1);
+        nodes[n].alive = false;
+        nodeIndex.erase(stateId);
+        initialNodes.erase(n);
+        liveStates--;
+        if (reachable[n])
+        {
+            reachable[n] = 0;
+            parentEdge[n] = None;
+            reachableCount--;
+        }
+
+        // Without edges the state is a component of its own
+        uint32_t c = component[n];
+        uint32_t at = position[c];
+        order.erase(order.begin() + at);
+        renumber(at);
+        members[c].clear();
+        position[c] = None;
+        freeComponents.push_back(c);
+        component[n] = None;
+
+        updateRoot();
+    }
+
+    void IncrementalVerifier::updateState(const State &state)
+    {
+        if (!state.parent.empty() || !state.kind.empty())
+            throw std::invalid_argument("Incremental verification needs a flat machine: " + state.id);
+        uint32_t n = node(state.id);
+        work = 0;
+        edits++;
+
+        Node &target = nodes[n];
+        target.name = state.name;
+        if (target.isFinal != state.isFinal)
+        {
+            countState(n, -1);
+            target.isFinal = state.isFinal;
+            countState(n, +1);
+            finals[component[n]] += state.isFinal ? 1 : -1;
+        }
+        if (target.isInitial != state.isInitial)
+        {
+            target.isInitial = state.isInitial;
+            if (state.isInitial)
+                initialNodes.insert(n);
+            else
+                initialNodes.erase(n);
+            updateRoot();
+        }
+    }
+
+    void IncrementalVerifier::addTransition(const Transition &transition)
+    {
+        work = 0;
+        uint32_t e = appendEdge(transition);
+        edits++;
+
+        uint32_t from = edges[e].from;
+        uint32_t to = edges[e].to;
+        if (reachable[from] && !reachable[to])
+            reach(to, e);
+        if (component[from] != component[to])
+        {
+            exits[component[from]]++;
+            insertComponentEdge(component[from], component[to]);
+        }
+    }
+
+    void IncrementalVerifier::removeTransition(const std::string &transitionId)
+    {
+        auto it = edgeIndex.find(transitionId);
+        if (it == edgeIndex.end())
+            throw std::invalid_argument("Unknown transition: " + transitionId);
+        work = 0;
+        edits++;
+        dropEdge(it->second);
+    }
+
+    void IncrementalVerifier::updateTransition(const Transition &transition)
+    {
+        auto it = edgeIndex.find(transition.id);
+        if (it == edgeIndex.end())
+            throw std::invalid_argument("Unknown transition: " + transition.id);
+        const Edge &edge = edges[it->second];
+        uint32_t from = node(transition.from);
+        uint32_t to = node(transition.to);
+
+        auto input = inputIndex.find(transition.input);
+        int32_t current = transition.input.empty() ? -1 : input == inputIndex.end() ? -2
+                                                                                     : input->second;
+        if (edge.from == from && edge.to == to && edge.input == current)
+        {
+            // Output, guard and action do not affect the analyses
+            work = 0;
+            edits++;
+            return;
+        }
+        removeTransition(transition.id);
+        uint64_t removal = work;
+        addTransition(transition);
+        work += removal;
+        edits--;
+    }
+
+    // ---------------------------------------------------------------
+    // Report
+    // ---------------------------------------------------------------
+
+    IncrementalReport IncrementalVerifier::report(size_t listLimit) const
+    {
+        IncrementalReport result;
+        result.revision = edits;
+        result.totalStates = liveStates;
+        result.reachableStates = reachableCount;
+        result.transitions = liveEdges;
+        result.initialStates = static_cast<uint32_t>(initialNodes.size());
+        result.deadlockCount = deadlockCount;
+        result.inputAlphabet = alphabet;
+        result.incompleteCount = liveNonFinal - (alphabet < distinctHistogram.size() ? distinctHistogram[alphabet] : 0);
+        result.lastEditWork = work;
+
+        for (uint32_t n = 0; n < nodes.size(); n++)
+        {
+            const Node &state = nodes[n];
+            if (!state.alive)
+                continue;
+            if (!reachable[n])
+            {
+                if (result.unreachableStates.size() < listLimit)
+                    result.unreachableStates.push_back(state.id);
+            }
+            else if (state.isFinal)
+                result.finalReachable = true;
+            if (state.isFinal)
+                continue;
+            if (state.out.empty() && result.deadlocks.size() < listLimit)
+                result.deadlocks.push_back(state.id);
+            if (state.inputs.size() < alphabet && result.incompleteStates.size() < listLimit)
+                result.incompleteStates.push_back(state.id);
+        }
+
+        result.components = static_cast<uint32_t>(order.size());
+        for (uint32_t c : order)
+        {
+            if (members[c].size() == 1 && loops[c] == 0)
+                continue;
+            result.cyclicComponents++;
+            if (exits[c] != 0 || finals[c] != 0 || !reachable[members[c].front()])
+                continue;
+            result.trapComponents++;
+            if (result.traps.size() < listLimit)
+            {
+                std::vector<std::string> ids;
+                for (size_t i = 0; i < members[c].size() && i < listLimit; i++)
+                    ids.push_back(nodes[members[c][i]].id);
+                result.traps.push_back(std::move(ids));
+            }
+        }
+        return result;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,218 @@
+#include "../include/JobScheduler.h"
+#include <algorithm>
+
+namespace ReactiveSystem
+{
+
+    JobScheduler::JobScheduler(unsigned workers)
+    {
+        if (workers == 0)
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        backgroundLimit = std::max<size_t>(1, workers - 1);
+        threads.reserve(workers);
+        for (unsigned i = 0; i < workers; i++)
+            threads.emplace_back(&JobScheduler::workerLoop, this);
+    }
+
+    JobScheduler::~JobScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    std::shared_ptr<CancellationToken> JobScheduler::submit(Work work, Done done, const JobOptions &options)
+    {
+        auto token = std::make_shared<CancellationToken>(options.deadline);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            QueueKey key(options.deadline, sequence++);
+            queues[static_cast<int>(options.priority)].emplace(key, Job{token, std::move(work), std::move(done)});
+        }
+        ready.notify_one();
+        return token;
+    }
+
+    void JobScheduler::cancel(const std::shared_ptr<CancellationToken> &token)
+    {
+        {
+            // Under the lock, so a worker cannot check for cancelled jobs
+            // and then start waiting after this notification
+            std::lock_guard<std::mutex> lock(mutex);
+            token->cancel();
+        }
+        // Wake a worker to complete the job if it is still queued
+        ready.notify_one();
+    }
+
+    JobScheduler::Stats JobScheduler::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result;
+        result.workers = static_cast<unsigned>(threads.size());
+        for (int p = 0; p < 3; p++)
+        {
+            result.queued[p] = queues[p].size();
+            result.running[p] = running[p];
+        }
+        result.completed = completed;
+        result.failed = failed;
+        result.cancelled = cancelledCount;
+        return result;
+    }
+
+    JobPriority JobScheduler::parsePriority(const std::string &name)
+    {
+        if (name == "interactive")
+            return JobPriority::Interactive;
+        if (name == "normal")
+            return JobPriority::Normal;
+        if (name == "bulk")
+            return JobPriority::Bulk;
+        throw std::invalid_argument("Unknown job priority: " + name);
+    }
+
+    /**
+     * Remove queued jobs that were cancelled or expired (all of them when
+     * stopping); called with the lock held
+     */
+    std::vector<JobScheduler::Job> JobScheduler::takeCancelled()
+    {
+        std::vector<Job> taken;
+        for (auto &queue : queues)
+        {
+            for (auto it = queue.begin(); it != queue.end();)
+            {
+                if (stopping)
+                    it->second.token->cancel();
+                if (it->second.token->cancelled())
+                {
+                    taken.push_back(std::move(it->second));
+                    it = queue.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+        return taken;
+    }
+
+    /**
+     * Most urgent runnable job; normal and bulk jobs leave one worker free
+     */
+    bool JobScheduler::takeNext(Job &job, JobPriority &priority)
+    {
+        size_t background = running[1] + running[2];
+        for (int p = 0; p < 3; p++)
+        {
+            if (queues[p].empty() || (p != 0 && background >= backgroundLimit))
+                continue;
+            auto first = queues[p].begin();
+            job = std::move(first->second);
+            queues[p].erase(first);
+            priority = static_cast<JobPriority>(p);
+            return true;
+        }
+        return false;
+    }
+
+    void JobScheduler::workerLoop()
+    {
+        for (;;)
+        {
+            std::vector<Job> dropped;
+            Job job;
+            JobPriority priority = JobPriority::Normal;
+            bool runnable = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                {
+                    dropped = takeCancelled();
+                    if (!dropped.empty())
+                    {
+                        cancelledCount += dropped.size();
+                        break;
+                    }
+                    if (stopping)
+                        return;
+                    if (takeNext(job, priority))
+                    {
+                        running[static_cast<int>(priority)]++;
+                        runnable = true;
+                        break;
+                    }
+
+                    // Sleep until new work, a cancellation or the next deadline
+                    Clock::time_point wake = Clock::time_point::max();
+                    for (const auto &queue : queues)
+                    {
+                        if (!queue.empty())
+                            wake = std::min(wake, queue.begin()->first.first);
+                    }
+                    if (wake == Clock::time_point::max())
+                        ready.wait(lock);
+                    else
+                        ready.wait_until(lock, wake);
+                }
+            }
+
+            for (auto &cancelled : dropped)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    cancelled.token->throwIfCancelled();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                if (cancelled.done)
+                    cancelled.done(error);
+            }
+            if (!runnable)
+                continue;
+
+            std::exception_ptr error;
+            bool wasCancelled = false;
+            try
+            {
+                CancellationScope scope(job.token.get());
+                job.token->throwIfCancelled();
+                job.work();
+            }
+            catch (const JobCancelled &)
+            {
+                error = std::current_exception();
+                wasCancelled = true;
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running[static_cast<int>(priority)]--;
+                if (wasCancelled)
+                    cancelledCount++;
+                else if (error)
+                    failed++;
+                else
+                    completed++;
+            }
+            // A freed background slot may unblock a queued job
+            if (priority != JobPriority::Interactive)
+                ready.notify_one();
+
+            if (job.done)
+                job.done(error);
+        }
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,605 @@
+#include "../include/Json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        class Parser
+        {
+        public:
+            explicit Parser(const std::string &text) : text(text) {}
+
+            JsonValue document()
+            {
+                JsonValue value = parseValue(0);
+                skipWhitespace();
+                if (position != text.size())
+                    fail("trailing characters");
+                return value;
+            }
+
+        private:
+            static constexpr int MaxDepth = 512;
+
+            const std::string &text;
+            size_t position = 0;
+
+            [[noreturn]] void fail(const std::string &message) const
+            {
+                throw std::invalid_argument("JSON error at offset " + std::to_string(position) + ": " + message);
+            }
+
+            void skipWhitespace()
+            {
+                while (position < text.size() &&
+                       (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+                {
+                    position++;
+                }
+            }
+
+            bool consume(const char *literal)
+            {
+                size_t length = std::char_traits<char>::length(literal);
+                if (text.compare(position, length, literal) == 0)
+                {
+                    position += length;
+                    return true;
+                }
+                return false;
+            }
+
+            JsonValue parseValue(int depth)
+            {
+                if (depth > MaxDepth)
+                    fail("nesting too deep");
+
+                skipWhitespace();
+                if (position >= text.size())
+                    fail("unexpected end of input");
+
+                char c = text[position];
+                if (c == '{')
+                    return parseObject(depth);
+                if (c == '[')
+                    return parseArray(depth);
+                if (c == '"')
+                    return JsonValue::string(parseString());
+                if (consume("true"))
+                    return JsonValue::boolean(true);
+                if (consume("false"))
+                    return JsonValue::boolean(false);
+                if (consume("null"))
+                    return JsonValue();
+                if (c == '-' || (c >= '0' && c <= '9'))
+                    return parseNumber();
+                fail(std::string("unexpected character '") + c + "'");
+            }
+
+            JsonValue parseObject(int depth)
+            {
+                JsonValue object = JsonValue::object();
+                position++;
+                skipWhitespace();
+                if (position < text.size() && text[position] == '}')
+                {
+                    position++;
+                    return object;
+                }
+
+                while (true)
+                {
+                    skipWhitespace();
+                    if (position >= text.size() || text[position] != '"')
+                        fail("expected member name");
+                    std::string key = parseString();
+
+                    skipWhitespace();
+                    if (position >= text.size() || text[position] != ':')
+                        fail("expected ':'");
+                    position++;
+                    object.set(key, parseValue(depth + 1));
+
+                    skipWhitespace();
+                    if (position < text.size() && text[position] == ',')
+                    {
+                        position++;
+                        continue;
+                    }
+                    if (position < text.size() && text[position] == '}')
+                    {
+                        position++;
+                        return object;
+                    }
+                    fail("expected ',' or '}'");
+                }
+            }
+
+            JsonValue parseArray(int depth)
+            {
+                JsonValue array = JsonValue::array();
+                position++;
+                skipWhitespace();
+                if (position < text.size() && text[position] == ']')
+                {
+                    position++;
+                    return array;
+                }
+
+                while (true)
+                {
+                    array.push(parseValue(depth + 1));
+                    skipWhitespace();
+                    if (position < text.size() && text[position] == ',')
+                    {
+                        position++;
+                        continue;
+                    }
+                    if (position < text.size() && text[position] == ']')
+                    {
+                        position++;
+                        return array;
+                    }
+                    fail("expected ',' or ']'");
+                }
+            }
+
+            JsonValue parseNumber()
+            {
+                const char *begin = text.c_str() + position;
+                char *end = nullptr;
+                double value = std::strtod(begin, &end);
+                if (end == begin)
+                    fail("invalid number");
+                position += static_cast<size_t>(end - begin);
+                return JsonValue::number(value);
+            }
+
+            unsigned hex4()
+            {
+                if (text.size() - position < 4)
+                    fail("truncated escape");
+                unsigned value = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char c = text[position++];
+                    value <<= 4;
+                    if (c >= '0' && c <= '9')
+                        value |= static_cast<unsigned>(c - '0');
+                    else if (c >= 'a' && c <= 'f')
+                        value |= static_cast<unsigned>(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F')
+                        value |= static_cast<unsigned>(c - 'A' + 10);
+                    else
+                        fail("invalid escape");
+                }
+                return value;
+            }
+
+            static void appendUtf8(std::string &out, unsigned code)
+            {
+                if (code < 0x80)
+                {
+                    out += static_cast<char>(code);
+                }
+                else if (code < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            std::string parseString()
+            {
+                std::string out;
+                position++;
+                while (true)
+                {
+                    if (position >= text.size())
+                        fail("unterminated string");
+                    char c = text[position++];
+                    if (c == '"')
+                        return out;
+                    if (c != '\\')
+                    {
+                        out += c;
+                        continue;
+                    }
+
+                    if (position >= text.size())
+                        fail("unterminated string");
+                    char escape = text[position++];
+                    switch (escape)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        out += escape;
+                        break;
+                    case 'b':
+                        out += '\b';
+                        break;
+                    case 'f':
+                        out += '\f';
+                        break;
+                    case 'n':
+                        out += '\n';
+                        break;
+                    case 'r':
+                        out += '\r';
+                        break;
+                    case 't':
+                        out += '\t';
+                        break;
+                    case 'u':
+                    {
+                        unsigned code = hex4();
+                        if (code >= 0xD800 && code < 0xDC00 && consume("\\u"))
+                        {
+                            unsigned low = hex4();
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, code);
+                        break;
+                    }
+                    default:
+                        fail("invalid escape");
+                    }
+                }
+            }
+        };
+
+        void dumpString(std::string &out, const std::string &value)
+        {
+            out += '"';
+            for (unsigned char c : value)
+            {
+                switch (c)
+                {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                default:
+                    if (c < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    }
+                    else
+                    {
+                        out += static_cast<char>(c);
+                    }
+                }
+            }
+            out += '"';
+        }
+
+        std::string numberText(double value)
+        {
+            char buffer[32];
+            if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 9.007199254740992e15)
+                std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+            else if (std::isfinite(value))
+                std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+            else
+                return "null";
+            return buffer;
+        }
+    } // namespace
+
+    JsonValue JsonValue::parse(const std::string &text)
+    {
+        return Parser(text).document();
+    }
+
+    JsonValue JsonValue::boolean(bool value)
+    {
+        JsonValue result;
+        result.kind = Type::Boolean;
+        result.flag = value;
+        return result;
+    }
+
+    JsonValue JsonValue::number(double value)
+    {
+        JsonValue result;
+        result.kind = Type::Number;
+        result.numberValue = value;
+        return result;
+    }
+
+    JsonValue JsonValue::string(const std::string &value)
+    {
+        JsonValue result;
+        result.kind = Type::String;
+        result.text = value;
+        return result;
+    }
+
+    JsonValue JsonValue::array()
+    {
+        JsonValue result;
+        result.kind = Type::Array;
+        return result;
+    }
+
+    JsonValue JsonValue::object()
+    {
+        JsonValue result;
+        result.kind = Type::Object;
+        return result;
+    }
+
+    const JsonValue *JsonValue::get(const std::string &key) const
+    {
+        for (const auto &field : fields)
+        {
+            if (field.first == key)
+                return &field.second;
+        }
+        return nullptr;
+    }
+
+    std::string JsonValue::getString(const std::string &key, const std::string &fallback) const
+    {
+        const JsonValue *value = get(key);
+        if (!value)
+            return fallback;
+        switch (value->kind)
+        {
+        case Type::String:
+            return value->text;
+        case Type::Number:
+            return numberText(value->numberValue);
+        case Type::Boolean:
+            return value->flag ? "true" : "false";
+        default:
+            return fallback;
+        }
+    }
+
+    JsonValue &JsonValue::push(JsonValue value)
+    {
+        elements.push_back(std::move(value));
+        return elements.back();
+    }
+
+    JsonValue &JsonValue::set(const std::string &key, JsonValue value)
+    {
+        for (auto &field : fields)
+        {
+            if (field.first == key)
+            {
+                field.second = std::move(value);
+                return field.second;
+            }
+        }
+        fields.emplace_back(key, std::move(value));
+        return fields.back().second;
+    }
+
+    std::string JsonValue::dump() const
+    {
+        std::string out;
+        dump(out);
+        return out;
+    }
+
+    void JsonValue::dump(std::string &out) const
+    {
+        switch (kind)
+        {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Boolean:
+            out += flag ? "true" : "false";
+            break;
+        case Type::Number:
+            out += numberText(numberValue);
+            break;
+        case Type::String:
+            dumpString(out, text);
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < elements.size(); i++)
+            {
+                if (i > 0)
+                    out += ',';
+                elements[i].dump(out);
+            }
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < fields.size(); i++)
+            {
+                if (i > 0)
+                    out += ',';
+                dumpString(out, fields[i].first);
+                out += ':';
+                fields[i].second.dump(out);
+            }
+            out += '}';
+            break;
+        }
+    }
+
+    namespace
+    {
+        std::vector<Variable> variablesFromJson(const JsonValue *json)
+        {
+            std::vector<Variable> variables;
+            if (!json || !json->isArray())
+                return variables;
+
+            for (const auto &item : json->items())
+            {
+                Variable variable;
+                variable.name = item.getString("name");
+                variable.type = item.getString("type");
+                variable.initialValue = item.getString("initialValue");
+                const JsonValue *range = item.get("range");
+                if (range && range->isObject())
+                {
+                    variable.hasRange = true;
+                    variable.min = range->get("min") ? static_cast<long long>(range->get("min")->asNumber()) : 0;
+                    variable.max = range->get("max") ? static_cast<long long>(range->get("max")->asNumber()) : 0;
+                }
+                variables.push_back(variable);
+            }
+            return variables;
+        }
+
+        JsonValue variablesToJson(const std::vector<Variable> &variables)
+        {
+            JsonValue json = JsonValue::array();
+            for (const auto &variable : variables)
+            {
+                JsonValue item = JsonValue::object();
+                item.set("name", JsonValue::string(variable.name));
+                item.set("type", JsonValue::string(variable.type));
+                item.set("initialValue", JsonValue::string(variable.initialValue));
+                if (variable.hasRange)
+                {
+                    JsonValue range = JsonValue::object();
+                    range.set("min", JsonValue::number(static_cast<double>(variable.min)));
+                    range.set("max", JsonValue::number(static_cast<double>(variable.max)));
+                    item.set("range", range);
+                }
+                json.push(item);
+            }
+            return json;
+        }
+    } // namespace
+
+    StateMachine stateMachineFromJson(const JsonValue &json)
+    {
+        if (!json.isObject())
+        {
+            throw std::invalid_argument("State machine object expected");
+        }
+
+        StateMachine machine;
+        machine.id = json.getString("id");
+        machine.name = json.getString("name");
+        machine.type = json.getString("type") == "mealy" ? "mealy" : "moore";
+
+        if (const JsonValue *states = json.get("states"))
+        {
+            for (const auto &item : states->items())
+            {
+                State state;
+                state.id = item.getString("id");
+                state.name = item.getString("name");
+                state.isInitial = item.get("isInitial") && item.get("isInitial")->asBool();
+                state.isFinal = item.get("isFinal") && item.get("isFinal")->asBool();
+                state.parent = item.getString("parent");
+                state.kind = item.getString("kind");
+                machine.states.push_back(state);
+            }
+        }
+
+        if (const JsonValue *transitions = json.get("transitions"))
+        {
+            for (const auto &item : transitions->items())
+            {
+                Transition transition;
+                transition.id = item.getString("id");
+                transition.from = item.getString("from");
+                transition.to = item.getString("to");
+                transition.input = item.getString("input");
+                transition.output = item.getString("output");
+                transition.guard = item.getString("guard");
+                transition.action = item.getString("action");
+                machine.transitions.push_back(transition);
+            }
+        }
+
+        machine.inputVariables = variablesFromJson(json.get("inputVariables"));
+        machine.outputVariables = variablesFromJson(json.get("outputVariables"));
+        machine.stateVariables = variablesFromJson(json.get("stateVariables"));
+        return machine;
+    }
+
+    JsonValue stateMachineToJson(const StateMachine &machine)
+    {
+        JsonValue json = JsonValue::object();
+        json.set("id", JsonValue::string(machine.id));
+        json.set("name", JsonValue::string(machine.name));
+        json.set("type", JsonValue::string(machine.type));
+
+        JsonValue states = JsonValue::array();
+        for (const auto &state : machine.states)
+        {
+            JsonValue item = JsonValue::object();
+            item.set("id", JsonValue::string(state.id));
+            item.set("name", JsonValue::string(state.name));
+            item.set("isInitial", JsonValue::boolean(state.isInitial));
+            item.set("isFinal", JsonValue::boolean(state.isFinal));
+            if (!state.parent.empty())
+                item.set("parent", JsonValue::string(state.parent));
+            if (!state.kind.empty())
+                item.set("kind", JsonValue::string(state.kind));
+            states.push(item);
+        }
+        json.set("states", states);
+
+        JsonValue transitions = JsonValue::array();
+        for (const auto &transition : machine.transitions)
+        {
+            JsonValue item = JsonValue::object();
+            item.set("id", JsonValue::string(transition.id));
+            item.set("from", JsonValue::string(transition.from));
+            item.set("to", JsonValue::string(transition.to));
+            if (!transition.input.empty())
+                item.set("input", JsonValue::string(transition.input));
+            if (!transition.output.empty())
+                item.set("output", JsonValue::string(transition.output));
+            if (!transition.guard.empty())
+                item.set("guard", JsonValue::string(transition.guard));
+            if (!transition.action.empty())
+                item.set("action", JsonValue::string(transition.action));
+            transitions.push(item);
+        }
+        json.set("transitions", transitions);
+
+        json.set("inputVariables", variablesToJson(machine.inputVariables));
+        json.set("outputVariables", variablesToJson(machine.outputVariables));
+        json.set("stateVariables", variablesToJson(machine.stateVariables));
+        return json;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,362 @@
+#include "../include/Kiss2.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    int32_t KissMachine::match(uint32_t state, uint64_t minterm) const
+    {
+        for (uint32_t e = graph.edgeOffsets[state]; e < graph.edgeOffsets[state + 1]; e++)
+        {
+            const KissCube &cube = cubes[graph.edgeInputs[e]];
+            if ((minterm & cube.care) == cube.value)
+                return static_cast<int32_t>(e);
+        }
+        return -1;
+    }
+
+    uint64_t KissMachine::mintermCount(int32_t input) const
+    {
+        uint32_t free = inputBits;
+        uint64_t care = cubes[input].care;
+        while (care)
+        {
+            free--;
+            care &= care - 1;
+        }
+        return free >= 64 ? UINT64_MAX : uint64_t(1) << free;
+    }
+
+    StateMachine KissMachine::toStateMachine(const std::string &name) const
+    {
+        StateMachine machine;
+        machine.id = name;
+        machine.name = name;
+        machine.type = "mealy";
+
+        for (size_t s = 0; s < graph.stateCount(); s++)
+        {
+            State state;
+            state.id = graph.stateIds[s];
+            state.name = graph.stateNames[s];
+            state.isInitial = static_cast<int32_t>(s) == graph.initialState;
+            machine.states.push_back(state);
+        }
+
+        // Edges are grouped by state; emit them back in product-term order
+        std::vector<uint32_t> byTerm(graph.edgeCount());
+        std::vector<uint32_t> sources(graph.edgeCount());
+        for (uint32_t s = 0; s < graph.stateCount(); s++)
+        {
+            for (uint32_t e = graph.edgeOffsets[s]; e < graph.edgeOffsets[s + 1]; e++)
+            {
+                sources[e] = s;
+            }
+        }
+        for (uint32_t e = 0; e < graph.edgeCount(); e++)
+        {
+            byTerm[e] = e;
+        }
+        std::stable_sort(byTerm.begin(), byTerm.end(), [this](uint32_t a, uint32_t b)
+                         { return graph.edgeTransitions[a] < graph.edgeTransitions[b]; });
+
+        machine.transitions.reserve(graph.edgeCount());
+        for (uint32_t e : byTerm)
+        {
+            Transition transition;
+            transition.id = "t" + std::to_string(graph.edgeTransitions[e]);
+            if (graph.edgeCount() != productTerms)
+            {
+                // "*" terms fan out to several edges
+                transition.id += "_" + graph.stateIds[sources[e]];
+            }
+            transition.from = graph.stateIds[sources[e]];
+            transition.to = graph.stateIds[graph.edgeTargets[e]];
+            transition.input = graph.inputSymbols[graph.edgeInputs[e]];
+            if (graph.edgeOutputs[e] != CompiledMachine::NoOutput)
+                transition.output = graph.outputSymbols[graph.edgeOutputs[e]];
+            machine.transitions.push_back(transition);
+        }
+        return machine;
+    }
+
+    namespace
+    {
+        int32_t intern(
+            const std::string &symbol,
+            std::vector<std::string> &symbols,
+            std::unordered_map<std::string, uint32_t> &index)
+        {
+            auto it = index.find(symbol);
+            if (it != index.end())
+                return static_cast<int32_t>(it->second);
+            index.emplace(symbol, static_cast<uint32_t>(symbols.size()));
+            symbols.push_back(symbol);
+            return static_cast<int32_t>(symbols.size() - 1);
+        }
+
+        bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+    } // namespace
+
+    void KissParser::fail(const std::string &message) const
+    {
+        throw std::invalid_argument("KISS2 line " + std::to_string(line) + ": " + message);
+    }
+
+    uint64_t KissParser::number(const std::string &token) const
+    {
+        uint64_t value = 0;
+        for (char c : token)
+        {
+            if (c < '0' || c > '9' || value > UINT32_MAX)
+                fail("invalid number " + token);
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return value;
+    }
+
+    uint32_t KissParser::state(const std::string &name)
+    {
+        if (name == "*")
+            return AnyState;
+        return static_cast<uint32_t>(intern(name, stateNames, stateIndex));
+    }
+
+    void KissParser::feed(const char *data, size_t size)
+    {
+        bytes += size;
+        const char *end = data + size;
+
+        while (data < end)
+        {
+            const char *newline = static_cast<const char *>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+            if (!newline)
+            {
+                partial.append(data, end);
+                return;
+            }
+
+            line++;
+            if (partial.empty())
+            {
+                parseLine(data, newline);
+            }
+            else
+            {
+                partial.append(data, newline);
+                parseLine(partial.data(), partial.data() + partial.size());
+                partial.clear();
+            }
+            data = newline + 1;
+        }
+    }
+
+    void KissParser::parseLine(const char *begin, const char *end)
+    {
+        if (ended)
+            return;
+
+        // Split into at most five whitespace-separated tokens; '#' starts a comment
+        std::string tokens[5];
+        size_t count = 0;
+        for (const char *p = begin; p < end;)
+        {
+            while (p < end && isSpace(*p))
+                p++;
+            if (p == end || *p == '#')
+                break;
+            const char *start = p;
+            while (p < end && !isSpace(*p))
+                p++;
+            if (count == 5)
+                fail("too many fields");
+            tokens[count++].assign(start, p);
+        }
+        if (count == 0)
+            return;
+
+        if (tokens[0][0] == '.')
+        {
+            const std::string &directive = tokens[0];
+            if (directive == ".e" || directive == ".end")
+            {
+                ended = true;
+            }
+            else if (directive == ".i" || directive == ".o")
+            {
+                if (count < 2 || sawTerm)
+                    fail(directive + " must precede the product terms and take a number");
+                uint64_t bits = number(tokens[1]);
+                if (directive == ".i" && bits > 64)
+                    fail("more than 64 inputs are not supported");
+                (directive == ".i" ? inputBits : outputBits) = static_cast<uint32_t>(bits);
+            }
+            else if (directive == ".p" && count >= 2)
+            {
+                // Advisory only: cap the reservation rather than trust the header
+                size_t expected = static_cast<size_t>(std::min<uint64_t>(number(tokens[1]), uint64_t(1) << 24));
+                termFrom.reserve(expected);
+                termTo.reserve(expected);
+                termInput.reserve(expected);
+                termOutput.reserve(expected);
+            }
+            else if (directive == ".s" && count >= 2)
+            {
+                stateIndex.reserve(static_cast<size_t>(std::min<uint64_t>(number(tokens[1]), uint64_t(1) << 24)));
+            }
+            else if (directive == ".r" && count >= 2)
+            {
+                resetState = tokens[1];
+                state(resetState);
+            }
+            // Other directives (.ilb, .ob, .type, ...) do not affect the machine
+            return;
+        }
+
+        sawTerm = true;
+        const size_t expected = (inputBits > 0 ? 1 : 0) + 2 + (outputBits > 0 ? 1 : 0);
+        if (count != expected)
+            fail("expected " + std::to_string(expected) + " fields, found " + std::to_string(count));
+
+        size_t field = 0;
+        std::string cube = inputBits > 0 ? tokens[field++] : std::string();
+        if (cube.size() != inputBits)
+            fail("input cube " + cube + " does not have " + std::to_string(inputBits) + " bits");
+        for (char c : cube)
+        {
+            if (c != '0' && c != '1' && c != '-')
+                fail("invalid input cube " + cube);
+        }
+
+        // Terms are usually grouped by current state
+        uint32_t from;
+        if (tokens[field] == lastFromName)
+        {
+            from = lastFrom;
+            field++;
+        }
+        else
+        {
+            lastFromName = tokens[field];
+            from = lastFrom = state(tokens[field++]);
+        }
+        uint32_t to = state(tokens[field++]);
+        if (to == AnyState)
+            fail("next state cannot be *");
+
+        int32_t output = CompiledMachine::NoOutput;
+        if (outputBits > 0)
+        {
+            if (tokens[field].size() != outputBits)
+                fail("output cube " + tokens[field] + " does not have " + std::to_string(outputBits) + " bits");
+            output = intern(tokens[field], outputSymbols, outputIndex);
+        }
+
+        termFrom.push_back(from);
+        termTo.push_back(to);
+        termInput.push_back(intern(cube, inputSymbols, inputIndex));
+        termOutput.push_back(output);
+    }
+
+    KissMachine KissParser::finish()
+    {
+        if (!partial.empty())
+        {
+            line++;
+            parseLine(partial.data(), partial.data() + partial.size());
+            partial.clear();
+        }
+
+        KissMachine machine;
+        machine.inputBits = inputBits;
+        machine.outputBits = outputBits;
+        machine.productTerms = termFrom.size();
+
+        CompiledMachine &graph = machine.graph;
+        const size_t stateCount = stateNames.size();
+        graph.stateIds = stateNames;
+        graph.stateNames = stateNames;
+        graph.finalStates.assign(stateCount, 0);
+        graph.stateIndex.swap(stateIndex);
+        graph.initialState = stateCount == 0 ? -1 : (resetState.empty() ? 0 : static_cast<int32_t>(graph.stateIndex.at(resetState)));
+        graph.inputSymbols.swap(inputSymbols);
+        graph.inputIndex.swap(inputIndex);
+        graph.outputSymbols.swap(outputSymbols);
+        graph.outputIndex.swap(outputIndex);
+
+        // Count out-degrees ("*" terms leave every state), then scatter in term order
+        graph.edgeOffsets.assign(stateCount + 1, 0);
+        uint64_t anyTerms = 0;
+        for (uint32_t from : termFrom)
+        {
+            if (from == AnyState)
+                anyTerms++;
+            else
+                graph.edgeOffsets[from + 1]++;
+        }
+
+        // Edge offsets are 32-bit, and each "*" term multiplies by the state count
+        const uint64_t edgeTotal = (termFrom.size() - anyTerms) + anyTerms * stateCount;
+        if (edgeTotal > UINT32_MAX)
+            fail("machine expands to " + std::to_string(edgeTotal) + " edges, more than " +
+                 std::to_string(UINT32_MAX) + " are not supported");
+        for (size_t s = 0; s < stateCount; s++)
+        {
+            graph.edgeOffsets[s + 1] += graph.edgeOffsets[s] + static_cast<uint32_t>(anyTerms);
+        }
+
+        const size_t edgeCount = graph.edgeOffsets.back();
+        graph.edgeTargets.resize(edgeCount);
+        graph.edgeInputs.resize(edgeCount);
+        graph.edgeOutputs.resize(edgeCount);
+        graph.edgeTransitions.resize(edgeCount);
+
+        std::vector<uint32_t> cursor(graph.edgeOffsets.begin(), graph.edgeOffsets.end() - 1);
+        auto place = [&](uint32_t from, size_t term)
+        {
+            uint32_t slot = cursor[from]++;
+            graph.edgeTargets[slot] = termTo[term];
+            graph.edgeInputs[slot] = termInput[term];
+            graph.edgeOutputs[slot] = termOutput[term];
+            graph.edgeTransitions[slot] = static_cast<uint32_t>(term);
+        };
+        for (size_t term = 0; term < termFrom.size(); term++)
+        {
+            if (termFrom[term] != AnyState)
+            {
+                place(termFrom[term], term);
+                continue;
+            }
+            for (uint32_t s = 0; s < stateCount; s++)
+            {
+                place(s, term);
+            }
+        }
+
+        // Decode each distinct cube once
+        machine.cubes.reserve(graph.inputSymbols.size());
+        for (const auto &text : graph.inputSymbols)
+        {
+            KissCube cube{0, 0};
+            for (size_t bit = 0; bit < text.size(); bit++)
+            {
+                if (text[bit] != '-')
+                {
+                    cube.care |= uint64_t(1) << bit;
+                    if (text[bit] == '1')
+                        cube.value |= uint64_t(1) << bit;
+                }
+            }
+            machine.cubes.push_back(cube);
+        }
+
+        *this = KissParser();
+        return machine;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,219 @@
+#include "../include/Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    namespace MetricsDetail
+    {
+        size_t threadShard()
+        {
+            static std::atomic<size_t> next{0};
+            static thread_local size_t shard = next++ % Shards;
+            return shard;
+        }
+    }
+
+    uint64_t Counter::value() const
+    {
+        uint64_t total = 0;
+        for (const auto &shard : shards)
+            total += shard.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    HdrHistogram::~HdrHistogram()
+    {
+        for (auto &shard : shards)
+            delete shard.load(std::memory_order_relaxed);
+    }
+
+    HdrHistogram::Shard &HdrHistogram::allocate(size_t index)
+    {
+        Shard *created = new Shard();
+        Shard *expected = nullptr;
+        if (!shards[index].compare_exchange_strong(expected, created, std::memory_order_acq_rel))
+        {
+            // Another thread of this shard got there first
+            delete created;
+            return *expected;
+        }
+        return *created;
+    }
+
+    uint64_t HdrHistogram::highestEquivalent(size_t bucket)
+    {
+        if (bucket < SubBuckets)
+            return bucket;
+        unsigned exponent = static_cast<unsigned>((bucket - SubBuckets) / SubBuckets) + SubBits;
+        uint64_t mantissa = (bucket - SubBuckets) % SubBuckets;
+        uint64_t width = uint64_t(1) << (exponent - SubBits);
+        uint64_t lowest = (uint64_t(1) << exponent) | (mantissa * width);
+        return lowest + width - 1;
+    }
+
+    HdrHistogram::Snapshot HdrHistogram::snapshot() const
+    {
+        Snapshot result;
+        result.buckets.assign(BucketCount, 0);
+        for (const auto &slot : shards)
+        {
+            const Shard *shard = slot.load(std::memory_order_acquire);
+            if (!shard)
+                continue;
+            result.sum += shard->sum.load(std::memory_order_relaxed);
+            result.max = std::max(result.max, shard->max.load(std::memory_order_relaxed));
+            for (size_t b = 0; b < BucketCount; b++)
+                result.buckets[b] += shard->buckets[b].load(std::memory_order_relaxed);
+        }
+        for (uint64_t n : result.buckets)
+            result.count += n;
+        return result;
+    }
+
+    uint64_t HdrHistogram::Snapshot::quantile(double q) const
+    {
+        if (count == 0)
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * count));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); b++)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return std::min(highestEquivalent(b), max);
+        }
+        return max;
+    }
+
+    MetricsRegistry &MetricsRegistry::global()
+    {
+        // Never destroyed, so metrics outlive every thread recording them
+        static MetricsRegistry *registry = new MetricsRegistry();
+        return *registry;
+    }
+
+    /**
+     * The kind is checked against every entry of the name, whatever its
+     * labels: the exporter writes one family per name, of one type
+     */
+    MetricsRegistry::Entry *MetricsRegistry::find(const std::string &name, const std::string &labels, bool counter)
+    {
+        Entry *found = nullptr;
+        for (auto &entry : entries)
+        {
+            if (entry.name != name)
+                continue;
+            if (static_cast<bool>(entry.counter) != counter)
+                throw std::invalid_argument("Metric " + name + " is not a " + (counter ? "counter" : "histogram"));
+            if (entry.labels == labels)
+                found = &entry;
+        }
+        return found;
+    }
+
+    Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry *entry = find(name, labels, true);
+        if (entry)
+            return *entry->counter;
+
+        entries.push_back(Entry{name, help, labels, 1, std::make_unique<Counter>(), nullptr});
+        return *entries.back().counter;
+    }
+
+    HdrHistogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, const std::string &labels,
+                                             double scale)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry *entry = find(name, labels, false);
+        if (entry)
+            return *entry->histogram;
+
+        entries.push_back(Entry{name, help, labels, scale, nullptr, std::make_unique<HdrHistogram>()});
+        return *entries.back().histogram;
+    }
+
+    void MetricsRegistry::writeHeader(std::string &out, const std::string &name, const char *type,
+                                      const std::string &help)
+    {
+        out += "# HELP " + name + " " + help + "\n";
+        out += "# TYPE " + name + " " + type + "\n";
+    }
+
+    void MetricsRegistry::writeSample(std::string &out, const std::string &name, const std::string &labels,
+                                      double value)
+    {
+        std::ostringstream line;
+        line.precision(12);
+        line << name;
+        if (!labels.empty())
+            line << "{" << labels << "}";
+        line << " " << value << "\n";
+        out += line.str();
+    }
+
+    std::string MetricsRegistry::prometheusText() const
+    {
+        static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string out;
+        std::vector<bool> written(entries.size(), false);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (written[i])
+                continue;
+
+            // A family is every entry with this name, whatever its labels
+            const Entry &first = entries[i];
+            std::vector<const Entry *> family;
+            for (size_t j = i; j < entries.size(); j++)
+            {
+                if (entries[j].name == first.name)
+                {
+                    family.push_back(&entries[j]);
+                    written[j] = true;
+                }
+            }
+
+            if (first.counter)
+            {
+                writeHeader(out, first.name, "counter", first.help);
+                for (const Entry *entry : family)
+                    writeSample(out, entry->name, entry->labels, static_cast<double>(entry->counter->value()));
+                continue;
+            }
+
+            std::vector<HdrHistogram::Snapshot> snapshots;
+            for (const Entry *entry : family)
+                snapshots.push_back(entry->histogram->snapshot());
+
+            writeHeader(out, first.name, "summary", first.help);
+            for (size_t k = 0; k < family.size(); k++)
+            {
+                const Entry &entry = *family[k];
+                std::string separator = entry.labels.empty() ? "" : ",";
+                for (double q : quantiles)
+                {
+                    std::ostringstream label;
+                    label << entry.labels << separator << "quantile=\"" << q << "\"";
+                    writeSample(out, entry.name, label.str(), snapshots[k].quantile(q) * entry.scale);
+                }
+                writeSample(out, entry.name + "_sum", entry.labels, snapshots[k].sum * entry.scale);
+                writeSample(out, entry.name + "_count", entry.labels, static_cast<double>(snapshots[k].count));
+            }
+            writeHeader(out, first.name + "_max", "gauge", "Largest value of " + first.name);
+            for (size_t k = 0; k < family.size(); k++)
+                writeSample(out, family[k]->name + "_max", family[k]->labels, snapshots[k].max * family[k]->scale);
+        }
+        return out;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,419 @@
+#include "../include/ModelFile.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        /**
+         * Interns strings for the writer; id 0 is the empty string
+         */
+        class StringTable
+        {
+        public:
+            explicit StringTable(size_t expected)
+            {
+                values.reserve(expected);
+                index.reserve(expected);
+                intern(std::string());
+            }
+
+            uint32_t intern(const std::string &value)
+            {
+                auto it = index.find(value);
+                if (it != index.end())
+                {
+                    return it->second;
+                }
+                uint32_t id = static_cast<uint32_t>(values.size());
+                values.push_back(value);
+                index.emplace(value, id);
+                return id;
+            }
+
+            const std::vector<std::string> &strings() const { return values; }
+
+        private:
+            std::vector<std::string> values;
+            std::unordered_map<std::string, uint32_t> index;
+        };
+
+        size_t align8(size_t offset)
+        {
+            return (offset + 7) & ~size_t(7);
+        }
+
+        template <class T>
+        size_t appendSection(std::vector<uint8_t> &out, const T *data, size_t count)
+        {
+            size_t offset = align8(out.size());
+            out.resize(offset + count * sizeof(T));
+            if (count > 0)
+            {
+                std::memcpy(out.data() + offset, data, count * sizeof(T));
+            }
+            return offset;
+        }
+
+        bool sectionFits(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize)
+        {
+            return offset % 8 == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+        }
+    } // namespace
+
+    MappedModel::~MappedModel()
+    {
+#ifndef _WIN32
+        if (mapped && base)
+        {
+            munmap(const_cast<uint8_t *>(base), size);
+        }
+#else
+        delete[] base;
+#endif
+    }
+
+    std::unique_ptr<MappedModel> MappedModel::open(const std::string &path)
+    {
+        std::unique_ptr<MappedModel> model(new MappedModel());
+
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open model file " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ModelHeader)))
+        {
+            ::close(fd);
+            throw std::invalid_argument("Not a model file: " + path);
+        }
+
+        model->size = static_cast<size_t>(info.st_size);
+        void *address = mmap(nullptr, model->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map model file " + path);
+        }
+        model->base = static_cast<const uint8_t *>(address);
+        model->mapped = true;
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open model file " + path);
+        }
+        std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        uint8_t *copy = new uint8_t[contents.size()];
+        std::memcpy(copy, contents.data(), contents.size());
+        model->base = copy;
+        model->size = contents.size();
+#endif
+
+        model->validate();
+        return model;
+    }
+
+    /**
+     * Check the header and that every section and index lies inside the file,
+     * so accessors never read out of bounds
+     */
+    void MappedModel::validate()
+    {
+        if (size < sizeof(ModelHeader))
+        {
+            throw std::invalid_argument("Model file is truncated");
+        }
+
+        head = reinterpret_cast<const ModelHeader *>(base);
+        if (std::memcmp(head->magic, ModelHeader::Magic, sizeof(head->magic)) != 0)
+        {
+            throw std::invalid_argument("Not a model file");
+        }
+        if (head->version != ModelHeader::CurrentVersion || head->headerSize != sizeof(ModelHeader))
+        {
+            throw std::invalid_argument("Unsupported model file version " + std::to_string(head->version));
+        }
+        if (head->fileSize != size)
+        {
+            throw std::invalid_argument("Model file is truncated");
+        }
+
+        const ModelHeader &h = *head;
+        if (h.stringCount == 0 ||
+            !sectionFits(h.stringsOffset, uint64_t(h.stringCount) + 1, sizeof(uint64_t), size) ||
+            !sectionFits(h.statesOffset, h.stateCount, sizeof(ModelState), size) ||
+            !sectionFits(h.edgeOffsetsOffset, uint64_t(h.stateCount) + 1, sizeof(uint32_t), size) ||
+            !sectionFits(h.edgeTargetsOffset, h.edgeCount, sizeof(uint32_t), size) ||
+            !sectionFits(h.edgeInputsOffset, h.edgeCount, sizeof(int32_t), size) ||
+            !sectionFits(h.edgeOutputsOffset, h.edgeCount, sizeof(int32_t), size) ||
+            !sectionFits(h.edgeLabelsOffset, h.edgeCount, sizeof(ModelEdgeLabel), size) ||
+            !sectionFits(h.inputsOffset, h.inputCount, sizeof(uint32_t), size) ||
+            !sectionFits(h.outputsOffset, h.outputCount, sizeof(uint32_t), size) ||
+            !sectionFits(h.variablesOffset, h.variableCount, sizeof(ModelVariable), size))
+        {
+            throw std::invalid_argument("Model file section out of bounds");
+        }
+
+        stringOffsets = reinterpret_cast<const uint64_t *>(base + h.stringsOffset);
+        states = reinterpret_cast<const ModelState *>(base + h.statesOffset);
+        edgeOffsets = reinterpret_cast<const uint32_t *>(base + h.edgeOffsetsOffset);
+        edgeTargets = reinterpret_cast<const uint32_t *>(base + h.edgeTargetsOffset);
+        edgeInputs = reinterpret_cast<const int32_t *>(base + h.edgeInputsOffset);
+        edgeOutputs = reinterpret_cast<const int32_t *>(base + h.edgeOutputsOffset);
+        edgeLabels = reinterpret_cast<const ModelEdgeLabel *>(base + h.edgeLabelsOffset);
+        inputs = reinterpret_cast<const uint32_t *>(base + h.inputsOffset);
+        outputs = reinterpret_cast<const uint32_t *>(base + h.outputsOffset);
+        variables = reinterpret_cast<const ModelVariable *>(base + h.variablesOffset);
+
+        if (h.initialState >= 0 && static_cast<uint32_t>(h.initialState) >= h.stateCount)
+        {
+            throw std::invalid_argument("Model initial state out of range");
+        }
+        if (edgeOffsets[0] != 0 || edgeOffsets[h.stateCount] != h.edgeCount)
+        {
+            throw std::invalid_argument("Model transition index is inconsistent");
+        }
+        for (uint32_t s = 0; s < h.stateCount; s++)
+        {
+            if (edgeOffsets[s] > edgeOffsets[s + 1])
+                throw std::invalid_argument("Model transition index is inconsistent");
+        }
+        for (uint32_t e = 0; e < h.edgeCount; e++)
+        {
+            if (edgeTargets[e] >= h.stateCount ||
+                edgeInputs[e] >= static_cast<int64_t>(h.inputCount) ||
+                edgeOutputs[e] >= static_cast<int64_t>(h.outputCount))
+                throw std::invalid_argument("Model transition out of range");
+        }
+    }
+
+    std::string_view MappedModel::string(uint32_t id) const
+    {
+        if (id >= head->stringCount)
+        {
+            return std::string_view();
+        }
+        uint64_t begin = stringOffsets[id];
+        uint64_t end = stringOffsets[id + 1];
+        if (begin > end || end > size)
+        {
+            return std::string_view();
+        }
+        return std::string_view(reinterpret_cast<const char *>(base + begin), static_cast<size_t>(end - begin));
+    }
+
+    void MappedModel::save(const StateMachine &machine, const std::string &path)
+    {
+        CompiledMachine graph = CompiledMachine::compile(machine);
+        // Ids and names are usually distinct; labels mostly repeat
+        StringTable strings(graph.stateCount() * 2 + graph.edgeCount() + 16);
+
+        ModelHeader h{};
+        std::memcpy(h.magic, ModelHeader::Magic, sizeof(h.magic));
+        h.version = ModelHeader::CurrentVersion;
+        h.headerSize = sizeof(ModelHeader);
+        h.machineId = strings.intern(machine.id);
+        h.machineName = strings.intern(machine.name);
+        h.machineType = strings.intern(machine.type);
+        h.initialState = graph.initialState;
+        h.stateCount = static_cast<uint32_t>(graph.stateCount());
+        h.edgeCount = static_cast<uint32_t>(graph.edgeCount());
+        h.inputCount = static_cast<uint32_t>(graph.inputCount());
+        h.outputCount = static_cast<uint32_t>(graph.outputCount());
+
+        std::vector<ModelState> stateRecords(graph.stateCount());
+        for (size_t s = 0; s < graph.stateCount(); s++)
+        {
+            stateRecords[s].id = strings.intern(graph.stateIds[s]);
+            stateRecords[s].name = strings.intern(graph.stateNames[s]);
+            stateRecords[s].flags = (static_cast<int32_t>(s) == graph.initialState ? ModelState::Initial : 0) |
+                                    (graph.finalStates[s] ? ModelState::Final : 0);
+        }
+
+        // Hierarchy: the first occurrence of each id is the compiled state
+        std::vector<uint8_t> described(graph.stateCount(), 0);
+        for (const auto &state : machine.states)
+        {
+            uint32_t s = graph.stateIndex.at(state.id);
+            if (described[s]++)
+                continue;
+            if (state.isInitial)
+                stateRecords[s].flags |= ModelState::Initial;
+            if (!state.parent.empty())
+                stateRecords[s].parent = strings.intern(state.parent);
+            if (state.kind == "parallel")
+                stateRecords[s].flags |= ModelState::Parallel;
+            else if (state.kind == "history")
+                stateRecords[s].flags |= ModelState::History;
+            else if (state.kind == "deepHistory")
+                stateRecords[s].flags |= ModelState::DeepHistory;
+        }
+
+        std::vector<ModelEdgeLabel> labels(graph.edgeCount());
+        for (size_t e = 0; e < graph.edgeCount(); e++)
+        {
+            const Transition &transition = machine.transitions[graph.edgeTransitions[e]];
+            labels[e].transitionId = strings.intern(transition.id);
+            labels[e].guard = strings.intern(transition.guard);
+            labels[e].action = strings.intern(transition.action);
+        }
+
+        std::vector<uint32_t> inputIds, outputIds;
+        for (const auto &symbol : graph.inputSymbols)
+            inputIds.push_back(strings.intern(symbol));
+        for (const auto &symbol : graph.outputSymbols)
+            outputIds.push_back(strings.intern(symbol));
+
+        std::vector<ModelVariable> variableRecords;
+        auto addVariables = [&](const std::vector<Variable> &declared, ModelVariable::Role role)
+        {
+            for (const auto &variable : declared)
+            {
+                ModelVariable record{};
+                record.name = strings.intern(variable.name);
+                record.type = strings.intern(variable.type);
+                record.initialValue = strings.intern(variable.initialValue);
+                record.role = role;
+                record.hasRange = variable.hasRange ? 1 : 0;
+                record.min = variable.min;
+                record.max = variable.max;
+                variableRecords.push_back(record);
+            }
+        };
+        addVariables(machine.inputVariables, ModelVariable::Input);
+        addVariables(machine.outputVariables, ModelVariable::Output);
+        addVariables(machine.stateVariables, ModelVariable::StateVariable);
+        h.variableCount = static_cast<uint32_t>(variableRecords.size());
+
+        // Lay out the file: header placeholder, then the sections in order
+        std::vector<uint8_t> out(sizeof(ModelHeader));
+
+        const auto &table = strings.strings();
+        h.stringCount = static_cast<uint32_t>(table.size());
+        std::vector<uint64_t> offsets(table.size() + 1);
+        h.stringsOffset = appendSection(out, offsets.data(), offsets.size());
+        offsets[0] = out.size();
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            out.insert(out.end(), table[i].begin(), table[i].end());
+            offsets[i + 1] = out.size();
+        }
+        std::memcpy(out.data() + h.stringsOffset, offsets.data(), offsets.size() * sizeof(uint64_t));
+
+        h.statesOffset = appendSection(out, stateRecords.data(), stateRecords.size());
+        h.edgeOffsetsOffset = appendSection(out, graph.edgeOffsets.data(), graph.edgeOffsets.size());
+        h.edgeTargetsOffset = appendSection(out, graph.edgeTargets.data(), graph.edgeTargets.size());
+        h.edgeInputsOffset = appendSection(out, graph.edgeInputs.data(), graph.edgeInputs.size());
+        h.edgeOutputsOffset = appendSection(out, graph.edgeOutputs.data(), graph.edgeOutputs.size());
+        h.edgeLabelsOffset = appendSection(out, labels.data(), labels.size());
+        h.inputsOffset = appendSection(out, inputIds.data(), inputIds.size());
+        h.outputsOffset = appendSection(out, outputIds.data(), outputIds.size());
+        h.variablesOffset = appendSection(out, variableRecords.data(), variableRecords.size());
+        out.resize(align8(out.size()));
+
+        h.fileSize = out.size();
+        std::memcpy(out.data(), &h, sizeof(h));
+
+        // Write beside the target and rename, so readers never map a partial file
+        const std::string temporary = path + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file)
+        {
+            throw std::runtime_error("Cannot write model file " + path);
+        }
+        bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write model file " + path);
+        }
+    }
+
+    StateMachine MappedModel::toStateMachine() const
+    {
+        auto text = [this](uint32_t id)
+        { return std::string(string(id)); };
+
+        StateMachine machine;
+        machine.id = text(head->machineId);
+        machine.name = text(head->machineName);
+        machine.type = text(head->machineType);
+
+        machine.states.reserve(stateCount());
+        for (uint32_t s = 0; s < stateCount(); s++)
+        {
+            State state;
+            state.id = text(states[s].id);
+            state.name = text(states[s].name);
+            state.isInitial = (states[s].flags & ModelState::Initial) != 0;
+            state.isFinal = (states[s].flags & ModelState::Final) != 0;
+            state.parent = text(states[s].parent);
+            if (states[s].flags & ModelState::Parallel)
+                state.kind = "parallel";
+            else if (states[s].flags & ModelState::History)
+                state.kind = "history";
+            else if (states[s].flags & ModelState::DeepHistory)
+                state.kind = "deepHistory";
+            machine.states.push_back(state);
+        }
+
+        machine.transitions.reserve(edgeCount());
+        for (uint32_t s = 0; s < stateCount(); s++)
+        {
+            for (uint32_t e = edgeBegin(s); e < edgeEnd(s); e++)
+            {
+                Transition transition;
+                transition.id = text(edgeLabels[e].transitionId);
+                transition.from = text(states[s].id);
+                transition.to = text(states[edgeTargets[e]].id);
+                if (edgeInputs[e] >= 0)
+                    transition.input = text(inputs[edgeInputs[e]]);
+                if (edgeOutputs[e] >= 0)
+                    transition.output = text(outputs[edgeOutputs[e]]);
+                transition.guard = text(edgeLabels[e].guard);
+                transition.action = text(edgeLabels[e].action);
+                machine.transitions.push_back(transition);
+            }
+        }
+
+        for (uint32_t v = 0; v < variableCount(); v++)
+        {
+            const ModelVariable &record = variables[v];
+            Variable variable;
+            variable.name = text(record.name);
+            variable.type = text(record.type);
+            variable.initialValue = text(record.initialValue);
+            variable.hasRange = record.hasRange != 0;
+            variable.min = record.min;
+            variable.max = record.max;
+
+            if (record.role == ModelVariable::Input)
+                machine.inputVariables.push_back(variable);
+            else if (record.role == ModelVariable::Output)
+                machine.outputVariables.push_back(variable);
+            else
+                machine.stateVariables.push_back(variable);
+        }
+        return machine;
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,650 @@
+#include "../include/ParallelSearch.h"
+#include "../include/Cancellation.h"
+#include "../include/ChaseLevDeque.h"
+#include "../include/ConcurrentStateSet.h"
+#include "../include/Progress.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        // Deadlocks kept for choosing the shortest counterexamples
+        constexpr size_t MaxKeptDeadlocks = 4096;
+
+        uint64_t splitmix(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /**
+         * Successor function of one worker: the chart's configurations,
+         * optionally paired with a non-progress monitor bit appended to the
+         * key (0 = waiting, 1 = committed to never seeing progress again)
+         */
+        class ChartSpace
+        {
+        public:
+            ChartSpace(const Statechart &chart, const std::vector<uint64_t> &marked, bool monitor)
+                : chart(chart), explorer(chart), marked(marked), monitor(monitor), baseWords(explorer.keyWords())
+            {
+            }
+
+            size_t keyWords() const { return baseWords + (monitor ? 1 : 0); }
+
+            void initial(std::vector<uint64_t> &out)
+            {
+                scratch.clear();
+                explorer.initial(scratch);
+                for (size_t i = 0; i < scratch.size(); i += baseWords)
+                    append(out, scratch.data() + i, 0);
+            }
+
+            /**
+             * Successors over every external event, with the event of each;
+             * false when no event is enabled
+             */
+            bool successors(const uint64_t *key, std::vector<uint64_t> &out, std::vector<int32_t> &events)
+            {
+                bool enabled = false;
+                for (int32_t event : chart.externalEvents)
+                {
+                    scratch.clear();
+                    if (!explorer.step(key, event, scratch))
+                        continue;
+                    enabled = true;
+                    for (size_t i = 0; i < scratch.size(); i += baseWords)
+                    {
+                        const uint64_t *next = scratch.data() + i;
+                        if (!monitor || key[baseWords] == 0)
+                        {
+                            append(out, next, 0);
+                            events.push_back(event);
+                        }
+                        if (monitor && !isMarked(next))
+                        {
+                            append(out, next, 1);
+                            events.push_back(event);
+                        }
+                    }
+                }
+                return enabled;
+            }
+
+            bool terminal(const uint64_t *key) const { return explorer.terminated(key); }
+
+            bool accepting(const uint64_t *key) const { return monitor ? key[baseWords] != 0 : isMarked(key); }
+
+            std::vector<std::string> describe(const uint64_t *key)
+            {
+                atomics.clear();
+                explorer.activeAtomicStates(key, atomics);
+                std::vector<std::string> names;
+                for (uint32_t s : atomics)
+                    names.push_back(chart.nodes[s].id);
+                return names;
+            }
+
+            uint64_t divergentMacrosteps() const { return explorer.divergentMacrosteps(); }
+
+        private:
+            const Statechart &chart;
+            StatechartExplorer explorer;
+            const std::vector<uint64_t> &marked;
+            bool monitor;
+            size_t baseWords;
+            std::vector<uint64_t> scratch;
+            std::vector<uint32_t> atomics;
+
+            bool isMarked(const uint64_t *key) const
+            {
+                for (size_t w = 0; w < marked.size(); w++)
+                {
+                    if (key[w] & marked[w])
+                        return true;
+                }
+                return false;
+            }
+
+            void append(std::vector<uint64_t> &out, const uint64_t *key, uint64_t bit) const
+            {
+                out.insert(out.end(), key, key + baseWords);
+                if (monitor)
+                    out.push_back(bit);
+            }
+        };
+
+        /**
+         * Why the workers stopped; the first reason raised wins, and None
+         * means the search ran to its natural end
+         */
+        class Halt
+        {
+        public:
+            void raise(StopReason why)
+            {
+                int expected = Unset;
+                reason.compare_exchange_strong(expected, static_cast<int>(why));
+                stopped.store(true, std::memory_order_release);
+            }
+
+            bool requested() const { return stopped.load(std::memory_order_acquire); }
+
+            StopReason why() const
+            {
+                int value = reason.load();
+                return value == Unset ? StopReason::None : static_cast<StopReason>(value);
+            }
+
+        private:
+            static constexpr int Unset = -1;
+            std::atomic<bool> stopped{false};
+            std::atomic<int> reason{Unset};
+        };
+
+        struct alignas(64) WorkerCounters
+        {
+            uint64_t transitions = 0;
+            uint64_t steals = 0;
+            uint64_t divergent = 0;
+        };
+
+        unsigned workerCount(const ParallelSearchOptions &options)
+        {
+            unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+            return std::min(threads, ParallelSearchOptions::MaxThreads);
+        }
+
+        /**
+         * States the visited set may hold. Under a memory budget the
+         * capacity is rounded down to a power of two so the table, which
+         * doubles it, fits the budget exactly.
+         */
+        size_t stateCapacity(const ParallelSearchOptions &options, size_t keyWords, StopReason &limit)
+        {
+            limit = StopReason::ConfigurationLimit;
+            size_t capacity = std::min(std::max<size_t>(options.maxStates, 1), ConcurrentStateSet::MaxCapacity);
+            if (options.budget.memoryBytes == std::numeric_limits<size_t>::max())
+                return capacity;
+
+            size_t fit = 8;
+            while (fit < capacity && fit * 2 * ConcurrentStateSet::bytesPerState(keyWords) <= options.budget.memoryBytes)
+                fit *= 2;
+            if (fit < capacity)
+            {
+                capacity = fit;
+                limit = StopReason::MemoryBudget;
+            }
+            return capacity;
+        }
+
+        /**
+         * Run worker(0..threads) with the caller's cancellation token, the
+         * first on the calling thread so it reports to the caller's progress
+         * sink; rethrows the first worker error
+         */
+        template <class Worker>
+        void runWorkers(unsigned threads, Halt &halt, const Worker &worker)
+        {
+            std::vector<std::exception_ptr> errors(threads);
+            const CancellationToken *token = CancellationToken::current();
+            auto guarded = [&](unsigned w)
+            {
+                CancellationScope scope(token);
+                try
+                {
+                    worker(w);
+                }
+                catch (...)
+                {
+                    errors[w] = std::current_exception();
+                    halt.raise(StopReason::None);
+                }
+            };
+            std::vector<std::thread> pool;
+            for (unsigned w = 1; w < threads; w++)
+                pool.emplace_back(guarded, w);
+            guarded(0);
+            for (auto &thread : pool)
+                thread.join();
+            for (auto &error : errors)
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        }
+
+        void finishStatistics(ParallelSearchStatistics &report, const ConcurrentStateSet &visited,
+                              const std::vector<WorkerCounters> &counters, const Halt &halt,
+                              std::chrono::steady_clock::time_point started)
+        {
+            report.threads = static_cast<unsigned>(counters.size());
+            report.states = visited.size();
+            for (const auto &counter : counters)
+            {
+                report.transitions += counter.transitions;
+                report.steals += counter.steals;
+                report.divergentMacrosteps += counter.divergent;
+            }
+            report.stopReason = halt.why();
+            report.complete = report.stopReason == StopReason::None;
+            report.elapsedMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        }
+    } // namespace
+
+    ParallelDeadlockReport ParallelSearch::findDeadlocks(const Statechart &chart, const ParallelSearchOptions &options)
+    {
+        RSM_TRACE_SPAN("ParallelSearch::findDeadlocks");
+        auto started = std::chrono::steady_clock::now();
+        const unsigned threads = workerCount(options);
+        const std::vector<uint64_t> unmarked;
+        ChartSpace space(chart, unmarked, false);
+        const size_t keyWords = space.keyWords();
+        StopReason limit;
+        ConcurrentStateSet visited(keyWords, stateCapacity(options, keyWords, limit));
+
+        std::vector<std::unique_ptr<ChaseLevDeque<uint32_t>>> deques;
+        for (unsigned w = 0; w < threads; w++)
+            deques.emplace_back(new ChaseLevDeque<uint32_t>());
+        // Configurations pushed but not yet expanded; zero ends the search
+        std::atomic<int64_t> pending{0};
+        Halt halt;
+
+        std::vector<uint64_t> initial;
+        space.initial(initial);
+        for (size_t i = 0; i < initial.size(); i += keyWords)
+        {
+            auto insertion = visited.insert(initial.data() + i, ConcurrentStateSet::NoParent, Statechart::NoEvent);
+            if (insertion.inserted)
+            {
+                pending++;
+                deques[0]->push(insertion.id);
+            }
+        }
+
+        std::vector<WorkerCounters> counters(threads);
+        std::atomic<uint64_t> deadlockCount{0};
+        std::mutex foundMutex;
+        std::vector<uint32_t> found;
+
+        runWorkers(threads, halt, [&](unsigned w)
+                   {
+            ChartSpace local(chart, unmarked, false);
+            WorkerCounters &counter = counters[w];
+            ChaseLevDeque<uint32_t> &own = *deques[w];
+            std::mt19937_64 random(options.seed + w);
+            CancellationPoint cancellation;
+            // Memory is bounded by the visited set's capacity
+            BudgetMeter meter(options.budget);
+            ProgressMeter progress;
+            std::vector<uint64_t> successors;
+            std::vector<int32_t> events;
+
+            auto steal = [&](uint32_t &id)
+            {
+                unsigned first = static_cast<unsigned>(random() % threads);
+                for (unsigned k = 0; k < threads; k++)
+                {
+                    unsigned victim = (first + k) % threads;
+                    if (victim != w && deques[victim]->steal(id))
+                    {
+                        counter.steals++;
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            try
+            {
+                while (!halt.requested())
+                {
+                    uint32_t id;
+                    if (!own.pop(id) && !steal(id))
+                    {
+                        if (pending.load() == 0)
+                            break;
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    cancellation.check();
+                    if (meter.exhausted(0))
+                    {
+                        halt.raise(meter.reason());
+                        break;
+                    }
+                    progress.update(visited.size(), static_cast<uint64_t>(std::max<int64_t>(pending.load(), 0)), 0,
+                                    visited.bytes());
+
+                    const uint64_t *key = visited.key(id);
+                    successors.clear();
+                    events.clear();
+                    if (!local.terminal(key) && !local.successors(key, successors, events))
+                    {
+                        deadlockCount++;
+                        std::lock_guard<std::mutex> lock(foundMutex);
+                        if (found.size() < MaxKeptDeadlocks)
+                            found.push_back(id);
+                    }
+                    for (size_t i = 0; i < events.size(); i++)
+                    {
+                        counter.transitions++;
+                        auto insertion = visited.insert(successors.data() + i * keyWords, id, events[i]);
+                        if (insertion.inserted)
+                        {
+                            pending++;
+                            own.push(insertion.id);
+                        }
+                    }
+                    pending--;
+                }
+            }
+            catch (const StateSetFull &)
+            {
+                halt.raise(limit);
+            }
+            counter.divergent = local.divergentMacrosteps();
+            if (w == 0)
+                progress.finish(visited.size(), static_cast<uint64_t>(std::max<int64_t>(pending.load(), 0)), 0,
+                                visited.bytes()); });
+
+        ParallelDeadlockReport report;
+        finishStatistics(report, visited, counters, halt, started);
+        report.deadlockCount = deadlockCount;
+
+        // Shortest counterexamples first
+        auto depth = [&](uint32_t id)
+        {
+            size_t length = 0;
+            for (; visited.parent(id) != ConcurrentStateSet::NoParent; id = visited.parent(id))
+                length++;
+            return length;
+        };
+        std::vector<std::pair<size_t, uint32_t>> ordered;
+        for (uint32_t id : found)
+            ordered.push_back({depth(id), id});
+        std::sort(ordered.begin(), ordered.end());
+        for (size_t i = 0; i < ordered.size() && i < ParallelDeadlockReport::MaxReportedDeadlocks; i++)
+        {
+            std::vector<std::string> path;
+            for (uint32_t at = ordered[i].second; visited.parent(at) != ConcurrentStateSet::NoParent;
+                 at = visited.parent(at))
+                path.push_back(chart.events[visited.event(at)]);
+            std::reverse(path.begin(), path.end());
+            report.deadlocks.push_back(space.describe(visited.key(ordered[i].second)));
+            report.deadlockPaths.push_back(std::move(path));
+        }
+        return report;
+    }
+
+    CycleReport ParallelSearch::findCycle(const Statechart &chart, CycleProperty property,
+                                          const std::vector<std::string> &markedStates,
+                                          const ParallelSearchOptions &options)
+    {
+        RSM_TRACE_SPAN("ParallelSearch::findCycle");
+        auto started = std::chrono::steady_clock::now();
+        std::vector<uint64_t> marked(chart.nodeWords, 0);
+        for (const auto &id : markedStates)
+        {
+            int32_t node = chart.findNode(id);
+            if (node < 0)
+                throw std::invalid_argument("Unknown state: " + id);
+            marked[node / 64] |= 1ull << (node % 64);
+        }
+        if (markedStates.empty() && property == CycleProperty::NonProgress)
+        {
+            for (uint32_t n = 1; n < chart.nodes.size(); n++)
+            {
+                if (chart.nodes[n].id.compare(0, 8, "progress") == 0)
+                    marked[n / 64] |= 1ull << (n % 64);
+            }
+        }
+        if (markedStates.empty() && property == CycleProperty::Acceptance)
+            throw std::invalid_argument("Accepting states expected");
+
+        const bool monitor = property == CycleProperty::NonProgress;
+        const unsigned threads = workerCount(options);
+        ChartSpace space(chart, marked, monitor);
+        const size_t keyWords = space.keyWords();
+        StopReason limit;
+        ConcurrentStateSet visited(keyWords, stateCapacity(options, keyWords, limit));
+
+        std::vector<uint32_t> roots;
+        std::vector<uint64_t> initial;
+        space.initial(initial);
+        for (size_t i = 0; i < initial.size(); i += keyWords)
+        {
+            auto insertion = visited.insert(initial.data() + i, ConcurrentStateSet::NoParent, Statechart::NoEvent);
+            if (insertion.inserted)
+                roots.push_back(insertion.id);
+        }
+
+        std::vector<WorkerCounters> counters(threads);
+        Halt halt;
+        std::mutex resultMutex;
+        CycleReport report;
+
+        runWorkers(threads, halt, [&](unsigned w)
+                   {
+            ChartSpace local(chart, marked, monitor);
+            WorkerCounters &counter = counters[w];
+            uint64_t seed = options.seed + w;
+            std::mt19937_64 random(splitmix(seed));
+            CancellationPoint cancellation;
+            BudgetMeter meter(options.budget);
+            ProgressMeter progress;
+
+            struct Edge
+            {
+                uint32_t target;
+                int32_t event;
+            };
+            // A state on a DFS stack: its shuffled successors are
+            // edges[next, end), and event is how the search entered it
+            struct Frame
+            {
+                uint32_t state;
+                int32_t event;
+                size_t begin;
+                size_t next;
+                size_t end;
+            };
+            std::vector<Frame> blue, red;
+            std::vector<Edge> blueEdges, redEdges;
+            std::unordered_set<uint32_t> cyan, pink;
+            std::vector<uint32_t> pinkOrder;
+            std::vector<uint64_t> successors;
+            std::vector<int32_t> events;
+
+            auto push = [&](std::vector<Frame> &stack, std::vector<Edge> &edges, uint32_t id, int32_t event)
+            {
+                const uint64_t *key = visited.key(id);
+                successors.clear();
+                events.clear();
+                if (!local.terminal(key))
+                    local.successors(key, successors, events);
+                size_t begin = edges.size();
+                for (size_t i = 0; i < events.size(); i++)
+                {
+                    counter.transitions++;
+                    edges.push_back({visited.insert(successors.data() + i * keyWords, id, events[i]).id, events[i]});
+                }
+                std::shuffle(edges.begin() + begin, edges.end(), random);
+                stack.push_back({id, event, begin, begin, edges.size()});
+            };
+            auto pop = [](std::vector<Frame> &stack, std::vector<Edge> &edges)
+            {
+                edges.resize(stack.back().begin);
+                stack.pop_back();
+            };
+            auto poll = [&]()
+            {
+                cancellation.check();
+                if (meter.exhausted(0))
+                    halt.raise(meter.reason());
+                progress.update(visited.size(), 0, static_cast<uint32_t>(blue.size() + red.size()), visited.bytes());
+                return !halt.requested();
+            };
+
+            // The cycle closes at the cyan state `to`, through the blue
+            // stack down from it, then the red stack, then `event`
+            auto closeCycle = [&](uint32_t to, int32_t event)
+            {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (halt.requested())
+                    return;
+                size_t at = 0;
+                while (blue[at].state != to)
+                    at++;
+                for (size_t i = 1; i <= at; i++)
+                    report.stem.push_back(chart.events[blue[i].event]);
+                for (size_t i = at + 1; i < blue.size(); i++)
+                    report.cycle.push_back(chart.events[blue[i].event]);
+                for (size_t i = 1; i < red.size(); i++)
+                    report.cycle.push_back(chart.events[red[i].event]);
+                report.cycle.push_back(chart.events[event]);
+                report.cycleEntry = local.describe(visited.key(to));
+                report.cycleFound = true;
+                halt.raise(StopReason::None);
+            };
+
+            // Red search from the accepting seed on top of the blue stack;
+            // false when it stopped without closing a cycle
+            auto redSearch = [&](uint32_t seed)
+            {
+                pink.clear();
+                pinkOrder.clear();
+                pink.insert(seed);
+                pinkOrder.push_back(seed);
+                push(red, redEdges, seed, Statechart::NoEvent);
+                while (!red.empty())
+                {
+                    if (!poll())
+                        return false;
+                    Frame &top = red.back();
+                    if (top.next == top.end)
+                    {
+                        pop(red, redEdges);
+                        continue;
+                    }
+                    Edge edge = redEdges[top.next++];
+                    if (cyan.count(edge.target))
+                    {
+                        closeCycle(edge.target, edge.event);
+                        return true;
+                    }
+                    if (!pink.count(edge.target) && !visited.hasColor(edge.target, ConcurrentStateSet::Red))
+                    {
+                        pink.insert(edge.target);
+                        pinkOrder.push_back(edge.target);
+                        push(red, redEdges, edge.target, edge.event);
+                    }
+                }
+
+                // Accepting states this search passed through may still be
+                // seeds of other workers' red searches
+                for (uint32_t id : pinkOrder)
+                {
+                    if (id == seed || !local.accepting(visited.key(id)))
+                        continue;
+                    while (!visited.hasColor(id, ConcurrentStateSet::Red))
+                    {
+                        if (!poll())
+                            return false;
+                        std::this_thread::yield();
+                    }
+                }
+                for (uint32_t id : pinkOrder)
+                    visited.setColor(id, ConcurrentStateSet::Red);
+                return false;
+            };
+
+            auto blueSearch = [&]()
+            {
+                std::vector<uint32_t> order = roots;
+                std::shuffle(order.begin(), order.end(), random);
+                for (uint32_t root : order)
+                {
+                    if (visited.hasColor(root, ConcurrentStateSet::Blue))
+                        continue;
+                    cyan.insert(root);
+                    push(blue, blueEdges, root, Statechart::NoEvent);
+                    while (!blue.empty())
+                    {
+                        if (!poll())
+                            return;
+                        Frame &top = blue.back();
+                        if (top.next < top.end)
+                        {
+                            Edge edge = blueEdges[top.next++];
+                            if (cyan.count(edge.target))
+                            {
+                                // Early detection: a back edge from or to an
+                                // accepting state closes a cycle
+                                if (local.accepting(visited.key(top.state)) ||
+                                    local.accepting(visited.key(edge.target)))
+                                {
+                                    closeCycle(edge.target, edge.event);
+                                    return;
+                                }
+                                continue;
+                            }
+                            if (!visited.hasColor(edge.target, ConcurrentStateSet::Blue))
+                            {
+                                cyan.insert(edge.target);
+                                push(blue, blueEdges, edge.target, edge.event);
+                            }
+                            continue;
+                        }
+
+                        uint32_t state = top.state;
+                        visited.setColor(state, ConcurrentStateSet::Blue);
+                        if (local.accepting(visited.key(state)) && (redSearch(state) || halt.requested()))
+                            return;
+                        cyan.erase(state);
+                        pop(blue, blueEdges);
+                    }
+                }
+                // This worker's blue search covered everything reachable:
+                // there is no accepting cycle
+                halt.raise(StopReason::None);
+            };
+
+            try
+            {
+                blueSearch();
+            }
+            catch (const StateSetFull &)
+            {
+                halt.raise(limit);
+            }
+            counter.divergent = local.divergentMacrosteps();
+            if (w == 0)
+                progress.finish(visited.size(), 0, 0, visited.bytes()); });
+
+        finishStatistics(report, visited, counters, halt, started);
+        if (report.cycleFound)
+        {
+            report.complete = true;
+            report.stopReason = StopReason::None;
+        }
+        return report;
+    }
+
+} // namespace ReactiveSystem
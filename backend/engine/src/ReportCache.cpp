@@ -0,0 +1,467 @@
+#include "../include/ReportCache.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        constexpr uint64_t SeedHigh = 0x9e3779b97f4a7c15ULL;
+        constexpr uint64_t SeedLow = 0xc2b2ae3d27d4eb4fULL;
+
+        uint64_t mix(uint64_t a, uint64_t b)
+        {
+            __uint128_t product = static_cast<__uint128_t>(a) * b;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+        }
+
+        /**
+         * Two independent multiply-xor lanes, eight bytes at a time
+         */
+        class Hasher
+        {
+        public:
+            void bytes(const void *data, size_t length)
+            {
+                const unsigned char *p = static_cast<const unsigned char *>(data);
+                word(length);
+                while (length >= 8)
+                {
+                    uint64_t w;
+                    std::memcpy(&w, p, 8);
+                    word(w);
+                    p += 8;
+                    length -= 8;
+                }
+                if (length > 0)
+                {
+                    uint64_t w = 0;
+                    std::memcpy(&w, p, length);
+                    word(w);
+                }
+            }
+
+            void string(const std::string &value) { bytes(value.data(), value.size()); }
+
+            void word(uint64_t value)
+            {
+                high = mix(high ^ value, 0xa0761d6478bd642fULL);
+                low = mix(low ^ value, 0xe7037ed1a0b428dbULL);
+            }
+
+            MachineHash digest() const
+            {
+                return {mix(high, SeedLow), mix(low, SeedHigh)};
+            }
+
+        private:
+            uint64_t high = SeedHigh;
+            uint64_t low = SeedLow;
+        };
+
+        bool before(const MachineHash &a, const MachineHash &b)
+        {
+            return a.high != b.high ? a.high < b.high : a.low < b.low;
+        }
+
+        /**
+         * Fold element digests in their given order
+         */
+        void sequence(Hasher &hasher, const std::vector<MachineHash> &digests)
+        {
+            hasher.word(digests.size());
+            for (const auto &digest : digests)
+            {
+                hasher.word(digest.high);
+                hasher.word(digest.low);
+            }
+        }
+
+        /**
+         * Fold element digests in sorted order, so the result ignores the
+         * order of the elements but not their multiplicity
+         */
+        void multiset(Hasher &hasher, std::vector<MachineHash> &digests)
+        {
+            std::sort(digests.begin(), digests.end(), before);
+            sequence(hasher, digests);
+        }
+
+        void variables(Hasher &hasher, const std::vector<Variable> &list)
+        {
+            std::vector<MachineHash> digests;
+            digests.reserve(list.size());
+            for (const auto &variable : list)
+            {
+                Hasher element;
+                element.string(variable.name);
+                element.string(variable.type);
+                element.string(variable.initialValue);
+                element.word(variable.hasRange);
+                element.word(static_cast<uint64_t>(variable.min));
+                element.word(static_cast<uint64_t>(variable.max));
+                digests.push_back(element.digest());
+            }
+            multiset(hasher, digests);
+        }
+
+        // Report file: magic, then the fields with u32-length strings. Only
+        // complete reports are stored, so completeness is implied.
+        constexpr char FileMagic[8] = {'R', 'S', 'R', 'E', 'P', 'O', 'R', '2'};
+
+        void putWord(std::string &out, uint32_t value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        void putString(std::string &out, const std::string &value)
+        {
+            putWord(out, static_cast<uint32_t>(value.size()));
+            out += value;
+        }
+
+        void putStrings(std::string &out, const std::vector<std::string> &values)
+        {
+            putWord(out, static_cast<uint32_t>(values.size()));
+            for (const auto &value : values)
+                putString(out, value);
+        }
+
+        class FileReader
+        {
+        public:
+            explicit FileReader(const std::string &data) : data(data) {}
+
+            bool word(uint32_t &value)
+            {
+                if (data.size() - pos < sizeof(value))
+                    return false;
+                std::memcpy(&value, data.data() + pos, sizeof(value));
+                pos += sizeof(value);
+                return true;
+            }
+
+            bool string(std::string &value)
+            {
+                uint32_t length;
+                if (!word(length) || data.size() - pos < length)
+                    return false;
+                value.assign(data, pos, length);
+                pos += length;
+                return true;
+            }
+
+            bool strings(std::vector<std::string> &values)
+            {
+                uint32_t count;
+                if (!word(count) || count > data.size() - pos)
+                    return false;
+                values.resize(count);
+                for (auto &value : values)
+                {
+                    if (!string(value))
+                        return false;
+                }
+                return true;
+            }
+
+            bool done() const { return pos == data.size(); }
+
+        private:
+            const std::string &data;
+            size_t pos = sizeof(FileMagic);
+        };
+    } // namespace
+
+    std::string MachineHash::hex() const
+    {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                      static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+        return buffer;
+    }
+
+    MachineHash canonicalHash(const StateMachine &machine)
+    {
+        // Statecharts resolve conflicting transitions in document order, and
+        // a flat machine with several initial states starts in the first
+        const bool ordered = Statechart::isHierarchical(machine) ||
+                             std::count_if(machine.states.begin(), machine.states.end(),
+                                           [](const State &state) { return state.isInitial; }) > 1;
+        auto fold = [ordered](Hasher &hasher, std::vector<MachineHash> &digests)
+        {
+            if (ordered)
+                sequence(hasher, digests);
+            else
+                multiset(hasher, digests);
+        };
+
+        Hasher hasher;
+        hasher.string(machine.type);
+        if (ordered)
+            hasher.word(1);
+
+        std::vector<MachineHash> digests;
+        digests.reserve(std::max(machine.states.size(), machine.transitions.size()));
+        for (const auto &state : machine.states)
+        {
+            Hasher element;
+            element.string(state.id);
+            element.string(state.name);
+            element.word((state.isInitial ? 1 : 0) | (state.isFinal ? 2 : 0));
+            element.string(state.parent);
+            element.string(state.kind);
+            digests.push_back(element.digest());
+        }
+        fold(hasher, digests);
+
+        digests.clear();
+        for (const auto &transition : machine.transitions)
+        {
+            Hasher element;
+            element.string(transition.from);
+            element.string(transition.to);
+            element.string(transition.input);
+            element.string(transition.output);
+            element.string(transition.guard);
+            element.string(transition.action);
+            digests.push_back(element.digest());
+        }
+        fold(hasher, digests);
+
+        variables(hasher, machine.inputVariables);
+        variables(hasher, machine.outputVariables);
+        variables(hasher, machine.stateVariables);
+        return hasher.digest();
+    }
+
+    MachineHash canonicalHash(const Statechart &chart)
+    {
+        Hasher hasher;
+        auto indices = [&hasher](const auto &values)
+        {
+            hasher.word(values.size());
+            for (auto value : values)
+                hasher.word(static_cast<uint64_t>(value));
+        };
+
+        hasher.word(chart.nodes.size());
+        for (const auto &node : chart.nodes)
+        {
+            hasher.string(node.id);
+            hasher.word(static_cast<uint64_t>(node.kind));
+            hasher.word(node.parent);
+            hasher.word(static_cast<uint64_t>(node.doneEvent));
+            indices(node.initial);
+            indices(node.transitions);
+            indices(node.entryRaises);
+            indices(node.exitRaises);
+        }
+        hasher.word(chart.transitions.size());
+        for (const auto &transition : chart.transitions)
+        {
+            hasher.word(transition.source);
+            indices(transition.targets);
+            hasher.word(transition.events.size());
+            for (const auto &event : transition.events)
+                hasher.string(event);
+            hasher.word(static_cast<uint64_t>(transition.guard) | (transition.internal ? 4 : 0));
+            indices(transition.raises);
+        }
+        hasher.word(chart.events.size());
+        for (const auto &event : chart.events)
+            hasher.string(event);
+        indices(chart.externalEvents);
+        return hasher.digest();
+    }
+
+    ReportCache::ReportCache(size_t capacity, const std::string &directory)
+        : capacity(capacity)
+    {
+        configure(capacity, directory);
+    }
+
+    void ReportCache::configure(size_t newCapacity, const std::string &newDirectory)
+    {
+        if (!newDirectory.empty() && ::mkdir(newDirectory.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            throw std::runtime_error("Cannot create report cache directory " + newDirectory);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        capacity = newCapacity;
+        directory = newDirectory;
+        while (recent.size() > capacity)
+        {
+            index.erase(recent.back().first);
+            recent.pop_back();
+            counters.evictions++;
+        }
+    }
+
+    bool ReportCache::lookup(const MachineHash &hash, Verifier::VerificationReport &report)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(hash);
+        if (it != index.end())
+        {
+            recent.splice(recent.begin(), recent, it->second);
+            report = it->second->second;
+            counters.hits++;
+            return true;
+        }
+        if (!directory.empty() && readFile(hash, report))
+        {
+            insert(hash, report);
+            counters.diskHits++;
+            return true;
+        }
+        counters.misses++;
+        return false;
+    }
+
+    void ReportCache::store(const MachineHash &hash, const Verifier::VerificationReport &report)
+    {
+        if (!report.complete)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(hash, report);
+        if (!directory.empty())
+            writeFile(hash, report);
+    }
+
+    Verifier::VerificationReport ReportCache::verify(const StateMachine &machine, MachineHash *hashOut, bool *cached,
+                                                     const AnalysisBudget &budget)
+    {
+        RSM_TRACE_SPAN("ReportCache::verify");
+        MachineHash hash = canonicalHash(machine);
+        if (hashOut)
+            *hashOut = hash;
+
+        Verifier::VerificationReport report;
+        bool hit = lookup(hash, report);
+        if (!hit)
+        {
+            report = Verifier::generateReport(machine, budget);
+            store(hash, report);
+        }
+        if (cached)
+            *cached = hit;
+        return report;
+    }
+
+    void ReportCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        recent.clear();
+        index.clear();
+    }
+
+    ReportCache::Stats ReportCache::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result = counters;
+        result.entries = recent.size();
+        result.capacity = capacity;
+        result.directory = directory;
+        return result;
+    }
+
+    void ReportCache::insert(const MachineHash &hash, const Verifier::VerificationReport &report)
+    {
+        if (capacity == 0)
+            return;
+        auto it = index.find(hash);
+        if (it != index.end())
+        {
+            it->second->second = report;
+            recent.splice(recent.begin(), recent, it->second);
+            return;
+        }
+        if (recent.size() >= capacity)
+        {
+            index.erase(recent.back().first);
+            recent.pop_back();
+            counters.evictions++;
+        }
+        recent.emplace_front(hash, report);
+        index.emplace(hash, recent.begin());
+    }
+
+    std::string ReportCache::pathFor(const MachineHash &hash) const
+    {
+        return directory + "/" + hash.hex() + ".report";
+    }
+
+    /**
+     * A missing, truncated or foreign file is a miss
+     */
+    bool ReportCache::readFile(const MachineHash &hash, Verifier::VerificationReport &report) const
+    {
+        FILE *file = std::fopen(pathFor(hash).c_str(), "rb");
+        if (!file)
+            return false;
+        std::string data;
+        char buffer[65536];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            data.append(buffer, read);
+        std::fclose(file);
+
+        if (data.size() < sizeof(FileMagic) || std::memcmp(data.data(), FileMagic, sizeof(FileMagic)) != 0)
+            return false;
+
+        FileReader reader(data);
+        uint32_t valid, reachableStates, totalStates, exploredHigh, exploredLow;
+        Verifier::VerificationReport loaded;
+        if (!reader.word(valid) || !reader.word(reachableStates) || !reader.word(totalStates) ||
+            !reader.word(exploredHigh) || !reader.word(exploredLow) ||
+            !reader.strings(loaded.errors) || !reader.strings(loaded.warnings) ||
+            !reader.strings(loaded.deadlocks) || !reader.string(loaded.summary) || !reader.done())
+        {
+            return false;
+        }
+        loaded.isValid = valid != 0;
+        loaded.reachableStates = static_cast<int>(reachableStates);
+        loaded.totalStates = static_cast<int>(totalStates);
+        loaded.statesExplored = (static_cast<uint64_t>(exploredHigh) << 32) | exploredLow;
+        report = std::move(loaded);
+        return true;
+    }
+
+    /**
+     * Best effort: a report that cannot be written is simply not persisted
+     */
+    void ReportCache::writeFile(const MachineHash &hash, const Verifier::VerificationReport &report) const
+    {
+        std::string out(FileMagic, sizeof(FileMagic));
+        putWord(out, report.isValid ? 1 : 0);
+        putWord(out, static_cast<uint32_t>(report.reachableStates));
+        putWord(out, static_cast<uint32_t>(report.totalStates));
+        putWord(out, static_cast<uint32_t>(report.statesExplored >> 32));
+        putWord(out, static_cast<uint32_t>(report.statesExplored));
+        putStrings(out, report.errors);
+        putStrings(out, report.warnings);
+        putStrings(out, report.deadlocks);
+        putString(out, report.summary);
+
+        // Write beside the target and rename, so readers never see a partial file
+        const std::string path = pathFor(hash);
+        const std::string temporary = path + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file)
+            return;
+        bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(temporary.c_str(), path.c_str()) != 0)
+            std::remove(temporary.c_str());
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,427 @@
+#include "../include/Scxml.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        // Deeper than any chart Statechart::finalize accepts, with room for
+        // executable content below the innermost state
+        constexpr int MaxNesting = static_cast<int>(Statechart::MaxDepth) + 16;
+
+        struct XmlElement
+        {
+            std::string name;
+            std::vector<std::pair<std::string, std::string>> attributes;
+            std::vector<XmlElement> children;
+            size_t offset = 0;
+
+            const std::string *attribute(const char *key) const
+            {
+                for (const auto &attribute : attributes)
+                {
+                    if (attribute.first == key)
+                        return &attribute.second;
+                }
+                return nullptr;
+            }
+        };
+
+        /**
+         * Just enough XML for SCXML documents: elements, attributes and the
+         * predefined/numeric entities. Text, comments, CDATA, processing
+         * instructions and the DOCTYPE are skipped; namespace prefixes are
+         * dropped from element and attribute names.
+         */
+        class XmlReader
+        {
+        public:
+            explicit XmlReader(const std::string &text) : text(text) {}
+
+            XmlElement document()
+            {
+                skipMisc();
+                if (at("<"))
+                {
+                    XmlElement root = element();
+                    skipMisc();
+                    if (pos == text.size())
+                        return root;
+                }
+                fail("expected a single root element");
+            }
+
+            [[noreturn]] void fail(const std::string &message, size_t offset = std::string::npos) const
+            {
+                if (offset == std::string::npos)
+                    offset = pos;
+                size_t line = 1;
+                for (size_t i = 0; i < offset && i < text.size(); i++)
+                {
+                    if (text[i] == '\n')
+                        line++;
+                }
+                throw std::invalid_argument("SCXML line " + std::to_string(line) + ": " + message);
+            }
+
+        private:
+            const std::string &text;
+            size_t pos = 0;
+            int depth = 0;
+
+            bool at(const char *literal) const
+            {
+                return text.compare(pos, std::strlen(literal), literal) == 0;
+            }
+
+            void skipPast(const char *terminator)
+            {
+                size_t end = text.find(terminator, pos);
+                if (end == std::string::npos)
+                    fail(std::string("missing ") + terminator);
+                pos = end + std::strlen(terminator);
+            }
+
+            void skipSpace()
+            {
+                while (pos < text.size() && std::strchr(" \t\r\n", text[pos]))
+                    pos++;
+            }
+
+            /**
+             * Whitespace, comments, processing instructions and DOCTYPE
+             */
+            void skipMisc()
+            {
+                for (;;)
+                {
+                    skipSpace();
+                    if (at("<?"))
+                        skipPast("?>");
+                    else if (at("<!--"))
+                        skipPast("-->");
+                    else if (at("<!DOCTYPE"))
+                    {
+                        int depth = 0;
+                        for (; pos < text.size(); pos++)
+                        {
+                            if (text[pos] == '[')
+                                depth++;
+                            else if (text[pos] == ']')
+                                depth--;
+                            else if (text[pos] == '>' && depth == 0)
+                                break;
+                        }
+                        pos++;
+                    }
+                    else
+                        return;
+                }
+            }
+
+            static std::string localName(const std::string &name)
+            {
+                size_t colon = name.find(':');
+                return colon == std::string::npos ? name : name.substr(colon + 1);
+            }
+
+            std::string name()
+            {
+                size_t start = pos;
+                while (pos < text.size() && !std::strchr(" \t\r\n/>=", text[pos]))
+                    pos++;
+                if (pos == start)
+                    fail("expected a name");
+                return text.substr(start, pos - start);
+            }
+
+            std::string decode(size_t begin, size_t end) const
+            {
+                std::string out;
+                out.reserve(end - begin);
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (text[i] != '&')
+                    {
+                        out += text[i];
+                        continue;
+                    }
+                    size_t semicolon = text.find(';', i);
+                    if (semicolon == std::string::npos || semicolon > end)
+                        fail("unterminated entity", i);
+                    std::string entity = text.substr(i + 1, semicolon - i - 1);
+                    if (entity == "lt")
+                        out += '<';
+                    else if (entity == "gt")
+                        out += '>';
+                    else if (entity == "amp")
+                        out += '&';
+                    else if (entity == "quot")
+                        out += '"';
+                    else if (entity == "apos")
+                        out += '\'';
+                    else if (entity.size() > 1 && entity[0] == '#')
+                    {
+                        unsigned long code = entity[1] == 'x' ? std::strtoul(entity.c_str() + 2, nullptr, 16) : std::strtoul(entity.c_str() + 1, nullptr, 10);
+                        // Identifiers are ASCII in practice; keep the rest as '?'
+                        out += code < 0x80 ? static_cast<char>(code) : '?';
+                    }
+                    else
+                        fail("unknown entity &" + entity + ";", i);
+                    i = semicolon;
+                }
+                return out;
+            }
+
+            XmlElement element()
+            {
+                if (++depth > MaxNesting)
+                    fail("nesting too deep");
+                XmlElement element;
+                element.offset = pos;
+                pos++;
+                const std::string tag = name();
+                element.name = localName(tag);
+
+                for (;;)
+                {
+                    skipSpace();
+                    if (at("/>"))
+                    {
+                        pos += 2;
+                        depth--;
+                        return element;
+                    }
+                    if (at(">"))
+                    {
+                        pos++;
+                        break;
+                    }
+                    std::string key = name();
+                    skipSpace();
+                    if (!at("="))
+                        fail("expected = after attribute " + key);
+                    pos++;
+                    skipSpace();
+                    if (pos >= text.size() || (text[pos] != '"' && text[pos] != '\''))
+                        fail("expected quoted value for attribute " + key);
+                    char quote = text[pos++];
+                    size_t end = text.find(quote, pos);
+                    if (end == std::string::npos)
+                        fail("unterminated attribute " + key);
+                    element.attributes.emplace_back(localName(key), decode(pos, end));
+                    pos = end + 1;
+                }
+
+                for (;;)
+                {
+                    if (pos >= text.size())
+                        fail("unclosed element <" + tag + ">", element.offset);
+                    if (at("</"))
+                    {
+                        pos += 2;
+                        if (name() != tag)
+                            fail("mismatched closing tag for <" + tag + ">");
+                        skipSpace();
+                        if (!at(">"))
+                            fail("expected >");
+                        pos++;
+                        depth--;
+                        return element;
+                    }
+                    if (at("<!--"))
+                        skipPast("-->");
+                    else if (at("<![CDATA["))
+                        skipPast("]]>");
+                    else if (at("<?"))
+                        skipPast("?>");
+                    else if (at("<"))
+                        element.children.push_back(this->element());
+                    else
+                    {
+                        size_t next = text.find('<', pos);
+                        pos = next == std::string::npos ? text.size() : next;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::string> tokens(const std::string &list)
+        {
+            std::vector<std::string> out;
+            std::istringstream stream(list);
+            std::string token;
+            while (stream >> token)
+                out.push_back(token);
+            return out;
+        }
+
+        /**
+         * Builds the chart in document order, deferring every id reference
+         * until all states are known
+         */
+        class ScxmlBuilder
+        {
+        public:
+            ScxmlBuilder(XmlReader &reader) : reader(reader) {}
+
+            Statechart build(const XmlElement &root)
+            {
+                if (root.name != "scxml")
+                    reader.fail("root element must be <scxml>", root.offset);
+                if (const std::string *name = root.attribute("name"))
+                    chart.name = *name;
+                if (const std::string *initial = root.attribute("initial"))
+                    initials.push_back({Statechart::Root, *initial, root.offset});
+
+                states(root, Statechart::Root);
+
+                for (const auto &pending : initials)
+                    chart.nodes[pending.node].initial = resolve(pending.targets, pending.offset);
+
+                for (const auto &pending : transitions)
+                {
+                    const XmlElement &element = *pending.element;
+                    Statechart::Transition transition;
+                    transition.source = pending.source;
+                    if (const std::string *id = element.attribute("id"))
+                        transition.id = *id;
+                    if (const std::string *target = element.attribute("target"))
+                        transition.targets = resolve(*target, element.offset);
+                    if (const std::string *event = element.attribute("event"))
+                        transition.events = tokens(*event);
+                    if (const std::string *cond = element.attribute("cond"))
+                    {
+                        transition.condition = *cond;
+                        transition.guard = *cond == "true" ? Statechart::Guard::Always : *cond == "false" ? Statechart::Guard::Never
+                                                                                                           : Statechart::Guard::Unknown;
+                    }
+                    const std::string *type = element.attribute("type");
+                    transition.internal = type && *type == "internal";
+                    raises(element, transition.raises);
+                    chart.addTransition(std::move(transition));
+                }
+
+                chart.finalize();
+                return std::move(chart);
+            }
+
+        private:
+            struct PendingInitial
+            {
+                uint32_t node;
+                std::string targets;
+                size_t offset;
+            };
+
+            struct PendingTransition
+            {
+                uint32_t source;
+                const XmlElement *element;
+            };
+
+            XmlReader &reader;
+            Statechart chart;
+            std::vector<PendingInitial> initials;
+            std::vector<PendingTransition> transitions;
+            size_t anonymous = 0;
+
+            std::vector<uint32_t> resolve(const std::string &ids, size_t offset)
+            {
+                std::vector<uint32_t> out;
+                for (const auto &id : tokens(ids))
+                {
+                    int32_t node = chart.findNode(id);
+                    if (node < 0)
+                        reader.fail("unknown state " + id, offset);
+                    out.push_back(static_cast<uint32_t>(node));
+                }
+                return out;
+            }
+
+            void raises(const XmlElement &block, std::vector<int32_t> &out)
+            {
+                for (const auto &child : block.children)
+                {
+                    const std::string *event = child.name == "raise" ? child.attribute("event") : nullptr;
+                    if (event)
+                        out.push_back(chart.internEvent(*event));
+                }
+            }
+
+            void states(const XmlElement &element, uint32_t parent)
+            {
+                for (const auto &child : element.children)
+                {
+                    Statechart::Kind kind;
+                    if (child.name == "state")
+                        kind = Statechart::Kind::Atomic;
+                    else if (child.name == "parallel")
+                        kind = Statechart::Kind::Parallel;
+                    else if (child.name == "final")
+                        kind = Statechart::Kind::Final;
+                    else if (child.name == "history")
+                    {
+                        const std::string *type = child.attribute("type");
+                        kind = type && *type == "deep" ? Statechart::Kind::DeepHistory : Statechart::Kind::ShallowHistory;
+                    }
+                    else
+                        continue;
+
+                    const std::string *id = child.attribute("id");
+                    uint32_t node;
+                    try
+                    {
+                        node = chart.addNode(id ? *id : "__state" + std::to_string(anonymous++), kind, parent);
+                    }
+                    catch (const std::invalid_argument &e)
+                    {
+                        reader.fail(e.what(), child.offset);
+                    }
+
+                    if (const std::string *initial = child.attribute("initial"))
+                        initials.push_back({node, *initial, child.offset});
+
+                    for (const auto &part : child.children)
+                    {
+                        if (part.name == "transition")
+                        {
+                            // A history's transition is its default entry
+                            if (kind == Statechart::Kind::ShallowHistory || kind == Statechart::Kind::DeepHistory)
+                                initials.push_back({node, part.attribute("target") ? *part.attribute("target") : std::string(), part.offset});
+                            else
+                                transitions.push_back({node, &part});
+                        }
+                        else if (part.name == "initial")
+                        {
+                            for (const auto &transition : part.children)
+                            {
+                                if (transition.name == "transition" && transition.attribute("target"))
+                                    initials.push_back({node, *transition.attribute("target"), transition.offset});
+                            }
+                        }
+                        else if (part.name == "onentry")
+                            raises(part, chart.nodes[node].entryRaises);
+                        else if (part.name == "onexit")
+                            raises(part, chart.nodes[node].exitRaises);
+                    }
+
+                    states(child, node);
+                }
+            }
+        };
+    } // namespace
+
+    Statechart statechartFromScxml(const std::string &document)
+    {
+        XmlReader reader(document);
+        XmlElement root = reader.document();
+        return ScxmlBuilder(reader).build(root);
+    }
+
+} // namespace ReactiveSystem
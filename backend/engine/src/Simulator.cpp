@@ -0,0 +1,100 @@
+#include "../include/Simulator.h"
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    bool MachineProgram::hasGuardsOrActions() const
+    {
+        for (size_t e = 0; e < edgeGuards.size(); e++)
+        {
+            if (!edgeGuards[e].empty() || !edgeActions[e].empty())
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Compile the graph and every guard/action label
+     */
+    MachineProgram MachineProgram::compile(const StateMachine &machine)
+    {
+        MachineProgram program;
+        program.graph = CompiledMachine::compile(machine);
+        program.variables = VariableTable::fromMachine(machine);
+
+        const size_t edgeCount = program.graph.edgeCount();
+        program.edgeGuardTrees.resize(edgeCount);
+        program.edgeActionTrees.resize(edgeCount);
+        program.edgeGuards.resize(edgeCount);
+        program.edgeActions.resize(edgeCount);
+
+        for (size_t e = 0; e < edgeCount; e++)
+        {
+            const Transition &transition = machine.transitions[program.graph.edgeTransitions[e]];
+            try
+            {
+                program.edgeGuardTrees[e] = Expression::parseGuard(transition.guard, program.variables);
+                program.edgeActionTrees[e] = Expression::parseAction(transition.action, program.variables);
+                program.edgeGuards[e] = Expression::compileGuard(program.edgeGuardTrees[e].get());
+                program.edgeActions[e] = Expression::compileAction(program.edgeActionTrees[e]);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                throw std::invalid_argument("Transition " + transition.id + ": " + e.what());
+            }
+        }
+
+        return program;
+    }
+
+    Simulator::Simulator(const MachineProgram &program)
+        : machineProgram(program)
+    {
+        reset();
+    }
+
+    void Simulator::reset()
+    {
+        state = machineProgram.graph.initialState;
+        values = machineProgram.variables.initialValues();
+    }
+
+    int32_t Simulator::step(int32_t input)
+    {
+        return step(machineProgram, state, values.data(), input);
+    }
+
+    int32_t Simulator::step(
+        const MachineProgram &program,
+        int32_t &state,
+        int64_t *variables,
+        int32_t input)
+    {
+        const CompiledMachine &graph = program.graph;
+        if (state < 0 || input < 0)
+        {
+            return -1;
+        }
+
+        for (uint32_t e = graph.edgeOffsets[state]; e < graph.edgeOffsets[state + 1]; e++)
+        {
+            if (graph.edgeInputs[e] != input)
+                continue;
+            if (Expression::execute(program.edgeGuards[e], variables) == 0)
+                continue;
+
+            Expression::execute(program.edgeActions[e], variables);
+            state = static_cast<int32_t>(graph.edgeTargets[e]);
+            return static_cast<int32_t>(e);
+        }
+        return -1;
+    }
+
+    void Simulator::restore(int32_t stateIndex, const std::vector<int64_t> &variableValues)
+    {
+        state = stateIndex;
+        values = variableValues;
+    }
+
+} // namespace ReactiveSystem
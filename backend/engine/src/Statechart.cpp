@@ -0,0 +1,1199 @@
+#include "../include/Statechart.h"
+#include "../include/Cancellation.h"
+#include "../include/Checkpoint.h"
+#include "../include/Progress.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        constexpr uint32_t NoTransition = UINT32_MAX;
+
+        bool testBit(const uint64_t *bits, uint32_t index)
+        {
+            return (bits[index / 64] >> (index % 64)) & 1;
+        }
+
+        void setBit(uint64_t *bits, uint32_t index)
+        {
+            bits[index / 64] |= uint64_t(1) << (index % 64);
+        }
+
+        bool isEmpty(const uint64_t *bits, size_t words)
+        {
+            for (size_t w = 0; w < words; w++)
+            {
+                if (bits[w])
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * Call fn(index) for every set bit in [begin, end), in ascending order
+         */
+        template <class Fn>
+        void forEachBit(const uint64_t *bits, uint32_t begin, uint32_t end, Fn &&fn)
+        {
+            for (uint32_t w = begin / 64; w * 64 < end; w++)
+            {
+                uint64_t word = bits[w];
+                if (w == begin / 64)
+                    word &= ~uint64_t(0) << (begin % 64);
+                if ((w + 1) * 64 > end && end % 64)
+                    word &= (uint64_t(1) << (end % 64)) - 1;
+                while (word)
+                {
+                    fn(w * 64 + static_cast<uint32_t>(__builtin_ctzll(word)));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        bool descriptorMatches(const std::string &descriptor, const std::string &event)
+        {
+            if (descriptor == "*" || descriptor == event)
+                return true;
+            return event.size() > descriptor.size() &&
+                   event.compare(0, descriptor.size(), descriptor) == 0 &&
+                   event[descriptor.size()] == '.';
+        }
+
+        /**
+         * Visited configurations: keys stored back to back, open addressing
+         * over their indices
+         */
+        class ConfigurationTable
+        {
+        public:
+            explicit ConfigurationTable(size_t words) : words(words), slots(1024, 0) {}
+
+            size_t size() const { return count; }
+            bool contains(const uint64_t *key) const { return *find(key) != 0; }
+            const uint64_t *key(size_t index) const { return keys.data() + index * words; }
+            size_t bytes() const { return keys.capacity() * sizeof(uint64_t) + slots.capacity() * sizeof(uint32_t); }
+
+            /**
+             * Index of the key, and whether it was added by this call
+             */
+            std::pair<uint32_t, bool> insert(const uint64_t *key)
+            {
+                if ((count + 1) * 2 > slots.size())
+                    grow();
+
+                uint32_t *slot = find(key);
+                if (*slot != 0)
+                    return {*slot - 1, false};
+                keys.insert(keys.end(), key, key + words);
+                *slot = static_cast<uint32_t>(++count);
+                return {static_cast<uint32_t>(count - 1), true};
+            }
+
+        private:
+            size_t words;
+            size_t count = 0;
+            std::vector<uint64_t> keys;
+            std::vector<uint32_t> slots;
+
+            uint64_t hash(const uint64_t *key) const
+            {
+                uint64_t h = 0x9E3779B97F4A7C15ull;
+                for (size_t w = 0; w < words; w++)
+                {
+                    h = (h ^ key[w]) * 0xBF58476D1CE4E5B9ull;
+                    h ^= h >> 31;
+                }
+                return h;
+            }
+
+            /**
+             * Slot holding the key, or the empty slot where it belongs
+             */
+            uint32_t *find(const uint64_t *key)
+            {
+                size_t slot = hash(key) & (slots.size() - 1);
+                while (slots[slot] != 0 && !std::equal(key, key + words, this->key(slots[slot] - 1)))
+                    slot = (slot + 1) & (slots.size() - 1);
+                return &slots[slot];
+            }
+
+            const uint32_t *find(const uint64_t *key) const
+            {
+                return const_cast<ConfigurationTable *>(this)->find(key);
+            }
+
+            void grow()
+            {
+                std::vector<uint32_t> old(slots.size() * 2, 0);
+                old.swap(slots);
+                for (size_t index = 0; index < count; index++)
+                {
+                    size_t slot = hash(key(index)) & (slots.size() - 1);
+                    while (slots[slot] != 0)
+                        slot = (slot + 1) & (slots.size() - 1);
+                    slots[slot] = static_cast<uint32_t>(index + 1);
+                }
+            }
+        };
+    } // namespace
+
+    Statechart::Statechart()
+    {
+        Node root;
+        root.kind = Kind::Compound;
+        nodes.push_back(root);
+    }
+
+    uint32_t Statechart::addNode(const std::string &id, Kind kind, uint32_t parent)
+    {
+        if (parent >= nodes.size())
+            throw std::invalid_argument("Unknown parent of state " + id);
+        if (!nodeIndex.emplace(id, static_cast<uint32_t>(nodes.size())).second)
+            throw std::invalid_argument("Duplicate state id " + id);
+
+        Node &parentNode = nodes[parent];
+        if (parentNode.kind == Kind::Final || (parent != Root && isHistory(parent)))
+            throw std::invalid_argument("State " + id + " cannot be nested in " + parentNode.id);
+        if (parentNode.kind == Kind::Atomic && kind != Kind::ShallowHistory && kind != Kind::DeepHistory)
+            parentNode.kind = Kind::Compound;
+
+        Node node;
+        node.id = id;
+        node.kind = kind;
+        node.parent = parent;
+        nodes.push_back(node);
+        nodes[parent].children.push_back(static_cast<uint32_t>(nodes.size() - 1));
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    uint32_t Statechart::addTransition(Transition transition)
+    {
+        if (transition.source == Root || transition.source >= nodes.size() || isHistory(transition.source))
+            throw std::invalid_argument("Transition " + transition.id + " has no valid source state");
+        for (uint32_t target : transition.targets)
+        {
+            if (target == Root || target >= nodes.size())
+                throw std::invalid_argument("Transition " + transition.id + " has an invalid target");
+        }
+
+        // "error.*" and "error." mean the same as "error"
+        for (auto &descriptor : transition.events)
+        {
+            if (descriptor.size() > 2 && descriptor.compare(descriptor.size() - 2, 2, ".*") == 0)
+                descriptor.resize(descriptor.size() - 2);
+            else if (descriptor.size() > 1 && descriptor.back() == '.')
+                descriptor.pop_back();
+            if (descriptor != "*")
+                internEvent(descriptor);
+        }
+
+        uint32_t index = static_cast<uint32_t>(transitions.size());
+        if (transition.id.empty())
+            transition.id = "t" + std::to_string(index);
+        nodes[transition.source].transitions.push_back(index);
+        transitions.push_back(std::move(transition));
+        return index;
+    }
+
+    int32_t Statechart::findNode(const std::string &id) const
+    {
+        auto it = nodeIndex.find(id);
+        return it == nodeIndex.end() ? -1 : static_cast<int32_t>(it->second);
+    }
+
+    int32_t Statechart::internEvent(const std::string &name)
+    {
+        auto inserted = eventIndex.emplace(name, static_cast<uint32_t>(events.size()));
+        if (inserted.second)
+            events.push_back(name);
+        return static_cast<int32_t>(inserted.first->second);
+    }
+
+    void Statechart::finalize()
+    {
+        const uint32_t count = static_cast<uint32_t>(nodes.size());
+
+        // Subtrees must be contiguous for the range-based descendant test
+        for (uint32_t n = count; n-- > 0;)
+        {
+            nodes[n].subtreeEnd = std::max(nodes[n].subtreeEnd, n + 1);
+            if (n != Root)
+                nodes[nodes[n].parent].subtreeEnd = std::max(nodes[nodes[n].parent].subtreeEnd, nodes[n].subtreeEnd);
+        }
+        for (uint32_t n = 0; n < count; n++)
+        {
+            uint32_t expected = n + 1;
+            for (uint32_t child : nodes[n].children)
+            {
+                if (child != expected)
+                    throw std::invalid_argument("States are not in document order");
+                expected = nodes[child].subtreeEnd;
+            }
+        }
+
+        // Parents precede their children
+        std::vector<uint32_t> depth(count, 0);
+        for (uint32_t n = 1; n < count; n++)
+        {
+            depth[n] = depth[nodes[n].parent] + 1;
+            if (depth[n] > MaxDepth)
+                throw std::invalid_argument("State " + nodes[n].id + " is nested too deeply");
+        }
+
+        historyCount = 0;
+        for (uint32_t n = 0; n < count; n++)
+        {
+            Node &node = nodes[n];
+            std::vector<uint32_t> regions;
+            for (uint32_t child : node.children)
+            {
+                if (!isHistory(child))
+                    regions.push_back(child);
+            }
+
+            if (node.kind == Kind::Compound && node.initial.empty())
+            {
+                if (regions.empty())
+                    throw std::invalid_argument("State " + node.id + " has no child states");
+                node.initial.push_back(regions.front());
+            }
+            else if (isHistory(n))
+            {
+                node.historySlot = static_cast<int32_t>(historyCount++);
+                if (node.initial.empty())
+                {
+                    const Node &parent = nodes[node.parent];
+                    node.initial = parent.kind == Kind::Parallel ? std::vector<uint32_t>{node.parent} : parent.initial;
+                }
+                // Entry follows defaults until it reaches a real state, so
+                // defaults naming a history could loop forever
+                for (uint32_t target : node.initial)
+                {
+                    if (isHistory(target))
+                        throw std::invalid_argument("Default entry of history " + node.id + " targets history " + nodes[target].id);
+                }
+            }
+
+            const uint32_t scope = isHistory(n) ? node.parent : n;
+            for (uint32_t target : node.initial)
+            {
+                if (!isDescendant(target, scope) && !(isHistory(n) && target == scope))
+                    throw std::invalid_argument("Initial state " + nodes[target].id + " is not inside " + (n == Root ? name : node.id));
+            }
+
+            if (n != Root && (node.kind == Kind::Compound || node.kind == Kind::Parallel))
+                node.doneEvent = internEvent("done.state." + node.id);
+        }
+
+        matchWords = (transitions.size() + 63) / 64;
+        nodeWords = (count + 63) / 64;
+        eventMatches.assign(events.size() * matchWords, 0);
+        eventScopes.assign((events.size() + 1) * nodeWords, 0);
+        externalEvents.clear();
+
+        auto addScope = [this](size_t row, uint32_t source)
+        {
+            for (uint32_t n = source; n < nodes[source].subtreeEnd; n++)
+                setBit(eventScopes.data() + row * nodeWords, n);
+        };
+        for (uint32_t t = 0; t < transitions.size(); t++)
+        {
+            if (transitions[t].events.empty())
+                addScope(events.size(), transitions[t].source);
+        }
+
+        for (uint32_t e = 0; e < events.size(); e++)
+        {
+            // Events only raised within the chart are internal
+            bool named = false;
+            for (uint32_t t = 0; t < transitions.size(); t++)
+            {
+                bool matched = false;
+                for (const auto &descriptor : transitions[t].events)
+                {
+                    named = named || descriptor == events[e];
+                    if (!matched && descriptorMatches(descriptor, events[e]))
+                    {
+                        setBit(eventMatches.data() + e * matchWords, t);
+                        addScope(e, transitions[t].source);
+                        matched = true;
+                    }
+                }
+            }
+            if (named && events[e].compare(0, 5, "done.") != 0)
+                externalEvents.push_back(static_cast<int32_t>(e));
+        }
+    }
+
+    bool Statechart::isHierarchical(const StateMachine &machine)
+    {
+        return std::any_of(machine.states.begin(), machine.states.end(), [](const State &state)
+                           { return !state.parent.empty() || !state.kind.empty(); });
+    }
+
+    Statechart Statechart::fromStateMachine(const StateMachine &machine)
+    {
+        RSM_TRACE_SPAN("Statechart::fromStateMachine");
+        Statechart chart;
+        chart.name = machine.name;
+
+        // Duplicate ids keep the first occurrence, like CompiledMachine
+        std::unordered_map<std::string, const State *> byId;
+        std::vector<const State *> unique;
+        for (const auto &state : machine.states)
+        {
+            if (byId.emplace(state.id, &state).second)
+                unique.push_back(&state);
+        }
+
+        std::unordered_map<std::string, std::vector<const State *>> children;
+        std::vector<const State *> topLevel;
+        for (const State *state : unique)
+        {
+            if (state->parent.empty())
+                topLevel.push_back(state);
+            else if (byId.count(state->parent))
+                children[state->parent].push_back(state);
+            else
+                throw std::invalid_argument("State " + state->id + " has unknown parent " + state->parent);
+        }
+
+        // Depth-first in declaration order yields document order
+        std::vector<std::pair<const State *, uint32_t>> stack;
+        for (auto it = topLevel.rbegin(); it != topLevel.rend(); ++it)
+            stack.emplace_back(*it, Root);
+        while (!stack.empty())
+        {
+            const State *state = stack.back().first;
+            uint32_t parent = stack.back().second;
+            stack.pop_back();
+
+            Kind kind = state->isFinal ? Kind::Final : Kind::Atomic;
+            if (state->kind == "parallel")
+                kind = Kind::Parallel;
+            else if (state->kind == "history")
+                kind = Kind::ShallowHistory;
+            else if (state->kind == "deepHistory")
+                kind = Kind::DeepHistory;
+
+            uint32_t node = chart.addNode(state->id, kind, parent);
+            if (state->isInitial && !chart.isHistory(node) && chart.nodes[parent].initial.empty())
+                chart.nodes[parent].initial.push_back(node);
+
+            auto nested = children.find(state->id);
+            if (nested == children.end())
+                continue;
+            for (auto it = nested->second.rbegin(); it != nested->second.rend(); ++it)
+                stack.emplace_back(*it, node);
+        }
+        if (chart.nodes.size() - 1 != unique.size())
+            throw std::invalid_argument("State hierarchy contains a cycle");
+
+        for (const auto &transition : machine.transitions)
+        {
+            int32_t from = chart.findNode(transition.from);
+            int32_t to = chart.findNode(transition.to);
+            if (from < 0 || to < 0)
+                continue;
+            if (chart.isHistory(static_cast<uint32_t>(from)))
+            {
+                chart.nodes[from].initial.push_back(static_cast<uint32_t>(to));
+                continue;
+            }
+
+            Transition t;
+            t.id = transition.id;
+            t.source = static_cast<uint32_t>(from);
+            t.targets.push_back(static_cast<uint32_t>(to));
+            if (!transition.input.empty())
+                t.events.push_back(transition.input);
+            if (!transition.guard.empty() && transition.guard != "true")
+            {
+                t.condition = transition.guard;
+                t.guard = transition.guard == "false" ? Guard::Never : Guard::Unknown;
+            }
+            chart.addTransition(std::move(t));
+        }
+
+        chart.finalize();
+        return chart;
+    }
+
+    double Statechart::flattenedSize() const
+    {
+        std::vector<double> size(nodes.size(), 1);
+        for (size_t n = nodes.size(); n-- > 0;)
+        {
+            const Node &node = nodes[n];
+            if (node.kind != Kind::Compound && node.kind != Kind::Parallel)
+                continue;
+            double total = node.kind == Kind::Parallel ? 1 : 0;
+            for (uint32_t child : node.children)
+            {
+                if (isHistory(child))
+                    continue;
+                total = node.kind == Kind::Parallel ? total * size[child] : total + size[child];
+            }
+            size[n] = total;
+        }
+        return size[Root];
+    }
+
+    StatechartExplorer::StatechartExplorer(const Statechart &chart)
+        : chart(chart), words((chart.nodes.size() + 63) / 64), entered(words, 0), candidates(words, 0)
+    {
+    }
+
+    void StatechartExplorer::restore(const std::vector<uint64_t> &enteredStates, uint64_t divergentMacrosteps)
+    {
+        if (enteredStates.size() != entered.size())
+            throw std::invalid_argument("Entered states do not match the chart");
+        entered = enteredStates;
+        divergent = divergentMacrosteps;
+    }
+
+    bool StatechartExplorer::anyInRange(const std::vector<uint64_t> &bits, uint32_t begin, uint32_t end) const
+    {
+        bool found = false;
+        forEachBit(bits.data(), begin, end, [&found](uint32_t)
+                   { found = true; });
+        return found;
+    }
+
+    bool StatechartExplorer::terminated(const uint64_t *key) const
+    {
+        for (uint32_t child : chart.nodes[Statechart::Root].children)
+        {
+            if (chart.nodes[child].kind == Statechart::Kind::Final && testBit(key, child))
+                return true;
+        }
+        return false;
+    }
+
+    void StatechartExplorer::activeAtomicStates(const uint64_t *key, std::vector<uint32_t> &out) const
+    {
+        forEachBit(key, 0, static_cast<uint32_t>(chart.nodes.size()), [&](uint32_t node)
+                   {
+                       if (chart.isAtomic(node))
+                           out.push_back(node); });
+    }
+
+    bool StatechartExplorer::inFinalState(const uint64_t *active, uint32_t node) const
+    {
+        const Statechart::Node &state = chart.nodes[node];
+        if (state.kind == Statechart::Kind::Compound)
+        {
+            for (uint32_t child : state.children)
+            {
+                if (chart.nodes[child].kind == Statechart::Kind::Final && testBit(active, child))
+                    return true;
+            }
+            return false;
+        }
+        if (state.kind == Statechart::Kind::Parallel)
+        {
+            for (uint32_t child : state.children)
+            {
+                if (!chart.isHistory(child) && !inFinalState(active, child))
+                    return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void StatechartExplorer::effectiveTargets(const uint64_t *key, uint32_t transition)
+    {
+        effective.clear();
+        std::vector<uint32_t> &pending = historyStack;
+        pending.assign(chart.transitions[transition].targets.rbegin(), chart.transitions[transition].targets.rend());
+        while (!pending.empty())
+        {
+            uint32_t target = pending.back();
+            pending.pop_back();
+            if (!chart.isHistory(target))
+            {
+                effective.push_back(target);
+                continue;
+            }
+
+            const uint64_t *value = key + (1 + chart.nodes[target].historySlot) * words;
+            if (!isEmpty(value, words))
+            {
+                forEachBit(value, 0, static_cast<uint32_t>(chart.nodes.size()), [this](uint32_t node)
+                           { effective.push_back(node); });
+            }
+            else
+            {
+                const auto &defaults = chart.nodes[target].initial;
+                pending.insert(pending.end(), defaults.rbegin(), defaults.rend());
+            }
+        }
+    }
+
+    int32_t StatechartExplorer::domain(const uint64_t *key, uint32_t transition)
+    {
+        effectiveTargets(key, transition);
+        if (effective.empty())
+            return -1;
+
+        const Statechart::Transition &t = chart.transitions[transition];
+        auto containsTargets = [this](uint32_t ancestor)
+        {
+            return std::all_of(effective.begin(), effective.end(), [&](uint32_t s)
+                               { return chart.isDescendant(s, ancestor); });
+        };
+
+        if (t.internal && chart.nodes[t.source].kind == Statechart::Kind::Compound && containsTargets(t.source))
+            return static_cast<int32_t>(t.source);
+
+        // Least common compound ancestor of the source and the targets
+        for (uint32_t ancestor = chart.nodes[t.source].parent;; ancestor = chart.nodes[ancestor].parent)
+        {
+            if ((ancestor == Statechart::Root || chart.nodes[ancestor].kind == Statechart::Kind::Compound) && containsTargets(ancestor))
+                return static_cast<int32_t>(ancestor);
+            if (ancestor == Statechart::Root)
+                return static_cast<int32_t>(Statechart::Root);
+        }
+    }
+
+    void StatechartExplorer::computeExitSet(const uint64_t *key, uint32_t transition, std::vector<uint64_t> &out)
+    {
+        int32_t scope = domain(key, transition);
+        if (scope < 0)
+            return;
+        forEachBit(key, static_cast<uint32_t>(scope) + 1, chart.nodes[scope].subtreeEnd, [&out](uint32_t node)
+                   { setBit(out.data(), node); });
+    }
+
+    bool StatechartExplorer::select(const uint64_t *key, int32_t event)
+    {
+        // Only active states under a transition that matches can contribute
+        const uint64_t *scope = chart.scope(event);
+        for (size_t w = 0; w < words; w++)
+            candidates[w] = key[w] & scope[w];
+
+        size_t used = 0;
+        forEachBit(candidates.data(), 0, static_cast<uint32_t>(chart.nodes.size()), [&](uint32_t atomic)
+                   {
+            if (!chart.isAtomic(atomic))
+                return;
+            if (used == options.size())
+                options.emplace_back();
+            std::vector<uint32_t> &choices = options[used];
+            choices.clear();
+
+            // Document order within each state, innermost state first; an
+            // unknown guard may fail, so later transitions stay candidates
+            bool decided = false;
+            for (uint32_t state = atomic; state != Statechart::Root && !decided; state = chart.nodes[state].parent)
+            {
+                for (uint32_t t : chart.nodes[state].transitions)
+                {
+                    if (!chart.matches(t, event) || chart.transitions[t].guard == Statechart::Guard::Never)
+                        continue;
+                    choices.push_back(t);
+                    if (chart.transitions[t].guard == Statechart::Guard::Always)
+                    {
+                        decided = true;
+                        break;
+                    }
+                }
+            }
+            if (choices.empty())
+                return;
+            if (!decided)
+                choices.push_back(NoTransition);
+            used++; });
+
+        options.resize(used);
+        return used > 0;
+    }
+
+    bool StatechartExplorer::nextCombination(std::vector<size_t> &choice) const
+    {
+        for (size_t i = 0; i < choice.size(); i++)
+        {
+            if (++choice[i] < options[i].size())
+                return true;
+            choice[i] = 0;
+        }
+        return false;
+    }
+
+    void StatechartExplorer::removeConflicts(const uint64_t *key)
+    {
+        filtered.clear();
+        size_t kept = 0;
+        for (uint32_t t1 : selected)
+        {
+            if (kept == exitSets.size())
+                exitSets.emplace_back();
+            std::vector<uint64_t> &exit1 = exitSets[kept];
+            exit1.assign(words, 0);
+            computeExitSet(key, t1, exit1);
+
+            bool preempted = false;
+            std::vector<uint8_t> &remove = preemptedBy;
+            remove.assign(filtered.size(), 0);
+            for (size_t j = 0; j < filtered.size() && !preempted; j++)
+            {
+                bool overlap = false;
+                for (size_t w = 0; w < words && !overlap; w++)
+                    overlap = (exit1[w] & exitSets[j][w]) != 0;
+                if (!overlap)
+                    continue;
+                if (chart.isDescendant(chart.transitions[t1].source, chart.transitions[filtered[j]].source))
+                    remove[j] = 1;
+                else
+                    preempted = true;
+            }
+            if (preempted)
+                continue;
+
+            size_t out = 0;
+            for (size_t j = 0; j < filtered.size(); j++)
+            {
+                if (remove[j])
+                    continue;
+                filtered[out] = filtered[j];
+                exitSets[out].swap(exitSets[j]);
+                out++;
+            }
+            filtered.resize(out);
+            exitSets[out].swap(exit1);
+            filtered.push_back(t1);
+            kept = filtered.size();
+        }
+    }
+
+    void StatechartExplorer::addDescendants(const uint64_t *key, uint32_t node)
+    {
+        const Statechart::Node &state = chart.nodes[node];
+        if (chart.isHistory(node))
+        {
+            const uint64_t *value = key + (1 + state.historySlot) * words;
+            std::vector<uint32_t> restored;
+            if (!isEmpty(value, words))
+                forEachBit(value, 0, static_cast<uint32_t>(chart.nodes.size()), [&restored](uint32_t s)
+                           { restored.push_back(s); });
+            else
+                restored = state.initial;
+
+            for (uint32_t s : restored)
+                addDescendants(key, s);
+            for (uint32_t s : restored)
+                addAncestors(key, s, state.parent);
+            return;
+        }
+
+        setBit(entrySet.data(), node);
+        if (state.kind == Statechart::Kind::Compound)
+        {
+            for (uint32_t s : state.initial)
+                addDescendants(key, s);
+            for (uint32_t s : state.initial)
+                addAncestors(key, s, node);
+        }
+        else if (state.kind == Statechart::Kind::Parallel)
+        {
+            for (uint32_t child : state.children)
+            {
+                if (!chart.isHistory(child) && !anyInRange(entrySet, child, chart.nodes[child].subtreeEnd))
+                    addDescendants(key, child);
+            }
+        }
+    }
+
+    void StatechartExplorer::addAncestors(const uint64_t *key, uint32_t node, uint32_t ancestor)
+    {
+        for (uint32_t a = chart.nodes[node].parent; a != ancestor && a != Statechart::Root; a = chart.nodes[a].parent)
+        {
+            setBit(entrySet.data(), a);
+            if (chart.nodes[a].kind != Statechart::Kind::Parallel)
+                continue;
+            for (uint32_t child : chart.nodes[a].children)
+            {
+                if (!chart.isHistory(child) && !anyInRange(entrySet, child, chart.nodes[child].subtreeEnd))
+                    addDescendants(key, child);
+            }
+        }
+    }
+
+    void StatechartExplorer::enter(Pending &next)
+    {
+        uint64_t *active = next.key.data();
+        for (size_t w = 0; w < words; w++)
+            entered[w] |= entrySet[w];
+        forEachBit(entrySet.data(), 0, static_cast<uint32_t>(chart.nodes.size()), [&](uint32_t node)
+                   {
+            setBit(active, node);
+            const Statechart::Node &state = chart.nodes[node];
+            next.queue.insert(next.queue.end(), state.entryRaises.begin(), state.entryRaises.end());
+            if (state.kind != Statechart::Kind::Final || state.parent == Statechart::Root)
+                return;
+
+            const Statechart::Node &parent = chart.nodes[state.parent];
+            next.queue.push_back(parent.doneEvent);
+            if (parent.parent != Statechart::Root && chart.nodes[parent.parent].kind == Statechart::Kind::Parallel &&
+                inFinalState(active, parent.parent))
+                next.queue.push_back(chart.nodes[parent.parent].doneEvent); });
+    }
+
+    StatechartExplorer::Pending StatechartExplorer::microstep(const Pending &item)
+    {
+        Pending next{item.key, std::vector<int32_t>(item.queue.begin() + static_cast<std::ptrdiff_t>(item.head), item.queue.end()), 0, item.microsteps + 1, false};
+        const uint64_t *before = item.key.data();
+        uint64_t *active = next.key.data();
+        const uint32_t count = static_cast<uint32_t>(chart.nodes.size());
+
+        exitSet.assign(words, 0);
+        for (size_t i = 0; i < filtered.size(); i++)
+        {
+            for (size_t w = 0; w < words; w++)
+                exitSet[w] |= exitSets[i][w];
+        }
+
+        // Record history before anything is exited
+        forEachBit(exitSet.data(), 0, count, [&](uint32_t node)
+                   {
+            for (uint32_t h : chart.nodes[node].children)
+            {
+                if (!chart.isHistory(h))
+                    continue;
+                uint64_t *value = active + (1 + chart.nodes[h].historySlot) * words;
+                std::fill(value, value + words, 0);
+                if (chart.nodes[h].kind == Statechart::Kind::DeepHistory)
+                {
+                    forEachBit(before, node + 1, chart.nodes[node].subtreeEnd, [&](uint32_t s)
+                               {
+                                   if (chart.isAtomic(s))
+                                       setBit(value, s); });
+                }
+                else
+                {
+                    for (uint32_t child : chart.nodes[node].children)
+                    {
+                        if (testBit(before, child))
+                            setBit(value, child);
+                    }
+                }
+            } });
+
+        // Exit innermost first, then clear the exited states
+        for (uint32_t node = count; node-- > 0;)
+        {
+            if (!testBit(exitSet.data(), node))
+                continue;
+            const auto &raises = chart.nodes[node].exitRaises;
+            next.queue.insert(next.queue.end(), raises.begin(), raises.end());
+        }
+        for (size_t w = 0; w < words; w++)
+            active[w] &= ~exitSet[w];
+
+        for (uint32_t t : filtered)
+        {
+            const auto &raises = chart.transitions[t].raises;
+            next.queue.insert(next.queue.end(), raises.begin(), raises.end());
+        }
+
+        // Entry resolves history against the values just recorded
+        entrySet.assign(words, 0);
+        for (uint32_t t : filtered)
+        {
+            for (uint32_t target : chart.transitions[t].targets)
+                addDescendants(active, target);
+            int32_t scope = domain(active, t);
+            if (scope < 0)
+                continue;
+            // addAncestors never touches the effective target scratch
+            for (uint32_t target : effective)
+                addAncestors(active, target, static_cast<uint32_t>(scope));
+        }
+        enter(next);
+        return next;
+    }
+
+    void StatechartExplorer::branch(const Pending &item, bool eventless)
+    {
+        std::vector<size_t> choice(options.size(), 0);
+        do
+        {
+            selected.clear();
+            for (size_t i = 0; i < options.size(); i++)
+            {
+                uint32_t t = options[i][choice[i]];
+                if (t != NoTransition && std::find(selected.begin(), selected.end(), t) == selected.end())
+                    selected.push_back(t);
+            }
+
+            if (selected.empty())
+            {
+                // Every candidate guard failed: the configuration is unchanged
+                Pending same = item;
+                same.eventlessStable = eventless;
+                work.push_back(std::move(same));
+                continue;
+            }
+            removeConflicts(item.key.data());
+            work.push_back(microstep(item));
+        } while (nextCombination(choice));
+    }
+
+    void StatechartExplorer::settle(std::vector<uint64_t> &out)
+    {
+        // Depth-first over the items of one macrostep. An item reached
+        // again is not expanded again, so unknown guards in orthogonal
+        // regions cost one visit per distinct item rather than one per
+        // interleaving; reaching an item still on the path is a loop.
+        seen.clear();
+        frames.clear();
+        frames.push_back(Frame{std::move(work), 0, seen.end()});
+        work.clear();
+        CancellationPoint cancellation;
+        while (!frames.empty())
+        {
+            cancellation.check();
+            if (budget && budget->exhausted(0))
+            {
+                stopped = true;
+                return;
+            }
+            Frame &frame = frames.back();
+            if (frame.next == frame.children.size())
+            {
+                if (frame.entry != seen.end())
+                    frame.entry->second = false;
+                frames.pop_back();
+                continue;
+            }
+            Pending item = std::move(frame.children[frame.next++]);
+            if (item.microsteps > MaxMicrosteps)
+            {
+                // Eventless or raised events keep firing forever
+                divergent++;
+                continue;
+            }
+
+            identity.assign(item.key.begin(), item.key.end());
+            for (size_t i = item.head; i < item.queue.size(); i++)
+                identity.push_back(static_cast<uint32_t>(item.queue[i]));
+            identity.push_back(item.eventlessStable);
+            auto visit = seen.emplace(identity, true);
+            if (!visit.second)
+            {
+                if (visit.first->second)
+                    divergent++;
+                continue;
+            }
+
+            if (!item.eventlessStable && select(item.key.data(), Statechart::NoEvent))
+            {
+                branch(item, true);
+            }
+            else if (item.head == item.queue.size())
+            {
+                out.insert(out.end(), item.key.begin(), item.key.end());
+                visit.first->second = false;
+                continue;
+            }
+            else
+            {
+                // Internal events are discarded when nothing matches them
+                int32_t event = item.queue[item.head++];
+                if (!select(item.key.data(), event))
+                {
+                    item.eventlessStable = true;
+                    work.push_back(std::move(item));
+                }
+                else
+                {
+                    item.eventlessStable = false;
+                    branch(item, false);
+                }
+            }
+            frames.push_back(Frame{std::move(work), 0, visit.first});
+            work.clear();
+        }
+    }
+
+    void StatechartExplorer::initial(std::vector<uint64_t> &out)
+    {
+        Pending start{std::vector<uint64_t>(keyWords(), 0), {}, 0, 0, false};
+        entrySet.assign(words, 0);
+        for (uint32_t target : chart.nodes[Statechart::Root].initial)
+            addDescendants(start.key.data(), target);
+        for (uint32_t target : chart.nodes[Statechart::Root].initial)
+            addAncestors(start.key.data(), target, Statechart::Root);
+        enter(start);
+
+        stopped = false;
+        work.clear();
+        work.push_back(std::move(start));
+        settle(out);
+    }
+
+    bool StatechartExplorer::step(const uint64_t *key, int32_t event, std::vector<uint64_t> &out)
+    {
+        if (!select(key, event))
+            return false;
+
+        Pending start{std::vector<uint64_t>(key, key + keyWords()), {}, 0, 0, false};
+        stopped = false;
+        work.clear();
+        branch(start, false);
+        settle(out);
+        return true;
+    }
+
+    StatechartReport StatechartExplorer::explore(const Statechart &chart, size_t maxConfigurations,
+                                                 const AnalysisBudget &budget, const CheckpointOptions &checkpointOptions)
+    {
+        RSM_TRACE_SPAN("StatechartExplorer::explore");
+        StatechartExplorer explorer(chart);
+        const size_t keyWords = explorer.keyWords();
+        const uint32_t count = static_cast<uint32_t>(chart.nodes.size());
+
+        StatechartReport report;
+        report.flattenedSize = chart.flattenedSize();
+
+        ConfigurationTable visited(keyWords);
+        // Union of the active states of every deadlocked configuration
+        std::vector<uint64_t> deadlocked(chart.nodeWords, 0);
+        auto deadlockedStates = [&]()
+        {
+            std::vector<std::string> names;
+            forEachBit(deadlocked.data(), 0, count, [&](uint32_t node)
+                       {
+                           if (chart.isAtomic(node))
+                               names.push_back(chart.nodes[node].id); });
+            return names;
+        };
+        std::vector<uint32_t> parents;
+        std::vector<int32_t> parentEvents;
+        std::vector<uint64_t> successors;
+
+        uint32_t index = 0;
+
+        // Successors dropped at the limit are in no record, so a checkpoint
+        // must re-expand the configuration that first dropped one: it holds
+        // the findings as they were before that configuration
+        bool dropped = false;
+        uint64_t macrostepsBefore = 0;
+        uint64_t divergentBefore = 0;
+        StatechartReport resumeReport;
+        uint32_t resumeIndex = 0;
+        uint64_t resumeDivergent = 0;
+
+        auto add = [&](const uint64_t *key, uint32_t parent, int32_t event)
+        {
+            if (visited.size() >= maxConfigurations)
+            {
+                if (!visited.contains(key))
+                {
+                    if (!dropped)
+                    {
+                        dropped = true;
+                        resumeReport = report;
+                        resumeReport.macrosteps = macrostepsBefore;
+                        resumeIndex = index;
+                        resumeDivergent = divergentBefore;
+                    }
+                    report.complete = false;
+                    report.stopReason = StopReason::ConfigurationLimit;
+                    report.frontier++;
+                }
+                return;
+            }
+            if (visited.insert(key).second)
+            {
+                parents.push_back(parent);
+                parentEvents.push_back(event);
+            }
+        };
+
+        // Resume from the last checkpoint, or start from the initial configurations
+        std::unique_ptr<ExplorationCheckpoint> checkpoint;
+        ExplorationCheckpoint::State saved;
+        if (!checkpointOptions.directory.empty())
+        {
+            checkpoint.reset(new ExplorationCheckpoint(checkpointOptions, canonicalHash(chart), static_cast<uint32_t>(keyWords),
+                                                       static_cast<uint32_t>(chart.events.size())));
+            // Another exploration of this chart owns its checkpoint; run without one
+            if (!checkpoint->locked())
+                checkpoint.reset();
+        }
+        if (checkpoint)
+        {
+            auto restoreRecord = [&](const uint64_t *key, uint32_t parent, int32_t event)
+            {
+                // Records are numbered by position, so each key is new
+                if (!visited.insert(key).second)
+                    throw std::runtime_error("Corrupt checkpoint: " + checkpoint->path());
+                parents.push_back(parent);
+                parentEvents.push_back(event);
+            };
+            if (checkpoint->load(saved, restoreRecord))
+            {
+                // Findings carry over; how the saved run stopped does not
+                report = saved.report;
+                report.complete = true;
+                report.stopReason = StopReason::None;
+                report.frontier = 0;
+                report.flattenedSize = chart.flattenedSize();
+                report.elapsedMs = saved.elapsedMs;
+                explorer.restore(saved.entered, saved.divergent);
+                index = static_cast<uint32_t>(saved.expanded);
+                for (const auto &id : saved.report.deadlockedStates)
+                {
+                    int32_t node = chart.findNode(id);
+                    if (node < 0)
+                        throw std::runtime_error("Corrupt checkpoint: " + checkpoint->path());
+                    setBit(deadlocked.data(), static_cast<uint32_t>(node));
+                }
+            }
+        }
+        BudgetMeter meter(budget);
+        explorer.useBudget(&meter);
+        if (!saved.committed)
+        {
+            explorer.initial(successors);
+            for (size_t i = 0; i < successors.size(); i += keyWords)
+                add(successors.data() + i, UINT32_MAX, Statechart::NoEvent);
+            // Initial configurations are never re-entered on resume
+            if (dropped || explorer.interrupted())
+                checkpoint.reset();
+        }
+
+        std::vector<uint32_t> atomics;
+        CancellationPoint cancellation;
+        ProgressMeter progress;
+
+        // Saved before a budget stop is recorded, so a resumed run goes on
+        auto save = [&]()
+        {
+            saved.expanded = dropped ? resumeIndex : index;
+            saved.divergent = dropped ? resumeDivergent : explorer.divergentMacrosteps();
+            saved.elapsedMs = report.elapsedMs + meter.elapsedMs();
+            // States entered past resumeIndex are entered again on resume
+            saved.entered = explorer.enteredStates();
+            saved.report = dropped ? resumeReport : report;
+            // Deadlocks found past resumeIndex are found again on resume
+            saved.report.deadlockedStates = deadlockedStates();
+            checkpoint->save(saved, visited.size(), visited.key(0), parents.data(), parentEvents.data());
+        };
+
+        uint32_t depth = 0;
+        size_t levelEnd = visited.size();
+        size_t bytes = 0;
+        for (; index < visited.size(); index++)
+        {
+            cancellation.check();
+            if (index == levelEnd)
+            {
+                depth++;
+                levelEnd = visited.size();
+            }
+            bytes = visited.bytes() + (parents.capacity() + parentEvents.capacity()) * sizeof(uint32_t);
+            progress.update(index, visited.size() - index, depth, bytes);
+            if (checkpoint && checkpoint->due())
+                save();
+            if (meter.exhausted(bytes))
+            {
+                if (checkpoint)
+                    save();
+                report.complete = false;
+                report.stopReason = meter.reason();
+                report.frontier += visited.size() - index;
+                break;
+            }
+            if (explorer.terminated(visited.key(index)))
+            {
+                report.terminalConfigurations++;
+                continue;
+            }
+
+            macrostepsBefore = report.macrosteps;
+            divergentBefore = explorer.divergentMacrosteps();
+            bool enabled = false;
+            for (int32_t event : chart.externalEvents)
+            {
+                successors.clear();
+                if (!explorer.step(visited.key(index), event, successors))
+                    continue;
+                enabled = true;
+                if (explorer.interrupted())
+                    break;
+                for (size_t i = 0; i < successors.size(); i += keyWords)
+                {
+                    report.macrosteps++;
+                    add(successors.data() + i, index, event);
+                }
+            }
+            if (explorer.interrupted())
+            {
+                // The budget ran out within a macrostep: this configuration
+                // counts as unexpanded, and its successors added so far
+                // are expanded on resume like any other
+                report.macrosteps = macrostepsBefore;
+                explorer.restore(explorer.enteredStates(), divergentBefore);
+                if (checkpoint)
+                    save();
+                report.complete = false;
+                report.stopReason = meter.reason();
+                report.frontier += visited.size() - index;
+                break;
+            }
+            if (enabled)
+                continue;
+
+            report.deadlockCount++;
+            for (size_t w = 0; w < chart.nodeWords; w++)
+                deadlocked[w] |= visited.key(index)[w];
+            if (report.deadlocks.size() < StatechartReport::MaxReportedDeadlocks)
+            {
+                atomics.clear();
+                explorer.activeAtomicStates(visited.key(index), atomics);
+                std::vector<std::string> names;
+                for (uint32_t s : atomics)
+                    names.push_back(chart.nodes[s].id);
+                report.deadlocks.push_back(names);
+            }
+            if (report.deadlockCount == 1)
+            {
+                for (uint32_t at = index; parents[at] != UINT32_MAX; at = parents[at])
+                    report.deadlockPath.push_back(chart.events[parentEvents[at]]);
+                std::reverse(report.deadlockPath.begin(), report.deadlockPath.end());
+            }
+        }
+
+        for (uint32_t n = 1; n < count; n++)
+        {
+            if (!chart.isHistory(n) && !testBit(explorer.enteredStates().data(), n))
+                report.unreachableStates.push_back(chart.nodes[n].id);
+        }
+        // A complete run has nothing to resume; one stopped at the limit can go on with a larger one
+        if (checkpoint && report.complete)
+            checkpoint->discard();
+        else if (checkpoint && index == visited.size())
+            save();
+        progress.finish(index, visited.size() - index, depth, bytes);
+        report.deadlockedStates = deadlockedStates();
+        report.configurations = visited.size();
+        report.expanded = index;
+        report.divergentMacrosteps = explorer.divergentMacrosteps();
+        report.elapsedMs += meter.elapsedMs();
+        report.peakBytes = visited.bytes() + (parents.capacity() + parentEvents.capacity()) * sizeof(uint32_t);
+        // Each expanded key is read once per external event and each
+        // successor is written, then hashed and compared on insertion
+        report.bytesTouched = (index * chart.externalEvents.size() + 2 * report.macrosteps) * keyWords * sizeof(uint64_t) +
+                              visited.size() * 2 * sizeof(uint32_t);
+        return report;
+    }
+
+} // namespace ReactiveSystem
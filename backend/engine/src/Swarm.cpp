@@ -0,0 +1,344 @@
+#include "../include/Swarm.h"
+#include "../include/Cancellation.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        // Bounds the findings one search keeps before they are merged
+        constexpr size_t MaxFindingsPerSearch = 1024;
+
+        uint64_t splitmix(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /**
+         * Bloom-style visited set: three bits per configuration from a
+         * seeded hash, so each search forgets different configurations
+         */
+        class Bitstate
+        {
+        public:
+            static constexpr int Probes = 3;
+
+            Bitstate(size_t bytes, uint64_t seed) : seed(seed)
+            {
+                const size_t size = tableBytes(bytes);
+                mask = size * 8 - 1;
+                words.assign(size / 8, 0);
+            }
+
+            /**
+             * Table size for a request: a power of two in [8, MaxBitstateBytes],
+             * computed in bytes so a huge request cannot overflow the bit count
+             */
+            static size_t tableBytes(size_t requested)
+            {
+                const size_t limit = std::min(std::max<size_t>(requested, 8), SwarmOptions::MaxBitstateBytes);
+                size_t size = 8;
+                while (size <= limit / 2)
+                    size *= 2;
+                return size;
+            }
+
+            /**
+             * Set the configuration's bits; false when all were already set
+             */
+            bool insert(const uint64_t *key, size_t keyWords)
+            {
+                uint64_t h = seed;
+                for (size_t w = 0; w < keyWords; w++)
+                {
+                    h = (h ^ key[w]) * 0xBF58476D1CE4E5B9ull;
+                    h ^= h >> 31;
+                }
+                uint64_t step = (h >> 32) | 1;
+                bool added = false;
+                for (int probe = 0; probe < Probes; probe++, h += step)
+                {
+                    uint64_t bit = h & mask;
+                    uint64_t &word = words[bit / 64];
+                    uint64_t flag = 1ull << (bit % 64);
+                    if (!(word & flag))
+                    {
+                        word |= flag;
+                        set++;
+                        added = true;
+                    }
+                }
+                return added;
+            }
+
+            size_t bytes() const { return words.size() * sizeof(uint64_t); }
+            double fill() const { return static_cast<double>(set) / (mask + 1); }
+
+        private:
+            uint64_t seed;
+            uint64_t mask;
+            uint64_t set = 0;
+            std::vector<uint64_t> words;
+        };
+
+        /**
+         * At most half the memory budget, leaving the rest to the search stack
+         */
+        size_t requestedTable(const SwarmOptions &options)
+        {
+            return std::min(options.bitstateBytes, options.budget.memoryBytes / 2);
+        }
+
+        struct Found
+        {
+            std::vector<uint64_t> key;
+            std::vector<int32_t> path;
+        };
+
+        struct SearchResult
+        {
+            uint64_t states = 0;
+            uint64_t transitions = 0;
+            uint64_t truncated = 0;
+            uint64_t divergent = 0;
+            double fill = 0;
+            std::vector<uint64_t> entered;
+            std::vector<Found> found;
+        };
+
+        /**
+         * One bounded depth-first search. The stack holds configurations
+         * still to visit with their depth and the event that produced them;
+         * the path to the configuration being visited is rebuilt from the
+         * events of the last configuration popped at each depth.
+         */
+        SearchResult search(const Statechart &chart, const SwarmOptions &options, uint64_t seed)
+        {
+            StatechartExplorer explorer(chart);
+            const size_t keyWords = explorer.keyWords();
+            Bitstate seen(requestedTable(options), splitmix(seed));
+            std::mt19937_64 random(splitmix(seed));
+
+            std::vector<int32_t> events = chart.externalEvents;
+            std::shuffle(events.begin(), events.end(), random);
+
+            struct Pending
+            {
+                uint32_t depth;
+                int32_t event;
+            };
+            std::vector<uint64_t> stackKeys;
+            std::vector<Pending> stack;
+            std::vector<uint64_t> current(keyWords);
+            std::vector<int32_t> path;
+            std::vector<uint64_t> successors;
+            std::vector<uint64_t> batchKeys;
+            std::vector<int32_t> batchEvents;
+            std::vector<uint32_t> order;
+
+            explorer.initial(successors);
+            for (size_t i = 0; i < successors.size(); i += keyWords)
+            {
+                if (seen.insert(successors.data() + i, keyWords))
+                {
+                    stackKeys.insert(stackKeys.end(), successors.begin() + i, successors.begin() + i + keyWords);
+                    stack.push_back({0, Statechart::NoEvent});
+                }
+            }
+
+            SearchResult result;
+            CancellationPoint cancellation;
+            BudgetMeter meter(options.budget);
+            explorer.useBudget(&meter);
+            while (!stack.empty())
+            {
+                cancellation.check();
+                if (meter.exhausted(seen.bytes() + stackKeys.capacity() * sizeof(uint64_t)))
+                    break;
+
+                Pending visit = stack.back();
+                stack.pop_back();
+                std::copy(stackKeys.end() - keyWords, stackKeys.end(), current.begin());
+                stackKeys.resize(stackKeys.size() - keyWords);
+                path.resize(visit.depth);
+                if (visit.depth > 0)
+                    path[visit.depth - 1] = visit.event;
+                result.states++;
+
+                if (explorer.terminated(current.data()))
+                    continue;
+                if (visit.depth >= options.maxDepth)
+                {
+                    result.truncated++;
+                    continue;
+                }
+
+                batchKeys.clear();
+                batchEvents.clear();
+                bool enabled = false;
+                for (int32_t event : events)
+                {
+                    successors.clear();
+                    if (!explorer.step(current.data(), event, successors))
+                        continue;
+                    enabled = true;
+                    for (size_t i = 0; i < successors.size(); i += keyWords)
+                    {
+                        result.transitions++;
+                        if (seen.insert(successors.data() + i, keyWords))
+                        {
+                            batchKeys.insert(batchKeys.end(), successors.begin() + i, successors.begin() + i + keyWords);
+                            batchEvents.push_back(event);
+                        }
+                    }
+                }
+                if (!enabled)
+                {
+                    if (result.found.size() < MaxFindingsPerSearch)
+                        result.found.push_back({current, path});
+                    continue;
+                }
+
+                // Visit the new successors in a random order
+                order.resize(batchEvents.size());
+                for (uint32_t i = 0; i < order.size(); i++)
+                    order[i] = i;
+                std::shuffle(order.begin(), order.end(), random);
+                for (uint32_t i : order)
+                {
+                    stackKeys.insert(stackKeys.end(), batchKeys.begin() + i * keyWords, batchKeys.begin() + (i + 1) * keyWords);
+                    stack.push_back({visit.depth + 1, batchEvents[i]});
+                }
+            }
+
+            result.divergent = explorer.divergentMacrosteps();
+            result.fill = seen.fill();
+            result.entered = explorer.enteredStates();
+            return result;
+        }
+    } // namespace
+
+    SwarmReport Swarm::run(const Statechart &chart, const SwarmOptions &options)
+    {
+        RSM_TRACE_SPAN("Swarm::run");
+        auto started = std::chrono::steady_clock::now();
+        unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, SwarmOptions::MaxThreads);
+        unsigned searches = std::min(options.searches ? options.searches : threads, SwarmOptions::MaxSearches);
+        threads = std::min(threads, searches);
+        // Every running search zero-fills its table up front, before its
+        // budget is first checked
+        const size_t table = Bitstate::tableBytes(requestedTable(options));
+        threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, SwarmOptions::MaxTotalBitstateBytes / table)));
+
+        std::vector<SearchResult> results(searches);
+        std::vector<std::exception_ptr> errors(threads);
+        std::atomic<unsigned> nextSearch{0};
+        const CancellationToken *token = CancellationToken::current();
+
+        auto worker = [&](unsigned thread)
+        {
+            CancellationScope scope(token);
+            try
+            {
+                for (unsigned i; (i = nextSearch++) < searches;)
+                {
+                    uint64_t seed = options.seed + i;
+                    results[i] = search(chart, options, splitmix(seed));
+                }
+            }
+            catch (...)
+            {
+                errors[thread] = std::current_exception();
+                nextSearch = searches;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++)
+            pool.emplace_back(worker, t);
+        worker(0);
+        for (auto &thread : pool)
+            thread.join();
+        for (auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        // Merge: sum the counters, OR the entered states, and deduplicate
+        // deadlocks by configuration keeping the shortest path
+        SwarmReport report;
+        report.searches = searches;
+        report.threads = threads;
+        report.bitstateBytes = threads * table;
+        std::vector<uint64_t> entered;
+        std::map<std::vector<uint64_t>, std::pair<const Found *, unsigned>> deadlocks;
+        for (const auto &result : results)
+        {
+            report.statesVisited += result.states;
+            report.transitions += result.transitions;
+            report.truncated += result.truncated;
+            report.divergentMacrosteps += result.divergent;
+            report.bitstateFill += result.fill / searches;
+            entered.resize(std::max(entered.size(), result.entered.size()), 0);
+            for (size_t w = 0; w < result.entered.size(); w++)
+                entered[w] |= result.entered[w];
+            for (const auto &found : result.found)
+            {
+                auto &entry = deadlocks[found.key];
+                if (!entry.first || found.path.size() < entry.first->path.size())
+                    entry.first = &found;
+                entry.second++;
+            }
+        }
+
+        std::vector<std::pair<const Found *, unsigned>> ordered;
+        for (const auto &entry : deadlocks)
+            ordered.push_back(entry.second);
+        std::stable_sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b)
+                         { return a.first->path.size() < b.first->path.size(); });
+        report.deadlockCount = ordered.size();
+
+        StatechartExplorer explorer(chart);
+        std::vector<uint32_t> atomics;
+        for (size_t i = 0; i < ordered.size() && i < SwarmReport::MaxReportedDeadlocks; i++)
+        {
+            SwarmFinding finding;
+            atomics.clear();
+            explorer.activeAtomicStates(ordered[i].first->key.data(), atomics);
+            for (uint32_t s : atomics)
+                finding.configuration.push_back(chart.nodes[s].id);
+            for (int32_t event : ordered[i].first->path)
+                finding.path.push_back(chart.events[event]);
+            finding.foundBy = ordered[i].second;
+            report.deadlocks.push_back(std::move(finding));
+        }
+
+        for (uint32_t n = 1; n < chart.nodes.size(); n++)
+        {
+            if (chart.isHistory(n))
+                continue;
+            report.stateCount++;
+            if (n / 64 < entered.size() && (entered[n / 64] >> (n % 64)) & 1)
+                report.statesCovered++;
+            else
+                report.unreachedStates.push_back(chart.nodes[n].id);
+        }
+        report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+} // namespace ReactiveSystem
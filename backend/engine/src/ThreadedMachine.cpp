@@ -0,0 +1,456 @@
+#include "../include/ThreadedMachine.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RSM_COMPUTED_GOTO 1
+#else
+#define RSM_COMPUTED_GOTO 0
+#endif
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        /**
+         * Bytecode ops map 1:1 onto threaded ops except for jumps, whose
+         * targets are rebased when guards and actions are inlined
+         */
+        bool isJump(OpCode op)
+        {
+            return op == OpCode::Jump || op == OpCode::JumpIfZero || op == OpCode::JumpIfNonZero;
+        }
+    } // namespace
+
+    void ThreadedMachine::append(OpCode op, int64_t operand, int32_t edge)
+    {
+        code.push_back({nullptr, operand, edge, op});
+    }
+
+    /**
+     * Layout: ops [0, stateCount) are the per-state dispatch ops, op
+     * stateCount is the shared failure exit, then one block per
+     * (state, input) holding its candidate transitions in declaration order
+     */
+    std::unique_ptr<ThreadedMachine> ThreadedMachine::compile(const MachineProgram &program)
+    {
+        const CompiledMachine &graph = program.graph;
+        const size_t stateCount = graph.stateCount();
+        const size_t inputCount = graph.inputCount();
+        if (stateCount == 0 || stateCount * inputCount > MaxDispatchEntries)
+        {
+            return nullptr;
+        }
+
+        // Bytecode ops share their order with the threaded ops, shifted by Dispatch
+        static_assert(static_cast<int>(OpCode::PushConst) == static_cast<int>(ReactiveSystem::OpCode::PushConst) + 1 &&
+                          static_cast<int>(OpCode::JumpIfNonZero) == static_cast<int>(ReactiveSystem::OpCode::JumpIfNonZero) + 1,
+                      "Expression OpCode layout changed; update ThreadedMachine::OpCode");
+        auto threaded = [](ReactiveSystem::OpCode op)
+        {
+            return static_cast<OpCode>(static_cast<int>(op) + 1);
+        };
+
+        std::unique_ptr<ThreadedMachine> machine(new ThreadedMachine());
+        machine->inputCount = inputCount;
+        machine->entries.assign(stateCount * inputCount, -1);
+
+        for (size_t s = 0; s < stateCount; s++)
+        {
+            machine->append(OpCode::Dispatch, static_cast<int64_t>(s));
+        }
+        const int64_t failIndex = static_cast<int64_t>(machine->code.size());
+        machine->append(OpCode::Fail, 0);
+
+        std::vector<uint32_t> candidates;
+        for (size_t s = 0; s < stateCount; s++)
+        {
+            for (size_t input = 0; input < inputCount; input++)
+            {
+                candidates.clear();
+                for (uint32_t e = graph.edgeOffsets[s]; e < graph.edgeOffsets[s + 1]; e++)
+                {
+                    if (graph.edgeInputs[e] == static_cast<int32_t>(input))
+                        candidates.push_back(e);
+                }
+                if (candidates.empty())
+                    continue;
+
+                machine->entries[s * inputCount + input] = static_cast<int32_t>(machine->code.size());
+
+                for (size_t c = 0; c < candidates.size(); c++)
+                {
+                    const uint32_t e = candidates[c];
+                    const Bytecode &guard = program.edgeGuards[e];
+                    size_t guardExit = 0;
+
+                    if (!guard.empty())
+                    {
+                        const int64_t base = static_cast<int64_t>(machine->code.size());
+                        for (const Instruction &instruction : guard.code)
+                        {
+                            int64_t operand = isJump(instruction.op) ? instruction.operand + base : instruction.operand;
+                            machine->append(threaded(instruction.op), operand);
+                        }
+                        // Patched below to the next candidate (or the failure exit)
+                        guardExit = machine->code.size();
+                        machine->append(OpCode::JumpIfZero, failIndex);
+                    }
+
+                    const int64_t actionBase = static_cast<int64_t>(machine->code.size());
+                    for (const Instruction &instruction : program.edgeActions[e].code)
+                    {
+                        int64_t operand = isJump(instruction.op) ? instruction.operand + actionBase : instruction.operand;
+                        machine->append(threaded(instruction.op), operand);
+                    }
+                    // Fire jumps to the target's dispatch op, whose index is the state index
+                    machine->append(OpCode::Fire, graph.edgeTargets[e], static_cast<int32_t>(e));
+
+                    if (guard.empty())
+                    {
+                        break; // later candidates can never fire
+                    }
+                    if (c + 1 < candidates.size())
+                    {
+                        machine->code[guardExit].operand = static_cast<int64_t>(machine->code.size());
+                    }
+                }
+            }
+        }
+
+        // Thread the code: replace op codes by handler addresses
+        const void *const *handlers = nullptr;
+        int32_t unusedState = 0;
+        machine->execute(unusedState, nullptr, nullptr, 0, nullptr, &handlers);
+        if (handlers)
+        {
+            for (Op &op : machine->code)
+            {
+                op.handler = handlers[static_cast<size_t>(op.code)];
+            }
+        }
+
+        return machine;
+    }
+
+    ThreadedMachine::RunResult ThreadedMachine::run(
+        int32_t &state,
+        int64_t *variables,
+        const int32_t *inputs,
+        size_t count,
+        int32_t *edgeTrace) const
+    {
+        return execute(state, variables, inputs, count, edgeTrace, nullptr);
+    }
+
+    ThreadedMachine::RunResult ThreadedMachine::execute(
+        int32_t &state,
+        int64_t *variables,
+        const int32_t *inputs,
+        size_t count,
+        int32_t *edgeTrace,
+        const void *const **handlerTable) const
+    {
+#if RSM_COMPUTED_GOTO
+        static const void *const handlers[] = {
+            &&op_Dispatch, &&op_PushConst, &&op_Load, &&op_Store, &&op_Add, &&op_Sub, &&op_Mul,
+            &&op_Div, &&op_Mod, &&op_Neg, &&op_Not, &&op_Eq, &&op_Ne, &&op_Lt, &&op_Le, &&op_Gt,
+            &&op_Ge, &&op_ToBool, &&op_Jump, &&op_JumpIfZero, &&op_JumpIfNonZero, &&op_Fire, &&op_Fail};
+        if (handlerTable)
+        {
+            *handlerTable = handlers;
+            return {0, false};
+        }
+#define RSM_OP(name) op_##name:
+#define RSM_NEXT() goto *ip->handler
+#else
+        if (handlerTable)
+        {
+            *handlerTable = nullptr;
+            return {0, false};
+        }
+#define RSM_OP(name) case OpCode::name:
+#define RSM_NEXT() continue
+#endif
+
+        RunResult result{0, false};
+        if (state < 0 || count == 0)
+        {
+            return result;
+        }
+
+        const Op *const base = code.data();
+        const int32_t *const entryTable = entries.data();
+        const Op *ip = base + state;
+        int32_t current = state;
+        size_t position = 0;
+        int64_t stack[Bytecode::MaxStack];
+        int64_t *sp = stack; // one past the top
+
+#if RSM_COMPUTED_GOTO
+        RSM_NEXT();
+#else
+        for (;;)
+        {
+            switch (ip->code)
+            {
+#endif
+
+        RSM_OP(Dispatch)
+        {
+            if (position == count)
+            {
+                state = current;
+                result.steps = position;
+                return result;
+            }
+            const int32_t input = inputs[position];
+            int32_t entry = -1;
+            if (input >= 0 && static_cast<size_t>(input) < inputCount)
+            {
+                entry = entryTable[static_cast<size_t>(ip->operand) * inputCount + static_cast<size_t>(input)];
+            }
+            if (entry < 0)
+            {
+                state = current;
+                result.steps = position;
+                result.failed = true;
+                return result;
+            }
+            ip = base + entry;
+            RSM_NEXT();
+        }
+        RSM_OP(PushConst)
+        {
+            *sp++ = ip->operand;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Load)
+        {
+            *sp++ = variables[ip->operand];
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Store)
+        {
+            variables[ip->operand] = *--sp;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Add)
+        {
+            sp[-2] = static_cast<int64_t>(static_cast<uint64_t>(sp[-2]) + static_cast<uint64_t>(sp[-1]));
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Sub)
+        {
+            sp[-2] = static_cast<int64_t>(static_cast<uint64_t>(sp[-2]) - static_cast<uint64_t>(sp[-1]));
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Mul)
+        {
+            sp[-2] = static_cast<int64_t>(static_cast<uint64_t>(sp[-2]) * static_cast<uint64_t>(sp[-1]));
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Div)
+        {
+            sp[-2] = Expression::applyBinary(ReactiveSystem::OpCode::Div, sp[-2], sp[-1]);
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Mod)
+        {
+            sp[-2] = Expression::applyBinary(ReactiveSystem::OpCode::Mod, sp[-2], sp[-1]);
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Neg)
+        {
+            sp[-1] = static_cast<int64_t>(0 - static_cast<uint64_t>(sp[-1]));
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Not)
+        {
+            sp[-1] = sp[-1] == 0;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Eq)
+        {
+            sp[-2] = sp[-2] == sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Ne)
+        {
+            sp[-2] = sp[-2] != sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Lt)
+        {
+            sp[-2] = sp[-2] < sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Le)
+        {
+            sp[-2] = sp[-2] <= sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Gt)
+        {
+            sp[-2] = sp[-2] > sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Ge)
+        {
+            sp[-2] = sp[-2] >= sp[-1];
+            sp--;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(ToBool)
+        {
+            sp[-1] = sp[-1] != 0;
+            ip++;
+            RSM_NEXT();
+        }
+        RSM_OP(Jump)
+        {
+            ip = base + ip->operand;
+            RSM_NEXT();
+        }
+        RSM_OP(JumpIfZero)
+        {
+            ip = (*--sp == 0) ? base + ip->operand : ip + 1;
+            RSM_NEXT();
+        }
+        RSM_OP(JumpIfNonZero)
+        {
+            ip = (*--sp != 0) ? base + ip->operand : ip + 1;
+            RSM_NEXT();
+        }
+        RSM_OP(Fire)
+        {
+            if (edgeTrace)
+            {
+                edgeTrace[position] = ip->edge;
+            }
+            position++;
+            current = static_cast<int32_t>(ip->operand);
+            ip = base + ip->operand;
+            RSM_NEXT();
+        }
+        RSM_OP(Fail)
+        {
+            // Every candidate's guard was false: the input is not consumed
+            state = current;
+            result.steps = position;
+            result.failed = true;
+            return result;
+        }
+
+#if !RSM_COMPUTED_GOTO
+            }
+        }
+#endif
+#undef RSM_OP
+#undef RSM_NEXT
+    }
+
+    TieredSimulator::TieredSimulator(const MachineProgram &program, uint64_t tierUpSteps)
+        : program(program), tierUpSteps(tierUpSteps)
+    {
+        reset();
+    }
+
+    void TieredSimulator::reset()
+    {
+        state = program.graph.initialState;
+        values = program.variables.initialValues();
+    }
+
+    void TieredSimulator::restore(int32_t stateIndex, const std::vector<int64_t> &variableValues, uint64_t stepsTaken)
+    {
+        state = stateIndex;
+        values = variableValues;
+        stepCount += stepsTaken;
+        maybeTierUp();
+    }
+
+    void TieredSimulator::maybeTierUp()
+    {
+        if (!compileAttempted && stepCount >= tierUpSteps)
+        {
+            compileAttempted = true;
+            compiled = ThreadedMachine::compile(program);
+        }
+    }
+
+    int32_t TieredSimulator::step(int32_t input)
+    {
+        maybeTierUp();
+        stepCount++;
+        if (!compiled)
+        {
+            return Simulator::step(program, state, values.data(), input);
+        }
+
+        int32_t edge = -1;
+        compiled->run(state, values.data(), &input, 1, &edge);
+        return edge;
+    }
+
+    ThreadedMachine::RunResult TieredSimulator::run(const int32_t *inputs, size_t count, int32_t *edgeTrace)
+    {
+        ThreadedMachine::RunResult result{0, false};
+
+        // Interpret until the tier-up threshold, then hand the rest to the threaded code
+        while (!compiled && result.steps < count)
+        {
+            maybeTierUp();
+            if (compiled)
+                break;
+
+            int32_t edge = Simulator::step(program, state, values.data(), inputs[result.steps]);
+            stepCount++;
+            if (edge < 0)
+            {
+                result.failed = true;
+                return result;
+            }
+            if (edgeTrace)
+                edgeTrace[result.steps] = edge;
+            result.steps++;
+        }
+
+        if (compiled && result.steps < count)
+        {
+            auto rest = compiled->run(
+                state, values.data(), inputs + result.steps, count - result.steps,
+                edgeTrace ? edgeTrace + result.steps : nullptr);
+            stepCount += rest.steps + (rest.failed ? 1 : 0);
+            result.steps += rest.steps;
+            result.failed = rest.failed;
+        }
+        return result;
+    }
+
+} // namespace ReactiveSystem
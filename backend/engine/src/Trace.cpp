@@ -0,0 +1,239 @@
+#include "../include/Trace.h"
+#include "../include/Json.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        /**
+         * Spans of one thread. Only the owner writes: it fills the slot at
+         * head, then publishes it by advancing head. A reader copies the
+         * slots below head and keeps those the owner cannot have started
+         * to overwrite before it read head again.
+         */
+        struct TraceRing
+        {
+            struct Slot
+            {
+                std::atomic<const char *> name{nullptr};
+                std::atomic<uint64_t> begin{0};
+                std::atomic<uint64_t> end{0};
+                std::atomic<uint32_t> request{0};
+                std::atomic<uint32_t> thread{0};
+            };
+
+            std::atomic<uint64_t> head{0};
+            Slot slots[Tracer::RingCapacity];
+        };
+
+        struct Span
+        {
+            const char *name;
+            uint64_t begin;
+            uint64_t end;
+            uint32_t request;
+            uint32_t thread;
+        };
+
+        /**
+         * Every ring ever handed out, and those of exited threads ready to be
+         * reused; rings are never freed, so a dump may read one at any time
+         */
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<TraceRing *> rings;
+            std::vector<TraceRing *> free;
+            std::atomic<uint32_t> nextThread{1};
+            std::atomic<uint32_t> nextRequest{1};
+            std::atomic<uint64_t> clearedAt{0};
+            // Reference point for converting ticks to microseconds
+            uint64_t originTicks = Tracer::now();
+            std::chrono::steady_clock::time_point originTime = std::chrono::steady_clock::now();
+        };
+
+        Registry &registry()
+        {
+            static Registry *instance = new Registry();
+            return *instance;
+        }
+
+        /**
+         * The calling thread's ring, returned to the free list at thread exit
+         */
+        struct ThreadRing
+        {
+            TraceRing *ring = nullptr;
+            uint32_t thread = 0;
+
+            ~ThreadRing()
+            {
+                if (!ring)
+                    return;
+                Registry &shared = registry();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                shared.free.push_back(ring);
+            }
+
+            TraceRing &get()
+            {
+                if (ring)
+                    return *ring;
+                Registry &shared = registry();
+                thread = shared.nextThread++;
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                if (!shared.free.empty())
+                {
+                    ring = shared.free.back();
+                    shared.free.pop_back();
+                }
+                else
+                {
+                    ring = new TraceRing();
+                    shared.rings.push_back(ring);
+                }
+                return *ring;
+            }
+        };
+
+        thread_local ThreadRing threadRing;
+
+        void collect(TraceRing &ring, uint32_t request, uint64_t after, std::vector<Span> &out)
+        {
+            const uint64_t capacity = Tracer::RingCapacity;
+            uint64_t head = ring.head.load(std::memory_order_acquire);
+            uint64_t first = head > capacity ? head - capacity : 0;
+
+            std::vector<Span> copied;
+            copied.reserve(head - first);
+            for (uint64_t i = first; i < head; i++)
+            {
+                const TraceRing::Slot &slot = ring.slots[i % capacity];
+                copied.push_back(Span{slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+                                      slot.end.load(std::memory_order_relaxed),
+                                      slot.request.load(std::memory_order_relaxed),
+                                      slot.thread.load(std::memory_order_relaxed)});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Slot i may be rewritten once the owner is writing span i + capacity
+            uint64_t reread = ring.head.load(std::memory_order_relaxed);
+            for (uint64_t i = first; i < head; i++)
+            {
+                const Span &span = copied[i - first];
+                if (i + capacity <= reread || span.begin < after)
+                    continue;
+                if (request == 0 || span.request == request)
+                    out.push_back(span);
+            }
+        }
+
+        /**
+         * Ticks per microsecond, measured against the steady clock since
+         * the registry was created
+         */
+        double ticksPerMicrosecond(const Registry &shared)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            // Too short an interval gives a poor estimate
+            while (std::chrono::steady_clock::now() - shared.originTime < std::chrono::milliseconds(10))
+                std::this_thread::yield();
+            uint64_t ticks = Tracer::now();
+            double microseconds =
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - shared.originTime).count();
+            return (ticks - shared.originTicks) / microseconds;
+#else
+            (void)shared;
+            return std::chrono::steady_clock::period::den / (1e6 * std::chrono::steady_clock::period::num);
+#endif
+        }
+    } // namespace
+
+    void Tracer::record(const char *name, uint64_t begin, uint64_t end)
+    {
+#if RSM_TRACING
+        TraceRing &ring = threadRing.get();
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        TraceRing::Slot &slot = ring.slots[head % RingCapacity];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.request.store(currentRequest, std::memory_order_relaxed);
+        slot.thread.store(threadRing.thread, std::memory_order_relaxed);
+        ring.head.store(head + 1, std::memory_order_release);
+#else
+        (void)name;
+        (void)begin;
+        (void)end;
+#endif
+    }
+
+    void Tracer::setEnabled(bool enabled)
+    {
+        enabledFlag.store(enabled && available(), std::memory_order_relaxed);
+    }
+
+    bool Tracer::enabled()
+    {
+        return enabledFlag.load(std::memory_order_relaxed);
+    }
+
+    uint32_t Tracer::newRequest()
+    {
+        uint32_t request = registry().nextRequest++;
+        return request ? request : registry().nextRequest++;
+    }
+
+    void Tracer::clear()
+    {
+        registry().clearedAt.store(now(), std::memory_order_relaxed);
+    }
+
+    std::string Tracer::chromeJson(uint32_t request)
+    {
+        Registry &shared = registry();
+        std::vector<Span> spans;
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            uint64_t after = shared.clearedAt.load(std::memory_order_relaxed);
+            for (TraceRing *ring : shared.rings)
+                collect(*ring, request, after, spans);
+        }
+        std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) { return a.begin < b.begin; });
+
+        // Timestamps are steady-clock microseconds, so dumps line up
+        double rate = ticksPerMicrosecond(shared);
+        double origin =
+            std::chrono::duration<double, std::micro>(shared.originTime.time_since_epoch()).count();
+        JsonValue events = JsonValue::array();
+        for (const Span &span : spans)
+        {
+            JsonValue event = JsonValue::object();
+            event.set("name", JsonValue::string(span.name));
+            event.set("cat", JsonValue::string("engine"));
+            event.set("ph", JsonValue::string("X"));
+            event.set("ts", JsonValue::number(origin + (static_cast<double>(span.begin) - shared.originTicks) / rate));
+            event.set("dur", JsonValue::number(static_cast<double>(span.end - span.begin) / rate));
+            event.set("pid", JsonValue::number(1));
+            event.set("tid", JsonValue::number(span.thread));
+            if (span.request)
+            {
+                JsonValue args = JsonValue::object();
+                args.set("request", JsonValue::number(span.request));
+                event.set("args", args);
+            }
+            events.push(event);
+        }
+
+        JsonValue document = JsonValue::object();
+        document.set("traceEvents", events);
+        document.set("displayTimeUnit", JsonValue::string("ms"));
+        return document.dump();
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,373 @@
+#include "../include/TraceCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ReactiveSystem
+{
+
+    namespace
+    {
+        constexpr uint8_t Magic[4] = {'R', 'S', 'T', '1'};
+        constexpr size_t FooterSize = 8 + 4 + 8 + sizeof(Magic);
+
+        // Record tag bits
+        constexpr uint64_t ExplicitStep = 1;
+        constexpr uint64_t EdgeReference = 2;
+        constexpr uint64_t Run = 4;
+
+        void writeVarint(std::vector<uint8_t> &out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        void writeFixed(std::vector<uint8_t> &out, uint64_t value, size_t bytes)
+        {
+            for (size_t i = 0; i < bytes; i++)
+            {
+                out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        uint64_t zigzag(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        int64_t unzigzag(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        /**
+         * Bounds-checked reader over [data + position, data + end)
+         */
+        struct Cursor
+        {
+            const uint8_t *data;
+            size_t position;
+            size_t end;
+
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7)
+                {
+                    if (position >= end)
+                        throw std::invalid_argument("Truncated trace");
+                    uint8_t byte = data[position++];
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80))
+                        return value;
+                }
+                throw std::invalid_argument("Malformed varint in trace");
+            }
+
+            uint64_t fixed(size_t bytes)
+            {
+                if (end - position < bytes)
+                    throw std::invalid_argument("Truncated trace");
+                uint64_t value = 0;
+                for (size_t i = 0; i < bytes; i++)
+                {
+                    value |= static_cast<uint64_t>(data[position++]) << (8 * i);
+                }
+                return value;
+            }
+
+            // String id stored as id + 1 (0 = empty)
+            int32_t id(size_t limit)
+            {
+                uint64_t value = varint();
+                if (value > limit)
+                    throw std::invalid_argument("String id out of range in trace");
+                return static_cast<int32_t>(value) - 1;
+            }
+        };
+
+        bool sameFields(const EncodedRecord &a, const EncodedRecord &b)
+        {
+            return a.currentState == b.currentState && a.nextState == b.nextState &&
+                   a.input == b.input && a.output == b.output && a.transitionId == b.transitionId;
+        }
+    }
+
+    TraceEncoder::TraceEncoder(uint32_t blockRecords)
+        : blockRecords(std::max<uint32_t>(blockRecords, 1))
+    {
+    }
+
+    int32_t TraceEncoder::intern(const std::string &value)
+    {
+        if (value.empty())
+            return -1;
+
+        auto it = stringIds.find(value);
+        if (it != stringIds.end())
+            return it->second;
+
+        int32_t id = static_cast<int32_t>(strings.size());
+        strings.push_back(value);
+        stringIds.emplace(value, id);
+        return id;
+    }
+
+    void TraceEncoder::append(const TraceRecord &record)
+    {
+        EncodedRecord encoded{
+            record.step,
+            intern(record.currentState),
+            intern(record.nextState),
+            intern(record.input),
+            intern(record.output),
+            intern(record.transitionId)};
+
+        // Extend the run when this repeats it one step later, within the block
+        if (runLength > 0 && records % blockRecords != 0 &&
+            encoded.step == pending.step + runLength && sameFields(encoded, pending))
+        {
+            runLength++;
+            records++;
+            return;
+        }
+
+        flushRun();
+        if (records % blockRecords == 0)
+        {
+            index.emplace_back(body.size(), encoded.step);
+            previousStep = encoded.step - 1;
+        }
+        pending = encoded;
+        runLength = 1;
+        records++;
+    }
+
+    void TraceEncoder::flushRun()
+    {
+        if (runLength == 0)
+            return;
+
+        uint64_t tag = 0;
+        if (pending.step != previousStep + 1)
+            tag |= ExplicitStep;
+        if (runLength > 1)
+            tag |= Run;
+
+        int32_t edge = -1;
+        if (pending.transitionId >= 0)
+        {
+            auto it = edgeIds.find(pending.transitionId);
+            if (it == edgeIds.end())
+            {
+                // First occurrence defines the edge; it is still stored in full
+                edgeIds.emplace(pending.transitionId, static_cast<uint32_t>(edges.size()));
+                edges.push_back(pending);
+            }
+            else if (sameFields(edges[it->second], pending))
+            {
+                edge = static_cast<int32_t>(it->second);
+                tag |= EdgeReference;
+            }
+        }
+
+        writeVarint(body, tag);
+        if (tag & ExplicitStep)
+            writeVarint(body, zigzag(static_cast<int64_t>(pending.step - (previousStep + 1))));
+        if (tag & EdgeReference)
+        {
+            writeVarint(body, static_cast<uint64_t>(edge));
+        }
+        else
+        {
+            for (int32_t id : {pending.currentState, pending.nextState, pending.input, pending.output, pending.transitionId})
+                writeVarint(body, static_cast<uint64_t>(id + 1));
+        }
+        if (tag & Run)
+            writeVarint(body, runLength - 1);
+
+        previousStep = pending.step + runLength - 1;
+        runLength = 0;
+    }
+
+    std::vector<uint8_t> TraceEncoder::finish()
+    {
+        flushRun();
+
+        std::vector<uint8_t> out;
+        out.swap(body);
+        const uint64_t stringsOffset = out.size();
+
+        writeVarint(out, strings.size());
+        for (const auto &value : strings)
+        {
+            writeVarint(out, value.size());
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        writeVarint(out, edges.size());
+        for (const auto &edge : edges)
+        {
+            for (int32_t id : {edge.transitionId, edge.currentState, edge.nextState, edge.input, edge.output})
+                writeVarint(out, static_cast<uint64_t>(id + 1));
+        }
+
+        for (const auto &entry : index)
+        {
+            writeFixed(out, entry.first, 8);
+            writeFixed(out, entry.second, 8);
+        }
+
+        writeFixed(out, records, 8);
+        writeFixed(out, blockRecords, 4);
+        writeFixed(out, stringsOffset, 8);
+        out.insert(out.end(), Magic, Magic + sizeof(Magic));
+
+        *this = TraceEncoder(blockRecords);
+        return out;
+    }
+
+    TraceReader::TraceReader(const uint8_t *data, size_t size)
+        : data(data)
+    {
+        if (size < FooterSize || std::memcmp(data + size - sizeof(Magic), Magic, sizeof(Magic)) != 0)
+        {
+            throw std::invalid_argument("Not an encoded trace");
+        }
+
+        Cursor footer{data, size - FooterSize, size};
+        records = footer.fixed(8);
+        blockRecords = static_cast<uint32_t>(footer.fixed(4));
+        bodySize = footer.fixed(8);
+        if (blockRecords == 0 || bodySize > size - FooterSize)
+        {
+            throw std::invalid_argument("Malformed trace footer");
+        }
+
+        Cursor cursor{data, bodySize, size - FooterSize};
+        uint64_t stringCount = cursor.varint();
+        for (uint64_t i = 0; i < stringCount; i++)
+        {
+            uint64_t length = cursor.varint();
+            if (length > cursor.end - cursor.position)
+                throw std::invalid_argument("Truncated trace");
+            stringTable.emplace_back(reinterpret_cast<const char *>(data + cursor.position), length);
+            cursor.position += length;
+        }
+
+        uint64_t edgeCount = cursor.varint();
+        for (uint64_t i = 0; i < edgeCount; i++)
+        {
+            EncodedRecord edge{};
+            edge.transitionId = cursor.id(stringTable.size());
+            edge.currentState = cursor.id(stringTable.size());
+            edge.nextState = cursor.id(stringTable.size());
+            edge.input = cursor.id(stringTable.size());
+            edge.output = cursor.id(stringTable.size());
+            edges.push_back(edge);
+        }
+
+        // Every block holds at least one tag byte and one 16-byte index entry
+        const uint64_t blocks = records / blockRecords + (records % blockRecords != 0);
+        if (blocks > bodySize || blocks > (cursor.end - cursor.position) / 16)
+            throw std::invalid_argument("Malformed trace footer");
+        for (uint64_t b = 0; b < blocks; b++)
+        {
+            uint64_t offset = cursor.fixed(8);
+            uint64_t step = cursor.fixed(8);
+            if (offset > bodySize)
+                throw std::invalid_argument("Malformed trace index");
+            index.emplace_back(offset, step);
+        }
+    }
+
+    std::vector<EncodedRecord> TraceReader::read(uint64_t from, uint64_t count) const
+    {
+        std::vector<EncodedRecord> result;
+        if (from >= records)
+            return result;
+
+        const uint64_t end = from + std::min(count, records - from);
+        // Runs let a few bytes claim many records; grow past this on demand
+        result.reserve(static_cast<size_t>(std::min<uint64_t>(end - from, 1 << 16)));
+
+        // Decode from the start of the block holding `from`
+        const uint64_t block = from / blockRecords;
+        if (block >= index.size())
+            throw std::invalid_argument("Block out of range in trace");
+        Cursor cursor{data, static_cast<size_t>(index[block].first), bodySize};
+        uint64_t position = block * blockRecords;
+        uint64_t previousStep = 0;
+
+        while (position < end)
+        {
+            // The encoder restarts step prediction at every block
+            if (position % blockRecords == 0)
+            {
+                if (position / blockRecords >= index.size())
+                    throw std::invalid_argument("Block out of range in trace");
+                previousStep = index[position / blockRecords].second - 1;
+            }
+
+            uint64_t tag = cursor.varint();
+            EncodedRecord record{};
+            record.step = previousStep + 1;
+            if (tag & ExplicitStep)
+                record.step += static_cast<uint64_t>(unzigzag(cursor.varint()));
+
+            if (tag & EdgeReference)
+            {
+                uint64_t edge = cursor.varint();
+                if (edge >= edges.size())
+                    throw std::invalid_argument("Edge id out of range in trace");
+                uint64_t step = record.step;
+                record = edges[edge];
+                record.step = step;
+            }
+            else
+            {
+                record.currentState = cursor.id(stringTable.size());
+                record.nextState = cursor.id(stringTable.size());
+                record.input = cursor.id(stringTable.size());
+                record.output = cursor.id(stringTable.size());
+                record.transitionId = cursor.id(stringTable.size());
+            }
+
+            uint64_t repeat = (tag & Run) ? cursor.varint() + 1 : 1;
+            for (uint64_t i = 0; i < repeat && position < end; i++, position++)
+            {
+                if (position >= from)
+                {
+                    result.push_back(record);
+                }
+                record.step++;
+            }
+            previousStep = record.step - 1;
+        }
+        return result;
+    }
+
+    std::vector<TraceRecord> TraceReader::readRecords(uint64_t from, uint64_t count) const
+    {
+        static const std::string empty;
+        auto text = [this](int32_t id) -> const std::string &
+        { return id < 0 ? empty : stringTable[id]; };
+
+        std::vector<TraceRecord> result;
+        for (const auto &record : read(from, count))
+        {
+            result.push_back({record.step,
+                              text(record.currentState),
+                              text(record.nextState),
+                              text(record.input),
+                              text(record.output),
+                              text(record.transitionId)});
+        }
+        return result;
+    }
+
+} // namespace ReactiveSystem
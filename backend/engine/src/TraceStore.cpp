@@ -0,0 +1,148 @@
+#include "../include/TraceStore.h"
+#include <algorithm>
+#include <chrono>
+
+namespace ReactiveSystem
+{
+
+    TraceStore::TraceStore(const MachineProgram &program, const TraceStoreOptions &options)
+        : program(program),
+          options(options),
+          state(program.graph.initialState),
+          values(program.variables.initialValues()),
+          interval(options.minInterval),
+          nextSnapshot(0)
+    {
+        takeSnapshot();
+    }
+
+    void TraceStore::takeSnapshot()
+    {
+        snapshots.push_back({inputLog.size(), state, lastEdge, snapshotValues.size()});
+        snapshotValues.insert(snapshotValues.end(), values.begin(), values.end());
+        nextSnapshot = inputLog.size() + interval;
+    }
+
+    /**
+     * Pick k so that replaying k steps takes about targetSeekNanos
+     */
+    void TraceStore::adaptInterval(uint64_t steps, uint64_t nanos)
+    {
+        if (steps == 0)
+        {
+            return;
+        }
+        double nanosPerStep = std::max(1.0, static_cast<double>(nanos) / static_cast<double>(steps));
+        double target = static_cast<double>(options.targetSeekNanos) / nanosPerStep;
+
+        uint32_t k = options.minInterval;
+        while (k < options.maxInterval && k * 2.0 <= target)
+        {
+            k *= 2;
+        }
+        interval = k;
+    }
+
+    size_t TraceStore::record(const int32_t *inputs, size_t count)
+    {
+        // Re-measure the step cost every CalibrationSteps steps, however
+        // the inputs are batched; time between calls is not counted
+        constexpr uint64_t CalibrationSteps = 4096;
+        auto elapsedSince = [](std::chrono::steady_clock::time_point start)
+        {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        };
+        auto calibrationStart = std::chrono::steady_clock::now();
+        size_t consumed = 0;
+
+        for (; consumed < count; consumed++)
+        {
+            int32_t edge = Simulator::step(program, state, values.data(), inputs[consumed]);
+            if (edge < 0)
+            {
+                break;
+            }
+            inputLog.push_back(inputs[consumed]);
+            lastEdge = edge;
+
+            if (inputLog.size() >= nextSnapshot)
+            {
+                takeSnapshot();
+            }
+            if (++calibrationSteps == CalibrationSteps)
+            {
+                adaptInterval(calibrationSteps, calibrationNanos + elapsedSince(calibrationStart));
+                calibrationSteps = 0;
+                calibrationNanos = 0;
+                calibrationStart = std::chrono::steady_clock::now();
+                nextSnapshot = snapshots.back().step + interval;
+            }
+        }
+        calibrationNanos += elapsedSince(calibrationStart);
+        return consumed;
+    }
+
+    TraceFrame TraceStore::restore(uint64_t step) const
+    {
+        // Last snapshot with snapshot.step <= step; the first one is at step 0
+        auto it = std::upper_bound(
+            snapshots.begin(), snapshots.end(), step,
+            [](uint64_t value, const Snapshot &snapshot)
+            { return value < snapshot.step; });
+        const Snapshot &snapshot = *(it - 1);
+
+        const size_t width = values.size();
+        TraceFrame frame;
+        frame.step = snapshot.step;
+        frame.state = snapshot.state;
+        frame.edge = snapshot.edge;
+        frame.variables.assign(
+            snapshotValues.begin() + static_cast<std::ptrdiff_t>(snapshot.valuesOffset),
+            snapshotValues.begin() + static_cast<std::ptrdiff_t>(snapshot.valuesOffset + width));
+        return frame;
+    }
+
+    TraceFrame TraceStore::seek(uint64_t step) const
+    {
+        step = std::min<uint64_t>(step, inputLog.size());
+        TraceFrame frame = restore(step);
+        for (; frame.step < step; frame.step++)
+        {
+            frame.edge = Simulator::step(program, frame.state, frame.variables.data(), inputLog[frame.step]);
+        }
+        return frame;
+    }
+
+    std::vector<TraceFrame> TraceStore::frames(uint64_t from, size_t count) const
+    {
+        std::vector<TraceFrame> result;
+        if (count == 0 || from > inputLog.size())
+        {
+            return result;
+        }
+
+        // Clamp before adding so a huge count cannot wrap past the log
+        count = static_cast<size_t>(std::min<uint64_t>(count, inputLog.size() + 1 - from));
+        const uint64_t end = from + count;
+        result.reserve(count);
+
+        TraceFrame frame = seek(from);
+        result.push_back(frame);
+        while (frame.step + 1 < end)
+        {
+            frame.edge = Simulator::step(program, frame.state, frame.variables.data(), inputLog[frame.step]);
+            frame.step++;
+            result.push_back(frame);
+        }
+        return result;
+    }
+
+    size_t TraceStore::memoryBytes() const
+    {
+        return inputLog.capacity() * sizeof(int32_t) +
+               snapshots.capacity() * sizeof(Snapshot) +
+               snapshotValues.capacity() * sizeof(int64_t);
+    }
+
+} // namespace ReactiveSystem
@@ -0,0 +1,112 @@
+#include "../include/VerificationStats.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace ReactiveSystem
+{
+
+    double VerificationStats::wallMs() const
+    {
+        double total = 0;
+        for (const auto &phase : phases)
+            total += phase.wallMs;
+        return total;
+    }
+
+    double VerificationStats::cpuMs() const
+    {
+        double total = 0;
+        for (const auto &phase : phases)
+            total += phase.cpuMs;
+        return total;
+    }
+
+    double PhaseClock::threadCpuMs()
+    {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+#else
+        // Process CPU time where there is no per-thread clock
+        return std::clock() * 1e3 / CLOCKS_PER_SEC;
+#endif
+    }
+
+    double PhaseClock::wallClockMs()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void PhaseClock::next(const char *name)
+    {
+        stop();
+        current = name;
+        wallStart = wallClockMs();
+        cpuStart = threadCpuMs();
+        traceStart = Tracer::active() ? Tracer::now() : 0;
+    }
+
+    void PhaseClock::stop()
+    {
+        if (!current)
+            return;
+        double wall = wallClockMs() - wallStart;
+        double cpu = threadCpuMs() - cpuStart;
+        if (traceStart)
+            Tracer::record(current, traceStart, Tracer::now());
+
+        auto it = std::find_if(stats.phases.begin(), stats.phases.end(),
+                               [this](const PhaseStats &phase) { return phase.name == current; });
+        if (it == stats.phases.end())
+        {
+            stats.phases.push_back(PhaseStats{current, 0, 0});
+            it = stats.phases.end() - 1;
+        }
+        it->wallMs += wall;
+        it->cpuMs += cpu;
+        current = nullptr;
+    }
+
+    void VerificationStatsTotals::record(const VerificationStats &stats)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        totals.runs++;
+        for (const auto &phase : stats.phases)
+            add(phase);
+        totals.states += stats.states;
+        totals.edges += stats.edges;
+        totals.bytesTouched += stats.bytesTouched;
+        totals.peakBytes = std::max(totals.peakBytes, stats.peakBytes);
+    }
+
+    void VerificationStatsTotals::record(const PhaseStats &phase)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        add(phase);
+    }
+
+    void VerificationStatsTotals::add(const PhaseStats &phase)
+    {
+        Phase &total = totals.phases[phase.name];
+        total.count++;
+        total.wallMs += phase.wallMs;
+        total.cpuMs += phase.cpuMs;
+        total.maxWallMs = std::max(total.maxWallMs, phase.wallMs);
+    }
+
+    VerificationStatsTotals::Snapshot VerificationStatsTotals::snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totals;
+    }
+
+    void VerificationStatsTotals::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        totals = Snapshot();
+    }
+
+} // namespace ReactiveSystem
@@ -1,12 +1,62 @@
 #include "../include/Verifier.h"
-#include "MealyMachine.h"
+#include "../include/Cancellation.h"
+#include "../include/Progress.h"
+#include "../include/MealyMachine.h"
+#include "../include/Statechart.h"
+#include "../include/Trace.h"
 #include <algorithm>
 #include <queue>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace ReactiveSystem
 {
 
+    namespace
+    {
+        /**
+         * Completeness fields and warning of a report cut short; expects
+         * statesExplored and frontierSize to be set
+         */
+        void markPartial(Verifier::VerificationReport &report, StopReason reason, const std::string &unit)
+        {
+            static const char *causes[] = {"", "time budget exhausted", "memory budget exhausted",
+                                           "configuration limit reached"};
+            report.complete = false;
+            report.stopReason = stopReasonName(reason);
+            double discovered = static_cast<double>(report.statesExplored + report.frontierSize);
+            report.coverage = discovered > 0 ? report.statesExplored / discovered : 0;
+            report.warnings.push_back("WARNING: Verification incomplete (" + std::string(causes[static_cast<int>(reason)]) +
+                                      "): " + std::to_string(report.statesExplored) + " " + unit + " explored, " +
+                                      std::to_string(report.frontierSize) + " pending");
+        }
+
+        /**
+         * Explores a statechart for the yes/no queries, which have no way to
+         * say "unknown": a partial exploration throws instead of answering
+         */
+        StatechartReport exploreCompletely(const Statechart &chart, size_t maxConfigurations)
+        {
+            StatechartReport report = StatechartExplorer::explore(chart, maxConfigurations);
+            if (!report.complete)
+                throw std::runtime_error("Statechart exploration incomplete (" +
+                                         std::string(stopReasonName(report.stopReason)) + " after " +
+                                         std::to_string(report.expanded) + " configurations); result unknown");
+            return report;
+        }
+
+        std::string coverageSummary(const Verifier::VerificationReport &report)
+        {
+            if (report.complete)
+                return "";
+            std::ostringstream out;
+            out.precision(3);
+            out << " | Coverage: <= " << report.coverage * 100 << "% (" << report.stopReason << ")";
+            return out.str();
+        }
+    } // namespace
+
     /**
      * BFS to find all reachable states
      */
@@ -15,6 +65,23 @@ namespace ReactiveSystem
         std::set<std::string> reachable;
         std::queue<std::string> queue;
 
+        if (Statechart::isHierarchical(machine))
+        {
+            // A state is reachable when some macrostep enters it
+            Statechart chart = Statechart::fromStateMachine(machine);
+            StatechartReport report = exploreCompletely(chart, MaxConfigurations);
+            for (size_t n = 1; n < chart.nodes.size(); n++)
+            {
+                if (!chart.isHistory(static_cast<uint32_t>(n)))
+                    reachable.insert(chart.nodes[n].id);
+            }
+            for (const auto &stateId : report.unreachableStates)
+            {
+                reachable.erase(stateId);
+            }
+            return reachable;
+        }
+
         // Find initial state
         std::string initialStateId;
         for (const auto &state : machine.states)
@@ -34,8 +101,10 @@ namespace ReactiveSystem
         queue.push(initialStateId);
         reachable.insert(initialStateId);
 
+        CancellationPoint cancellation;
         while (!queue.empty())
         {
+            cancellation.check();
             std::string currentStateId = queue.front();
             queue.pop();
 
@@ -63,6 +132,7 @@ namespace ReactiveSystem
         const StateMachine &machine,
         const std::string &targetStateId)
     {
+        RSM_TRACE_SPAN("Verifier::isStateReachable");
         ReachabilityResult result;
         result.isReachable = false;
         result.message = "State not reachable";
@@ -87,6 +157,7 @@ namespace ReactiveSystem
      */
     std::vector<std::string> Verifier::getReachableStates(const StateMachine &machine)
     {
+        RSM_TRACE_SPAN("Verifier::getReachableStates");
         auto reachableSet = reachableStatesBFS(machine);
         return std::vector<std::string>(reachableSet.begin(), reachableSet.end());
     }
@@ -96,6 +167,12 @@ namespace ReactiveSystem
      */
     bool Verifier::isDeadlock(const StateMachine &machine, const std::string &stateId)
     {
+        if (Statechart::isHierarchical(machine))
+        {
+            auto deadlocks = findDeadlocks(machine);
+            return std::find(deadlocks.begin(), deadlocks.end(), stateId) != deadlocks.end();
+        }
+
         for (const auto &transition : machine.transitions)
         {
             if (transition.from == stateId)
@@ -111,8 +188,17 @@ namespace ReactiveSystem
      */
     std::vector<std::string> Verifier::findDeadlocks(const StateMachine &machine)
     {
+        RSM_TRACE_SPAN("Verifier::findDeadlocks");
         std::vector<std::string> deadlocks;
 
+        if (Statechart::isHierarchical(machine))
+        {
+            // Atomic states of the configurations in which no input is enabled
+            StatechartReport report = exploreCompletely(Statechart::fromStateMachine(machine), MaxConfigurations);
+            std::set<std::string> states(report.deadlockedStates.begin(), report.deadlockedStates.end());
+            return std::vector<std::string>(states.begin(), states.end());
+        }
+
         for (const auto &state : machine.states)
         {
             if (isDeadlock(machine, state.id) && !state.isFinal)
@@ -148,7 +234,7 @@ namespace ReactiveSystem
         const std::string &currentStateId)
     {
         // Get current state
-        const auto *currentState = nullptr;
+        const State *currentState = nullptr;
         for (const auto &state : machine.states)
         {
             if (state.id == currentStateId)
@@ -197,6 +283,7 @@ namespace ReactiveSystem
         const StateMachine &machine,
         const std::string &invariantExpression)
     {
+        RSM_TRACE_SPAN("Verifier::checkInvariant");
         InvariantCheckResult result;
         result.holds = true;
         result.message = "Invariant holds on all reachable states";
@@ -245,10 +332,18 @@ namespace ReactiveSystem
     /**
      * Generate comprehensive verification report
      */
-    VerificationReport Verifier::generateReport(const StateMachine &machine)
+    Verifier::VerificationReport Verifier::generateReport(const StateMachine &machine, const AnalysisBudget &budget)
     {
+        RSM_TRACE_SPAN("Verifier::generateReport");
+        if (Statechart::isHierarchical(machine))
+        {
+            return generateHierarchicalReport(machine, budget);
+        }
+
         VerificationReport report;
         report.isValid = true;
+        PhaseClock clock(report.stats);
+        clock.next("index");
 
         // Check initial state
         int initialCount = 0;
@@ -271,72 +366,307 @@ namespace ReactiveSystem
             report.errors.push_back("ERROR: Multiple initial states defined");
         }
 
-        // Check transitions
-        for (const auto &transition : machine.transitions)
+        // Index states once, so every later pass is linear
+        std::unordered_map<std::string, uint32_t> indexOf;
+        for (size_t i = 0; i < machine.states.size(); i++)
         {
-            bool fromExists = false, toExists = false;
+            indexOf.emplace(machine.states[i].id, static_cast<uint32_t>(i));
+            report.stats.bytesTouched += machine.states[i].id.size() + sizeof(uint32_t);
+        }
 
-            for (const auto &state : machine.states)
-            {
-                if (state.id == transition.from)
-                    fromExists = true;
-                if (state.id == transition.to)
-                    toExists = true;
-            }
+        // Check transitions and build the successor lists
+        std::vector<std::vector<uint32_t>> successors(machine.states.size());
+        std::vector<uint8_t> hasOutgoing(machine.states.size(), 0);
+        CancellationPoint cancellation;
+        for (const auto &transition : machine.transitions)
+        {
+            cancellation.check();
+            auto from = indexOf.find(transition.from);
+            auto to = indexOf.find(transition.to);
 
-            if (!fromExists)
+            if (from == indexOf.end())
             {
                 report.isValid = false;
                 report.errors.push_back("ERROR: Transition from non-existent state: " + transition.from);
             }
-            if (!toExists)
+            if (to == indexOf.end())
             {
                 report.isValid = false;
                 report.errors.push_back("ERROR: Transition to non-existent state: " + transition.to);
             }
+            if (from != indexOf.end())
+            {
+                hasOutgoing[from->second] = 1;
+                if (to != indexOf.end())
+                    successors[from->second].push_back(to->second);
+            }
+            report.stats.bytesTouched += transition.from.size() + transition.to.size() + sizeof(uint32_t) + 1;
         }
 
-        // Reachability analysis
-        auto reachable = getReachableStates(machine);
-        report.reachableStates = reachable.size();
-        report.totalStates = machine.states.size();
+        // Reachability analysis: BFS from the first initial state within
+        // the budget. The memory charged is the index and successor lists
+        // (approximately) plus the queue.
+        clock.next("bfs");
+        const size_t tableBytes = machine.states.size() * (sizeof(std::vector<uint32_t>) + 64) +
+                                  machine.transitions.size() * sizeof(uint32_t);
+        std::vector<uint8_t> reached(machine.states.size(), 0);
+        std::vector<uint32_t> queue;
+        for (size_t i = 0; i < machine.states.size(); i++)
+        {
+            if (machine.states[i].isInitial)
+            {
+                reached[i] = 1;
+                queue.push_back(static_cast<uint32_t>(i));
+                break;
+            }
+        }
 
-        if (report.reachableStates < report.totalStates)
+        BudgetMeter meter(budget);
+        ProgressMeter progress;
+        uint32_t depth = 0;
+        size_t levelEnd = queue.size();
+        size_t head = 0;
+        size_t peakBytes = tableBytes;
+        uint64_t edges = 0;
+        while (head < queue.size())
+        {
+            cancellation.check();
+            if (head == levelEnd)
+            {
+                depth++;
+                levelEnd = queue.size();
+            }
+            size_t bytes = tableBytes + queue.capacity() * sizeof(uint32_t);
+            peakBytes = std::max(peakBytes, bytes);
+            progress.update(head, queue.size() - head, depth, bytes);
+            if (meter.exhausted(bytes))
+                break;
+            const auto &targets = successors[queue[head++]];
+            edges += targets.size();
+            for (uint32_t next : targets)
+            {
+                if (!reached[next])
+                {
+                    reached[next] = 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+        progress.finish(head, queue.size() - head, depth, tableBytes + queue.capacity() * sizeof(uint32_t));
+        report.reachableStates = queue.size();
+        report.totalStates = machine.states.size();
+        report.statesExplored = head;
+        report.frontierSize = queue.size() - head;
+        report.stats.states = head;
+        report.stats.edges = edges;
+        report.stats.peakBytes = peakBytes;
+        // Successor lists and reached flags read, queue written and read
+        report.stats.bytesTouched += edges * (sizeof(uint32_t) + 1) + queue.size() * 2 * sizeof(uint32_t);
+
+        // States not reached by a partial search may still be reachable
+        if (meter.reason() == StopReason::None && report.reachableStates < report.totalStates)
         {
             for (const auto &state : machine.states)
             {
-                if (std::find(reachable.begin(), reachable.end(), state.id) == reachable.end())
+                if (!reached[indexOf[state.id]])
                 {
                     report.warnings.push_back("WARNING: Unreachable state: " + state.name);
                 }
             }
         }
 
-        // Deadlock detection
-        report.deadlocks = findDeadlocks(machine);
-        if (!report.deadlocks.empty())
+        // Deadlock detection is local to each state, so it is always complete
+        clock.next("deadlocks");
+        for (const auto &state : machine.states)
         {
-            for (const auto &deadlock : report.deadlocks)
+            if (!hasOutgoing[indexOf[state.id]] && !state.isFinal)
             {
-                report.warnings.push_back("WARNING: Potential deadlock state: " + deadlock);
+                report.deadlocks.push_back(state.id);
             }
         }
+        report.stats.bytesTouched += machine.states.size();
+        for (const auto &deadlock : report.deadlocks)
+        {
+            report.warnings.push_back("WARNING: Potential deadlock state: " + deadlock);
+        }
 
         // Check final state reachability
-        auto finalReachable = canReachFinalState(machine);
-        if (!finalReachable.isReachable)
+        clock.next("report");
+        bool finalReachable = false;
+        for (size_t i = 0; i < machine.states.size(); i++)
+        {
+            finalReachable = finalReachable || (machine.states[i].isFinal && reached[i]);
+        }
+        if (!finalReachable && meter.reason() == StopReason::None)
         {
             report.warnings.push_back("WARNING: No final state is reachable");
         }
 
+        if (meter.reason() != StopReason::None)
+        {
+            markPartial(report, meter.reason(), "states");
+        }
+
         // Generate summary
         std::ostringstream summary;
         summary << "States: " << report.totalStates << " (Reachable: " << report.reachableStates
                 << ")"
                 << " | Transitions: " << machine.transitions.size()
-                << " | Status: " << (report.isValid ? "VALID" : "INVALID");
+                << " | Status: " << (report.isValid ? "VALID" : "INVALID")
+                << coverageSummary(report);
+
+        report.summary = summary.str();
+        clock.stop();
+
+        return report;
+    }
 
+    /**
+     * Report for nested/parallel machines: everything is derived from one
+     * exploration of the active configurations, never from the flattened
+     * product
+     */
+    Verifier::VerificationReport Verifier::generateHierarchicalReport(const StateMachine &machine,
+                                                                     const AnalysisBudget &budget)
+    {
+        VerificationReport report;
+        report.isValid = true;
+        PhaseClock clock(report.stats);
+        clock.next("index");
+        report.reachableStates = 0;
+        report.totalStates = machine.states.size();
+
+        // One initial state at top level and at most one per composite state
+        std::map<std::string, int> initialCounts;
+        for (const auto &state : machine.states)
+        {
+            if (state.isInitial)
+            {
+                initialCounts[state.parent]++;
+            }
+        }
+        if (initialCounts[""] == 0)
+        {
+            report.isValid = false;
+            report.errors.push_back("ERROR: No initial state defined");
+        }
+        for (const auto &entry : initialCounts)
+        {
+            if (entry.second > 1)
+            {
+                report.isValid = false;
+                report.errors.push_back(entry.first.empty()
+                                            ? "ERROR: Multiple initial states defined"
+                                            : "ERROR: Multiple initial states in " + entry.first);
+            }
+        }
+
+        std::map<std::string, const State *> states;
+        for (const auto &state : machine.states)
+        {
+            states.emplace(state.id, &state);
+        }
+        for (const auto &transition : machine.transitions)
+        {
+            if (!states.count(transition.from))
+            {
+                report.isValid = false;
+                report.errors.push_back("ERROR: Transition from non-existent state: " + transition.from);
+            }
+            if (!states.count(transition.to))
+            {
+                report.isValid = false;
+                report.errors.push_back("ERROR: Transition to non-existent state: " + transition.to);
+            }
+        }
+
+        Statechart chart;
+        StatechartReport exploration;
+        try
+        {
+            clock.next("chart");
+            chart = Statechart::fromStateMachine(machine);
+            clock.next("explore");
+            exploration = StatechartExplorer::explore(chart, MaxConfigurations, budget);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            report.isValid = false;
+            report.errors.push_back(std::string("ERROR: ") + e.what());
+            report.summary = "States: " + std::to_string(report.totalStates) + " | Status: INVALID";
+            clock.stop();
+            return report;
+        }
+        report.stats.states = exploration.expanded;
+        report.stats.edges = exploration.macrosteps;
+        report.stats.peakBytes = exploration.peakBytes;
+        report.stats.bytesTouched = exploration.bytesTouched;
+
+        std::set<std::string> unreachable(exploration.unreachableStates.begin(), exploration.unreachableStates.end());
+        bool finalReachable = false;
+        for (size_t n = 1; n < chart.nodes.size(); n++)
+        {
+            const Statechart::Node &node = chart.nodes[n];
+            if (chart.isHistory(static_cast<uint32_t>(n)) || unreachable.count(node.id))
+                continue;
+            report.reachableStates++;
+            finalReachable = finalReachable || states[node.id]->isFinal;
+        }
+        // A partial exploration has not entered every reachable state yet
+        for (size_t i = 0; exploration.complete && i < exploration.unreachableStates.size(); i++)
+        {
+            report.warnings.push_back("WARNING: Unreachable state: " + states[exploration.unreachableStates[i]]->name);
+        }
+
+        clock.next("deadlocks");
+        // The configurations listed are capped; the states in them are not
+        std::set<std::string> deadlocked(exploration.deadlockedStates.begin(), exploration.deadlockedStates.end());
+        for (const auto &configuration : exploration.deadlocks)
+        {
+            std::string active;
+            for (const auto &stateId : configuration)
+            {
+                active += (active.empty() ? "" : ", ") + stateId;
+            }
+            report.warnings.push_back("WARNING: Potential deadlock configuration: {" + active + "}");
+        }
+        report.deadlocks.assign(deadlocked.begin(), deadlocked.end());
+        if (!exploration.deadlockPath.empty())
+        {
+            std::string path;
+            for (const auto &input : exploration.deadlockPath)
+            {
+                path += (path.empty() ? "" : ", ") + input;
+            }
+            report.warnings.push_back("WARNING: First deadlock reached after inputs: " + path);
+        }
+
+        clock.next("report");
+        if (!finalReachable && exploration.complete)
+        {
+            report.warnings.push_back("WARNING: No final state is reachable");
+        }
+        if (exploration.divergentMacrosteps > 0)
+        {
+            report.warnings.push_back("WARNING: Transitions without input loop forever in " +
+                                      std::to_string(exploration.divergentMacrosteps) + " step(s)");
+        }
+        report.statesExplored = exploration.expanded;
+        report.frontierSize = exploration.frontier;
+        if (!exploration.complete)
+        {
+            markPartial(report, exploration.stopReason, "configurations");
+        }
+
+        std::ostringstream summary;
+        summary << "States: " << report.totalStates << " (Reachable: " << report.reachableStates << ")"
+                << " | Configurations: " << exploration.configurations
+                << " (flattened: " << exploration.flattenedSize << ")"
+                << " | Transitions: " << machine.transitions.size()
+                << " | Status: " << (report.isValid ? "VALID" : "INVALID")
+                << coverageSummary(report);
         report.summary = summary.str();
+        clock.stop();
 
         return report;
     }
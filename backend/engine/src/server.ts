@@ -1,6 +1,9 @@
 import express, { Express, Request, Response } from "express";
 import cors from "cors";
 import bodyParser from "body-parser";
+import { randomUUID } from "crypto";
+import fs from "fs";
+import path from "path";
 import { StateMachine } from "../../src/types/types";
 
 // Load native module (try-catch for development)
@@ -14,6 +17,20 @@ try {
   );
 }
 
+// Verification reports are cached by canonical machine hash
+if (verifier && (process.env.REPORT_CACHE_SIZE || process.env.REPORT_CACHE_DIR)) {
+  try {
+    verifier.configureReportCache({
+      capacity: process.env.REPORT_CACHE_SIZE
+        ? Number(process.env.REPORT_CACHE_SIZE)
+        : undefined,
+      directory: process.env.REPORT_CACHE_DIR,
+    });
+  } catch (e) {
+    console.warn(`⚠ Report cache not configured: ${e}`);
+  }
+}
+
 const app: Express = express();
 const PORT = process.env.PORT || 5000;
 
@@ -29,6 +46,72 @@ interface ApiResponse<T> {
   timestamp: number;
 }
 
+// Aborts once the client goes away before the response is sent, so
+// native jobs for abandoned requests stop
+function requestSignal(res: Response): AbortSignal {
+  const controller = new AbortController();
+  res.on("close", () => {
+    if (!res.writableFinished) controller.abort();
+  });
+  return controller.signal;
+}
+
+// Scheduling options for native jobs: ?priority=interactive|normal|bulk
+// and ?deadlineMs=<n>, which fails the request once passed, plus
+// ?timeBudgetMs=<n> and ?memoryBudgetMb=<n>, which make the analysis
+// return a partial report instead
+function jobOptions(req: Request, res: Response) {
+  return {
+    priority:
+      typeof req.query.priority === "string" ? req.query.priority : undefined,
+    deadlineMs:
+      req.query.deadlineMs !== undefined
+        ? Number(req.query.deadlineMs)
+        : undefined,
+    timeBudgetMs:
+      req.query.timeBudgetMs !== undefined
+        ? Number(req.query.timeBudgetMs)
+        : undefined,
+    memoryBudgetMb:
+      req.query.memoryBudgetMb !== undefined
+        ? Number(req.query.memoryBudgetMb)
+        : undefined,
+    trace: req.query.trace === "true",
+    signal: requestSignal(res),
+  };
+}
+
+// Runs a native job with its progress relayed as server-sent events:
+// "progress" events while it runs (throttled by the engine), then one
+// "result" or "error" event
+async function streamJob(
+  req: Request,
+  res: Response,
+  start: (options: any) => Promise<any>,
+) {
+  res.writeHead(200, {
+    "Content-Type": "text/event-stream",
+    "Cache-Control": "no-cache",
+    Connection: "keep-alive",
+  });
+  const send = (event: string, data: unknown) => {
+    if (!res.writableEnded) {
+      res.write(`event: ${event}\ndata: ${JSON.stringify(data)}\n\n`);
+    }
+  };
+
+  try {
+    const result = await start({
+      ...jobOptions(req, res),
+      onProgress: (progress: unknown) => send("progress", progress),
+    });
+    send("result", result);
+  } catch (error) {
+    send("error", { error: `${error}` });
+  }
+  res.end();
+}
+
 // Routes
 app.get("/api/health", (req: Request, res: Response) => {
   res.json({
@@ -45,7 +128,7 @@ app.get("/api/health", (req: Request, res: Response) => {
 /**
  * Verify state machine with C++ engine
  */
-app.post("/api/verify", (req: Request, res: Response) => {
+app.post("/api/verify", async (req: Request, res: Response) => {
   try {
     if (!verifier) {
       return res.status(503).json({
@@ -55,8 +138,12 @@ app.post("/api/verify", (req: Request, res: Response) => {
       });
     }
 
+    // Runs off the event loop; identical machines in flight share one run
     const stateMachine: StateMachine = req.body;
-    const result = verifier.verifyStateMachine(stateMachine);
+    const result = await verifier.verifyStateMachineAsync(
+      stateMachine,
+      jobOptions(req, res),
+    );
 
     res.json({
       success: true,
@@ -72,6 +159,138 @@ app.post("/api/verify", (req: Request, res: Response) => {
   }
 });
 
+/**
+ * /api/verify streamed as server-sent events with progress
+ */
+app.post("/api/verify/stream", async (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  const stateMachine: StateMachine = req.body;
+  await streamJob(req, res, (options) =>
+    verifier.verifyStateMachineAsync(stateMachine, options),
+  );
+});
+
+/**
+ * Hit/miss statistics of the verification report cache
+ */
+app.get("/api/verify/cache", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  res.json({
+    success: true,
+    data: verifier.reportCacheStats(),
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Per-phase wall/CPU time and work totals of native verifications;
+ * ?reset=true clears them after reading
+ */
+app.get("/api/verify/stats", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  res.json({
+    success: true,
+    data: verifier.verificationStats({ reset: req.query.reset === "true" }),
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Buffered engine spans as Chrome trace-event JSON, loadable as is in
+ * chrome://tracing or Perfetto; ?request=N keeps one traced request's
+ */
+app.get("/api/trace", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  const request =
+    req.query.request !== undefined ? Number(req.query.request) : undefined;
+  res.type("application/json").send(verifier.traceEvents({ request }));
+});
+
+/**
+ * Turn process-wide engine tracing on or off: { enabled, clear }. Single
+ * requests can be traced without it with ?trace=true.
+ */
+app.post("/api/trace", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  res.json({
+    success: true,
+    data: verifier.configureTracing(req.body || {}),
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Native job scheduler: queued and running jobs by priority class
+ */
+app.get("/api/jobs", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res.status(503).json({
+      success: false,
+      error: "Verification engine not available",
+      timestamp: Date.now(),
+    });
+  }
+
+  res.json({
+    success: true,
+    data: verifier.schedulerStats(),
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Native metrics in the Prometheus text format: latency and input-size
+ * quantiles of native calls, verification phase totals, report cache and
+ * job scheduler
+ */
+app.get("/api/metrics", (req: Request, res: Response) => {
+  if (!verifier) {
+    return res
+      .status(503)
+      .type("text/plain")
+      .send("# verification engine not available\n");
+  }
+
+  res
+    .type("text/plain; version=0.0.4; charset=utf-8")
+    .send(verifier.metricsText());
+});
+
 /**
  * Check if state is reachable
  */
@@ -132,6 +351,879 @@ app.post("/api/find-deadlocks", (req: Request, res: Response) => {
   }
 });
 
+/**
+ * Simulate a nondeterministic machine with the bit-parallel engine
+ */
+app.post("/api/simulate-nfa", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { stateMachine, inputs, findMatches } = req.body as {
+      stateMachine: StateMachine;
+      inputs: string[];
+      findMatches?: boolean;
+    };
+    const result = findMatches
+      ? { matchEnds: verifier.findInputMatches(stateMachine, inputs) }
+      : verifier.simulateNondeterministic(stateMachine, inputs);
+
+    res.json({
+      success: true,
+      data: result,
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Nondeterministic simulation error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+/**
+ * Generate a standalone C++ header for a machine
+ */
+app.post("/api/codegen/cpp", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { stateMachine, options } = req.body as {
+      stateMachine: StateMachine;
+      options?: {
+        namespace?: string;
+        className?: string;
+        dispatch?: "auto" | "switch" | "table";
+      };
+    };
+    const result = verifier.generateCppCode(stateMachine, options || {});
+
+    res.json({
+      success: true,
+      data: result,
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Code generation error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+/**
+ * Server-side simulation sessions (native, tiered interpreter)
+ */
+const MAX_NATIVE_HANDLES = 1000;
+const simulationSessions = new Map<string, any>();
+
+// Store a native handle under a fresh id, evicting the oldest at the cap
+function storeHandle(handles: Map<string, any>, handle: any): string {
+  if (handles.size >= MAX_NATIVE_HANDLES) {
+    const oldest = handles.keys().next().value;
+    if (oldest !== undefined) handles.delete(oldest);
+  }
+  const id = randomUUID();
+  handles.set(id, handle);
+  return id;
+}
+
+app.post("/api/sessions", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { stateMachine, tierUpSteps } = req.body as {
+      stateMachine: StateMachine;
+      tierUpSteps?: number;
+    };
+    const session = new verifier.SimulationSession(stateMachine, {
+      tierUpSteps,
+    });
+
+    const sessionId = storeHandle(simulationSessions, session);
+
+    res.json({
+      success: true,
+      data: { sessionId },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Session error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.post("/api/sessions/:id/run", (req: Request, res: Response) => {
+  try {
+    const session = simulationSessions.get(req.params.id);
+    if (!session) {
+      return res.status(404).json({
+        success: false,
+        error: "Unknown simulation session",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { inputs, reset } = req.body as { inputs: string[]; reset?: boolean };
+    if (reset) session.reset();
+    const result = session.run(inputs);
+
+    res.json({
+      success: true,
+      data: { ...result, stats: session.stats() },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Session error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+// Breakpoints are checked natively; only the context around a hit is returned
+app.post("/api/sessions/:id/run-until-breakpoint", (req: Request, res: Response) => {
+  try {
+    const session = simulationSessions.get(req.params.id);
+    if (!session) {
+      return res.status(404).json({
+        success: false,
+        error: "Unknown simulation session",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { inputs, breakpoints, before, after } = req.body as {
+      inputs: string[];
+      breakpoints: { kind: string; target?: string; condition?: string }[];
+      before?: number;
+      after?: number;
+    };
+    const result = session.runUntilBreakpoint(inputs, breakpoints || [], {
+      before,
+      after,
+    });
+
+    res.json({
+      success: true,
+      data: { ...result, stats: session.stats() },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Session error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.delete("/api/sessions/:id", (req: Request, res: Response) => {
+  const deleted = simulationSessions.delete(req.params.id);
+  res.json({
+    success: true,
+    data: { deleted },
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Incremental verification: the editor posts its actions and gets the
+ * report updated in place instead of re-verifying the whole machine
+ */
+const incrementalVerifiers = new Map<string, any>();
+
+app.post("/api/incremental", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { stateMachine } = req.body as { stateMachine: StateMachine };
+    const incremental = new verifier.IncrementalVerifier(stateMachine);
+    const verifierId = storeHandle(incrementalVerifiers, incremental);
+
+    res.json({
+      success: true,
+      data: { verifierId, report: incremental.report() },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Incremental verification error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.post("/api/incremental/:id/actions", (req: Request, res: Response) => {
+  try {
+    const incremental = incrementalVerifiers.get(req.params.id);
+    if (!incremental) {
+      return res.status(404).json({
+        success: false,
+        error: "Unknown incremental verifier",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { actions } = req.body as { actions: { type: string; payload?: any }[] };
+    const report = incremental.apply(actions || []);
+
+    res.json({
+      success: true,
+      data: report,
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Incremental verification error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.delete("/api/incremental/:id", (req: Request, res: Response) => {
+  const deleted = incrementalVerifiers.delete(req.params.id);
+  res.json({
+    success: true,
+    data: { deleted },
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Time-travel traces: record long runs natively, then seek to any step
+ */
+const traces = new Map<string, any>();
+
+app.post("/api/traces", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { stateMachine, inputs, targetSeekMicros } = req.body as {
+      stateMachine: StateMachine;
+      inputs?: string[];
+      targetSeekMicros?: number;
+    };
+    const trace = new verifier.TraceRecorder(stateMachine, {
+      targetSeekMicros,
+    });
+    const { consumed } = trace.record(inputs || []);
+    const traceId = storeHandle(traces, trace);
+
+    res.json({
+      success: true,
+      data: { traceId, consumed, stats: trace.stats() },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Trace error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.post("/api/traces/:id/record", (req: Request, res: Response) => {
+  try {
+    const trace = traces.get(req.params.id);
+    if (!trace) {
+      return res.status(404).json({
+        success: false,
+        error: "Unknown trace",
+        timestamp: Date.now(),
+      });
+    }
+
+    const { consumed } = trace.record((req.body.inputs as string[]) || []);
+
+    res.json({
+      success: true,
+      data: { consumed, stats: trace.stats() },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Trace error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.get("/api/traces/:id/frames", (req: Request, res: Response) => {
+  try {
+    const trace = traces.get(req.params.id);
+    if (!trace) {
+      return res.status(404).json({
+        success: false,
+        error: "Unknown trace",
+        timestamp: Date.now(),
+      });
+    }
+
+    const from = req.query.from === undefined ? 0 : Number(req.query.from);
+    const count = req.query.count === undefined ? 1 : Number(req.query.count);
+    if (!Number.isSafeInteger(from) || from < 0 || !Number.isSafeInteger(count) || count < 0) {
+      return res.status(400).json({
+        success: false,
+        error: "from and count must be non-negative integers",
+        timestamp: Date.now(),
+      });
+    }
+
+    res.json({
+      success: true,
+      data: { frames: trace.frames(from, Math.min(count, 10000)) },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Trace error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+// Compact binary form of SimulationStep[] for storing long soak runs
+app.post("/api/traces/encode", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const encoded: Buffer = verifier.encodeTrace(req.body.steps || []);
+    res.type("application/octet-stream").send(encoded);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Trace encoding error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.post(
+  "/api/traces/decode",
+  bodyParser.raw({ type: "application/octet-stream", limit: "50mb" }),
+  (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const from = Number(req.query.from) || 0;
+      const count =
+        req.query.count !== undefined ? Number(req.query.count) : undefined;
+      const decoded = verifier.decodeTrace(req.body, from, count);
+
+      res.json({
+        success: true,
+        data: decoded,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `Trace decoding error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
+app.delete("/api/traces/:id", (req: Request, res: Response) => {
+  const deleted = traces.delete(req.params.id);
+  res.json({
+    success: true,
+    data: { deleted },
+    timestamp: Date.now(),
+  } as ApiResponse<any>);
+});
+
+/**
+ * Binary model files: saved once, then memory-mapped and checked in place
+ */
+const MODEL_DIR = process.env.MODEL_DIR || path.join(__dirname, "../models");
+const openModels = new Map<string, any>();
+
+function modelPath(name: string): string {
+  if (!/^[A-Za-z0-9_-]+$/.test(name)) {
+    throw new Error("Invalid model name");
+  }
+  return path.join(MODEL_DIR, `${name}.rsm`);
+}
+
+function openModel(name: string): any {
+  let model = openModels.get(name);
+  if (!model) {
+    model = new verifier.ModelHandle(modelPath(name));
+    openModels.set(name, model);
+  }
+  return model;
+}
+
+app.put("/api/models/:name", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const file = modelPath(req.params.name);
+    fs.mkdirSync(MODEL_DIR, { recursive: true });
+    verifier.saveModel(req.body.stateMachine as StateMachine, file);
+    openModels.delete(req.params.name);
+
+    res.json({
+      success: true,
+      data: openModel(req.params.name).stats(),
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Model error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.get("/api/models/:name", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const model = openModel(req.params.name);
+    const data =
+      req.query.include === "machine"
+        ? { stats: model.stats(), stateMachine: model.toStateMachine() }
+        : { stats: model.stats() };
+
+    res.json({
+      success: true,
+      data,
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(404).json({
+      success: false,
+      error: `Model error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+app.post("/api/models/:name/verify", (req: Request, res: Response) => {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const model = openModel(req.params.name);
+
+    res.json({
+      success: true,
+      data: {
+        stats: model.stats(),
+        deadlocks: model.findDeadlocks(),
+        unreachableStates: model.findUnreachable(),
+      },
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Model error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+});
+
+/**
+ * Import a KISS2 (MCNC/LGSynth) benchmark; ?save=<name> also stores it as a
+ * binary model
+ */
+app.post(
+  "/api/import/kiss2",
+  bodyParser.raw({
+    type: ["text/plain", "application/octet-stream"],
+    limit: "200mb",
+  }),
+  (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const save = req.query.save as string | undefined;
+      const name = (req.query.name as string) || save || "kiss2";
+      const imported = verifier.importKiss2(req.body, name);
+
+      if (save) {
+        const file = modelPath(save);
+        fs.mkdirSync(MODEL_DIR, { recursive: true });
+        verifier.saveModel(imported.stateMachine, file);
+        openModels.delete(save);
+      }
+
+      res.json({
+        success: true,
+        data: imported,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `KISS2 import error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
+// SCXML routes take the document as the raw request body
+const scxmlBody = bodyParser.raw({
+  type: ["application/xml", "text/xml", "application/scxml+xml", "text/plain"],
+  limit: "50mb",
+});
+
+// Explorations checkpoint into CHECKPOINT_DIR when set, so an import
+// repeated after a restart (here or on a host sharing the directory)
+// resumes instead of starting over
+const checkpointDir = process.env.CHECKPOINT_DIR;
+const checkpointIntervalMs = Number(process.env.CHECKPOINT_INTERVAL_MS) || 60000;
+
+function scxmlOptions(req: Request) {
+  return {
+    ...(req.query.maxConfigurations !== undefined
+      ? { maxConfigurations: Number(req.query.maxConfigurations) }
+      : {}),
+    ...(checkpointDir ? { checkpointDir, checkpointIntervalMs } : {}),
+  };
+}
+
+/**
+ * Import an SCXML statechart and explore its configurations without
+ * flattening; ?maxConfigurations bounds the search
+ */
+app.post(
+  "/api/import/scxml",
+  scxmlBody,
+  async (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const options = { ...jobOptions(req, res), ...scxmlOptions(req) };
+      const imported = await verifier.importScxmlAsync(req.body, options);
+
+      res.json({
+        success: true,
+        data: imported,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `SCXML import error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
+/**
+ * /api/import/scxml streamed as server-sent events with progress
+ */
+app.post(
+  "/api/import/scxml/stream",
+  scxmlBody,
+  async (req: Request, res: Response) => {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    await streamJob(req, res, (options) =>
+      verifier.importScxmlAsync(req.body, { ...options, ...scxmlOptions(req) }),
+    );
+  },
+);
+
+// Swarm search options: ?searches, ?threads, ?bitstateBytes, ?maxDepth
+// and ?seed
+function swarmOptions(req: Request) {
+  const options: Record<string, number> = {};
+  for (const name of [
+    "searches",
+    "threads",
+    "bitstateBytes",
+    "maxDepth",
+    "seed",
+  ]) {
+    if (req.query[name] !== undefined) options[name] = Number(req.query[name]);
+  }
+  return options;
+}
+
+async function runSwarm(req: Request, res: Response, input: unknown) {
+  try {
+    if (!verifier) {
+      return res.status(503).json({
+        success: false,
+        error: "Verification engine not available",
+        timestamp: Date.now(),
+      });
+    }
+
+    const report = await verifier.swarmVerifyAsync(input, {
+      ...jobOptions(req, res),
+      ...swarmOptions(req),
+    });
+
+    res.json({
+      success: true,
+      data: report,
+      timestamp: Date.now(),
+    } as ApiResponse<any>);
+  } catch (error) {
+    res.status(400).json({
+      success: false,
+      error: `Swarm verification error: ${error}`,
+      timestamp: Date.now(),
+    });
+  }
+}
+
+/**
+ * Swarm verification: many diversified bounded searches for deadlocks in
+ * machines too large to explore exhaustively
+ */
+app.post("/api/verify/swarm", (req: Request, res: Response) =>
+  runSwarm(req, res, req.body),
+);
+
+/**
+ * Swarm verification of an SCXML document
+ */
+app.post("/api/import/scxml/swarm", scxmlBody, (req: Request, res: Response) =>
+  runSwarm(req, res, req.body),
+);
+
+// Parallel search options: ?threads, ?maxStates and ?seed
+function parallelSearchOptions(req: Request) {
+  const options: Record<string, number> = {};
+  for (const name of ["threads", "maxStates", "seed"]) {
+    if (req.query[name] !== undefined) options[name] = Number(req.query[name]);
+  }
+  return options;
+}
+
+/**
+ * Exhaustive deadlock search of a state machine or SCXML document by a
+ * work-stealing depth-first search across threads
+ */
+app.post(
+  "/api/verify/parallel-dfs",
+  scxmlBody,
+  async (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const report = await verifier.parallelDeadlocksAsync(req.body, {
+        ...jobOptions(req, res),
+        ...parallelSearchOptions(req),
+      });
+
+      res.json({
+        success: true,
+        data: report,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `Parallel search error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
+/**
+ * Parallel cycle detection: ?property=non-progress (default) looks for runs
+ * that never again reach a progress state, ?property=acceptance for runs
+ * through an accepting state infinitely often; ?states=a,b names the
+ * progress or accepting states
+ */
+app.post(
+  "/api/verify/cycles",
+  scxmlBody,
+  async (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const states =
+        typeof req.query.states === "string" && req.query.states !== ""
+          ? req.query.states.split(",")
+          : undefined;
+      const report = await verifier.findCycleAsync(req.body, {
+        ...jobOptions(req, res),
+        ...parallelSearchOptions(req),
+        property: req.query.property,
+        states,
+      });
+
+      res.json({
+        success: true,
+        data: report,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `Cycle detection error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
+// Distributed exploration options: ?workers, ?batchSize, ?ringBytes and
+// ?maxConfigurations
+function distributedOptions(req: Request) {
+  const options: Record<string, number> = {};
+  for (const name of [
+    "workers",
+    "batchSize",
+    "ringBytes",
+    "maxConfigurations",
+  ]) {
+    if (req.query[name] !== undefined) options[name] = Number(req.query[name]);
+  }
+  return options;
+}
+
+/**
+ * Exploration of a state machine or SCXML document partitioned across
+ * local worker processes, each with its own heap
+ */
+app.post(
+  "/api/verify/distributed",
+  scxmlBody,
+  async (req: Request, res: Response) => {
+    try {
+      if (!verifier) {
+        return res.status(503).json({
+          success: false,
+          error: "Verification engine not available",
+          timestamp: Date.now(),
+        });
+      }
+
+      const report = await verifier.exploreDistributedAsync(req.body, {
+        ...jobOptions(req, res),
+        ...distributedOptions(req),
+      });
+
+      res.json({
+        success: true,
+        data: report,
+        timestamp: Date.now(),
+      } as ApiResponse<any>);
+    } catch (error) {
+      res.status(400).json({
+        success: false,
+        error: `Distributed exploration error: ${error}`,
+        timestamp: Date.now(),
+      });
+    }
+  },
+);
+
 /**
  * Validate state machine structure
  */
@@ -0,0 +1,424 @@
+/**
+ * BreakpointRunner against a reference that steps the Simulator and decides
+ * every breakpoint kind by hand: on random machines and breakpoint sets,
+ * fed in batches of random size, each run must stop on the same step and
+ * report the lowest matching breakpoint, its context window must equal the
+ * reference frames around the hit, and the next run must carry on from
+ * there. Runs cover both tiers, hits past several checkpoint chunks, a
+ * disabled input and the targets compile() rejects.
+ *
+ * Build: node-gyp build (target breakpoints_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/BreakpointsTest.cpp \
+ *       engine/src/Breakpoints.cpp engine/src/ThreadedMachine.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/Expression.cpp \
+ *       engine/src/Simulator.cpp engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "Breakpoints.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    const char *const VariableNames[] = {"x", "y", "z"};
+    const char *const Inputs[] = {"a", "b", "c"};
+    const char *const Outputs[] = {"", "beep", "ring"};
+
+    /**
+     * Guarded transitions in front of an unguarded one for every state and
+     * input, so every input is enabled everywhere
+     */
+    StateMachine randomMachine(std::mt19937 &rng)
+    {
+        StateMachine machine;
+        machine.id = machine.name = "breakpoints";
+        for (const char *name : VariableNames)
+        {
+            Variable variable;
+            variable.name = name;
+            variable.initialValue = std::to_string(rng() % 5);
+            machine.stateVariables.push_back(variable);
+        }
+        const int stateCount = 2 + static_cast<int>(rng() % 5);
+        for (int s = 0; s < stateCount; s++)
+        {
+            State state;
+            state.id = state.name = "s" + std::to_string(s);
+            state.isInitial = s == 0;
+            machine.states.push_back(state);
+        }
+        int id = 0;
+        for (int s = 0; s < stateCount; s++)
+        {
+            for (const char *input : Inputs)
+            {
+                const int guarded = static_cast<int>(rng() % 3);
+                for (int g = 0; g <= guarded; g++)
+                {
+                    Transition transition;
+                    transition.id = "t" + std::to_string(id++);
+                    transition.from = "s" + std::to_string(s);
+                    transition.to = "s" + std::to_string(rng() % stateCount);
+                    transition.input = input;
+                    transition.output = id == 1 ? "beep" : Outputs[rng() % 3];
+                    if (g < guarded)
+                        transition.guard = std::string(VariableNames[rng() % 3]) + " % 3 == " + std::to_string(rng() % 3);
+                    const std::string wrapped = VariableNames[rng() % 3];
+                    transition.action = std::string(VariableNames[rng() % 3]) + (rng() % 2 ? " = " : " += ") +
+                                        std::to_string(rng() % 7) + "; " + wrapped + " = " + wrapped + " % 11";
+                    machine.transitions.push_back(transition);
+                }
+            }
+        }
+        return machine;
+    }
+
+    /**
+     * "v > k", kept alongside the slot and bound so the reference can decide
+     * it without the expression interpreter
+     */
+    struct Condition
+    {
+        int32_t slot = -1;
+        int64_t bound = 0;
+
+        bool holds(const std::vector<int64_t> &values) const { return slot < 0 || values[slot] > bound; }
+    };
+
+    struct Reference
+    {
+        const StateMachine &machine;
+        const MachineProgram &program;
+        std::vector<BreakpointSpec> specs;
+        std::vector<Condition> conditions;
+        std::vector<TraceFrame> frames; // frames[i] = configuration after i inputs
+        std::vector<int32_t> inputs;
+
+        /**
+         * Lowest breakpoint the step into frames[i] matches, -1 if none
+         */
+        int32_t hit(size_t i) const
+        {
+            const TraceFrame &before = frames[i - 1];
+            const TraceFrame &after = frames[i];
+            const Transition &fired = machine.transitions[program.graph.edgeTransitions[after.edge]];
+            for (size_t b = 0; b < specs.size(); b++)
+            {
+                const BreakpointSpec &spec = specs[b];
+                const Condition &condition = conditions[b];
+                bool matched = false;
+                switch (spec.kind)
+                {
+                case BreakpointSpec::Kind::State:
+                    matched = fired.to == spec.target;
+                    break;
+                case BreakpointSpec::Kind::Transition:
+                    matched = fired.id == spec.target;
+                    break;
+                case BreakpointSpec::Kind::Input:
+                    matched = fired.input == spec.target;
+                    break;
+                case BreakpointSpec::Kind::Output:
+                    matched = fired.output == spec.target;
+                    break;
+                case BreakpointSpec::Kind::Variable:
+                {
+                    int32_t slot = program.variables.find(spec.target);
+                    matched = after.variables[slot] != before.variables[slot];
+                    break;
+                }
+                case BreakpointSpec::Kind::Predicate:
+                    matched = !condition.holds(before.variables);
+                    break;
+                }
+                if (matched && condition.holds(after.variables))
+                    return static_cast<int32_t>(b);
+            }
+            return -1;
+        }
+    };
+
+    void randomBreakpoint(std::mt19937 &rng, const StateMachine &machine, Reference &reference)
+    {
+        BreakpointSpec spec;
+        Condition condition;
+        spec.kind = static_cast<BreakpointSpec::Kind>(rng() % 6);
+        switch (spec.kind)
+        {
+        case BreakpointSpec::Kind::State:
+            spec.target = machine.states[rng() % machine.states.size()].id;
+            break;
+        case BreakpointSpec::Kind::Transition:
+            spec.target = machine.transitions[rng() % machine.transitions.size()].id;
+            break;
+        case BreakpointSpec::Kind::Input:
+            spec.target = Inputs[rng() % 3];
+            break;
+        case BreakpointSpec::Kind::Output:
+            // An output some transition emits
+            do
+                spec.target = machine.transitions[rng() % machine.transitions.size()].output;
+            while (spec.target.empty());
+            break;
+        case BreakpointSpec::Kind::Variable:
+        case BreakpointSpec::Kind::Predicate:
+            spec.target = VariableNames[rng() % 3];
+            break;
+        }
+        if (spec.kind == BreakpointSpec::Kind::Predicate || rng() % 3 == 0)
+        {
+            std::string variable = VariableNames[rng() % 3];
+            condition.slot = reference.program.variables.find(variable);
+            condition.bound = static_cast<int64_t>(rng() % 11);
+            spec.condition = variable + " > " + std::to_string(condition.bound);
+        }
+        reference.specs.push_back(spec);
+        reference.conditions.push_back(condition);
+    }
+
+    bool sameFrame(const TraceFrame &a, const TraceFrame &b)
+    {
+        return a.step == b.step && a.state == b.state && a.edge == b.edge && a.variables == b.variables;
+    }
+
+    /**
+     * Feed the whole input sequence through the runner, batch by batch and
+     * hit by hit, checking every stop against the reference; returns the
+     * number of hits
+     */
+    size_t runAll(const std::string &name, const Reference &reference, const BreakpointSet &set, uint64_t tierUpSteps,
+                  std::mt19937 &rng)
+    {
+        TieredSimulator simulator(reference.program, tierUpSteps);
+        BreakpointRunner runner(reference.program, simulator);
+        const size_t length = reference.inputs.size();
+        size_t position = 0;
+        size_t hits = 0;
+        // Each hit replays up to two chunks for its context; a few hundred
+        // cover the interesting positions
+        while (position < length && hits < 300)
+        {
+            const size_t batch = std::min<size_t>(length - position, 1 + rng() % 9000);
+            BreakpointWindow window;
+            window.before = rng() % 4 == 0 ? 5000 : static_cast<uint32_t>(rng() % 12);
+            window.after = static_cast<uint32_t>(rng() % 12);
+            BreakpointRunResult result = runner.run(set, reference.inputs.data() + position, batch, window);
+
+            size_t expectedStep = position + batch;
+            int32_t expectedHit = -1;
+            for (size_t i = position + 1; i <= position + batch; i++)
+            {
+                expectedHit = reference.hit(i);
+                if (expectedHit >= 0)
+                {
+                    expectedStep = i;
+                    break;
+                }
+            }
+            const std::string at = name + " from step " + std::to_string(position);
+            if (result.breakpoint != expectedHit || position + result.steps != expectedStep || result.failed)
+            {
+                expect(false, at + ": stopped at step " + std::to_string(position + result.steps) + " on breakpoint " +
+                                  std::to_string(result.breakpoint) + ", expected step " + std::to_string(expectedStep) +
+                                  " on breakpoint " + std::to_string(expectedHit));
+                return hits;
+            }
+            expect(runner.position() == expectedStep, at + ": the runner's position follows the run");
+            expect(simulator.currentState() == reference.frames[expectedStep].state &&
+                       simulator.variables() == reference.frames[expectedStep].variables,
+                   at + ": the simulator is left at the stop");
+
+            if (expectedHit >= 0)
+            {
+                hits++;
+                // Context never reaches back past the start of the history or
+                // more than a chunk
+                const size_t before = std::min<size_t>({window.before, BreakpointRunner::ChunkSteps, expectedStep});
+                const size_t after = std::min<size_t>(window.after, position + batch - expectedStep);
+                bool context = result.context.size() == before + 1 + after && result.hitFrame == before;
+                for (size_t i = 0; i < result.context.size() && context; i++)
+                    context = sameFrame(result.context[i], reference.frames[expectedStep - before + i]);
+                expect(context, at + ": the context window matches the reference frames");
+            }
+            else
+            {
+                expect(result.context.empty(), at + ": no context without a hit");
+            }
+            position = expectedStep;
+        }
+        return hits;
+    }
+
+    void randomRuns()
+    {
+        std::mt19937 rng(17);
+        for (int m = 0; m < 20 && !failures; m++)
+        {
+            const StateMachine machine = randomMachine(rng);
+            const MachineProgram program = MachineProgram::compile(machine);
+            Reference reference{machine, program, {}, {}, {}, {}};
+
+            // Mostly a and b; c is rare enough that a breakpoint on it spans chunks
+            reference.frames.push_back({0, program.graph.initialState, -1, program.variables.initialValues()});
+            for (int i = 0; i < 20000; i++)
+            {
+                const char *input = rng() % 3000 == 0 ? "c" : Inputs[rng() % 2];
+                reference.inputs.push_back(program.graph.findInput(input));
+                TraceFrame next = reference.frames.back();
+                next.step++;
+                next.edge = Simulator::step(program, next.state, next.variables.data(), reference.inputs.back());
+                reference.frames.push_back(next);
+            }
+
+            for (int s = 0; s < 6 && !failures; s++)
+            {
+                reference.specs.clear();
+                reference.conditions.clear();
+                const int count = s == 0 ? 1 : 1 + static_cast<int>(rng() % 3);
+                for (int b = 0; b < count; b++)
+                    randomBreakpoint(rng, machine, reference);
+                if (s == 0)
+                {
+                    reference.specs[0] = {BreakpointSpec::Kind::Input, "c", ""};
+                    reference.conditions[0] = Condition();
+                }
+                const BreakpointSet set = BreakpointSet::compile(machine, program, reference.specs);
+                const std::string name = "machine " + std::to_string(m) + ", set " + std::to_string(s);
+                size_t hits = runAll(name + " interpreted", reference, set, UINT64_MAX, rng);
+                hits += runAll(name + " tiered", reference, set, 0, rng);
+                if (s == 0)
+                    expect(hits > 0, name + ": the rare input is hit");
+            }
+        }
+    }
+
+    void disabledInput()
+    {
+        StateMachine machine;
+        machine.id = machine.name = "halting";
+        for (const char *id : {"A", "B"})
+        {
+            State state;
+            state.id = state.name = id;
+            state.isInitial = state.id == "A";
+            machine.states.push_back(state);
+        }
+        machine.transitions = {Transition{"t1", "A", "B", "go", "", "", ""},
+                               Transition{"t2", "B", "A", "go", "", "", ""},
+                               Transition{"t3", "B", "B", "stop", "", "", ""}};
+        const MachineProgram program = MachineProgram::compile(machine);
+        const BreakpointSet set = BreakpointSet::compile(machine, program, {{BreakpointSpec::Kind::Transition, "t3", ""}});
+        const int32_t go = program.graph.findInput("go");
+        const int32_t stop = program.graph.findInput("stop");
+
+        for (uint64_t tierUpSteps : {uint64_t(0), UINT64_MAX})
+        {
+            TieredSimulator simulator(program, tierUpSteps);
+            BreakpointRunner runner(program, simulator);
+            std::vector<int32_t> inputs{go, go, go, go, stop};
+            // Compiles the threaded tier when tierUpSteps is 0
+            runner.run(set, inputs.data(), 4, BreakpointWindow());
+
+            BreakpointRunResult result = runner.run(set, inputs.data(), inputs.size(), BreakpointWindow());
+            expect(result.failed && result.breakpoint < 0 && result.steps == 4,
+                   "disabled input: the run stops before stop in A, without a hit");
+            expect(runner.position() == 8 && simulator.currentState() == program.graph.findState("A"),
+                   "disabled input: the simulator stays where the run stopped");
+
+            result = runner.run(set, inputs.data(), inputs.size(), BreakpointWindow());
+            expect(result.failed && result.steps == 4 && runner.position() == 12, "disabled input: the next batch fails again");
+            std::vector<int32_t> tail{go, stop, go};
+            result = runner.run(set, tail.data(), tail.size(), BreakpointWindow());
+            expect(result.breakpoint == 0 && result.steps == 2 && result.context.size() == 10 && result.hitFrame == 8,
+                   "disabled input: t3 hits once B is reached; failed inputs leave no frames");
+        }
+    }
+
+    void rejected()
+    {
+        StateMachine machine;
+        machine.id = machine.name = "rejected";
+        State state;
+        state.id = state.name = "A";
+        state.isInitial = true;
+        machine.states.push_back(state);
+        Variable variable;
+        variable.name = "x";
+        variable.initialValue = "0";
+        machine.stateVariables.push_back(variable);
+        machine.transitions = {Transition{"t1", "A", "A", "go", "beep", "", "x++"}};
+        const MachineProgram program = MachineProgram::compile(machine);
+
+        const std::vector<BreakpointSpec> invalid = {
+            {BreakpointSpec::Kind::State, "B", ""},
+            {BreakpointSpec::Kind::Transition, "t2", ""},
+            {BreakpointSpec::Kind::Input, "stop", ""},
+            {BreakpointSpec::Kind::Output, "ring", ""},
+            {BreakpointSpec::Kind::Variable, "y", ""},
+            {BreakpointSpec::Kind::Predicate, "", ""},
+            {BreakpointSpec::Kind::State, "A", "y > 0"},
+            {BreakpointSpec::Kind::State, "A", "x >"},
+        };
+        for (size_t i = 0; i < invalid.size(); i++)
+        {
+            std::string message;
+            try
+            {
+                BreakpointSet::compile(machine, program, {{BreakpointSpec::Kind::Input, "go", ""}, invalid[i]});
+            }
+            catch (const std::invalid_argument &e)
+            {
+                message = e.what();
+            }
+            expect(message.rfind("Breakpoint 1: ", 0) == 0, "rejected " + std::to_string(i) + ": names the breakpoint");
+        }
+
+        const BreakpointSet set = BreakpointSet::compile(machine, program, {{BreakpointSpec::Kind::Input, "go", ""}});
+        StateMachine other = machine;
+        other.transitions.push_back(Transition{"t2", "A", "A", "go", "", "", ""});
+        const MachineProgram otherProgram = MachineProgram::compile(other);
+        TieredSimulator simulator(otherProgram);
+        BreakpointRunner runner(otherProgram, simulator);
+        int32_t go = otherProgram.graph.findInput("go");
+        bool thrown = false;
+        try
+        {
+            runner.run(set, &go, 1, BreakpointWindow());
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown = true;
+        }
+        expect(thrown, "rejected: a set compiled for another machine");
+    }
+} // namespace
+
+int main()
+{
+    randomRuns();
+    disabledInput();
+    rejected();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d breakpoint check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: breakpoint runs match the reference\n");
+    return 0;
+}
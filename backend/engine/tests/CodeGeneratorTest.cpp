@@ -0,0 +1,242 @@
+/**
+ * Generated C++ must compile and behave like the reference Simulator: for
+ * random machines, with and without guards and actions, under every
+ * dispatch that applies, the header and its conformance test are written
+ * out, compiled with the host compiler ($CXX, else c++) and run. The
+ * conformance test replays walks recorded from the Simulator, so a zero
+ * exit status means the generated class agrees with it step by step.
+ *
+ * Build: node-gyp build (target code_generator_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/CodeGeneratorTest.cpp \
+ *       engine/src/CodeGenerator.cpp engine/src/CompiledMachine.cpp \
+ *       engine/src/Expression.cpp engine/src/Simulator.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "CodeGenerator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    const char *const VariableNames[] = {"x", "y", "z"};
+    // Labels that need renaming: reserved words, digits, punctuation and
+    // clashes once punctuation is dropped
+    const char *const Inputs[] = {"go", "class", "2nd", "go!", "stop now"};
+    const char *const Outputs[] = {"", "None", "beep", "beep?", "int"};
+
+    std::string randomOperand(std::mt19937 &rng)
+    {
+        if (rng() % 2)
+            return VariableNames[rng() % 3];
+        return std::to_string(static_cast<int>(rng() % 11) - 3);
+    }
+
+    std::string randomCondition(std::mt19937 &rng)
+    {
+        static const char *const ops[] = {"<", "<=", ">", ">=", "==", "!="};
+        std::string comparison = randomOperand(rng) + " " + ops[rng() % 6] + " " + randomOperand(rng);
+        if (rng() % 3)
+            return comparison;
+        return "(" + comparison + (rng() % 2 ? " && " : " || ") + randomOperand(rng) + " > 0)";
+    }
+
+    std::string randomAction(std::mt19937 &rng)
+    {
+        static const char *const arithmetic[] = {"+", "-", "*", "/", "%"};
+        std::string target = VariableNames[rng() % 3];
+        switch (rng() % 3)
+        {
+        case 0:
+            return target + " = " + randomOperand(rng) + " " + arithmetic[rng() % 5] + " " + randomOperand(rng);
+        case 1:
+            return target + " += " + randomOperand(rng);
+        default:
+            return target + "++";
+        }
+    }
+
+    StateMachine randomMachine(std::mt19937 &rng, bool guarded)
+    {
+        StateMachine machine;
+        machine.id = "generated";
+        machine.name = "Conformance machine";
+        machine.type = "mealy";
+
+        if (guarded)
+        {
+            for (const char *name : VariableNames)
+            {
+                Variable variable;
+                variable.name = name;
+                variable.initialValue = std::to_string(rng() % 5);
+                machine.stateVariables.push_back(variable);
+            }
+        }
+
+        const int stateCount = 2 + static_cast<int>(rng() % 6);
+        for (int i = 0; i < stateCount; i++)
+        {
+            State state;
+            state.id = "s" + std::to_string(i);
+            // Duplicate and reserved names must still give distinct enumerators
+            state.name = i % 3 == 2 ? "delete" : "state " + std::to_string(i / 2);
+            state.isInitial = i == 0;
+            state.isFinal = rng() % 5 == 0;
+            machine.states.push_back(state);
+        }
+
+        const int transitionCount = stateCount * (1 + static_cast<int>(rng() % 3));
+        for (int i = 0; i < transitionCount; i++)
+        {
+            Transition transition;
+            transition.id = "t" + std::to_string(i);
+            transition.from = "s" + std::to_string(rng() % stateCount);
+            transition.to = "s" + std::to_string(rng() % stateCount);
+            transition.input = Inputs[rng() % 5];
+            transition.output = Outputs[rng() % 5];
+            if (guarded && rng() % 2)
+                transition.guard = randomCondition(rng);
+            if (guarded && rng() % 2)
+                transition.action = randomAction(rng);
+            machine.transitions.push_back(transition);
+        }
+        return machine;
+    }
+
+    void write(const std::string &path, const std::string &contents)
+    {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    /**
+     * Compile and run the conformance test; true when it exits with 0
+     */
+    bool conforms(const std::string &compiler, const std::string &directory, const GeneratedCode &code)
+    {
+        write(directory + "/" + code.headerName, code.header);
+        write(directory + "/conformance.cpp", code.conformanceTest);
+        std::string build = compiler + " -std=c++17 -o " + directory + "/conformance " + directory +
+                            "/conformance.cpp > " + directory + "/build.log 2>&1";
+        if (std::system(build.c_str()) != 0)
+        {
+            std::string log = "cat " + directory + "/build.log >&2";
+            std::system(log.c_str());
+            return false;
+        }
+        std::string run = directory + "/conformance > /dev/null";
+        return std::system(run.c_str()) == 0;
+    }
+
+    void identifiers()
+    {
+        expect(CodeGenerator::toIdentifier("stop now!", "Input") == "stop_now", "identifiers: punctuation becomes _");
+        expect(CodeGenerator::toIdentifier("2nd", "Input") == "Input_2nd", "identifiers: no leading digit");
+        expect(CodeGenerator::toIdentifier("class", "Input") == "class_", "identifiers: reserved words are renamed");
+        expect(CodeGenerator::toIdentifier("?!", "Input") == "Input", "identifiers: the fallback when nothing is left");
+    }
+
+    void rejected()
+    {
+        std::mt19937 rng(3);
+        StateMachine guarded = randomMachine(rng, true);
+        guarded.transitions[0].guard = "x > 0";
+        CodeGenOptions table;
+        table.dispatch = CodeGenOptions::Dispatch::Table;
+        bool thrown = false;
+        try
+        {
+            CodeGenerator::generate(guarded, table);
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown = true;
+        }
+        expect(thrown, "rejected: table dispatch with guards");
+
+        thrown = false;
+        try
+        {
+            CodeGenerator::generate(StateMachine(), CodeGenOptions());
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown = true;
+        }
+        expect(thrown, "rejected: a machine without states");
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int machines = argc > 1 ? std::atoi(argv[1]) : 8;
+    identifiers();
+    rejected();
+
+    const char *cxx = std::getenv("CXX");
+    const std::string compiler = cxx && *cxx ? cxx : "c++";
+    if (std::system((compiler + " --version > /dev/null 2>&1").c_str()) != 0)
+    {
+        std::printf("%s checks only: no C++ compiler to build generated code with (%s)\n",
+                    failures ? "FAIL:" : "OK:", compiler.c_str());
+        return failures ? 1 : 0;
+    }
+
+    char directory[] = "/tmp/code_generator_test_XXXXXX";
+    if (!mkdtemp(directory))
+    {
+        std::printf("FAIL: temporary directory\n");
+        return 1;
+    }
+
+    std::mt19937 rng(5);
+    int builds = 0;
+    for (int m = 0; m < machines && !failures; m++)
+    {
+        const bool guarded = m % 2 == 1;
+        StateMachine machine = randomMachine(rng, guarded);
+        std::vector<CodeGenOptions::Dispatch> dispatches = {CodeGenOptions::Dispatch::Auto, CodeGenOptions::Dispatch::Switch};
+        if (!guarded)
+            dispatches.push_back(CodeGenOptions::Dispatch::Table);
+        for (auto dispatch : dispatches)
+        {
+            CodeGenOptions options;
+            options.dispatch = dispatch;
+            options.conformanceSeed = static_cast<uint32_t>(m + 1);
+            GeneratedCode code = CodeGenerator::generate(machine, options);
+            expect(code.headerName == "Conformance_machine.h", "machine " + std::to_string(m) + ": header named after the machine");
+            expect(conforms(compiler, directory, code),
+                   "machine " + std::to_string(m) + ", dispatch " + std::to_string(static_cast<int>(dispatch)) +
+                       ": generated code conforms to the simulator");
+            builds++;
+        }
+    }
+
+    std::string command = std::string("rm -rf ") + directory;
+    std::system(command.c_str());
+
+    if (failures)
+    {
+        std::printf("FAIL: %d code generation check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: %d generated machines compile and conform\n", builds);
+    return 0;
+}
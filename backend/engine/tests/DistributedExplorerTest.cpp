@@ -0,0 +1,144 @@
+/**
+ * Multi-process exploration against StatechartExplorer::explore: for one
+ * to four forked workers, with rings and batches small enough that most
+ * successors wait for room, the merged report must count the same
+ * configurations, macrosteps and deadlocks, and the coordinator must
+ * detect termination on its own (an alarm fails a run that never ends).
+ *
+ * Build: node-gyp build (target distributed_explorer_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/DistributedExplorerTest.cpp \
+ *       engine/src/DistributedExplorer.cpp engine/src/ConcurrentStateSet.cpp \
+ *       engine/src/Scxml.cpp engine/src/Statechart.cpp \
+ *       engine/src/Checkpoint.cpp engine/src/ReportCache.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "DistributedExplorer.h"
+#include "Scxml.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <unistd.h>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    std::vector<std::vector<std::string>> sorted(std::vector<std::vector<std::string>> configurations)
+    {
+        for (auto &configuration : configurations)
+            std::sort(configuration.begin(), configuration.end());
+        std::sort(configurations.begin(), configurations.end());
+        return configurations;
+    }
+
+    std::vector<std::string> sorted(std::vector<std::string> ids)
+    {
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    void matchesExplorer(const std::string &name, const Statechart &chart)
+    {
+        StatechartReport sequential = StatechartExplorer::explore(chart, 1000000);
+        for (unsigned workers = 1; workers <= 4; workers++)
+        {
+            const std::string run = name + " on " + std::to_string(workers) + " worker(s)";
+            DistributedOptions options;
+            options.workers = workers;
+            options.ringBytes = 1 << 10;
+            options.batchSize = 3;
+
+            // A coordinator that misses termination never returns
+            alarm(120);
+            DistributedReport distributed = DistributedExplorer::explore(chart, options);
+            alarm(0);
+
+            expect(distributed.complete && distributed.workers == workers, run + ": completes");
+            expect(distributed.configurations == sequential.configurations, run + ": same configurations");
+            expect(std::accumulate(distributed.partitionSizes.begin(), distributed.partitionSizes.end(), uint64_t(0)) ==
+                       distributed.configurations,
+                   run + ": partitions cover the configurations");
+            expect(distributed.macrosteps == sequential.macrosteps, run + ": same macrosteps");
+            expect(distributed.terminalConfigurations == sequential.terminalConfigurations, run + ": same terminal configurations");
+            expect(distributed.deadlockCount == sequential.deadlockCount, run + ": same deadlock count");
+            expect(sorted(distributed.deadlockedStates) == sorted(sequential.deadlockedStates), run + ": same deadlocked states");
+            if (sequential.deadlockCount <= StatechartReport::MaxReportedDeadlocks)
+                expect(sorted(distributed.deadlocks) == sorted(sequential.deadlocks), run + ": same deadlocked configurations");
+            expect(sorted(distributed.unreachableStates) == sorted(sequential.unreachableStates), run + ": same unreachable states");
+            if (workers > 1 && sequential.configurations >= 64)
+                expect(distributed.messages > 0, run + ": successors cross partitions");
+        }
+    }
+
+    /**
+     * Three orthogonal regions of four states each, every region cycling
+     * on its own event
+     */
+    std::string regions()
+    {
+        std::string document = "<scxml initial=\"R\"><parallel id=\"R\">";
+        for (int r = 0; r < 3; r++)
+        {
+            std::string region = "r" + std::to_string(r);
+            document += "<state id=\"" + region + "\">";
+            for (int s = 0; s < 4; s++)
+            {
+                document += "<state id=\"" + region + "_" + std::to_string(s) + "\"><transition event=\"e" +
+                            std::to_string(r) + "\" target=\"" + region + "_" + std::to_string((s + 1) % 4) +
+                            "\"/></state>";
+            }
+            document += "</state>";
+        }
+        return document + "</parallel></scxml>";
+    }
+
+    /**
+     * A region with forty dead ends beside a switch that only turns off:
+     * forty deadlocked configurations, more than the report lists
+     */
+    std::string deadEnds()
+    {
+        std::string document = "<scxml initial=\"P\"><parallel id=\"P\"><state id=\"left\" initial=\"A\"><state id=\"A\">";
+        for (int i = 0; i < 40; i++)
+            document += "<transition event=\"go" + std::to_string(i) + "\" target=\"d" + std::to_string(i) + "\"/>";
+        document += "</state>";
+        for (int i = 0; i < 40; i++)
+            document += "<state id=\"d" + std::to_string(i) + "\"/>";
+        return document + "</state><state id=\"right\" initial=\"on\">"
+                          "<state id=\"on\"><transition event=\"flip\" target=\"off\"/></state><state id=\"off\"/>"
+                          "<state id=\"unused\"/></state></parallel></scxml>";
+    }
+} // namespace
+
+int main()
+{
+    matchesExplorer("regions", statechartFromScxml(regions()));
+    matchesExplorer("dead ends", statechartFromScxml(deadEnds()));
+    matchesExplorer("final states", statechartFromScxml("<scxml initial=\"X\">"
+                                                        "<state id=\"X\"><transition event=\"a\" target=\"Y\"/>"
+                                                        "<transition event=\"d\" cond=\"ok\" target=\"T\"/>"
+                                                        "<transition event=\"d\" target=\"D\"/></state>"
+                                                        "<state id=\"Y\"><transition event=\"a\" target=\"X\"/></state>"
+                                                        "<state id=\"D\"/><final id=\"T\"/>"
+                                                        "</scxml>"));
+
+    if (failures)
+    {
+        std::printf("FAIL: %d distributed exploration check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: distributed explorations match the explorer\n");
+    return 0;
+}
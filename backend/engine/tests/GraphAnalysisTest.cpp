@@ -0,0 +1,154 @@
+/**
+ * GraphAnalysis::deadlockStates over a CompiledMachine and over a mapped
+ * model file against Verifier::findDeadlocks: equal on random flat
+ * machines, and different exactly as documented once a transition targets
+ * a state that does not exist.
+ *
+ * Build: node-gyp build (target graph_analysis_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/GraphAnalysisTest.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/ModelFile.cpp \
+ *       engine/src/Verifier.cpp engine/src/VerificationStats.cpp \
+ *       engine/src/Statechart.cpp engine/src/Checkpoint.cpp \
+ *       engine/src/ReportCache.cpp engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "CompiledMachine.h"
+#include "GraphAnalysis.h"
+#include "ModelFile.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    template <class Graph>
+    std::vector<std::string> deadlocks(const Graph &graph, const std::vector<std::string> &ids)
+    {
+        std::vector<std::string> names;
+        for (uint32_t s : GraphAnalysis::deadlockStates(graph))
+            names.push_back(ids[s]);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::vector<std::string> verifierDeadlocks(const StateMachine &machine)
+    {
+        std::vector<std::string> names = Verifier::findDeadlocks(machine);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    /**
+     * Deadlocks of the machine as written to and mapped from a model file
+     */
+    std::vector<std::string> mappedDeadlocks(const StateMachine &machine)
+    {
+        char path[] = "/tmp/graph_analysis_test_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+            return {"<no temporary file>"};
+        close(fd);
+        MappedModel::save(machine, path);
+        std::unique_ptr<MappedModel> model = MappedModel::open(path);
+        std::vector<std::string> ids;
+        for (uint32_t s = 0; s < model->stateCount(); s++)
+            ids.emplace_back(model->stateId(s));
+        std::vector<std::string> names = deadlocks(*model, ids);
+        model.reset();
+        unlink(path);
+        return names;
+    }
+
+    StateMachine randomMachine(std::mt19937 &rng)
+    {
+        StateMachine machine;
+        machine.id = machine.name = "random";
+        const size_t states = 2 + rng() % 12;
+        for (size_t i = 0; i < states; i++)
+        {
+            State state;
+            state.id = state.name = "s" + std::to_string(i);
+            state.isInitial = i == 0;
+            state.isFinal = rng() % 5 == 0;
+            machine.states.push_back(state);
+        }
+        const size_t transitions = rng() % (2 * states);
+        for (size_t i = 0; i < transitions; i++)
+        {
+            Transition transition;
+            transition.id = "t" + std::to_string(i);
+            transition.from = machine.states[rng() % states].id;
+            transition.to = machine.states[rng() % states].id;
+            transition.input = "i" + std::to_string(rng() % 3);
+            machine.transitions.push_back(transition);
+        }
+        return machine;
+    }
+
+    void randomMachines()
+    {
+        std::mt19937 rng(11);
+        for (int m = 0; m < 200 && !failures; m++)
+        {
+            StateMachine machine = randomMachine(rng);
+            CompiledMachine compiled = CompiledMachine::compile(machine);
+            std::vector<std::string> expected = verifierDeadlocks(machine);
+            expect(deadlocks(compiled, compiled.stateIds) == expected,
+                   "machine " + std::to_string(m) + ": compiled deadlocks match findDeadlocks");
+            expect(mappedDeadlocks(machine) == expected,
+                   "machine " + std::to_string(m) + ": mapped deadlocks match findDeadlocks");
+        }
+    }
+
+    void danglingTransition()
+    {
+        // B's only transition targets a state that does not exist
+        StateMachine machine;
+        machine.id = machine.name = "dangling";
+        for (const char *id : {"A", "B", "C"})
+        {
+            State state;
+            state.id = state.name = id;
+            state.isInitial = state.id == "A";
+            machine.states.push_back(state);
+        }
+        machine.transitions = {Transition{"t1", "A", "B", "go", "", "", ""},
+                               Transition{"t2", "B", "missing", "go", "", "", ""}};
+
+        CompiledMachine compiled = CompiledMachine::compile(machine);
+        expect(compiled.edgeCount() == 1, "dangling: the transition is dropped from the graph");
+        expect(verifierDeadlocks(machine) == std::vector<std::string>{"C"}, "dangling: findDeadlocks counts it as outgoing");
+        expect(deadlocks(compiled, compiled.stateIds) == std::vector<std::string>({"B", "C"}),
+               "dangling: the compiled graph reports its source");
+        expect(mappedDeadlocks(machine) == std::vector<std::string>({"B", "C"}), "dangling: so does the mapped model");
+    }
+} // namespace
+
+int main()
+{
+    randomMachines();
+    danglingTransition();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d graph analysis check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: graph deadlocks match the verifier\n");
+    return 0;
+}
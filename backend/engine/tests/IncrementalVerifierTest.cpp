@@ -0,0 +1,185 @@
+/**
+ * Differential test of the incremental analyses: after every edit of a
+ * random edit sequence, the report must match the one built from scratch
+ * for the edited machine. Merging cycles reorders components, so edges
+ * that close cycles across earlier merges are frequent here.
+ *
+ * Build: node-gyp build (target incremental_verifier_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/IncrementalVerifierTest.cpp \
+ *       engine/src/IncrementalVerifier.cpp
+ */
+#include "IncrementalVerifier.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    std::vector<std::string> sorted(std::vector<std::string> ids)
+    {
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    std::vector<std::vector<std::string>> sorted(std::vector<std::vector<std::string>> traps)
+    {
+        for (auto &trap : traps)
+            std::sort(trap.begin(), trap.end());
+        std::sort(traps.begin(), traps.end());
+        return traps;
+    }
+
+    /**
+     * Name of the first field that differs, or nullptr
+     */
+    const char *difference(const IncrementalReport &a, const IncrementalReport &b)
+    {
+        if (a.totalStates != b.totalStates)
+            return "totalStates";
+        if (a.reachableStates != b.reachableStates || sorted(a.unreachableStates) != sorted(b.unreachableStates))
+            return "reachableStates";
+        if (a.transitions != b.transitions)
+            return "transitions";
+        if (a.finalReachable != b.finalReachable)
+            return "finalReachable";
+        if (a.deadlockCount != b.deadlockCount || sorted(a.deadlocks) != sorted(b.deadlocks))
+            return "deadlocks";
+        if (a.inputAlphabet != b.inputAlphabet || a.incompleteCount != b.incompleteCount)
+            return "completeness";
+        if (a.components != b.components)
+            return "components";
+        if (a.cyclicComponents != b.cyclicComponents)
+            return "cyclicComponents";
+        if (a.trapComponents != b.trapComponents || sorted(a.traps) != sorted(b.traps))
+            return "trapComponents";
+        return nullptr;
+    }
+
+    /**
+     * The edited machine, mirrored so it can be rebuilt from scratch
+     */
+    struct Model
+    {
+        StateMachine machine;
+        size_t nextState = 0;
+        size_t nextTransition = 0;
+
+        State *randomState(std::mt19937 &rng)
+        {
+            return machine.states.empty() ? nullptr : &machine.states[rng() % machine.states.size()];
+        }
+
+        Transition *randomTransition(std::mt19937 &rng)
+        {
+            return machine.transitions.empty() ? nullptr : &machine.transitions[rng() % machine.transitions.size()];
+        }
+    };
+
+    /**
+     * Apply one random edit to both; returns a description of it
+     */
+    std::string edit(std::mt19937 &rng, Model &model, IncrementalVerifier &verifier)
+    {
+        const int kind = static_cast<int>(rng() % 16);
+        StateMachine &machine = model.machine;
+
+        if (kind < 2 || machine.states.size() < 2)
+        {
+            State state;
+            state.id = "s" + std::to_string(model.nextState++);
+            state.name = state.id;
+            state.isInitial = machine.states.empty() || rng() % 16 == 0;
+            state.isFinal = rng() % 8 == 0;
+            machine.states.push_back(state);
+            verifier.addState(state);
+            return "add state " + state.id;
+        }
+        if (kind == 2 && machine.states.size() > 4)
+        {
+            size_t index = rng() % machine.states.size();
+            std::string id = machine.states[index].id;
+            machine.states.erase(machine.states.begin() + static_cast<std::ptrdiff_t>(index));
+            machine.transitions.erase(std::remove_if(machine.transitions.begin(), machine.transitions.end(),
+                                                     [&id](const Transition &t)
+                                                     { return t.from == id || t.to == id; }),
+                                      machine.transitions.end());
+            verifier.removeState(id);
+            return "remove state " + id;
+        }
+        if (kind == 3)
+        {
+            State *state = model.randomState(rng);
+            if (rng() % 2)
+                state->isFinal = !state->isFinal;
+            else
+                state->isInitial = !state->isInitial;
+            verifier.updateState(*state);
+            return "update state " + state->id;
+        }
+        if (kind < 6 && !machine.transitions.empty())
+        {
+            size_t index = rng() % machine.transitions.size();
+            std::string id = machine.transitions[index].id;
+            machine.transitions.erase(machine.transitions.begin() + static_cast<std::ptrdiff_t>(index));
+            verifier.removeTransition(id);
+            return "remove transition " + id;
+        }
+        if (kind == 6 && !machine.transitions.empty())
+        {
+            Transition *transition = model.randomTransition(rng);
+            transition->to = model.randomState(rng)->id;
+            transition->input = "i" + std::to_string(rng() % 3);
+            verifier.updateTransition(*transition);
+            return "retarget transition " + transition->id;
+        }
+
+        Transition transition;
+        transition.id = "t" + std::to_string(model.nextTransition++);
+        transition.from = model.randomState(rng)->id;
+        transition.to = model.randomState(rng)->id;
+        transition.input = "i" + std::to_string(rng() % 3);
+        machine.transitions.push_back(transition);
+        verifier.addTransition(transition);
+        return "add transition " + transition.id + " " + transition.from + " -> " + transition.to;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int sequences = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int edits = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::mt19937 rng(7);
+    int failures = 0;
+    for (int s = 0; s < sequences && failures < 5; s++)
+    {
+        Model model;
+        model.machine.id = model.machine.name = "random";
+        IncrementalVerifier verifier(model.machine);
+
+        for (int e = 0; e < edits; e++)
+        {
+            std::string applied = edit(rng, model, verifier);
+            IncrementalReport incremental = verifier.report();
+            IncrementalReport rebuilt = IncrementalVerifier(model.machine).report();
+            if (const char *field = difference(incremental, rebuilt))
+            {
+                std::fprintf(stderr, "sequence %d, edit %d (%s): %s differs from a rebuild\n", s, e, applied.c_str(), field);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    if (failures)
+    {
+        std::printf("FAIL: %d edit sequence(s) diverged from a rebuild\n", failures);
+        return 1;
+    }
+    std::printf("OK: %d edit sequences of %d edits match a rebuild\n", sequences, edits);
+    return 0;
+}
@@ -0,0 +1,319 @@
+/**
+ * JobScheduler ordering and cancellation: queued jobs start by class, then
+ * earliest deadline, then submission order; an interactive job runs while
+ * background jobs hold every other worker; queued jobs that are cancelled
+ * or expire complete with JobCancelled without running, running ones stop
+ * at their next CancellationPoint; and the counters and the destructor
+ * account for every job.
+ *
+ * Build: node-gyp build (target job_scheduler_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/JobSchedulerTest.cpp \
+ *       engine/src/JobScheduler.cpp -lpthread
+ */
+#include "JobScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    using Clock = CancellationToken::Clock;
+
+    /**
+     * Jobs block on the gate until it opens; everything the test observes
+     * is recorded under its lock
+     */
+    struct Gate
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool open = false;
+        int started = 0;
+        std::string order;
+        std::vector<std::string> errors;
+
+        void pass()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            started++;
+            changed.notify_all();
+            changed.wait(lock, [this]
+                         { return open; });
+        }
+
+        void release()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+            changed.notify_all();
+        }
+
+        void record(const std::string &what)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order += what;
+            changed.notify_all();
+        }
+
+        JobScheduler::Done done()
+        {
+            return [this](std::exception_ptr error)
+            {
+                std::string message = "ok";
+                try
+                {
+                    if (error)
+                        std::rethrow_exception(error);
+                }
+                catch (const JobCancelled &e)
+                {
+                    message = std::string("cancelled: ") + e.what();
+                }
+                catch (const std::exception &e)
+                {
+                    message = std::string("failed: ") + e.what();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                errors.push_back(message);
+                changed.notify_all();
+            };
+        }
+
+        /**
+         * Wait up to ten seconds for the condition; false on timeout
+         */
+        template <class Condition>
+        bool await(Condition condition)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return changed.wait_for(lock, std::chrono::seconds(10), condition);
+        }
+    };
+
+    JobOptions options(JobPriority priority, Clock::duration deadline = Clock::duration::max())
+    {
+        JobOptions result;
+        result.priority = priority;
+        if (deadline != Clock::duration::max())
+            result.deadline = Clock::now() + deadline;
+        return result;
+    }
+
+    void priorityOrder()
+    {
+        Gate gate;
+        {
+            JobScheduler scheduler(1);
+            scheduler.submit([&]
+                             { gate.pass(); },
+                             nullptr);
+            expect(gate.await([&]
+                              { return gate.started == 1; }),
+                   "order: the blocking job starts");
+
+            auto job = [&](const char *name)
+            { return [&gate, name]
+              { gate.record(name); }; };
+            scheduler.submit(job("f"), gate.done(), options(JobPriority::Bulk));
+            scheduler.submit(job("c"), gate.done(), options(JobPriority::Normal, std::chrono::hours(2)));
+            scheduler.submit(job("b"), gate.done(), options(JobPriority::Normal, std::chrono::hours(1)));
+            scheduler.submit(job("a"), gate.done(), options(JobPriority::Interactive));
+            scheduler.submit(job("d"), gate.done(), options(JobPriority::Normal));
+            scheduler.submit(job("e"), gate.done(), options(JobPriority::Normal));
+
+            JobScheduler::Stats stats = scheduler.stats();
+            expect(stats.workers == 1 && stats.running[1] == 1 && stats.queued[0] == 1 && stats.queued[1] == 4 &&
+                       stats.queued[2] == 1,
+                   "order: jobs wait in their class queues");
+
+            gate.release();
+            expect(gate.await([&]
+                              { return gate.errors.size() == 6; }),
+                   "order: every job completes");
+            expect(gate.order == "abcdef", "order: by class, then deadline, then submission (got " + gate.order + ")");
+            stats = scheduler.stats();
+            expect(stats.completed == 7 && stats.failed == 0 && stats.cancelled == 0, "order: seven completed jobs");
+        }
+    }
+
+    void reservedWorker()
+    {
+        Gate gate;
+        JobScheduler scheduler(3);
+        for (int i = 0; i < 3; i++)
+            scheduler.submit([&]
+                             { gate.pass(); },
+                             gate.done(), options(i == 2 ? JobPriority::Bulk : JobPriority::Normal));
+        expect(gate.await([&]
+                          { return gate.started == 2; }),
+               "reserved: two background jobs start");
+
+        scheduler.submit([&]
+                         { gate.record("i"); },
+                         gate.done(), options(JobPriority::Interactive));
+        expect(gate.await([&]
+                          { return gate.order == "i"; }),
+               "reserved: an interactive job runs beside the background jobs");
+        JobScheduler::Stats stats = scheduler.stats();
+        expect(stats.running[1] + stats.running[2] == 2 && stats.queued[1] + stats.queued[2] == 1,
+               "reserved: the third background job waits for the reserved worker");
+
+        gate.release();
+        expect(gate.await([&]
+                          { return gate.errors.size() == 4; }),
+               "reserved: the waiting job runs once a slot frees");
+        expect(gate.started == 3, "reserved: every background job ran");
+    }
+
+    void deadlines()
+    {
+        Gate gate;
+        JobScheduler scheduler(2);
+        scheduler.submit([&]
+                         { gate.pass(); },
+                         gate.done(), options(JobPriority::Bulk));
+        expect(gate.await([&]
+                          { return gate.started == 1; }),
+               "deadlines: the blocking job starts");
+
+        // Held back by the background limit until its deadline passes; no
+        // other event wakes the idle worker
+        std::atomic<bool> ran{false};
+        const Clock::time_point start = Clock::now();
+        scheduler.submit([&]
+                         { ran = true; },
+                         gate.done(), options(JobPriority::Normal, std::chrono::milliseconds(50)));
+        expect(gate.await([&]
+                          { return gate.errors.size() == 1; }),
+               "deadlines: the expired job completes while queued");
+        expect(!ran && gate.errors[0] == "cancelled: Job deadline exceeded", "deadlines: without running");
+        expect(Clock::now() - start >= std::chrono::milliseconds(50), "deadlines: not before its deadline");
+
+        // Running past the deadline stops at a cancellation point
+        std::atomic<uint64_t> polls{0};
+        scheduler.submit([&]
+                         {
+                             CancellationPoint cancellation;
+                             for (;;)
+                             {
+                                 cancellation.check();
+                                 polls++;
+                             } },
+                         gate.done(), options(JobPriority::Interactive, std::chrono::milliseconds(20)));
+        expect(gate.await([&]
+                          { return gate.errors.size() == 2; }),
+               "deadlines: a running job stops");
+        expect(gate.errors[1] == "cancelled: Job deadline exceeded" && polls > 0, "deadlines: after running to its deadline");
+
+        gate.release();
+        expect(gate.await([&]
+                          { return gate.errors.size() == 3; }),
+               "deadlines: the blocking job completes");
+        JobScheduler::Stats stats = scheduler.stats();
+        expect(stats.completed == 1 && stats.cancelled == 2, "deadlines: counted as cancelled");
+    }
+
+    void cancellation()
+    {
+        Gate gate;
+        std::atomic<bool> ran{false};
+        {
+            JobScheduler scheduler(2);
+            std::atomic<bool> polling{false};
+            auto running = scheduler.submit([&]
+                                            {
+                                                CancellationPoint cancellation;
+                                                for (;;)
+                                                {
+                                                    polling = true;
+                                                    cancellation.check();
+                                                } },
+                                            gate.done(), options(JobPriority::Normal));
+            auto queued = scheduler.submit([&]
+                                           { ran = true; },
+                                           gate.done(), options(JobPriority::Bulk));
+            scheduler.submit([]
+                             { throw std::runtime_error("broken"); },
+                             gate.done(), options(JobPriority::Interactive));
+            expect(gate.await([&]
+                              { return gate.errors.size() == 1; }),
+                   "cancel: the failing job completes");
+            expect(gate.errors[0] == "failed: broken", "cancel: a job's exception reaches done");
+
+            scheduler.cancel(queued);
+            expect(gate.await([&]
+                              { return gate.errors.size() == 2; }),
+                   "cancel: a cancelled queued job completes");
+            expect(!ran && gate.errors[1] == "cancelled: Job cancelled", "cancel: without running");
+
+            while (!polling)
+                std::this_thread::yield();
+            scheduler.cancel(running);
+            expect(gate.await([&]
+                              { return gate.errors.size() == 3; }),
+                   "cancel: a running job stops at a cancellation point");
+            expect(gate.errors[2] == "cancelled: Job cancelled", "cancel: with JobCancelled");
+
+            JobScheduler::Stats stats = scheduler.stats();
+            expect(stats.completed == 0 && stats.failed == 1 && stats.cancelled == 2 && stats.running[1] == 0,
+                   "cancel: one failure and two cancellations");
+
+            // Still queued behind the blocking job when the scheduler goes away
+            scheduler.submit([&]
+                             { gate.pass(); },
+                             gate.done(), options(JobPriority::Normal));
+            expect(gate.await([&]
+                              { return gate.started == 1; }),
+                   "cancel: the blocking job starts");
+            scheduler.submit([&]
+                             { ran = true; },
+                             gate.done(), options(JobPriority::Bulk));
+            gate.release();
+        }
+        expect(gate.errors.size() == 5, "cancel: the destructor completes every job");
+        const auto ok = std::count(gate.errors.begin() + 3, gate.errors.end(), "ok");
+        expect(ok == (ran ? 2 : 1), "cancel: a job left queued at destruction runs or is cancelled, never lost");
+
+        bool thrown = false;
+        try
+        {
+            JobScheduler::parsePriority("urgent");
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown = true;
+        }
+        expect(thrown && JobScheduler::parsePriority("bulk") == JobPriority::Bulk, "priorities: parsed by name");
+    }
+} // namespace
+
+int main()
+{
+    priorityOrder();
+    reservedWorker();
+    deadlines();
+    cancellation();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d job scheduler check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: jobs run in order and stop when cancelled\n");
+    return 0;
+}
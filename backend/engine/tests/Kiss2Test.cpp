@@ -0,0 +1,216 @@
+/**
+ * KISS2 import: a small machine with comments, "*" terms, a reset state and
+ * a missing final newline must parse to the same CSR graph whatever the
+ * chunking of the text, with cubes, minterm matching and the object form as
+ * written; malformed lines must throw std::invalid_argument naming the line,
+ * and the parser must be reusable after finish().
+ *
+ * Build: node-gyp build (target kiss2_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/Kiss2Test.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/Kiss2.cpp
+ */
+#include "Kiss2.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    const char *const Valid = "# traffic light\n"
+                              ".i 3\r\n"
+                              ".o 2\n"
+                              ".p 6\n"
+                              ".s 3\n"
+                              ".ilb a b c\n"
+                              ".r green\n"
+                              "\n"
+                              "1-- red    green  01  # a turns green\n"
+                              "0-1 red    red    00\n"
+                              "--- green  yellow 10\n"
+                              "-1- yellow red    00\n"
+                              "\t11- *      red    11\n"
+                              "0-- yellow yellow 00\n"
+                              ".e\n"
+                              "not a product term\n"
+                              "1";
+
+    KissMachine parse(const char *text, size_t chunk)
+    {
+        KissParser parser;
+        const size_t size = std::strlen(text);
+        for (size_t offset = 0; offset < size; offset += chunk)
+            parser.feed(text + offset, std::min(chunk, size - offset));
+        return parser.finish();
+    }
+
+    bool sameGraph(const KissMachine &a, const KissMachine &b)
+    {
+        return a.inputBits == b.inputBits && a.outputBits == b.outputBits && a.productTerms == b.productTerms &&
+               a.graph.stateIds == b.graph.stateIds && a.graph.initialState == b.graph.initialState &&
+               a.graph.edgeOffsets == b.graph.edgeOffsets && a.graph.edgeTargets == b.graph.edgeTargets &&
+               a.graph.edgeInputs == b.graph.edgeInputs && a.graph.edgeOutputs == b.graph.edgeOutputs &&
+               a.graph.edgeTransitions == b.graph.edgeTransitions && a.graph.inputSymbols == b.graph.inputSymbols &&
+               a.graph.outputSymbols == b.graph.outputSymbols;
+    }
+
+    /**
+     * Edges of a state as "input>target/output#term", in CSR order
+     */
+    std::string edges(const KissMachine &machine, const std::string &state)
+    {
+        const CompiledMachine &graph = machine.graph;
+        const int32_t s = graph.findState(state);
+        std::string text;
+        for (uint32_t e = graph.edgeOffsets[s]; e < graph.edgeOffsets[s + 1]; e++)
+        {
+            text += (text.empty() ? "" : " ") + graph.inputSymbols[graph.edgeInputs[e]] + ">" +
+                    graph.stateIds[graph.edgeTargets[e]] + "/" + graph.outputSymbols[graph.edgeOutputs[e]] + "#" +
+                    std::to_string(graph.edgeTransitions[e]);
+        }
+        return text;
+    }
+
+    void valid()
+    {
+        const KissMachine machine = parse(Valid, std::strlen(Valid));
+        const CompiledMachine &graph = machine.graph;
+        expect(machine.inputBits == 3 && machine.outputBits == 2, "valid: widths from .i and .o");
+        expect(machine.productTerms == 6, "valid: terms after .e are ignored");
+        expect(graph.stateIds == std::vector<std::string>({"green", "red", "yellow"}), "valid: states in order of appearance");
+        expect(graph.initialState == graph.findState("green"), "valid: .r names the initial state");
+        expect(graph.edgeCount() == 8, "valid: the * term leaves every state");
+        expect(edges(machine, "red") == "1-->green/01#0 0-1>red/00#1 11->red/11#4", "valid: red's edges in file order");
+        expect(edges(machine, "green") == "--->yellow/10#2 11->red/11#4", "valid: green's edges in file order");
+        expect(edges(machine, "yellow") == "-1->red/00#3 11->red/11#4 0-->yellow/00#5", "valid: yellow's edges in file order");
+
+        // Bit i is the i-th character of the cube
+        const KissCube &cube = machine.cubes[graph.findInput("0-1")];
+        expect(cube.care == 0b101 && cube.value == 0b100, "valid: cubes decode character i to bit i");
+        expect(machine.mintermCount(graph.findInput("---")) == 8 && machine.mintermCount(graph.findInput("0-1")) == 2,
+               "valid: minterm counts");
+
+        const uint32_t red = static_cast<uint32_t>(graph.findState("red"));
+        const uint32_t yellow = static_cast<uint32_t>(graph.findState("yellow"));
+        bool matches = true;
+        for (uint64_t m = 0; m < 8; m++)
+        {
+            const bool a = m & 1, b = m & 2, c = m & 4;
+            const int32_t redEdge = a ? 0 : c ? 1 : -1;
+            const int32_t yellowEdge = b ? 0 : !a ? 2 : -1;
+            const int32_t offset = static_cast<int32_t>(graph.edgeOffsets[red]);
+            const int32_t yellowOffset = static_cast<int32_t>(graph.edgeOffsets[yellow]);
+            matches = matches && machine.match(red, m) == (redEdge < 0 ? -1 : offset + redEdge) &&
+                      machine.match(yellow, m) == (yellowEdge < 0 ? -1 : yellowOffset + yellowEdge);
+        }
+        expect(matches, "valid: match picks the first covering edge in file order");
+
+        for (size_t input = 0; input < machine.cubes.size(); input++)
+        {
+            const KissCube &c = machine.cubes[input];
+            uint64_t seen = 0, covered = 0;
+            machine.forEachMinterm(static_cast<int32_t>(input), [&](uint64_t m)
+                                   {
+                                       covered |= uint64_t(1) << m;
+                                       seen++;
+                                       return (m & c.care) == c.value; });
+            uint64_t expected = 0;
+            for (uint64_t m = 0; m < 8; m++)
+            {
+                if ((m & c.care) == c.value)
+                    expected |= uint64_t(1) << m;
+            }
+            expect(covered == expected && seen == machine.mintermCount(static_cast<int32_t>(input)),
+                   "valid: " + graph.inputSymbols[input] + " enumerates exactly its minterms");
+        }
+
+        StateMachine object = machine.toStateMachine("traffic");
+        bool ordered = object.transitions.size() == 8 && object.transitions[0].id == "t0_red" &&
+                       object.transitions[4].id == "t4_green" && object.transitions[5].id == "t4_red" &&
+                       object.transitions[6].id == "t4_yellow" && object.transitions[7].id == "t5_yellow";
+        expect(ordered, "valid: the object form lists transitions in term order, * terms once per state");
+        expect(object.states[0].isInitial && object.transitions[2].input == "---" && object.transitions[2].output == "10",
+               "valid: the object form keeps the initial state and the cube labels");
+
+        for (size_t chunk = 1; chunk < std::strlen(Valid); chunk++)
+        {
+            if (!sameGraph(parse(Valid, chunk), machine))
+            {
+                expect(false, "valid: chunks of " + std::to_string(chunk) + " bytes give the same graph");
+                break;
+            }
+        }
+
+        // Parsing starts over after finish
+        KissParser parser;
+        parser.feed(Valid, std::strlen(Valid));
+        parser.finish();
+        const char *other = ".i 1\n1 a b\n";
+        parser.feed(other, std::strlen(other));
+        KissMachine second = parser.finish();
+        expect(second.outputBits == 0 && second.productTerms == 1 && second.graph.stateIds.size() == 2 &&
+                   second.graph.initialState == 0 && second.graph.edgeOutputs[0] == CompiledMachine::NoOutput,
+               "valid: a reused parser forgets the previous machine");
+
+        std::string text = ".i 64\n" + std::string(64, '-') + " s s\n";
+        KissMachine all = parse(text.c_str(), 7);
+        expect(all.mintermCount(0) == UINT64_MAX, "valid: a 64-bit don't-care saturates the minterm count");
+    }
+
+    void malformed(const std::string &text, uint64_t line, const std::string &what)
+    {
+        std::string message;
+        try
+        {
+            parse(text.c_str(), 5);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            message = e.what();
+        }
+        const std::string prefix = "KISS2 line " + std::to_string(line) + ": ";
+        expect(message.compare(0, prefix.size(), prefix) == 0,
+               "malformed: " + what + " (got \"" + message + "\")");
+    }
+} // namespace
+
+int main()
+{
+    valid();
+
+    malformed(".i 2\n.o 1\n10 a b 0\n10 a b\n", 4, "a missing field");
+    malformed(".i 2\n.o 1\n10 a b 0 1\n", 3, "an extra field");
+    malformed(".i 2\n.o 1\n10 a b 0 1 1\n", 3, "too many fields");
+    malformed(".i 2\n.o 1\n1x a b 0\n", 3, "a bad cube character");
+    malformed(".i 2\n.o 1\n100 a b 0\n", 3, "a cube of the wrong width");
+    malformed(".i 2\n.o 1\n10 a b 01\n", 3, "an output of the wrong width");
+    malformed(".i 2\n.o 1\n10 a * 0\n", 3, "* as the next state");
+    malformed(".i 2\n10 a b\n.o 1\n", 3, ".o after the product terms");
+    malformed(".i\n", 1, ".i without a number");
+    malformed(".i 65\n", 1, "more than 64 inputs");
+    malformed(".i 2x\n", 1, "a malformed number");
+    malformed(".i 99999999999999\n", 1, "a number out of range");
+    malformed(".i 1\n\n# comment\n1 a", 4, "a last line without newline");
+
+    if (failures)
+    {
+        std::printf("FAIL: %d KISS2 check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: KISS2 machines parse as written\n");
+    return 0;
+}
@@ -0,0 +1,205 @@
+/**
+ * HdrHistogram buckets and quantiles, and the Prometheus export: every
+ * bucket boundary maps back to its bucket, values past 2^MaxBits share the
+ * last one, quantiles of random samples stay within 1/SubBuckets above the
+ * exact order statistic, records from several threads all count, and a
+ * registry with labelled counter and summary families exports each family
+ * once, in registration order, with the quantile label appended.
+ *
+ * Build: node-gyp build (target metrics_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/MetricsTest.cpp \
+ *       engine/src/Metrics.cpp -lpthread
+ */
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    void buckets()
+    {
+        using H = HdrHistogram;
+        bool exact = true;
+        for (uint64_t v = 0; v < H::SubBuckets; v++)
+            exact = exact && H::bucketOf(v) == v && H::highestEquivalent(v) == v;
+        expect(exact, "buckets: values below SubBuckets have buckets of their own");
+
+        // Each bucket starts right after the previous one ends and is at
+        // most 1/SubBuckets of its lowest value wide
+        bool contiguous = true, narrow = true;
+        for (size_t b = 1; b < H::BucketCount && contiguous; b++)
+        {
+            const uint64_t lowest = H::highestEquivalent(b - 1) + 1;
+            const uint64_t highest = H::highestEquivalent(b);
+            contiguous = H::bucketOf(lowest) == b && H::bucketOf(highest) == b && lowest <= highest;
+            narrow = narrow && (highest - lowest) * H::SubBuckets < lowest;
+        }
+        expect(contiguous, "buckets: boundaries map back to their buckets");
+        expect(narrow, "buckets: relative width at most 1/SubBuckets");
+
+        const uint64_t limit = uint64_t(1) << H::MaxBits;
+        expect(H::highestEquivalent(H::BucketCount - 1) == limit - 1, "buckets: the last bucket ends below 2^MaxBits");
+        expect(H::bucketOf(limit) == H::BucketCount - 1 && H::bucketOf(UINT64_MAX) == H::BucketCount - 1,
+               "buckets: larger values fall in the last bucket");
+    }
+
+    void quantiles()
+    {
+        HdrHistogram empty;
+        expect(empty.snapshot().count == 0 && empty.snapshot().quantile(0.5) == 0, "quantiles: 0 when empty");
+
+        std::mt19937_64 rng(23);
+        for (int run = 0; run < 20; run++)
+        {
+            // Log-uniform up to 2^(10..47), so every range of buckets is used
+            const unsigned bits = 10 + static_cast<unsigned>(rng() % 38);
+            std::vector<uint64_t> values(1 + rng() % 5000);
+            HdrHistogram histogram;
+            uint64_t sum = 0;
+            for (auto &value : values)
+            {
+                value = rng() >> (64 - 1 - rng() % bits);
+                histogram.record(value);
+                sum += value;
+            }
+            std::sort(values.begin(), values.end());
+            HdrHistogram::Snapshot snapshot = histogram.snapshot();
+            const std::string name = "quantiles: run " + std::to_string(run);
+            expect(snapshot.count == values.size() && snapshot.sum == sum && snapshot.max == values.back(),
+                   name + ": count, sum and max are exact");
+
+            for (double q : {0.0, 0.001, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0})
+            {
+                const size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(q * values.size())));
+                const uint64_t expected = values[rank - 1];
+                const uint64_t reported = snapshot.quantile(q);
+                if (reported < expected || reported - expected > expected / HdrHistogram::SubBuckets ||
+                    reported > snapshot.max)
+                {
+                    expect(false, name + ", q=" + std::to_string(q) + ": " + std::to_string(reported) +
+                                      " is not within 1/SubBuckets above " + std::to_string(expected));
+                }
+            }
+        }
+
+        HdrHistogram huge;
+        huge.record(uint64_t(1) << 60);
+        expect(huge.snapshot().quantile(0.5) == (uint64_t(1) << HdrHistogram::MaxBits) - 1,
+               "quantiles: values past 2^MaxBits report the last bucket's limit");
+    }
+
+    void threads()
+    {
+        HdrHistogram histogram;
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < 12; t++)
+        {
+            workers.emplace_back([&histogram, t]
+                                 {
+                                     for (uint64_t i = 0; i < 20000; i++)
+                                         histogram.record(i * (t + 1)); });
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        HdrHistogram::Snapshot snapshot = histogram.snapshot();
+        const uint64_t perThread = 20000ull * 19999 / 2;
+        expect(snapshot.count == 12 * 20000 && snapshot.sum == perThread * 78 && snapshot.max == 19999 * 12,
+               "threads: records from every shard are merged");
+    }
+
+    void prometheus()
+    {
+        MetricsRegistry registry;
+        Counter &verify = registry.counter("requests_total", "Requests served", "call=\"verify\"");
+        HdrHistogram &latency = registry.histogram("latency_seconds", "Call latency", "call=\"verify\"", 1e-3);
+        registry.counter("requests_total", "Requests served", "call=\"simulate\"");
+        registry.histogram("latency_seconds", "Call latency", "call=\"simulate\"", 1e-3);
+        registry.counter("up", "Up").add();
+
+        verify.add(2);
+        registry.counter("requests_total", "Requests served", "call=\"verify\"").add();
+        latency.record(10);
+        latency.record(20);
+        expect(&registry.histogram("latency_seconds", "Call latency", "call=\"verify\"") == &latency,
+               "prometheus: a name and label set registers once");
+
+        bool thrown = false;
+        try
+        {
+            registry.histogram("requests_total", "Requests served", "call=\"other\"");
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown = true;
+        }
+        expect(thrown, "prometheus: a family keeps one type across label sets");
+
+        const std::string expected = "# HELP requests_total Requests served\n"
+                                     "# TYPE requests_total counter\n"
+                                     "requests_total{call=\"verify\"} 3\n"
+                                     "requests_total{call=\"simulate\"} 0\n"
+                                     "# HELP latency_seconds Call latency\n"
+                                     "# TYPE latency_seconds summary\n"
+                                     "latency_seconds{call=\"verify\",quantile=\"0.5\"} 0.01\n"
+                                     "latency_seconds{call=\"verify\",quantile=\"0.9\"} 0.02\n"
+                                     "latency_seconds{call=\"verify\",quantile=\"0.99\"} 0.02\n"
+                                     "latency_seconds{call=\"verify\",quantile=\"0.999\"} 0.02\n"
+                                     "latency_seconds_sum{call=\"verify\"} 0.03\n"
+                                     "latency_seconds_count{call=\"verify\"} 2\n"
+                                     "latency_seconds{call=\"simulate\",quantile=\"0.5\"} 0\n"
+                                     "latency_seconds{call=\"simulate\",quantile=\"0.9\"} 0\n"
+                                     "latency_seconds{call=\"simulate\",quantile=\"0.99\"} 0\n"
+                                     "latency_seconds{call=\"simulate\",quantile=\"0.999\"} 0\n"
+                                     "latency_seconds_sum{call=\"simulate\"} 0\n"
+                                     "latency_seconds_count{call=\"simulate\"} 0\n"
+                                     "# HELP latency_seconds_max Largest value of latency_seconds\n"
+                                     "# TYPE latency_seconds_max gauge\n"
+                                     "latency_seconds_max{call=\"verify\"} 0.02\n"
+                                     "latency_seconds_max{call=\"simulate\"} 0\n"
+                                     "# HELP up Up\n"
+                                     "# TYPE up counter\n"
+                                     "up 1\n";
+        const std::string text = registry.prometheusText();
+        expect(text == expected, "prometheus: labelled families export once each, got:\n" + text);
+
+        MetricsRegistry unlabelled;
+        unlabelled.histogram("steps", "Steps").record(5);
+        expect(unlabelled.prometheusText().find("steps{quantile=\"0.5\"} 5\nsteps{quantile=\"0.9\"} 5\n") != std::string::npos,
+               "prometheus: an unlabelled summary gets the quantile label alone");
+    }
+} // namespace
+
+int main()
+{
+    buckets();
+    quantiles();
+    threads();
+    prometheus();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d metrics check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: histogram buckets, quantiles and export as documented\n");
+    return 0;
+}
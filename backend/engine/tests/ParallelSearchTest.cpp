@@ -0,0 +1,236 @@
+/**
+ * The multi-threaded searches against sequential references on charts
+ * small enough to enumerate: work-stealing findDeadlocks must store every
+ * configuration StatechartExplorer::explore finds and report the same
+ * deadlocks, and CNDFS findCycle must agree with a plain cycle check over
+ * the enumerated configuration graph, for one thread and for several.
+ *
+ * Build: node-gyp build (target parallel_search_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/ParallelSearchTest.cpp \
+ *       engine/src/ParallelSearch.cpp engine/src/ConcurrentStateSet.cpp \
+ *       engine/src/Scxml.cpp engine/src/Statechart.cpp \
+ *       engine/src/Checkpoint.cpp engine/src/ReportCache.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "ParallelSearch.h"
+#include "Scxml.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    std::vector<std::vector<std::string>> sorted(std::vector<std::vector<std::string>> configurations)
+    {
+        for (auto &configuration : configurations)
+            std::sort(configuration.begin(), configuration.end());
+        std::sort(configurations.begin(), configurations.end());
+        return configurations;
+    }
+
+    /**
+     * Every stable configuration and its successors, enumerated with the
+     * sequential successor function
+     */
+    struct ConfigurationGraph
+    {
+        std::vector<std::vector<uint64_t>> keys;
+        std::vector<std::vector<uint32_t>> successors;
+
+        explicit ConfigurationGraph(const Statechart &chart)
+        {
+            StatechartExplorer explorer(chart);
+            const size_t words = explorer.keyWords();
+            std::map<std::vector<uint64_t>, uint32_t> index;
+            auto add = [&](const uint64_t *key)
+            {
+                auto inserted = index.emplace(std::vector<uint64_t>(key, key + words), static_cast<uint32_t>(keys.size()));
+                if (inserted.second)
+                {
+                    keys.push_back(inserted.first->first);
+                    successors.emplace_back();
+                }
+                return inserted.first->second;
+            };
+
+            std::vector<uint64_t> out;
+            explorer.initial(out);
+            for (size_t i = 0; i < out.size(); i += words)
+                add(out.data() + i);
+            for (uint32_t c = 0; c < keys.size(); c++)
+            {
+                if (explorer.terminated(keys[c].data()))
+                    continue;
+                for (int32_t event : chart.externalEvents)
+                {
+                    out.clear();
+                    std::vector<uint64_t> key = keys[c];
+                    if (!explorer.step(key.data(), event, out))
+                        continue;
+                    for (size_t i = 0; i < out.size(); i += words)
+                    {
+                        uint32_t next = add(out.data() + i);
+                        successors[c].push_back(next);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Some configuration where inside(c) holds lies on a cycle of such
+         * configurations
+         */
+        template <class Inside>
+        bool cycle(Inside inside, bool throughAll) const
+        {
+            for (uint32_t start = 0; start < keys.size(); start++)
+            {
+                if (!inside(start))
+                    continue;
+                std::vector<uint8_t> seen(keys.size(), 0);
+                std::vector<uint32_t> queue{start};
+                for (size_t head = 0; head < queue.size(); head++)
+                {
+                    for (uint32_t next : successors[queue[head]])
+                    {
+                        if (next == start)
+                            return true;
+                        if (!seen[next] && (!throughAll || inside(next)))
+                        {
+                            seen[next] = 1;
+                            queue.push_back(next);
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    bool active(const Statechart &chart, const std::vector<uint64_t> &key, const std::string &id)
+    {
+        int32_t node = chart.findNode(id);
+        return node >= 0 && (key[node / 64] >> (node % 64)) & 1;
+    }
+
+    void deadlocks(const std::string &name, const Statechart &chart)
+    {
+        StatechartReport sequential = StatechartExplorer::explore(chart, 1000000);
+        for (unsigned threads : {1u, 2u, 4u})
+        {
+            const std::string run = name + " on " + std::to_string(threads) + " thread(s)";
+            ParallelSearchOptions options;
+            options.threads = threads;
+            ParallelDeadlockReport parallel = ParallelSearch::findDeadlocks(chart, options);
+            expect(parallel.complete && parallel.threads == threads, run + ": completes");
+            expect(parallel.states == sequential.configurations, run + ": same configurations");
+            expect(parallel.transitions == sequential.macrosteps, run + ": same macrosteps");
+            expect(parallel.deadlockCount == sequential.deadlockCount, run + ": same deadlock count");
+            expect(sorted(parallel.deadlocks) == sorted(sequential.deadlocks), run + ": same deadlocked configurations");
+        }
+    }
+
+    void cycles(const std::string &name, const Statechart &chart, const std::vector<std::string> &marked)
+    {
+        ConfigurationGraph graph(chart);
+        auto isMarked = [&](uint32_t c)
+        {
+            for (const auto &id : marked)
+            {
+                if (active(chart, graph.keys[c], id))
+                    return true;
+            }
+            return false;
+        };
+        const bool accepting = graph.cycle(isMarked, false);
+        const bool nonProgress = graph.cycle([&](uint32_t c)
+                                             { return !isMarked(c); },
+                                             true);
+
+        for (unsigned threads : {1u, 2u, 4u})
+        {
+            const std::string run = name + " on " + std::to_string(threads) + " thread(s)";
+            ParallelSearchOptions options;
+            options.threads = threads;
+            options.seed = threads;
+            CycleReport acceptance = ParallelSearch::findCycle(chart, CycleProperty::Acceptance, marked, options);
+            expect(acceptance.complete, run + ": acceptance search completes");
+            expect(acceptance.cycleFound == accepting, run + ": accepting cycle verdict");
+            expect(!acceptance.cycleFound || !acceptance.cycle.empty(), run + ": the accepting cycle is reported");
+
+            CycleReport progress = ParallelSearch::findCycle(chart, CycleProperty::NonProgress, marked, options);
+            expect(progress.complete, run + ": non-progress search completes");
+            expect(progress.cycleFound == nonProgress, run + ": non-progress cycle verdict");
+        }
+    }
+
+    /**
+     * Three orthogonal regions of four states each, every region cycling
+     * on its own event
+     */
+    std::string regions()
+    {
+        std::string document = "<scxml initial=\"R\"><parallel id=\"R\">";
+        for (int r = 0; r < 3; r++)
+        {
+            std::string region = "r" + std::to_string(r);
+            document += "<state id=\"" + region + "\">";
+            for (int s = 0; s < 4; s++)
+            {
+                document += "<state id=\"" + region + "_" + std::to_string(s) + "\"><transition event=\"e" +
+                            std::to_string(r) + "\" target=\"" + region + "_" + std::to_string((s + 1) % 4) +
+                            "\"/></state>";
+            }
+            document += "</state>";
+        }
+        return document + "</parallel></scxml>";
+    }
+
+    /**
+     * X and Y alternate on a; b detours from X through M; d leaves for
+     * good, to a deadlock in D or, past a guard that may fail, to T
+     */
+    const char *detours = "<scxml initial=\"X\">"
+                          "<state id=\"X\"><transition event=\"a\" target=\"Y\"/><transition event=\"b\" target=\"M\"/>"
+                          "<transition event=\"d\" cond=\"ok\" target=\"T\"/><transition event=\"d\" target=\"D\"/></state>"
+                          "<state id=\"Y\"><transition event=\"a\" target=\"X\"/></state>"
+                          "<state id=\"M\"><transition event=\"c\" target=\"X\"/></state>"
+                          "<state id=\"D\"/><final id=\"T\"/>"
+                          "</scxml>";
+} // namespace
+
+int main()
+{
+    const Statechart product = statechartFromScxml(regions());
+    const Statechart detour = statechartFromScxml(detours);
+
+    deadlocks("regions", product);
+    deadlocks("detours", detour);
+
+    cycles("regions through r0_0", product, {"r0_0"});
+    cycles("detours through M", detour, {"M"});
+    cycles("detours through X", detour, {"X"});
+    cycles("detours through D", detour, {"D"});
+
+    if (failures)
+    {
+        std::printf("FAIL: %d parallel search check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: parallel searches match the sequential references\n");
+    return 0;
+}
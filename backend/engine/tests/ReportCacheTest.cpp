@@ -0,0 +1,105 @@
+/**
+ * The machine hash keys the report cache and shares in-flight runs, so two
+ * machines may share a hash only when their reports agree: reordering
+ * conflicting statechart transitions, or the initial states of a flat
+ * machine, must change it, while reordering a plain flat machine must not.
+ *
+ * Build: node-gyp build (target report_cache_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/ReportCacheTest.cpp \
+ *       engine/src/ReportCache.cpp engine/src/Verifier.cpp \
+ *       engine/src/Statechart.cpp engine/src/Checkpoint.cpp \
+ *       engine/src/VerificationStats.cpp engine/src/Trace.cpp \
+ *       engine/src/Json.cpp -lpthread
+ */
+#include "ReportCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            failures++;
+        }
+    }
+
+    State state(const std::string &id, bool initial, const std::string &parent = "")
+    {
+        State result;
+        result.id = id;
+        result.name = id;
+        result.isInitial = initial;
+        result.parent = parent;
+        return result;
+    }
+
+    Transition transition(const std::string &id, const std::string &from, const std::string &to)
+    {
+        return Transition{id, from, to, "go", "", "", ""};
+    }
+
+    /**
+     * A and its two conflicting "go" transitions, to B and to C, nested
+     * in P; the first in document order wins
+     */
+    StateMachine conflicting()
+    {
+        StateMachine machine;
+        machine.id = "conflict";
+        machine.name = "conflict";
+        machine.type = "mealy";
+        machine.states = {state("P", true), state("A", true, "P"), state("B", false, "P"), state("C", false, "P")};
+        machine.transitions = {transition("t1", "A", "B"), transition("t2", "A", "C")};
+        return machine;
+    }
+
+    StateMachine flat()
+    {
+        StateMachine machine;
+        machine.id = "flat";
+        machine.name = "flat";
+        machine.type = "mealy";
+        machine.states = {state("A", true), state("B", false), state("C", false)};
+        machine.transitions = {transition("t1", "A", "B"), transition("t2", "B", "C"), transition("t3", "C", "A")};
+        return machine;
+    }
+} // namespace
+
+int main()
+{
+    StateMachine first = conflicting();
+    StateMachine second = conflicting();
+    std::reverse(second.transitions.begin(), second.transitions.end());
+    expect(Verifier::generateReport(first).warnings != Verifier::generateReport(second).warnings,
+           "reordered conflicting transitions give different reports");
+    expect(!(canonicalHash(first) == canonicalHash(second)),
+           "reordered conflicting transitions hash differently");
+
+    StateMachine reordered = flat();
+    std::reverse(reordered.states.begin(), reordered.states.end());
+    std::reverse(reordered.transitions.begin(), reordered.transitions.end());
+    expect(canonicalHash(flat()) == canonicalHash(reordered), "a reordered flat machine keeps its hash");
+
+    StateMachine twoInitial = flat();
+    twoInitial.states[1].isInitial = true;
+    StateMachine swapped = twoInitial;
+    std::swap(swapped.states[0], swapped.states[1]);
+    expect(!(canonicalHash(twoInitial) == canonicalHash(swapped)),
+           "reordered initial states of a flat machine hash differently");
+
+    if (failures)
+    {
+        std::printf("FAIL: %d check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: machine hashes follow report-relevant order\n");
+    return 0;
+}
@@ -0,0 +1,475 @@
+/**
+ * SCXML semantics of the configuration explorer on small charts whose
+ * reachable configurations are known: parallel products, history, done
+ * events, unknown guards, eventless unknown guards in orthogonal regions,
+ * more deadlocks than the report lists, and resuming checkpoints taken at
+ * the configuration limit (corrupt ones must be rejected), plus the charts
+ * Statechart::finalize must reject rather than explore forever.
+ *
+ * Build: node-gyp build (target statechart_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/StatechartTest.cpp \
+ *       engine/src/Scxml.cpp engine/src/Statechart.cpp \
+ *       engine/src/Checkpoint.cpp engine/src/ReportCache.cpp \
+ *       engine/src/Verifier.cpp engine/src/VerificationStats.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "Scxml.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            failures++;
+        }
+    }
+
+    StatechartReport explore(const std::string &document, size_t maxConfigurations = 1000000)
+    {
+        return StatechartExplorer::explore(statechartFromScxml(document), maxConfigurations);
+    }
+
+    bool rejects(const std::string &document)
+    {
+        try
+        {
+            statechartFromScxml(document);
+            return false;
+        }
+        catch (const std::invalid_argument &)
+        {
+            return true;
+        }
+    }
+
+    /**
+     * Three orthogonal regions of four states each, every region cycling
+     * on its own event: 4^3 configurations, none of them a deadlock
+     */
+    std::string regions()
+    {
+        std::string document = "<scxml initial=\"R\"><parallel id=\"R\">";
+        for (int r = 0; r < 3; r++)
+        {
+            std::string region = "r" + std::to_string(r);
+            document += "<state id=\"" + region + "\">";
+            for (int s = 0; s < 4; s++)
+            {
+                document += "<state id=\"" + region + "_" + std::to_string(s) + "\"><transition event=\"e" +
+                            std::to_string(r) + "\" target=\"" + region + "_" + std::to_string((s + 1) % 4) +
+                            "\"/></state>";
+            }
+            document += "</state>";
+        }
+        return document + "</parallel></scxml>";
+    }
+
+    State state(const std::string &id, bool initial, const std::string &parent = "", const std::string &kind = "")
+    {
+        State result;
+        result.id = id;
+        result.name = id;
+        result.isInitial = initial;
+        result.parent = parent;
+        result.kind = kind;
+        return result;
+    }
+
+    void parallelProduct()
+    {
+        StatechartReport report = explore(regions());
+        expect(report.complete, "parallel regions: exploration completes");
+        expect(report.configurations == 64, "parallel regions: 4^3 configurations");
+        expect(report.deadlockCount == 0, "parallel regions: no deadlock");
+        expect(report.unreachableStates.empty(), "parallel regions: every state reached");
+        expect(statechartFromScxml(regions()).flattenedSize() == 64, "parallel regions: flattened size");
+
+        StatechartReport limited = explore(regions(), 10);
+        expect(!limited.complete && limited.stopReason == StopReason::ConfigurationLimit,
+               "parallel regions: the configuration limit makes the report partial");
+        expect(limited.configurations == 10, "parallel regions: stops adding at the limit");
+    }
+
+    /**
+     * Name of the first finding that differs, or nullptr
+     */
+    const char *difference(const StatechartReport &a, const StatechartReport &b)
+    {
+        if (a.complete != b.complete || a.configurations != b.configurations || a.expanded != b.expanded)
+            return "configurations";
+        if (a.macrosteps != b.macrosteps || a.terminalConfigurations != b.terminalConfigurations)
+            return "macrosteps";
+        if (a.divergentMacrosteps != b.divergentMacrosteps)
+            return "divergentMacrosteps";
+        if (a.deadlockCount != b.deadlockCount || a.deadlocks != b.deadlocks || a.deadlockedStates != b.deadlockedStates)
+            return "deadlocks";
+        if (a.deadlockPath != b.deadlockPath)
+            return "deadlockPath";
+        if (a.unreachableStates != b.unreachableStates)
+            return "unreachableStates";
+        return nullptr;
+    }
+
+    /**
+     * The records file of the one checkpoint in directory
+     */
+    std::string recordsFile(const std::string &directory)
+    {
+        std::string found;
+        if (DIR *dir = opendir(directory.c_str()))
+        {
+            while (dirent *entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                if (name.size() > 5 && name.compare(name.size() - 5, 5, ".ckpt") == 0)
+                    found = directory + "/" + name;
+            }
+            closedir(dir);
+        }
+        return found;
+    }
+
+    /**
+     * Twelve branches of two states out of A, each ending in a deadlock
+     */
+    Statechart deadlockingChart()
+    {
+        StateMachine machine;
+        machine.states = {state("A", true)};
+        for (int i = 0; i < 12; i++)
+        {
+            std::string branch = "b" + std::to_string(i);
+            machine.states.push_back(state(branch + "_0", false));
+            machine.states.push_back(state(branch + "_1", false));
+            machine.transitions.push_back(Transition{branch + "a", "A", branch + "_0", "go" + std::to_string(i), "", "", ""});
+            machine.transitions.push_back(Transition{branch + "b", branch + "_0", branch + "_1", "next", "", "", ""});
+        }
+        return Statechart::fromStateMachine(machine);
+    }
+
+    void resumeAfterLimit()
+    {
+        // A run stopped at the limit leaves a checkpoint; resuming it with
+        // larger limits must find what a fresh run finds
+        char directory[] = "/tmp/statechart_test_XXXXXX";
+        if (!mkdtemp(directory))
+        {
+            expect(false, "checkpoint resume: temporary directory");
+            return;
+        }
+        CheckpointOptions checkpoint;
+        checkpoint.directory = directory;
+        const Statechart chart = statechartFromScxml(regions());
+
+        StatechartReport limited = StatechartExplorer::explore(chart, 10, AnalysisBudget(), checkpoint);
+        expect(!limited.complete && limited.configurations == 10, "checkpoint resume: first run stops at the limit");
+        StatechartReport resumed = StatechartExplorer::explore(chart, 1000000, AnalysisBudget(), checkpoint);
+        expect(resumed.complete, "checkpoint resume: resumed run completes");
+        expect(resumed.configurations == 64, "checkpoint resume: dropped successors are explored");
+        expect(resumed.macrosteps == 64 * 3, "checkpoint resume: macrosteps are counted once");
+        expect(resumed.unreachableStates.empty(), "checkpoint resume: every state reached");
+
+        // Stopping at several limits in a row, deadlocks included
+        const Statechart deadlocking = deadlockingChart();
+        StatechartReport full = StatechartExplorer::explore(deadlocking, 1000000);
+        StatechartReport last;
+        for (size_t limit = 3; limit <= 1000000; limit *= 3)
+        {
+            last = StatechartExplorer::explore(deadlocking, limit, AnalysisBudget(), checkpoint);
+            if (last.complete)
+                break;
+        }
+        expect(full.complete && full.deadlockCount == 12, "checkpoint resume: the fresh run finds every deadlock");
+        const char *field = difference(last, full);
+        if (field)
+            std::fprintf(stderr, "checkpoint resume: %s differs from a fresh run\n", field);
+        expect(!field, "checkpoint resume: repeated resumes report what a fresh run does");
+
+        std::string command = std::string("rm -rf ") + directory;
+        std::system(command.c_str());
+    }
+
+    /**
+     * Stop a run at the limit, damage its records with edit, then resume
+     */
+    bool resumeThrows(void (*edit)(const std::string &records, size_t recordBytes))
+    {
+        char directory[] = "/tmp/statechart_test_XXXXXX";
+        if (!mkdtemp(directory))
+            return false;
+        CheckpointOptions checkpoint;
+        checkpoint.directory = directory;
+        const Statechart chart = statechartFromScxml(regions());
+        StatechartExplorer::explore(chart, 10, AnalysisBudget(), checkpoint);
+
+        edit(recordsFile(directory), StatechartExplorer(chart).keyWords() * sizeof(uint64_t) + 2 * sizeof(uint32_t));
+        bool thrown = false;
+        try
+        {
+            StatechartExplorer::explore(chart, 1000000, AnalysisBudget(), checkpoint);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        std::string command = std::string("rm -rf ") + directory;
+        std::system(command.c_str());
+        return thrown;
+    }
+
+    /**
+     * Overwrite the parent and event of the last of the ten saved records
+     */
+    void relink(const std::string &records, size_t recordBytes, uint32_t parent, int32_t event)
+    {
+        const size_t header = 32;
+        if (FILE *file = std::fopen(records.c_str(), "r+b"))
+        {
+            std::fseek(file, static_cast<long>(header + 10 * recordBytes - 2 * sizeof(uint32_t)), SEEK_SET);
+            std::fwrite(&parent, sizeof(parent), 1, file);
+            std::fwrite(&event, sizeof(event), 1, file);
+            std::fclose(file);
+        }
+    }
+
+    void corruptCheckpoints()
+    {
+        expect(resumeThrows([](const std::string &records, size_t recordBytes)
+                            { expect(truncate(records.c_str(), static_cast<off_t>(32 + 5 * recordBytes)) == 0,
+                                     "corrupt checkpoint: truncate the records"); }),
+               "corrupt checkpoint: truncated records are rejected");
+        expect(resumeThrows([](const std::string &records, size_t recordBytes)
+                            { relink(records, recordBytes, 9, 0); }),
+               "corrupt checkpoint: a record that is its own parent is rejected");
+        expect(resumeThrows([](const std::string &records, size_t recordBytes)
+                            { relink(records, recordBytes, 0, 1000); }),
+               "corrupt checkpoint: an event outside the chart is rejected");
+        expect(resumeThrows([](const std::string &records, size_t recordBytes)
+                            { relink(records, recordBytes, 0, Statechart::NoEvent); }),
+               "corrupt checkpoint: a child record without an event is rejected");
+    }
+
+    void history()
+    {
+        // Leaving P from B and coming back through h restores B, not the
+        // default A; restoring A would add {P, A} with h = B
+        const std::string document =
+            "<scxml initial=\"P\">"
+            "<state id=\"P\" initial=\"A\">"
+            "<history id=\"h\" type=\"shallow\"><transition target=\"A\"/></history>"
+            "<state id=\"A\"><transition event=\"next\" target=\"B\"/></state>"
+            "<state id=\"B\"><transition event=\"leave\" target=\"Q\"/></state>"
+            "</state>"
+            "<state id=\"Q\"><transition event=\"back\" target=\"h\"/></state>"
+            "</scxml>";
+        StatechartReport report = explore(document);
+        expect(report.complete, "history: exploration completes");
+        expect(report.configurations == 4, "history: re-entry restores the recorded state");
+        expect(report.deadlockCount == 0, "history: no deadlock");
+    }
+
+    void doneEvents()
+    {
+        // Reaching F raises done.state.P, which leaves P for Z
+        const std::string document =
+            "<scxml initial=\"P\">"
+            "<state id=\"P\" initial=\"X\">"
+            "<state id=\"X\"><transition event=\"go\" target=\"F\"/></state>"
+            "<final id=\"F\"/>"
+            "<transition event=\"done.state.P\" target=\"Z\"/>"
+            "</state>"
+            "<state id=\"Z\"/>"
+            "</scxml>";
+        StatechartReport report = explore(document);
+        expect(report.configurations == 2, "done events: F is only passed through");
+        expect(report.deadlockCount == 1 && report.deadlocks.size() == 1 &&
+                   report.deadlocks[0] == std::vector<std::string>{"Z"},
+               "done events: Z is the only deadlock");
+        expect(report.deadlockPath == std::vector<std::string>{"go"}, "done events: deadlock path");
+        expect(report.unreachableStates.empty(), "done events: F counts as entered");
+    }
+
+    void manyDeadlocks()
+    {
+        // More deadlocked configurations than the report lists: the states
+        // in them must all be known to the yes/no queries
+        const int count = static_cast<int>(StatechartReport::MaxReportedDeadlocks) + 8;
+        StateMachine machine;
+        machine.states = {state("P", true), state("A", true, "P")};
+        for (int i = 0; i < count; i++)
+        {
+            std::string id = "d" + std::to_string(i);
+            machine.states.push_back(state(id, false, "P"));
+            machine.transitions.push_back(Transition{"t" + std::to_string(i), "A", id, "g" + std::to_string(i), "", "", ""});
+        }
+
+        StatechartReport report = StatechartExplorer::explore(Statechart::fromStateMachine(machine), 1000000);
+        expect(report.complete && report.deadlockCount == static_cast<uint64_t>(count), "many deadlocks: all counted");
+        expect(report.deadlocks.size() == StatechartReport::MaxReportedDeadlocks, "many deadlocks: listed up to the cap");
+        expect(report.deadlockedStates.size() == static_cast<size_t>(count), "many deadlocks: every deadlocked state");
+
+        std::vector<std::string> found = Verifier::findDeadlocks(machine);
+        expect(found.size() == static_cast<size_t>(count), "many deadlocks: findDeadlocks is not capped");
+        std::string last = "d" + std::to_string(count - 1);
+        expect(Verifier::isDeadlock(machine, last), "many deadlocks: isDeadlock past the cap");
+        expect(!Verifier::isDeadlock(machine, "A"), "many deadlocks: A is not deadlocked");
+
+        Verifier::VerificationReport verification = Verifier::generateReport(machine);
+        expect(std::count(verification.deadlocks.begin(), verification.deadlocks.end(), last) == 1,
+               "many deadlocks: the report names every deadlocked state");
+    }
+
+    void unknownGuards()
+    {
+        // The guard of the first "go" may fail, so both transitions fire;
+        // a top-level final state terminates the chart rather than deadlocks
+        const std::string document =
+            "<scxml initial=\"A\">"
+            "<state id=\"A\">"
+            "<transition event=\"go\" cond=\"x &gt; 0\" target=\"B\"/>"
+            "<transition event=\"go\" target=\"C\"/>"
+            "<transition event=\"never\" cond=\"false\" target=\"U\"/>"
+            "</state>"
+            "<final id=\"B\"/><final id=\"C\"/><state id=\"U\"/>"
+            "</scxml>";
+        StatechartReport report = explore(document);
+        expect(report.configurations == 3, "unknown guards: both branches are explored");
+        expect(report.terminalConfigurations == 2, "unknown guards: final states terminate");
+        expect(report.deadlockCount == 0, "unknown guards: terminated is not deadlocked");
+        expect(report.unreachableStates == std::vector<std::string>{"U"}, "unknown guards: cond=\"false\" never fires");
+    }
+
+    void parallelGuards()
+    {
+        // Each region toggles on an unknown eventless guard, so every
+        // microstep forks four ways; a macrostep must visit each of the
+        // few distinct items once rather than every interleaving
+        const std::string document =
+            "<scxml initial=\"P\"><parallel id=\"P\">"
+            "<state id=\"r1\" initial=\"A1\">"
+            "<state id=\"A1\"><transition cond=\"x\" target=\"B1\"/><transition event=\"tick\" target=\"A1\"/></state>"
+            "<state id=\"B1\"><transition cond=\"x\" target=\"A1\"/></state>"
+            "</state>"
+            "<state id=\"r2\" initial=\"A2\">"
+            "<state id=\"A2\"><transition cond=\"y\" target=\"B2\"/></state>"
+            "<state id=\"B2\"><transition cond=\"y\" target=\"A2\"/></state>"
+            "</state>"
+            "</parallel></scxml>";
+        AnalysisBudget budget;
+        budget.time = std::chrono::seconds(2);
+        StatechartReport report = StatechartExplorer::explore(statechartFromScxml(document), 1000000, budget);
+        expect(report.complete, "parallel guards: exploration completes within the budget");
+        expect(report.configurations == 4, "parallel guards: four configurations");
+        expect(report.divergentMacrosteps > 0, "parallel guards: the toggles can fire forever");
+        expect(report.unreachableStates.empty(), "parallel guards: every state reached");
+    }
+
+    void internalEvents()
+    {
+        // ping is only raised, and caught by B's wildcard within the
+        // macrostep; the environment never sends it
+        const Statechart chart = statechartFromScxml(
+            "<scxml initial=\"P\">"
+            "<state id=\"P\" initial=\"A\">"
+            "<state id=\"A\"><transition event=\"go\" target=\"B\"><raise event=\"ping\"/></transition></state>"
+            "<state id=\"B\"><transition event=\"*\" target=\"C\"/></state>"
+            "<final id=\"C\"/>"
+            "</state>"
+            "</scxml>");
+        std::vector<std::string> external;
+        for (int32_t event : chart.externalEvents)
+            external.push_back(chart.events[event]);
+        expect(external == std::vector<std::string>{"go"}, "internal events: raised and done events are not external");
+
+        StatechartReport report = StatechartExplorer::explore(chart, 1000000);
+        expect(report.configurations == 2, "internal events: B is only passed through");
+        expect(report.deadlockCount == 1, "internal events: nothing leaves C");
+    }
+
+    void malformedCharts()
+    {
+        expect(rejects("<scxml initial=\"P\"><state id=\"P\">"
+                       "<history id=\"h1\"><transition target=\"h2\"/></history>"
+                       "<history id=\"h2\"><transition target=\"h1\"/></history>"
+                       "<state id=\"A\"/></state></scxml>"),
+               "histories defaulting to each other are rejected");
+        expect(rejects("<scxml initial=\"P\"><state id=\"P\" initial=\"h\">"
+                       "<history id=\"h\"/><state id=\"A\"/></state></scxml>"),
+               "a history defaulting to its parent's initial history is rejected");
+        expect(rejects("<scxml initial=\"A\"><state id=\"A\"><transition target=\"B\"/></state></scxml>"),
+               "unknown targets are rejected");
+
+        std::string deep = "<scxml>";
+        for (int i = 0; i < 200000; i++)
+            deep += "<state id=\"s" + std::to_string(i) + "\">";
+        for (int i = 0; i < 200000; i++)
+            deep += "</state>";
+        expect(rejects(deep + "</scxml>"), "deeply nested documents are rejected");
+
+        StateMachine cycle;
+        cycle.states = {state("P", true), state("A", true, "P"), state("h1", false, "P", "history"),
+                        state("h2", false, "P", "history")};
+        cycle.transitions = {Transition{"t1", "h1", "h2", "", "", "", ""}, Transition{"t2", "h2", "h1", "", "", "", ""}};
+        bool rejected = false;
+        try
+        {
+            Statechart::fromStateMachine(cycle);
+        }
+        catch (const std::invalid_argument &)
+        {
+            rejected = true;
+        }
+        expect(rejected, "history to history transitions are rejected");
+
+        StateMachine nested;
+        for (int i = 0; i < 1000; i++)
+            nested.states.push_back(state("s" + std::to_string(i), true, i ? "s" + std::to_string(i - 1) : ""));
+        rejected = false;
+        try
+        {
+            Statechart::fromStateMachine(nested);
+        }
+        catch (const std::invalid_argument &)
+        {
+            rejected = true;
+        }
+        expect(rejected, "deeply nested machines are rejected");
+    }
+} // namespace
+
+int main()
+{
+    parallelProduct();
+    resumeAfterLimit();
+    corruptCheckpoints();
+    history();
+    doneEvents();
+    manyDeadlocks();
+    unknownGuards();
+    parallelGuards();
+    internalEvents();
+    malformedCharts();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d statechart check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: statechart semantics\n");
+    return 0;
+}
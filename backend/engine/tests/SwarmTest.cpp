@@ -0,0 +1,150 @@
+/**
+ * Swarm searches against the exhaustive explorer: on charts small enough
+ * that no bitstate table collides, every search visits every configuration,
+ * so the merged deadlocks and state coverage must be exactly those of
+ * StatechartExplorer::explore. Also checks that many searches with large
+ * tables run on no more threads than MaxTotalBitstateBytes allows.
+ *
+ * Build: node-gyp build (target swarm_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/SwarmTest.cpp \
+ *       engine/src/Swarm.cpp engine/src/Scxml.cpp engine/src/Statechart.cpp \
+ *       engine/src/Checkpoint.cpp engine/src/ReportCache.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "Scxml.h"
+#include "Swarm.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    std::vector<std::string> sorted(std::vector<std::string> ids)
+    {
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    State state(const std::string &id, bool initial, const std::string &parent = "")
+    {
+        State result;
+        result.id = id;
+        result.name = id;
+        result.isInitial = initial;
+        result.parent = parent;
+        return result;
+    }
+
+    /**
+     * Branches of two states out of A, each ending in a deadlock once the
+     * region alongside has switched off
+     */
+    Statechart branches()
+    {
+        StateMachine machine;
+        machine.states = {state("P", true), state("left", true, "P"), state("right", true, "P"),
+                          state("A", true, "left"), state("on", true, "right"), state("off", false, "right"),
+                          state("unused", false, "right")};
+        machine.states[0].kind = "parallel";
+        machine.transitions = {Transition{"t", "on", "off", "toggle", "", "", ""}};
+        for (int i = 0; i < 6; i++)
+        {
+            std::string branch = "b" + std::to_string(i);
+            machine.states.push_back(state(branch + "_0", false, "left"));
+            machine.states.push_back(state(branch + "_1", false, "left"));
+            machine.transitions.push_back(Transition{branch + "a", "A", branch + "_0", "go" + std::to_string(i), "", "", ""});
+            machine.transitions.push_back(Transition{branch + "b", branch + "_0", branch + "_1", "next", "", "", ""});
+        }
+        return Statechart::fromStateMachine(machine);
+    }
+
+    void matchesExplorer(const std::string &name, const Statechart &chart)
+    {
+        StatechartReport exhaustive = StatechartExplorer::explore(chart, 1000000);
+        expect(exhaustive.complete && exhaustive.deadlockCount > 0 &&
+                   exhaustive.deadlocks.size() == exhaustive.deadlockCount,
+               name + ": the chart is explored completely");
+
+        SwarmOptions options;
+        options.searches = 8;
+        options.threads = 2;
+        SwarmReport swarm = Swarm::run(chart, options);
+
+        expect(swarm.searches == 8, name + ": every search runs");
+        expect(swarm.truncated == 0, name + ": no search reaches the depth bound");
+        expect(swarm.statesVisited == 8 * exhaustive.configurations, name + ": each search visits every configuration");
+        expect(swarm.deadlockCount == exhaustive.deadlockCount, name + ": same deadlock count");
+
+        std::vector<std::vector<std::string>> expected, found;
+        for (const auto &deadlock : exhaustive.deadlocks)
+            expected.push_back(sorted(deadlock));
+        for (const auto &finding : swarm.deadlocks)
+        {
+            found.push_back(sorted(finding.configuration));
+            expect(finding.foundBy == 8, name + ": every search finds each deadlock");
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+        expect(found == expected, name + ": same deadlocked configurations");
+
+        expect(sorted(swarm.unreachedStates) == sorted(exhaustive.unreachableStates), name + ": same unreached states");
+        expect(swarm.statesCovered + swarm.unreachedStates.size() == swarm.stateCount,
+               name + ": covered and unreached states add up");
+    }
+
+    void bitstateCap()
+    {
+        // Twenty searches asking for the largest table fit sixteen threads
+        SwarmOptions options;
+        options.searches = 20;
+        options.threads = 20;
+        options.bitstateBytes = SwarmOptions::MaxBitstateBytes;
+        SwarmReport report = Swarm::run(branches(), options);
+        expect(report.searches == 20, "bitstate cap: every search runs");
+        expect(report.threads == SwarmOptions::MaxTotalBitstateBytes / SwarmOptions::MaxBitstateBytes,
+               "bitstate cap: threads are lowered to fit the tables");
+        expect(report.bitstateBytes <= SwarmOptions::MaxTotalBitstateBytes, "bitstate cap: tables held at once");
+
+        // Half the memory budget bounds each table
+        options.budget.memoryBytes = 1 << 20;
+        report = Swarm::run(branches(), options);
+        expect(report.threads == 20 && report.bitstateBytes == 20 * (1 << 19), "bitstate cap: memory budget halves the table");
+    }
+} // namespace
+
+int main()
+{
+    matchesExplorer("branches", branches());
+    matchesExplorer("history", statechartFromScxml("<scxml initial=\"P\">"
+                                                   "<state id=\"P\" initial=\"A\">"
+                                                   "<history id=\"h\"><transition target=\"A\"/></history>"
+                                                   "<state id=\"A\"><transition event=\"next\" target=\"B\"/></state>"
+                                                   "<state id=\"B\"><transition event=\"leave\" target=\"Q\"/></state>"
+                                                   "</state>"
+                                                   "<state id=\"Q\"><transition event=\"back\" target=\"h\"/>"
+                                                   "<transition event=\"stop\" target=\"Z\"/></state>"
+                                                   "<state id=\"Z\"/><state id=\"U\"/>"
+                                                   "</scxml>"));
+    bitstateCap();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d swarm check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: swarm searches match the explorer\n");
+    return 0;
+}
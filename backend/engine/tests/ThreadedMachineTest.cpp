@@ -0,0 +1,206 @@
+/**
+ * Differential test of the threaded tier against the reference Simulator:
+ * random machines with guards and actions (including short-circuit
+ * operators) must fire the same edges and end in the same configuration.
+ *
+ * Build: node-gyp build (target threaded_machine_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/ThreadedMachineTest.cpp \
+ *       engine/src/CompiledMachine.cpp engine/src/Expression.cpp \
+ *       engine/src/Simulator.cpp engine/src/ThreadedMachine.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "ThreadedMachine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    const char *const VariableNames[] = {"x", "y", "z"};
+    const char *const Inputs[] = {"a", "b", "c"};
+
+    std::string randomOperand(std::mt19937 &rng)
+    {
+        if (rng() % 2)
+            return VariableNames[rng() % 3];
+        return std::to_string(static_cast<int>(rng() % 11) - 3);
+    }
+
+    std::string randomComparison(std::mt19937 &rng)
+    {
+        static const char *const ops[] = {"<", "<=", ">", ">=", "==", "!="};
+        return randomOperand(rng) + " " + ops[rng() % 6] + " " + randomOperand(rng);
+    }
+
+    /**
+     * Comparisons joined by && and ||, sometimes negated or parenthesised
+     */
+    std::string randomCondition(std::mt19937 &rng, int depth = 0)
+    {
+        if (depth > 1 || rng() % 3 == 0)
+            return randomComparison(rng);
+        std::string lhs = randomCondition(rng, depth + 1);
+        std::string rhs = randomCondition(rng, depth + 1);
+        std::string joined = lhs + (rng() % 2 ? " && " : " || ") + rhs;
+        return rng() % 4 == 0 ? "!(" + joined + ")" : "(" + joined + ")";
+    }
+
+    std::string randomAction(std::mt19937 &rng)
+    {
+        static const char *const arithmetic[] = {"+", "-", "*", "/", "%"};
+        std::string action;
+        int statements = 1 + static_cast<int>(rng() % 3);
+        for (int i = 0; i < statements; i++)
+        {
+            if (i)
+                action += "; ";
+            std::string target = VariableNames[rng() % 3];
+            switch (rng() % 4)
+            {
+            case 0:
+                action += target + " = " + randomCondition(rng);
+                break;
+            case 1:
+                action += target + " = " + randomOperand(rng) + " " + arithmetic[rng() % 5] + " " + randomOperand(rng);
+                break;
+            case 2:
+                action += target + " += " + randomOperand(rng);
+                break;
+            default:
+                action += target + "++";
+                break;
+            }
+        }
+        return action;
+    }
+
+    StateMachine randomMachine(std::mt19937 &rng)
+    {
+        StateMachine machine;
+        machine.id = "differential";
+        machine.name = "differential";
+        machine.type = "mealy";
+
+        for (const char *name : VariableNames)
+        {
+            Variable variable;
+            variable.name = name;
+            variable.initialValue = std::to_string(rng() % 5);
+            machine.stateVariables.push_back(variable);
+        }
+
+        const int stateCount = 2 + static_cast<int>(rng() % 6);
+        for (int i = 0; i < stateCount; i++)
+        {
+            State state;
+            state.id = "s" + std::to_string(i);
+            state.name = state.id;
+            state.isInitial = i == 0;
+            machine.states.push_back(state);
+        }
+
+        const int transitionCount = stateCount * (1 + static_cast<int>(rng() % 4));
+        for (int i = 0; i < transitionCount; i++)
+        {
+            Transition transition;
+            transition.id = "t" + std::to_string(i);
+            transition.from = "s" + std::to_string(rng() % stateCount);
+            transition.to = "s" + std::to_string(rng() % stateCount);
+            transition.input = Inputs[rng() % 3];
+            if (rng() % 4)
+                transition.guard = randomCondition(rng);
+            if (rng() % 4)
+                transition.action = randomAction(rng);
+            machine.transitions.push_back(transition);
+        }
+        return machine;
+    }
+
+    /**
+     * Runs the inputs through both tiers; the threaded run stops at the
+     * first failed step, which the reference skips the same way
+     */
+    bool agree(const MachineProgram &program, const ThreadedMachine &threaded, const std::vector<int32_t> &inputs,
+               std::string &mismatch)
+    {
+        int32_t referenceState = program.graph.initialState;
+        std::vector<int64_t> referenceValues = program.variables.initialValues();
+        std::vector<int32_t> referenceEdges;
+        for (int32_t input : inputs)
+            referenceEdges.push_back(Simulator::step(program, referenceState, referenceValues.data(), input));
+
+        int32_t state = program.graph.initialState;
+        std::vector<int64_t> values = program.variables.initialValues();
+        std::vector<int32_t> edges(inputs.size(), -1);
+        size_t position = 0;
+        while (position < inputs.size())
+        {
+            auto result = threaded.run(state, values.data(), inputs.data() + position, inputs.size() - position,
+                                       edges.data() + position);
+            position += result.steps + (result.failed ? 1 : 0);
+        }
+
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (edges[i] != referenceEdges[i])
+            {
+                mismatch = "step " + std::to_string(i) + ": threaded edge " + std::to_string(edges[i]) +
+                           ", reference edge " + std::to_string(referenceEdges[i]);
+                return false;
+            }
+        }
+        if (state != referenceState || values != referenceValues)
+        {
+            mismatch = "final configuration differs";
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int machines = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const size_t steps = 256;
+
+    std::mt19937 rng(7);
+    int failures = 0;
+    for (int m = 0; m < machines; m++)
+    {
+        StateMachine machine = randomMachine(rng);
+        MachineProgram program = MachineProgram::compile(machine);
+        std::unique_ptr<ThreadedMachine> threaded = ThreadedMachine::compile(program);
+        if (!threaded)
+        {
+            std::fprintf(stderr, "machine %d: not compiled\n", m);
+            failures++;
+            continue;
+        }
+
+        std::vector<int32_t> inputs(steps);
+        for (auto &input : inputs)
+            input = program.graph.findInput(Inputs[rng() % 3]);
+
+        std::string mismatch;
+        if (!agree(program, *threaded, inputs, mismatch))
+        {
+            std::fprintf(stderr, "machine %d: %s\n", m, mismatch.c_str());
+            for (const auto &transition : machine.transitions)
+                std::fprintf(stderr, "  %s -> %s on %s [%s] / %s\n", transition.from.c_str(), transition.to.c_str(),
+                             transition.input.c_str(), transition.guard.c_str(), transition.action.c_str());
+            if (++failures >= 5)
+                break;
+        }
+    }
+
+    if (failures)
+    {
+        std::printf("FAIL: %d machine(s) disagree\n", failures);
+        return 1;
+    }
+    std::printf("OK: %d machines agree with the reference simulator\n", machines);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * Round trip of the binary trace format: random traces with step gaps,
+ * self-loop runs and repeated edges must decode to the records encoded,
+ * for every window, including windows that cross block boundaries.
+ *
+ * Build: node-gyp build (target trace_codec_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/TraceCodecTest.cpp \
+ *       engine/src/TraceCodec.cpp
+ */
+#include "TraceCodec.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    std::vector<TraceRecord> randomTrace(std::mt19937 &rng, size_t length)
+    {
+        std::vector<TraceRecord> trace;
+        uint64_t step = rng() % 100;
+        int state = 0;
+        while (trace.size() < length)
+        {
+            // Step gaps, as left by a session's reset or a truncated record
+            if (rng() % 8 == 0)
+                step += 1 + rng() % 50;
+
+            int next = static_cast<int>(rng() % 6);
+            int edge = state * 6 + next;
+            TraceRecord record{step,
+                               "s" + std::to_string(state),
+                               "s" + std::to_string(next),
+                               "i" + std::to_string(edge % 3),
+                               rng() % 4 ? "o" + std::to_string(edge % 5) : "",
+                               "t" + std::to_string(edge)};
+            // Self-loops repeat, so the encoder folds them into runs
+            size_t repeat = next == state ? 1 + rng() % 40 : 1;
+            for (size_t i = 0; i < repeat && trace.size() < length; i++)
+            {
+                trace.push_back(record);
+                record.step++;
+            }
+            step = record.step;
+            state = next;
+        }
+        return trace;
+    }
+
+    bool same(const TraceRecord &a, const TraceRecord &b)
+    {
+        return a.step == b.step && a.currentState == b.currentState && a.nextState == b.nextState &&
+               a.input == b.input && a.output == b.output && a.transitionId == b.transitionId;
+    }
+
+    /**
+     * Number of records in [from, from + count) that decode differently
+     */
+    size_t mismatches(const TraceReader &reader, const std::vector<TraceRecord> &trace, uint64_t from, uint64_t count)
+    {
+        std::vector<TraceRecord> decoded = reader.readRecords(from, count);
+        size_t expected = from >= trace.size() ? 0 : std::min<size_t>(count, trace.size() - from);
+        if (decoded.size() != expected)
+            return expected > decoded.size() ? expected : decoded.size();
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < decoded.size(); i++)
+        {
+            if (!same(decoded[i], trace[from + i]))
+                wrong++;
+        }
+        return wrong;
+    }
+
+    /**
+     * Overwrite the footer's record count and block size of an encoded trace
+     */
+    void patchFooter(std::vector<uint8_t> &bytes, uint64_t records, uint32_t blockRecords)
+    {
+        size_t footer = bytes.size() - (8 + 4 + 8 + 4);
+        for (size_t i = 0; i < 8; i++)
+            bytes[footer + i] = static_cast<uint8_t>(records >> (8 * i));
+        for (size_t i = 0; i < 4; i++)
+            bytes[footer + 8 + i] = static_cast<uint8_t>(blockRecords >> (8 * i));
+    }
+
+    /**
+     * Footers claiming more records than the body can hold must be rejected
+     * when opened, never dereferenced past the block index when read
+     */
+    int malformedFooters()
+    {
+        std::mt19937 rng(5);
+        std::vector<TraceRecord> trace = randomTrace(rng, 100);
+        TraceEncoder encoder(4);
+        for (const auto &record : trace)
+            encoder.append(record);
+        const std::vector<uint8_t> bytes = encoder.finish();
+
+        const std::pair<uint64_t, uint32_t> footers[] = {
+            {UINT64_MAX, 2}, {UINT64_MAX, 1}, {UINT64_MAX - 1, UINT32_MAX}, {1ull << 40, 4}, {101, 4}, {1000, 4}};
+        int failures = 0;
+        for (const auto &footer : footers)
+        {
+            std::vector<uint8_t> patched = bytes;
+            patchFooter(patched, footer.first, footer.second);
+            try
+            {
+                TraceReader reader(patched.data(), patched.size());
+                reader.read(footer.first - 1, 1);
+                std::fprintf(stderr, "footer with %llu records in blocks of %u was accepted\n",
+                             static_cast<unsigned long long>(footer.first), footer.second);
+                failures++;
+            }
+            catch (const std::invalid_argument &)
+            {
+            }
+        }
+        return failures;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int traces = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    std::mt19937 rng(11);
+    int failures = 0;
+    for (int t = 0; t < traces && failures < 5; t++)
+    {
+        const uint32_t blockRecords = 1 + rng() % 32;
+        std::vector<TraceRecord> trace = randomTrace(rng, 1 + rng() % 2000);
+
+        TraceEncoder encoder(blockRecords);
+        for (const auto &record : trace)
+            encoder.append(record);
+        std::vector<uint8_t> bytes = encoder.finish();
+        TraceReader reader(bytes.data(), bytes.size());
+
+        if (reader.size() != trace.size())
+        {
+            std::fprintf(stderr, "trace %d: %llu records decoded, %zu encoded\n", t,
+                         static_cast<unsigned long long>(reader.size()), trace.size());
+            failures++;
+            continue;
+        }
+
+        // The whole trace, every block on its own, and random windows,
+        // most of which start mid-block and end in a later block
+        std::vector<std::pair<uint64_t, uint64_t>> windows{{0, trace.size()}};
+        for (uint64_t from = 0; from < trace.size(); from += blockRecords)
+            windows.emplace_back(from, blockRecords);
+        for (int w = 0; w < 50; w++)
+            windows.emplace_back(rng() % trace.size(), 1 + rng() % (4 * blockRecords + 8));
+
+        for (const auto &window : windows)
+        {
+            size_t wrong = mismatches(reader, trace, window.first, window.second);
+            if (wrong)
+            {
+                std::fprintf(stderr, "trace %d (blocks of %u): %zu mismatches reading %llu records from %llu\n", t,
+                             blockRecords, wrong, static_cast<unsigned long long>(window.second),
+                             static_cast<unsigned long long>(window.first));
+                failures++;
+                break;
+            }
+        }
+    }
+
+    if (failures)
+    {
+        std::printf("FAIL: %d trace(s) did not round-trip\n", failures);
+        return 1;
+    }
+    if (int rejected = malformedFooters())
+    {
+        std::printf("FAIL: %d malformed footer(s) accepted\n", rejected);
+        return 1;
+    }
+    std::printf("OK: %d traces round-trip\n", traces);
+    return 0;
+}
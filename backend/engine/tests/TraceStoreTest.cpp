@@ -0,0 +1,185 @@
+/**
+ * Time-travel store against a trace that keeps every frame: after
+ * recording in batches of every size, seek and frames must reproduce the
+ * configuration of any step from the input log and the snapshots kept,
+ * recording must stop at the first input nothing accepts, and the store
+ * must retain one snapshot per interval, with the interval a power of two
+ * inside the configured bounds.
+ *
+ * Build: node-gyp build (target trace_store_test) or
+ *   g++ -O2 -std=c++17 -Iengine/include engine/tests/TraceStoreTest.cpp \
+ *       engine/src/TraceStore.cpp engine/src/CompiledMachine.cpp \
+ *       engine/src/Expression.cpp engine/src/Simulator.cpp \
+ *       engine/src/Trace.cpp engine/src/Json.cpp -lpthread
+ */
+#include "TraceStore.h"
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    /**
+     * Every state answers a, b and c, first through guarded transitions
+     * that update x and y, then unconditionally; nothing answers halt
+     */
+    StateMachine counterMachine()
+    {
+        StateMachine machine;
+        machine.id = machine.name = "counter";
+        for (const char *name : {"x", "y"})
+        {
+            Variable variable;
+            variable.name = name;
+            variable.initialValue = "1";
+            machine.stateVariables.push_back(variable);
+        }
+        for (int s = 0; s < 4; s++)
+        {
+            State state;
+            state.id = state.name = "s" + std::to_string(s);
+            state.isInitial = s == 0;
+            machine.states.push_back(state);
+        }
+        const char *inputs[] = {"a", "b", "c"};
+        int id = 0;
+        for (int s = 0; s < 4; s++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                std::string from = "s" + std::to_string(s);
+                machine.transitions.push_back(Transition{"t" + std::to_string(id++), from, "s" + std::to_string((s + i + 1) % 4),
+                                                         inputs[i], "", "x % 3 == " + std::to_string(i), "x = x * 7 + y; y++"});
+                machine.transitions.push_back(Transition{"t" + std::to_string(id++), from, "s" + std::to_string((s + 3 * i) % 4),
+                                                         inputs[i], "", "", "x = x + " + std::to_string(i + 1)});
+            }
+        }
+        Transition halt{"t" + std::to_string(id), "s0", "s0", "halt", "", "false", ""};
+        machine.transitions.push_back(halt);
+        return machine;
+    }
+
+    bool sameFrame(const TraceFrame &a, const TraceFrame &b)
+    {
+        return a.step == b.step && a.state == b.state && a.edge == b.edge && a.variables == b.variables;
+    }
+
+    void replay()
+    {
+        const StateMachine machine = counterMachine();
+        const MachineProgram program = MachineProgram::compile(machine);
+        const int32_t halt = program.graph.findInput("halt");
+        TraceStore store(program);
+
+        // Every frame, simulated directly
+        std::vector<TraceFrame> expected{{0, program.graph.initialState, -1, program.variables.initialValues()}};
+        std::mt19937 rng(9);
+        std::vector<int32_t> batch;
+        while (expected.size() <= 20000)
+        {
+            batch.resize(1 + rng() % 700);
+            for (auto &input : batch)
+                input = program.graph.findInput(std::string(1, static_cast<char>('a' + rng() % 3)));
+            expect(store.record(batch.data(), batch.size()) == batch.size(), "replay: enabled inputs are all recorded");
+            for (int32_t input : batch)
+            {
+                TraceFrame next = expected.back();
+                next.step++;
+                next.edge = Simulator::step(program, next.state, next.variables.data(), input);
+                expected.push_back(next);
+            }
+        }
+        const uint64_t length = expected.size() - 1;
+        expect(store.length() == length, "replay: the log holds every recorded input");
+
+        // An input nothing accepts ends the batch
+        int32_t tail[] = {program.graph.findInput("a"), halt, program.graph.findInput("b")};
+        expect(store.record(tail, 3) == 1, "replay: recording stops at a disabled input");
+        TraceFrame last = expected.back();
+        last.step++;
+        last.edge = Simulator::step(program, last.state, last.variables.data(), tail[0]);
+        expected.push_back(last);
+
+        bool seeks = true;
+        for (int i = 0; i < 2000 && seeks; i++)
+        {
+            uint64_t step = rng() % expected.size();
+            seeks = sameFrame(store.seek(step), expected[step]);
+        }
+        expect(seeks, "replay: seek reproduces any step");
+        expect(sameFrame(store.seek(0), expected[0]), "replay: step 0 is the initial configuration");
+        expect(sameFrame(store.seek(UINT64_MAX), expected.back()), "replay: seeking past the end clamps to it");
+
+        std::vector<TraceFrame> window = store.frames(12345, 300);
+        bool frames = window.size() == 300;
+        for (size_t i = 0; i < window.size() && frames; i++)
+            frames = sameFrame(window[i], expected[12345 + i]);
+        expect(frames, "replay: frames match a step-by-step run");
+        expect(store.frames(length - 1, SIZE_MAX).size() == 3, "replay: frames stop at the end of the log");
+        expect(store.frames(length + 2, 1).empty(), "replay: frames past the end are empty");
+    }
+
+    void retention()
+    {
+        const StateMachine machine = counterMachine();
+        const MachineProgram program = MachineProgram::compile(machine);
+        std::vector<int32_t> inputs(50000, program.graph.findInput("a"));
+
+        // Any measured step cost exceeds a nanosecond, so the interval
+        // stays at its minimum
+        TraceStoreOptions tight;
+        tight.targetSeekNanos = 1;
+        tight.minInterval = 32;
+        TraceStore dense(program, tight);
+        dense.record(inputs.data(), inputs.size());
+        expect(dense.snapshotInterval() == 32, "retention: a tight seek budget keeps the minimum interval");
+        expect(dense.snapshotCount() == inputs.size() / 32 + 1, "retention: one snapshot per interval, plus step 0");
+
+        // A generous budget grows the interval to its maximum
+        TraceStoreOptions loose;
+        loose.targetSeekNanos = UINT64_MAX / 4;
+        loose.maxInterval = 1024;
+        TraceStore sparse(program, loose);
+        sparse.record(inputs.data(), inputs.size());
+        const uint32_t k = sparse.snapshotInterval();
+        expect(k == 1024, "retention: a loose seek budget reaches the maximum interval");
+        expect(sparse.snapshotCount() < dense.snapshotCount() / 4, "retention: fewer snapshots with a longer interval");
+        expect(sparse.memoryBytes() < dense.memoryBytes(), "retention: fewer snapshots take less memory");
+        expect(sameFrame(sparse.seek(40000), dense.seek(40000)), "retention: both intervals replay the same frame");
+
+        // Default bounds: a power of two within them
+        TraceStore adaptive(program);
+        adaptive.record(inputs.data(), inputs.size());
+        const uint32_t interval = adaptive.snapshotInterval();
+        expect(interval >= TraceStoreOptions().minInterval && interval <= TraceStoreOptions().maxInterval &&
+                   (interval & (interval - 1)) == 0,
+               "retention: the adapted interval is a power of two within bounds");
+    }
+} // namespace
+
+int main()
+{
+    replay();
+    retention();
+
+    if (failures)
+    {
+        std::printf("FAIL: %d trace store check(s)\n", failures);
+        return 1;
+    }
+    std::printf("OK: trace store replays every step\n");
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * Verify saved models in bulk without the server: every machine JSON
+ * (.json) and binary model (.rsm) under the given directories or files is
+ * checked with Verifier::generateReport on a pool of threads, and one JSON
+ * report per model is written as a line as soon as it is done.
+ *
+ *   batch_verify [--jobs N] [--recursive] [--out reports.ndjson]
+ *                [--time-budget-ms N] [--memory-budget-mb N]
+ *                [--trace trace.json] <path>...
+ *
+ * Each line holds the file, the report (or the error), the load and
+ * verify times and the per-phase stats of the run. A summary goes to
+ * stderr; --trace also writes the engine spans of the batch as Chrome
+ * trace JSON. Exits 0 when every model loaded and is valid, 1 otherwise.
+ *
+ * Build: node-gyp build (target batch_verify)
+ */
+#include "Json.h"
+#include "ModelFile.h"
+#include "Trace.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace ReactiveSystem;
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot read " + path);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool isModel(const fs::path &path)
+    {
+        return path.extension() == ".json" || path.extension() == ".rsm";
+    }
+
+    StateMachine loadModel(const std::string &path)
+    {
+        if (fs::path(path).extension() == ".rsm")
+            return MappedModel::open(path)->toStateMachine();
+        return stateMachineFromJson(JsonValue::parse(readFile(path)));
+    }
+
+    JsonValue strings(const std::vector<std::string> &values)
+    {
+        JsonValue array = JsonValue::array();
+        for (const auto &value : values)
+            array.push(JsonValue::string(value));
+        return array;
+    }
+
+    JsonValue statsJson(const VerificationStats &stats)
+    {
+        JsonValue phases = JsonValue::array();
+        for (const auto &phase : stats.phases)
+        {
+            JsonValue entry = JsonValue::object();
+            entry.set("name", JsonValue::string(phase.name));
+            entry.set("wallMs", JsonValue::number(phase.wallMs));
+            entry.set("cpuMs", JsonValue::number(phase.cpuMs));
+            phases.push(entry);
+        }
+        JsonValue result = JsonValue::object();
+        result.set("phases", phases);
+        result.set("states", JsonValue::number(static_cast<double>(stats.states)));
+        result.set("edges", JsonValue::number(static_cast<double>(stats.edges)));
+        result.set("bytesTouched", JsonValue::number(static_cast<double>(stats.bytesTouched)));
+        result.set("peakBytes", JsonValue::number(static_cast<double>(stats.peakBytes)));
+        return result;
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr,
+                     "usage: batch_verify [--jobs N] [--recursive] [--out reports.ndjson]\n"
+                     "                    [--time-budget-ms N] [--memory-budget-mb N]\n"
+                     "                    [--trace trace.json] <path>...\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool recursive = false;
+    std::string outPath;
+    std::string tracePath;
+    AnalysisBudget budget;
+    std::vector<std::string> roots;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--recursive")
+            recursive = true;
+        else if (option == "--jobs" && hasValue)
+            jobs = static_cast<unsigned>(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+        else if (option == "--out" && hasValue)
+            outPath = argv[++i];
+        else if (option == "--trace" && hasValue)
+            tracePath = argv[++i];
+        else if (option == "--time-budget-ms" && hasValue)
+            budget.time = std::chrono::milliseconds(std::strtoll(argv[++i], nullptr, 10));
+        else if (option == "--memory-budget-mb" && hasValue)
+            budget.memoryBytes = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        else if (option.compare(0, 2, "--") == 0)
+            return usage();
+        else
+            roots.push_back(option);
+    }
+    if (roots.empty())
+    {
+        return usage();
+    }
+
+    // Collect in a stable order so runs are comparable
+    std::vector<std::string> files;
+    try
+    {
+        for (const auto &root : roots)
+        {
+            if (!fs::is_directory(root))
+            {
+                files.push_back(root);
+                continue;
+            }
+            if (recursive)
+            {
+                for (const auto &entry : fs::recursive_directory_iterator(root))
+                {
+                    if (entry.is_regular_file() && isModel(entry.path()))
+                        files.push_back(entry.path().string());
+                }
+            }
+            else
+            {
+                for (const auto &entry : fs::directory_iterator(root))
+                {
+                    if (entry.is_regular_file() && isModel(entry.path()))
+                        files.push_back(entry.path().string());
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "batch_verify: %s\n", e.what());
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    FILE *out = stdout;
+    if (!outPath.empty() && !(out = std::fopen(outPath.c_str(), "wb")))
+    {
+        std::fprintf(stderr, "batch_verify: cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+
+    if (!tracePath.empty())
+    {
+        if (!Tracer::available())
+        {
+            std::fprintf(stderr, "batch_verify: built without tracing (RSM_TRACING=0)\n");
+            return 1;
+        }
+        Tracer::setEnabled(true);
+    }
+
+    std::mutex outputMutex;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> valid{0}, invalid{0}, failed{0};
+    auto started = std::chrono::steady_clock::now();
+
+    auto worker = [&]()
+    {
+        for (size_t i; (i = next++) < files.size();)
+        {
+            const std::string &file = files[i];
+            JsonValue line = JsonValue::object();
+            line.set("file", JsonValue::string(file));
+
+            auto loadStart = std::chrono::steady_clock::now();
+            try
+            {
+                RSM_TRACE_SPAN("batch_verify model");
+                StateMachine machine = loadModel(file);
+                double loadMs = millisecondsSince(loadStart);
+                auto verifyStart = std::chrono::steady_clock::now();
+                Verifier::VerificationReport report = Verifier::generateReport(machine, budget);
+                double verifyMs = millisecondsSince(verifyStart);
+
+                line.set("name", JsonValue::string(machine.name));
+                line.set("states", JsonValue::number(static_cast<double>(machine.states.size())));
+                line.set("transitions", JsonValue::number(static_cast<double>(machine.transitions.size())));
+                line.set("isValid", JsonValue::boolean(report.isValid));
+                line.set("complete", JsonValue::boolean(report.complete));
+                if (!report.complete)
+                    line.set("stopReason", JsonValue::string(report.stopReason));
+                line.set("reachableStates", JsonValue::number(report.reachableStates));
+                line.set("totalStates", JsonValue::number(report.totalStates));
+                line.set("coverage", JsonValue::number(report.coverage));
+                line.set("deadlocks", strings(report.deadlocks));
+                line.set("errors", strings(report.errors));
+                line.set("warnings", strings(report.warnings));
+                line.set("summary", JsonValue::string(report.summary));
+                line.set("loadMs", JsonValue::number(loadMs));
+                line.set("verifyMs", JsonValue::number(verifyMs));
+                line.set("stats", statsJson(report.stats));
+                (report.isValid ? valid : invalid)++;
+            }
+            catch (const std::exception &e)
+            {
+                line.set("error", JsonValue::string(e.what()));
+                line.set("loadMs", JsonValue::number(millisecondsSince(loadStart)));
+                failed++;
+            }
+
+            std::string text = line.dump() + "\n";
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::fwrite(text.data(), 1, text.size(), out);
+            std::fflush(out);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(jobs, files.size()); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+
+    if (out != stdout && std::fclose(out) != 0)
+    {
+        std::fprintf(stderr, "batch_verify: cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    if (!tracePath.empty())
+    {
+        std::ofstream trace(tracePath, std::ios::binary);
+        trace << Tracer::chromeJson();
+        if (!trace.flush())
+        {
+            std::fprintf(stderr, "batch_verify: cannot write %s\n", tracePath.c_str());
+            return 1;
+        }
+    }
+    std::fprintf(stderr, "verified %zu models in %.1f ms: %zu valid, %zu invalid, %zu failed\n", files.size(),
+                 millisecondsSince(started), valid.load(), invalid.load(), failed.load());
+    return invalid == 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**
+ * Convert machines between JSON and the binary model format, and run the
+ * structural checks directly on a mapped model.
+ *
+ *   model_tool pack <machine.json> <model.rsm>
+ *   model_tool unpack <model.rsm> <machine.json>
+ *   model_tool info <model.rsm>
+ *   model_tool check <model.rsm>
+ *   model_tool import-kiss <machine.kiss2> <model.rsm>
+ *
+ * Build: node-gyp build (target model_tool)
+ */
+#include "GraphAnalysis.h"
+#include "Json.h"
+#include "Kiss2.h"
+#include "ModelFile.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ReactiveSystem;
+
+namespace
+{
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot read " + path);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    void writeFile(const std::string &path, const std::string &contents)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file || !file.write(contents.data(), static_cast<std::streamsize>(contents.size())))
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr,
+                     "usage: model_tool pack <machine.json> <model.rsm>\n"
+                     "       model_tool unpack <model.rsm> <machine.json>\n"
+                     "       model_tool info <model.rsm>\n"
+                     "       model_tool check <model.rsm>\n"
+                     "       model_tool import-kiss <machine.kiss2> <model.rsm>\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        return usage();
+    }
+    const std::string command = argv[1];
+
+    try
+    {
+        if (command == "pack" && argc == 4)
+        {
+            auto start = std::chrono::steady_clock::now();
+            StateMachine machine = stateMachineFromJson(JsonValue::parse(readFile(argv[2])));
+            MappedModel::save(machine, argv[3]);
+            std::printf("packed %zu states, %zu transitions in %.1f ms\n",
+                        machine.states.size(), machine.transitions.size(), millisecondsSince(start));
+            return 0;
+        }
+
+        if (command == "import-kiss" && argc == 4)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::FILE *file = std::fopen(argv[2], "rb");
+            if (!file)
+            {
+                throw std::runtime_error(std::string("Cannot read ") + argv[2]);
+            }
+
+            // Stream the file so large benchmarks never sit in memory as text
+            KissParser parser;
+            std::vector<char> chunk(1 << 16);
+            size_t read;
+            try
+            {
+                while ((read = std::fread(chunk.data(), 1, chunk.size(), file)) > 0)
+                {
+                    parser.feed(chunk.data(), read);
+                }
+            }
+            catch (...)
+            {
+                std::fclose(file);
+                throw;
+            }
+            std::fclose(file);
+
+            KissMachine kiss = parser.finish();
+            std::string name = argv[2];
+            name = name.substr(name.find_last_of("/\\") + 1);
+            name = name.substr(0, name.find('.'));
+            MappedModel::save(kiss.toStateMachine(name), argv[3]);
+            std::printf("imported %zu states, %llu product terms (%u inputs, %u outputs) in %.1f ms\n",
+                        kiss.graph.stateCount(), static_cast<unsigned long long>(kiss.productTerms),
+                        kiss.inputBits, kiss.outputBits, millisecondsSince(start));
+            return 0;
+        }
+
+        if (command == "unpack" && argc == 4)
+        {
+            auto model = MappedModel::open(argv[2]);
+            writeFile(argv[3], stateMachineToJson(model->toStateMachine()).dump());
+            return 0;
+        }
+
+        if (command == "info" && argc == 3)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto model = MappedModel::open(argv[2]);
+            double openMs = millisecondsSince(start);
+
+            const ModelHeader &header = model->header();
+            std::printf("machine     %s (%s)\n",
+                        std::string(model->string(header.machineName)).c_str(),
+                        std::string(model->string(header.machineType)).c_str());
+            std::printf("version     %u\n", header.version);
+            std::printf("states      %u\n", header.stateCount);
+            std::printf("transitions %u\n", header.edgeCount);
+            std::printf("inputs      %u\n", header.inputCount);
+            std::printf("outputs     %u\n", header.outputCount);
+            std::printf("variables   %u\n", header.variableCount);
+            std::printf("strings     %u\n", header.stringCount);
+            std::printf("file bytes  %zu\n", model->mappedBytes());
+            std::printf("open        %.2f ms\n", openMs);
+            return 0;
+        }
+
+        if (command == "check" && argc == 3)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto model = MappedModel::open(argv[2]);
+            auto reachable = GraphAnalysis::reachableStates(*model);
+            auto deadlocks = GraphAnalysis::deadlockStates(*model);
+
+            size_t reachableCount = 0;
+            for (uint8_t flag : reachable)
+                reachableCount += flag;
+
+            std::printf("reachable %zu / %zu states\n", reachableCount, model->stateCount());
+            for (uint32_t s = 0; s < model->stateCount(); s++)
+            {
+                if (!reachable[s])
+                    std::printf("  unreachable: %s\n", std::string(model->stateId(s)).c_str());
+            }
+            std::printf("deadlocks %zu\n", deadlocks.size());
+            for (uint32_t s : deadlocks)
+            {
+                std::printf("  deadlock: %s\n", std::string(model->stateId(s)).c_str());
+            }
+            std::printf("checked in %.1f ms\n", millisecondsSince(start));
+            return deadlocks.empty() && reachableCount == model->stateCount() ? 0 : 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "model_tool: %s\n", e.what());
+        return 1;
+    }
+
+    return usage();
+}
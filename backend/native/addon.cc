@@ -1,17 +1,134 @@
 #include <napi.h>
 #include "../engine/include/Verifier.h"
 #include "../engine/include/MealyMachine.h"
+#include "../engine/include/CompiledMachine.h"
+#include "../engine/include/BitParallelNFA.h"
+#include "../engine/include/CodeGenerator.h"
+#include "../engine/include/ThreadedMachine.h"
+#include "../engine/include/TraceStore.h"
+#include "../engine/include/Breakpoints.h"
+#include "../engine/include/TraceCodec.h"
+#include "../engine/include/ModelFile.h"
+#include "../engine/include/GraphAnalysis.h"
+#include "../engine/include/Kiss2.h"
+#include "../engine/include/Scxml.h"
+#include "../engine/include/IncrementalVerifier.h"
+#include "../engine/include/ReportCache.h"
+#include "../engine/include/SingleFlight.h"
+#include "../engine/include/JobScheduler.h"
+#include "../engine/include/Progress.h"
+#include "../engine/include/Swarm.h"
+#include "../engine/include/ParallelSearch.h"
+#include "../engine/include/ConcurrentStateSet.h"
+#include "../engine/include/DistributedExplorer.h"
+#include "../engine/include/VerificationStats.h"
+#include "../engine/include/Trace.h"
+#include "../engine/include/Metrics.h"
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <exception>
+#include <memory>
 #include <vector>
 #include <string>
 
 using namespace ReactiveSystem;
 using namespace Napi;
 
+/**
+ * Convert JS Variable array to C++ vector
+ */
+std::vector<Variable> convertJSVariables(const Value &jsVariables)
+{
+    std::vector<Variable> variables;
+    if (!jsVariables.IsArray())
+    {
+        return variables;
+    }
+
+    Array variablesArray = jsVariables.As<Array>();
+    for (uint32_t i = 0; i < variablesArray.Length(); i++)
+    {
+        Object varObj = variablesArray.Get(i).As<Object>();
+        Variable variable;
+        variable.name = varObj.Get("name").As<String>().Utf8Value();
+        if (varObj.Get("type").IsString())
+        {
+            variable.type = varObj.Get("type").As<String>().Utf8Value();
+        }
+        if (!varObj.Get("initialValue").IsUndefined())
+        {
+            variable.initialValue = varObj.Get("initialValue").ToString().Utf8Value();
+        }
+        if (varObj.Get("range").IsObject())
+        {
+            Object range = varObj.Get("range").As<Object>();
+            variable.hasRange = true;
+            variable.min = static_cast<long long>(range.Get("min").As<Number>().Int64Value());
+            variable.max = static_cast<long long>(range.Get("max").As<Number>().Int64Value());
+        }
+        variables.push_back(variable);
+    }
+    return variables;
+}
+
+/**
+ * Convert JS State object to C++ struct
+ */
+State convertJSState(const Object &stateObj)
+{
+    State state;
+    state.id = stateObj.Get("id").As<String>().Utf8Value();
+    state.name = stateObj.Get("name").As<String>().Utf8Value();
+    state.isInitial = stateObj.Get("isInitial").As<Boolean>();
+    state.isFinal = stateObj.Get("isFinal").As<Boolean>();
+    if (stateObj.Get("parent").IsString())
+    {
+        state.parent = stateObj.Get("parent").As<String>().Utf8Value();
+    }
+    if (stateObj.Get("kind").IsString())
+    {
+        state.kind = stateObj.Get("kind").As<String>().Utf8Value();
+    }
+    return state;
+}
+
+/**
+ * Convert JS Transition object to C++ struct
+ */
+Transition convertJSTransition(const Object &transObj)
+{
+    Transition transition;
+    transition.id = transObj.Get("id").As<String>().Utf8Value();
+    transition.from = transObj.Get("from").As<String>().Utf8Value();
+    transition.to = transObj.Get("to").As<String>().Utf8Value();
+
+    // Optional fields
+    if (!transObj.Get("input").IsUndefined())
+    {
+        transition.input = transObj.Get("input").As<String>().Utf8Value();
+    }
+    if (!transObj.Get("output").IsUndefined())
+    {
+        transition.output = transObj.Get("output").As<String>().Utf8Value();
+    }
+    if (!transObj.Get("guard").IsUndefined())
+    {
+        transition.guard = transObj.Get("guard").As<String>().Utf8Value();
+    }
+    if (!transObj.Get("action").IsUndefined())
+    {
+        transition.action = transObj.Get("action").As<String>().Utf8Value();
+    }
+    return transition;
+}
+
 /**
  * Convert JS StateMachine object to C++ struct
  */
 StateMachine convertJSStateMachine(const Object &jsStateMachine)
 {
+    RSM_TRACE_SPAN("convertJSStateMachine");
     StateMachine machine;
     machine.id = jsStateMachine.Get("id").As<String>().Utf8Value();
     machine.name = jsStateMachine.Get("name").As<String>().Utf8Value();
@@ -21,139 +138,537 @@ StateMachine convertJSStateMachine(const Object &jsStateMachine)
     Array statesArray = jsStateMachine.Get("states").As<Array>();
     for (uint32_t i = 0; i < statesArray.Length(); i++)
     {
-        Object stateObj = statesArray.Get(i).As<Object>();
-        State state;
-        state.id = stateObj.Get("id").As<String>().Utf8Value();
-        state.name = stateObj.Get("name").As<String>().Utf8Value();
-        state.isInitial = stateObj.Get("isInitial").As<Boolean>();
-        state.isFinal = stateObj.Get("isFinal").As<Boolean>();
-        machine.states.push_back(state);
+        machine.states.push_back(convertJSState(statesArray.Get(i).As<Object>()));
     }
 
     // Convert transitions
     Array transitionsArray = jsStateMachine.Get("transitions").As<Array>();
     for (uint32_t i = 0; i < transitionsArray.Length(); i++)
     {
-        Object transObj = transitionsArray.Get(i).As<Object>();
-        Transition transition;
-        transition.id = transObj.Get("id").As<String>().Utf8Value();
-        transition.from = transObj.Get("from").As<String>().Utf8Value();
-        transition.to = transObj.Get("to").As<String>().Utf8Value();
+        machine.transitions.push_back(convertJSTransition(transitionsArray.Get(i).As<Object>()));
+    }
 
-        // Optional fields
-        if (!transObj.Get("input").IsUndefined())
-        {
-            transition.input = transObj.Get("input").As<String>().Utf8Value();
-        }
-        if (!transObj.Get("output").IsUndefined())
+    machine.inputVariables = convertJSVariables(jsStateMachine.Get("inputVariables"));
+    machine.outputVariables = convertJSVariables(jsStateMachine.Get("outputVariables"));
+    machine.stateVariables = convertJSVariables(jsStateMachine.Get("stateVariables"));
+
+    return machine;
+}
+
+/**
+ * Convert C++ StateMachine struct to a JS object in the frontend shape
+ */
+Object convertStateMachineToJS(Env env, const StateMachine &machine)
+{
+    auto variablesToJS = [env](const std::vector<Variable> &variables)
+    {
+        Array result = Array::New(env, variables.size());
+        for (size_t i = 0; i < variables.size(); i++)
         {
-            transition.output = transObj.Get("output").As<String>().Utf8Value();
+            Object variable = Object::New(env);
+            variable.Set("name", String::New(env, variables[i].name));
+            variable.Set("type", String::New(env, variables[i].type));
+            variable.Set("initialValue", String::New(env, variables[i].initialValue));
+            if (variables[i].hasRange)
+            {
+                Object range = Object::New(env);
+                range.Set("min", Number::New(env, static_cast<double>(variables[i].min)));
+                range.Set("max", Number::New(env, static_cast<double>(variables[i].max)));
+                variable.Set("range", range);
+            }
+            result.Set(i, variable);
         }
+        return result;
+    };
+
+    Object result = Object::New(env);
+    result.Set("id", String::New(env, machine.id));
+    result.Set("name", String::New(env, machine.name));
+    result.Set("type", String::New(env, machine.type));
 
-        machine.transitions.push_back(transition);
+    Array states = Array::New(env, machine.states.size());
+    for (size_t i = 0; i < machine.states.size(); i++)
+    {
+        Object state = Object::New(env);
+        state.Set("id", String::New(env, machine.states[i].id));
+        state.Set("name", String::New(env, machine.states[i].name));
+        state.Set("isInitial", Boolean::New(env, machine.states[i].isInitial));
+        state.Set("isFinal", Boolean::New(env, machine.states[i].isFinal));
+        if (!machine.states[i].parent.empty())
+            state.Set("parent", String::New(env, machine.states[i].parent));
+        if (!machine.states[i].kind.empty())
+            state.Set("kind", String::New(env, machine.states[i].kind));
+        states.Set(i, state);
     }
+    result.Set("states", states);
 
-    return machine;
+    Array transitions = Array::New(env, machine.transitions.size());
+    for (size_t i = 0; i < machine.transitions.size(); i++)
+    {
+        const Transition &source = machine.transitions[i];
+        Object transition = Object::New(env);
+        transition.Set("id", String::New(env, source.id));
+        transition.Set("from", String::New(env, source.from));
+        transition.Set("to", String::New(env, source.to));
+        if (!source.input.empty())
+            transition.Set("input", String::New(env, source.input));
+        if (!source.output.empty())
+            transition.Set("output", String::New(env, source.output));
+        if (!source.guard.empty())
+            transition.Set("guard", String::New(env, source.guard));
+        if (!source.action.empty())
+            transition.Set("action", String::New(env, source.action));
+        transitions.Set(i, transition);
+    }
+    result.Set("transitions", transitions);
+
+    result.Set("inputVariables", variablesToJS(machine.inputVariables));
+    result.Set("outputVariables", variablesToJS(machine.outputVariables));
+    result.Set("stateVariables", variablesToJS(machine.stateVariables));
+    return result;
 }
 
 /**
- * Verify state machine
+ * Convert JS array of strings (e.g. an input sequence) to C++ vector
  */
-Value VerifyStateMachine(const CallbackInfo &info)
+std::vector<std::string> convertJSStringArray(const Array &jsArray)
 {
-    Env env = info.Env();
+    std::vector<std::string> values;
+    values.reserve(jsArray.Length());
+    for (uint32_t i = 0; i < jsArray.Length(); i++)
+    {
+        values.push_back(jsArray.Get(i).As<String>().Utf8Value());
+    }
+    return values;
+}
 
-    if (info.Length() < 1 || !info[0].IsObject())
+/**
+ * Convert JS breakpoint specs ({kind, target, condition}) to C++ vector
+ */
+std::vector<BreakpointSpec> convertJSBreakpoints(const Array &jsBreakpoints)
+{
+    static const std::pair<const char *, BreakpointSpec::Kind> kinds[] = {
+        {"state", BreakpointSpec::Kind::State},
+        {"transition", BreakpointSpec::Kind::Transition},
+        {"input", BreakpointSpec::Kind::Input},
+        {"output", BreakpointSpec::Kind::Output},
+        {"variable", BreakpointSpec::Kind::Variable},
+        {"predicate", BreakpointSpec::Kind::Predicate}};
+
+    std::vector<BreakpointSpec> specs;
+    for (uint32_t i = 0; i < jsBreakpoints.Length(); i++)
     {
-        TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
-        return env.Null();
+        Object jsSpec = jsBreakpoints.Get(i).As<Object>();
+        std::string kind = jsSpec.Get("kind").As<String>().Utf8Value();
+
+        BreakpointSpec spec;
+        bool known = false;
+        for (const auto &entry : kinds)
+        {
+            if (kind == entry.first)
+            {
+                spec.kind = entry.second;
+                known = true;
+            }
+        }
+        if (!known)
+        {
+            throw std::invalid_argument("Breakpoint " + std::to_string(i) + ": unknown kind " + kind);
+        }
+        if (jsSpec.Has("target") && jsSpec.Get("target").IsString())
+        {
+            spec.target = jsSpec.Get("target").As<String>().Utf8Value();
+        }
+        if (jsSpec.Has("condition") && jsSpec.Get("condition").IsString())
+        {
+            spec.condition = jsSpec.Get("condition").As<String>().Utf8Value();
+        }
+        specs.push_back(spec);
     }
+    return specs;
+}
 
-    try
+/**
+ * Convert a reconstructed simulation step to a JS object
+ */
+Object convertTraceFrame(Env env, const StateMachine &machine, const MachineProgram &program, const TraceFrame &frame)
+{
+    Object result = Object::New(env);
+    result.Set("step", Number::New(env, static_cast<double>(frame.step)));
+    result.Set("stateId", String::New(env, frame.state < 0 ? std::string() : program.graph.stateIds[frame.state]));
+    if (frame.edge >= 0)
     {
-        Object jsStateMachine = info[0].As<Object>();
-        StateMachine machine = convertJSStateMachine(jsStateMachine);
+        result.Set("transitionId", String::New(env, machine.transitions[program.graph.edgeTransitions[frame.edge]].id));
+    }
 
-        auto report = Verifier::generateReport(machine);
+    Object variables = Object::New(env);
+    for (size_t v = 0; v < frame.variables.size(); v++)
+    {
+        variables.Set(program.variables.name(v), Number::New(env, static_cast<double>(frame.variables[v])));
+    }
+    result.Set("variables", variables);
+    return result;
+}
 
-        // Create result object
-        Object result = Object::New(env);
-        result.Set("isValid", Boolean::New(env, report.isValid));
-        result.Set("reachableStates", Number::New(env, report.reachableStates));
-        result.Set("totalStates", Number::New(env, report.totalStates));
-        result.Set("summary", String::New(env, report.summary));
+/**
+ * Reports of verifyStateMachine, shared by every caller in the process
+ */
+ReportCache reportCache;
 
-        // Add errors array
-        Array errorsArray = Array::New(env);
-        for (size_t i = 0; i < report.errors.size(); i++)
-        {
-            errorsArray.Set(i, String::New(env, report.errors[i]));
-        }
-        result.Set("errors", errorsArray);
+/**
+ * Verifications running on the worker pool, coalesced by machine hash
+ */
+SingleFlight<MachineHash, Verifier::VerificationReport, MachineHashHasher> verificationFlights;
 
-        // Add warnings array
-        Array warningsArray = Array::New(env);
-        for (size_t i = 0; i < report.warnings.size(); i++)
+/**
+ * Worker pool for the long-running native calls
+ */
+JobScheduler scheduler;
+
+/**
+ * Phase totals of every verification run in the process
+ */
+VerificationStatsTotals verificationTotals;
+
+/**
+ * Latency and input-size distributions of one native call, registered
+ * once at load; recording is lock-free. Calls taking a machine record its
+ * size, simulations the length of their input.
+ */
+struct CallMetrics
+{
+    enum Input
+    {
+        Machine = 1,
+        Sequence = 2
+    };
+
+    HdrHistogram &latency;
+    Counter &errors;
+    HdrHistogram *states = nullptr;
+    HdrHistogram *transitions = nullptr;
+    HdrHistogram *length = nullptr;
+
+    CallMetrics(const std::string &call, int inputs)
+        : latency(MetricsRegistry::global().histogram("rsm_native_call_duration_seconds",
+                                                      "Latency of native calls, from call to result", label(call), 1e-9)),
+          errors(MetricsRegistry::global().counter("rsm_native_call_errors_total", "Native calls that failed", label(call)))
+    {
+        MetricsRegistry &registry = MetricsRegistry::global();
+        if (inputs & Machine)
         {
-            warningsArray.Set(i, String::New(env, report.warnings[i]));
+            states = &registry.histogram("rsm_native_input_states", "States of the input machine", label(call));
+            transitions = &registry.histogram("rsm_native_input_transitions", "Transitions of the input machine", label(call));
         }
-        result.Set("warnings", warningsArray);
-
-        // Add deadlocks array
-        Array deadlocksArray = Array::New(env);
-        for (size_t i = 0; i < report.deadlocks.size(); i++)
+        if (inputs & Sequence)
         {
-            deadlocksArray.Set(i, String::New(env, report.deadlocks[i]));
+            length = &registry.histogram("rsm_native_input_length", "Input symbols of a simulation", label(call));
         }
-        result.Set("deadlocks", deadlocksArray);
+    }
 
-        return result;
+    static std::string label(const std::string &call) { return "call=\"" + call + "\""; }
+
+    void input(const StateMachine &machine)
+    {
+        states->record(machine.states.size());
+        transitions->record(machine.transitions.size());
     }
-    catch (const std::exception &e)
+
+    void input(size_t symbols) { length->record(symbols); }
+
+    void finish(std::chrono::steady_clock::time_point started)
     {
-        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
-        return env.Null();
+        latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count()));
+    }
+};
+
+CallMetrics verifyMetrics("verify", CallMetrics::Machine);
+CallMetrics reachabilityMetrics("reachability", CallMetrics::Machine);
+CallMetrics deadlockMetrics("deadlocks", CallMetrics::Machine);
+CallMetrics simulateMetrics("simulate", CallMetrics::Machine | CallMetrics::Sequence);
+CallMetrics sessionRunMetrics("session_run", CallMetrics::Sequence);
+
+/**
+ * Convert a machine from JS, timed as the "convert" phase
+ */
+StateMachine convertTimed(const Object &jsStateMachine, PhaseStats &convert)
+{
+    VerificationStats stats;
+    StateMachine machine;
+    {
+        PhaseClock clock(stats);
+        clock.next("convert");
+        machine = convertJSStateMachine(jsStateMachine);
+    }
+    convert = stats.phases[0];
+    verificationTotals.record(convert);
+    return machine;
+}
+
+Object convertPhase(Env env, const PhaseStats &phase)
+{
+    Object result = Object::New(env);
+    result.Set("name", String::New(env, phase.name));
+    result.Set("wallMs", Number::New(env, phase.wallMs));
+    result.Set("cpuMs", Number::New(env, phase.cpuMs));
+    return result;
+}
+
+/**
+ * Stats of a run, with this request's conversion as the first phase
+ */
+Object convertVerificationStats(Env env, const VerificationStats &stats, const PhaseStats &convert)
+{
+    Object result = Object::New(env);
+    Array phases = Array::New(env);
+    phases.Set(uint32_t(0), convertPhase(env, convert));
+    for (size_t i = 0; i < stats.phases.size(); i++)
+    {
+        phases.Set(i + 1, convertPhase(env, stats.phases[i]));
     }
+    result.Set("phases", phases);
+    result.Set("wallMs", Number::New(env, convert.wallMs + stats.wallMs()));
+    result.Set("cpuMs", Number::New(env, convert.cpuMs + stats.cpuMs()));
+    result.Set("states", Number::New(env, static_cast<double>(stats.states)));
+    result.Set("edges", Number::New(env, static_cast<double>(stats.edges)));
+    result.Set("bytesTouched", Number::New(env, static_cast<double>(stats.bytesTouched)));
+    result.Set("peakBytes", Number::New(env, static_cast<double>(stats.peakBytes)));
+    return result;
 }
 
 /**
- * Check reachability
+ * Convert a verification report to JS; a cached report carries the stats
+ * of the run that produced it
  */
-Value CheckReachability(const CallbackInfo &info)
+Object convertVerificationReport(Env env, const Verifier::VerificationReport &report, const PhaseStats &convert)
 {
-    Env env = info.Env();
+    Object result = Object::New(env);
+    result.Set("isValid", Boolean::New(env, report.isValid));
+    result.Set("reachableStates", Number::New(env, report.reachableStates));
+    result.Set("totalStates", Number::New(env, report.totalStates));
+    result.Set("summary", String::New(env, report.summary));
 
-    if (info.Length() < 2)
+    // Add errors array
+    Array errorsArray = Array::New(env);
+    for (size_t i = 0; i < report.errors.size(); i++)
     {
-        TypeError::New(env, "State machine and target state ID expected").ThrowAsJavaScriptException();
-        return env.Null();
+        errorsArray.Set(i, String::New(env, report.errors[i]));
     }
+    result.Set("errors", errorsArray);
 
-    try
+    // Add warnings array
+    Array warningsArray = Array::New(env);
+    for (size_t i = 0; i < report.warnings.size(); i++)
     {
-        Object jsStateMachine = info[0].As<Object>();
-        std::string targetStateId = info[1].As<String>().Utf8Value();
+        warningsArray.Set(i, String::New(env, report.warnings[i]));
+    }
+    result.Set("warnings", warningsArray);
 
-        StateMachine machine = convertJSStateMachine(jsStateMachine);
-        auto result = Verifier::isStateReachable(machine, targetStateId);
+    // Add deadlocks array
+    Array deadlocksArray = Array::New(env);
+    for (size_t i = 0; i < report.deadlocks.size(); i++)
+    {
+        deadlocksArray.Set(i, String::New(env, report.deadlocks[i]));
+    }
+    result.Set("deadlocks", deadlocksArray);
 
-        Object jsResult = Object::New(env);
-        jsResult.Set("isReachable", Boolean::New(env, result.isReachable));
-        jsResult.Set("message", String::New(env, result.message));
+    result.Set("complete", Boolean::New(env, report.complete));
+    result.Set("stopReason", String::New(env, report.stopReason));
+    result.Set("statesExplored", Number::New(env, static_cast<double>(report.statesExplored)));
+    result.Set("frontierSize", Number::New(env, static_cast<double>(report.frontierSize)));
+    result.Set("coverage", Number::New(env, report.coverage));
+    result.Set("stats", convertVerificationStats(env, report.stats, convert));
+    return result;
+}
 
-        return jsResult;
+/**
+ * Analysis budget from JS options: { timeBudgetMs, memoryBudgetMb }
+ */
+AnalysisBudget convertBudget(const Napi::Value &options)
+{
+    AnalysisBudget budget;
+    if (!options.IsObject())
+    {
+        return budget;
     }
-    catch (const std::exception &e)
+
+    Object object = options.As<Object>();
+    if (object.Get("timeBudgetMs").IsNumber())
     {
-        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
-        return env.Null();
+        double milliseconds = object.Get("timeBudgetMs").As<Number>().DoubleValue();
+        if (!(milliseconds >= 0) || std::isinf(milliseconds))
+            throw std::invalid_argument("timeBudgetMs must be a finite, non-negative number");
+        // Budgets beyond what the clock can represent are unlimited
+        std::chrono::duration<double, std::milli> time(milliseconds);
+        if (time < std::chrono::duration<double, std::milli>(AnalysisBudget::Clock::duration::max()))
+            budget.time = std::chrono::duration_cast<AnalysisBudget::Clock::duration>(time);
+    }
+    if (object.Get("memoryBudgetMb").IsNumber())
+    {
+        double megabytes = object.Get("memoryBudgetMb").As<Number>().DoubleValue();
+        if (!(megabytes >= 0) || std::isinf(megabytes))
+            throw std::invalid_argument("memoryBudgetMb must be a finite, non-negative number");
+        double bytes = megabytes * 1024 * 1024;
+        if (bytes < static_cast<double>(std::numeric_limits<size_t>::max()))
+            budget.memoryBytes = static_cast<size_t>(bytes);
     }
+    return budget;
 }
 
 /**
- * Find deadlocks
+ * options[name] as an integer in [min, max]; throws std::invalid_argument
+ * naming the option otherwise
  */
-Value FindDeadlocks(const CallbackInfo &info)
+uint64_t convertCount(const Object &options, const char *name, uint64_t min, uint64_t max)
+{
+    double value = options.Get(name).As<Number>().DoubleValue();
+    if (!(value >= static_cast<double>(min) && value <= static_cast<double>(max)) || value != std::floor(value))
+        throw std::invalid_argument(std::string(name) + " must be an integer from " + std::to_string(min) + " to " +
+                                    std::to_string(max));
+    return static_cast<uint64_t>(value);
+}
+
+// Largest integer a JS number holds exactly
+constexpr uint64_t MaxSafeInteger = 9007199254740991;
+
+/**
+ * value as a step index or count; throws std::invalid_argument naming it
+ * unless it is a non-negative integer
+ */
+uint64_t convertStep(const Napi::Value &value, const char *name)
+{
+    double number = value.As<Number>().DoubleValue();
+    if (!(number >= 0 && number <= static_cast<double>(MaxSafeInteger)) || number != std::floor(number))
+        throw std::invalid_argument(std::string(name) + " must be a non-negative integer");
+    return static_cast<uint64_t>(number);
+}
+
+/**
+ * A trace request id when options.trace is set, otherwise 0
+ */
+uint32_t traceRequest(const Napi::Value &options)
+{
+    if (!options.IsObject() || !options.As<Object>().Get("trace").ToBoolean())
+    {
+        return 0;
+    }
+    return Tracer::newRequest();
+}
+
+/**
+ * Add the spans of a traced request to its result as result.trace, a
+ * Chrome trace-event object
+ */
+Napi::Value attachTrace(Napi::Env env, Napi::Value result, uint32_t request)
+{
+    if (request && result.IsObject())
+    {
+        Object json = env.Global().Get("JSON").As<Object>();
+        result.As<Object>().Set("trace", json.Get("parse").As<Function>().Call(json, {String::New(env, Tracer::chromeJson(request))}));
+    }
+    return result;
+}
+
+/**
+ * Hit/miss statistics of the report cache
+ */
+Value ReportCacheStats(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    ReportCache::Stats stats = reportCache.stats();
+
+    Object result = Object::New(env);
+    result.Set("hits", Number::New(env, static_cast<double>(stats.hits)));
+    result.Set("diskHits", Number::New(env, static_cast<double>(stats.diskHits)));
+    result.Set("misses", Number::New(env, static_cast<double>(stats.misses)));
+    result.Set("evictions", Number::New(env, static_cast<double>(stats.evictions)));
+    result.Set("entries", Number::New(env, static_cast<double>(stats.entries)));
+    result.Set("capacity", Number::New(env, static_cast<double>(stats.capacity)));
+    result.Set("directory", String::New(env, stats.directory));
+
+    auto flights = verificationFlights.stats();
+    result.Set("coalesced", Number::New(env, static_cast<double>(flights.followers)));
+    result.Set("inFlight", Number::New(env, static_cast<double>(flights.inFlight)));
+    return result;
+}
+
+/**
+ * Per-phase totals of the verifications run so far (cache hits run no
+ * phase but conversion). Options: { reset } clears them after reading.
+ */
+Value VerificationStatsOf(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    VerificationStatsTotals::Snapshot totals = verificationTotals.snapshot();
+    if (info.Length() > 0 && info[0].IsObject() && info[0].As<Object>().Get("reset").ToBoolean())
+    {
+        verificationTotals.reset();
+    }
+
+    Object result = Object::New(env);
+    result.Set("runs", Number::New(env, static_cast<double>(totals.runs)));
+    Object phases = Object::New(env);
+    for (const auto &entry : totals.phases)
+    {
+        Object phase = Object::New(env);
+        phase.Set("count", Number::New(env, static_cast<double>(entry.second.count)));
+        phase.Set("wallMs", Number::New(env, entry.second.wallMs));
+        phase.Set("cpuMs", Number::New(env, entry.second.cpuMs));
+        phase.Set("maxWallMs", Number::New(env, entry.second.maxWallMs));
+        phase.Set("meanWallMs", Number::New(env, entry.second.wallMs / entry.second.count));
+        phases.Set(entry.first, phase);
+    }
+    result.Set("phases", phases);
+    result.Set("states", Number::New(env, static_cast<double>(totals.states)));
+    result.Set("edges", Number::New(env, static_cast<double>(totals.edges)));
+    result.Set("bytesTouched", Number::New(env, static_cast<double>(totals.bytesTouched)));
+    result.Set("peakBytes", Number::New(env, static_cast<double>(totals.peakBytes)));
+    return result;
+}
+
+/**
+ * The buffered engine spans as Chrome trace-event JSON (a string), all of
+ * them or those of options.request
+ */
+Value TraceEvents(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    uint32_t request = 0;
+    if (info.Length() > 0 && info[0].IsObject() && info[0].As<Object>().Get("request").IsNumber())
+    {
+        request = info[0].As<Object>().Get("request").As<Number>().Uint32Value();
+    }
+    return String::New(env, Tracer::chromeJson(request));
+}
+
+/**
+ * Options: { enabled, clear }. Returns { enabled, available }; tracing
+ * can only be enabled when spans are compiled in.
+ */
+Value ConfigureTracing(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Object options = info[0].As<Object>();
+        if (options.Get("enabled").IsBoolean())
+            Tracer::setEnabled(options.Get("enabled").As<Boolean>().Value());
+        if (options.Get("clear").ToBoolean())
+            Tracer::clear();
+    }
+
+    Object result = Object::New(env);
+    result.Set("enabled", Boolean::New(env, Tracer::enabled()));
+    result.Set("available", Boolean::New(env, Tracer::available()));
+    return result;
+}
+
+/**
+ * Verify state machine; identical machines are answered from the cache
+ * Options: { timeBudgetMs, memoryBudgetMb, trace }
+ */
+Value VerifyStateMachine(const CallbackInfo &info)
 {
     Env env = info.Env();
 
@@ -163,36 +678,2159 @@ Value FindDeadlocks(const CallbackInfo &info)
         return env.Null();
     }
 
+    ScopedLatency latency(verifyMetrics.latency);
     try
     {
-        Object jsStateMachine = info[0].As<Object>();
-        StateMachine machine = convertJSStateMachine(jsStateMachine);
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        uint32_t trace = traceRequest(options);
+        TraceRequestScope tracing(trace);
+        PhaseStats convert;
+        StateMachine machine = convertTimed(info[0].As<Object>(), convert);
+        verifyMetrics.input(machine);
 
-        auto deadlocks = Verifier::findDeadlocks(machine);
+        AnalysisBudget budget = convertBudget(options);
 
-        Array result = Array::New(env);
-        for (size_t i = 0; i < deadlocks.size(); i++)
-        {
-            result.Set(i, String::New(env, deadlocks[i]));
-        }
+        MachineHash hash;
+        bool cached = false;
+        auto report = reportCache.verify(machine, &hash, &cached, budget);
+        if (!cached)
+            verificationTotals.record(report.stats);
 
-        return result;
+        Object result = convertVerificationReport(env, report, convert);
+        result.Set("hash", String::New(env, hash.hex()));
+        result.Set("cached", Boolean::New(env, cached));
+        return attachTrace(env, result, trace);
     }
     catch (const std::exception &e)
     {
+        verifyMetrics.errors.add();
         TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
+/**
+ * Scheduling options from JS: { priority, deadlineMs }
+ */
+JobOptions convertJobOptions(const Napi::Value &options, JobPriority defaultPriority)
+{
+    JobOptions jobOptions;
+    jobOptions.priority = defaultPriority;
+    if (!options.IsObject())
+    {
+        return jobOptions;
+    }
+
+    Object object = options.As<Object>();
+    if (object.Get("priority").IsString())
+    {
+        jobOptions.priority = JobScheduler::parsePriority(object.Get("priority").As<String>().Utf8Value());
+    }
+    if (object.Get("deadlineMs").IsNumber())
+    {
+        // Bounded so the conversion below stays defined
+        const double MaxDeadlineMs = 365.0 * 24 * 60 * 60 * 1000;
+        double milliseconds = object.Get("deadlineMs").As<Number>().DoubleValue();
+        if (!(milliseconds >= 0 && milliseconds <= MaxDeadlineMs))
+            throw std::invalid_argument("deadlineMs must be from 0 to " + std::to_string(static_cast<int64_t>(MaxDeadlineMs)));
+        jobOptions.deadline = CancellationToken::Clock::now() +
+                              std::chrono::microseconds(static_cast<int64_t>(milliseconds * 1000));
+    }
+    return jobOptions;
+}
+
+/**
+ * Call onAbort when options.signal (an AbortSignal) aborts, at once if it
+ * already has
+ */
+void watchAbortSignal(Napi::Env env, const Napi::Value &options, std::function<void()> onAbort)
+{
+    if (!options.IsObject() || !options.As<Object>().Get("signal").IsObject())
+    {
+        return;
+    }
+
+    Object signal = options.As<Object>().Get("signal").As<Object>();
+    if (signal.Get("aborted").ToBoolean())
+    {
+        onAbort();
+        return;
+    }
+
+    Object listenerOptions = Object::New(env);
+    listenerOptions.Set("once", Boolean::New(env, true));
+    Function listener = Function::New(env, [onAbort](const CallbackInfo &)
+                                      { onAbort(); });
+    signal.Get("addEventListener").As<Function>().Call(signal, {String::New(env, "abort"), listener, listenerOptions});
+}
+
+/**
+ * Rejection value for a failed job: an AbortError when it was cancelled or
+ * ran past its deadline, the usual TypeError otherwise
+ */
+Napi::Value jobError(Napi::Env env, std::exception_ptr error)
+{
+    try
+    {
+        std::rethrow_exception(error);
+    }
+    catch (const JobCancelled &e)
+    {
+        Object abort = Error::New(env, e.what()).Value().As<Object>();
+        abort.Set("name", String::New(env, "AbortError"));
+        return abort;
+    }
+    catch (const std::exception &e)
+    {
+        return TypeError::New(env, std::string("C++ Error: ") + e.what()).Value();
+    }
+    catch (...)
+    {
+        return TypeError::New(env, "C++ Error: unknown failure").Value();
+    }
+}
+
+Object convertProgress(Napi::Env env, const ProgressSnapshot &snapshot)
+{
+    Object result = Object::New(env);
+    result.Set("explored", Number::New(env, static_cast<double>(snapshot.explored)));
+    result.Set("frontier", Number::New(env, static_cast<double>(snapshot.frontier)));
+    result.Set("depth", Number::New(env, snapshot.depth));
+    result.Set("bytes", Number::New(env, static_cast<double>(snapshot.bytes)));
+    result.Set("elapsedMs", Number::New(env, snapshot.elapsedMs));
+    result.Set("statesPerSecond", Number::New(env, snapshot.statesPerSecond));
+    result.Set("etaMs", Number::New(env, snapshot.etaMs));
+    return result;
+}
+
+/**
+ * Sink relaying a job's progress to options.onProgress on the main thread,
+ * or nullptr without one. The queue holds a single event, so the analysis
+ * never waits: while the main thread has not taken the last event, newer
+ * ones are dropped.
+ */
+std::shared_ptr<ProgressSink> progressSink(Napi::Env env, const Napi::Value &options)
+{
+    if (!options.IsObject() || !options.As<Object>().Get("onProgress").IsFunction())
+    {
+        return nullptr;
+    }
+
+    // Released with the last copy of the sink, on whichever thread drops it
+    struct Channel
+    {
+        ThreadSafeFunction function;
+        ~Channel() { function.Release(); }
+    };
+    auto channel = std::make_shared<Channel>();
+    channel->function = ThreadSafeFunction::New(env, options.As<Object>().Get("onProgress").As<Function>(), "progress", 1, 1);
+
+    auto publish = [channel](const ProgressSnapshot &snapshot)
+    {
+        auto deliver = [](Napi::Env env, Function callback, ProgressSnapshot *event)
+        {
+            callback.Call({convertProgress(env, *event)});
+            delete event;
+        };
+        auto *event = new ProgressSnapshot(snapshot);
+        if (channel->function.NonBlockingCall(event, deliver) != napi_ok)
+            delete event;
+    };
+    return std::make_shared<ProgressSink>(publish);
+}
+
+/**
+ * Run work on the scheduler and settle a Promise with convert(result) on
+ * the main thread. options.signal cancels the job and options.onProgress
+ * receives its progress. With options.trace the job's spans are traced
+ * under trace (a new request when 0) and attached to the result.
+ */
+template <typename Result>
+Promise scheduleJob(Napi::Env env, const Napi::Value &options, JobPriority defaultPriority,
+                    std::function<Result()> work, std::function<Napi::Value(Napi::Env, const Result &)> convert,
+                    uint32_t trace = 0)
+{
+    struct Pending
+    {
+        Promise::Deferred deferred;
+        Result result;
+        bool settled = false;
+    };
+    auto pending = std::make_shared<Pending>(Pending{Promise::Deferred::New(env), Result()});
+
+    JobOptions jobOptions = convertJobOptions(options, defaultPriority);
+    auto completion = ThreadSafeFunction::New(env, Function::New(env, [](const CallbackInfo &) {}), "job", 0, 1);
+
+    auto sink = progressSink(env, options);
+    if (!trace)
+        trace = traceRequest(options);
+    auto run = [pending, work, sink, trace]()
+    {
+        ProgressScope scope(sink.get());
+        TraceRequestScope tracing(trace);
+        pending->result = work();
+    };
+    auto done = [pending, convert, completion, trace](std::exception_ptr error)
+    {
+        auto settle = [pending, convert, error, trace](Napi::Env env, Function)
+        {
+            if (pending->settled)
+                return;
+            pending->settled = true;
+            if (error)
+                pending->deferred.Reject(jobError(env, error));
+            else
+                pending->deferred.Resolve(attachTrace(env, convert(env, pending->result), trace));
+        };
+        completion.NonBlockingCall(settle);
+        completion.Release();
+    };
+    auto token = scheduler.submit(run, done, jobOptions);
+
+    watchAbortSignal(env, options, [token]()
+                     { scheduler.cancel(token); });
+    return pending->deferred.Promise();
+}
+
+/**
+ * Verifications waiting on a scheduled job, by machine hash; main thread
+ * only. The job is cancelled once every request waiting for it aborts.
+ */
+struct PendingVerification
+{
+    std::shared_ptr<CancellationToken> token;
+    uint64_t flight = 0;
+    size_t waiting = 0;
+    JobPriority priority = JobPriority::Interactive;
+};
+std::unordered_map<MachineHash, PendingVerification, MachineHashHasher> pendingVerifications;
+
+/**
+ * verifyStateMachine on the job scheduler, returning a Promise.
+ * Options: { priority = "interactive", deadlineMs, signal, onProgress,
+ * timeBudgetMs, memoryBudgetMb, trace }
+ * Requests for a machine already being verified at the same priority share
+ * that run instead of starting their own, and only the first request's
+ * onProgress receives progress. Budgeted requests always run on their own,
+ * since their report may be partial, and so do traced ones, whose trace
+ * must cover their own run, and ones with a deadline, which the shared run
+ * would not honour.
+ */
+Value VerifyStateMachineAsync(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        deferred.Reject(TypeError::New(env, "State machine object expected").Value());
+        return deferred.Promise();
+    }
+
+    // Timed until the Promise settles, so queueing counts
+    auto started = std::chrono::steady_clock::now();
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        uint32_t trace = traceRequest(options);
+        TraceRequestScope tracing(trace);
+        PhaseStats convert;
+        StateMachine machine = convertTimed(info[0].As<Object>(), convert);
+        verifyMetrics.input(machine);
+        MachineHash hash = canonicalHash(machine);
+        JobOptions jobOptions = convertJobOptions(options, JobPriority::Interactive);
+        AnalysisBudget budget = convertBudget(options);
+
+        Verifier::VerificationReport cachedReport;
+        if (reportCache.lookup(hash, cachedReport))
+        {
+            Object result = convertVerificationReport(env, cachedReport, convert);
+            result.Set("hash", String::New(env, hash.hex()));
+            result.Set("cached", Boolean::New(env, true));
+            result.Set("shared", Boolean::New(env, false));
+            verifyMetrics.finish(started);
+            deferred.Resolve(attachTrace(env, result, trace));
+            return deferred.Promise();
+        }
+
+        auto pending = pendingVerifications.find(hash);
+        bool shareable = budget.unlimited() && !trace &&
+                         jobOptions.deadline == CancellationToken::Clock::time_point::max() &&
+                         (pending == pendingVerifications.end() || pending->second.priority == jobOptions.priority);
+        if (!shareable)
+        {
+            std::function<Verifier::VerificationReport()> work = [machine = std::move(machine), hash, budget, started]()
+            {
+                try
+                {
+                    auto report = Verifier::generateReport(machine, budget);
+                    verificationTotals.record(report.stats);
+                    reportCache.store(hash, report);
+                    return report;
+                }
+                catch (...)
+                {
+                    verifyMetrics.errors.add();
+                    verifyMetrics.finish(started);
+                    throw;
+                }
+            };
+            std::function<Napi::Value(Napi::Env, const Verifier::VerificationReport &)> toJS =
+                [hash, convert, started](Napi::Env env, const Verifier::VerificationReport &report)
+            {
+                verifyMetrics.finish(started);
+                Object result = convertVerificationReport(env, report, convert);
+                result.Set("hash", String::New(env, hash.hex()));
+                result.Set("cached", Boolean::New(env, false));
+                result.Set("shared", Boolean::New(env, false));
+                return result;
+            };
+            return scheduleJob<Verifier::VerificationReport>(env, options, JobPriority::Interactive, work, toJS, trace);
+        }
+
+        // Waiters run on the main thread, from the job's completion
+        auto settled = std::make_shared<bool>(false);
+        auto follower = std::make_shared<bool>(false);
+        auto waiter = [deferred, hash, settled, follower, convert, started](const Verifier::VerificationReport *report,
+                                                                           std::exception_ptr error)
+        {
+            if (*settled)
+                return;
+            *settled = true;
+            verifyMetrics.finish(started);
+
+            Napi::Env env = deferred.Env();
+            if (!report)
+            {
+                verifyMetrics.errors.add();
+                deferred.Reject(jobError(env, error));
+                return;
+            }
+            Object result = convertVerificationReport(env, *report, convert);
+            result.Set("hash", String::New(env, hash.hex()));
+            result.Set("cached", Boolean::New(env, false));
+            result.Set("shared", Boolean::New(env, *follower));
+            deferred.Resolve(result);
+        };
+
+        auto ticket = verificationFlights.join(hash, waiter);
+        *follower = !ticket.leader;
+        if (ticket.leader)
+        {
+            auto report = std::make_shared<Verifier::VerificationReport>();
+            auto completion = ThreadSafeFunction::New(env, Function::New(env, [](const CallbackInfo &) {}), "verify", 0, 1);
+            uint64_t flight = ticket.flight;
+            auto sink = progressSink(env, options);
+            auto run = [machine = std::move(machine), hash, report, sink]()
+            {
+                ProgressScope scope(sink.get());
+                *report = Verifier::generateReport(machine);
+                verificationTotals.record(report->stats);
+                reportCache.store(hash, *report);
+            };
+            auto done = [hash, flight, report, completion](std::exception_ptr error)
+            {
+                auto settle = [hash, flight, report, error](Napi::Env, Function)
+                {
+                    auto it = pendingVerifications.find(hash);
+                    if (it != pendingVerifications.end() && it->second.flight == flight)
+                        pendingVerifications.erase(it);
+                    if (error)
+                        verificationFlights.fail(hash, flight, error);
+                    else
+                        verificationFlights.finish(hash, flight, *report);
+                };
+                completion.NonBlockingCall(settle);
+                completion.Release();
+            };
+            auto token = scheduler.submit(run, done, jobOptions);
+            pendingVerifications[hash] = PendingVerification{token, flight, 1, jobOptions.priority};
+        }
+        else
+        {
+            pendingVerifications[hash].waiting++;
+        }
+
+        // An aborted request settles at once; the run stops when nobody waits
+        uint64_t flight = ticket.flight;
+        auto abort = [deferred, hash, flight, settled]()
+        {
+            if (*settled)
+                return;
+            *settled = true;
+            Napi::Env env = deferred.Env();
+            Object error = Error::New(env, "Request aborted").Value().As<Object>();
+            error.Set("name", String::New(env, "AbortError"));
+            deferred.Reject(error);
+
+            auto it = pendingVerifications.find(hash);
+            if (it != pendingVerifications.end() && it->second.flight == flight && --it->second.waiting == 0)
+            {
+                verificationFlights.abandon(hash, flight);
+                scheduler.cancel(it->second.token);
+                pendingVerifications.erase(it);
+            }
+        };
+        watchAbortSignal(env, options, abort);
+    }
+    catch (const std::exception &e)
+    {
+        verifyMetrics.errors.add();
+        deferred.Reject(TypeError::New(env, std::string("C++ Error: ") + e.what()).Value());
+    }
+    return deferred.Promise();
+}
+
+/**
+ * Queue, running and outcome counts of the job scheduler
+ */
+Value SchedulerStats(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    JobScheduler::Stats stats = scheduler.stats();
+    static const char *classes[] = {"interactive", "normal", "bulk"};
+
+    Object queued = Object::New(env);
+    Object running = Object::New(env);
+    for (int p = 0; p < 3; p++)
+    {
+        queued.Set(classes[p], Number::New(env, static_cast<double>(stats.queued[p])));
+        running.Set(classes[p], Number::New(env, static_cast<double>(stats.running[p])));
+    }
+
+    Object result = Object::New(env);
+    result.Set("workers", Number::New(env, stats.workers));
+    result.Set("queued", queued);
+    result.Set("running", running);
+    result.Set("completed", Number::New(env, static_cast<double>(stats.completed)));
+    result.Set("failed", Number::New(env, static_cast<double>(stats.failed)));
+    result.Set("cancelled", Number::New(env, static_cast<double>(stats.cancelled)));
+    return result;
+}
+
+/**
+ * Every native metric in the Prometheus text format: the registry's
+ * latency and input-size summaries, then the verification phase totals,
+ * the report cache and the job scheduler
+ */
+Value MetricsText(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    std::string out = MetricsRegistry::global().prometheusText();
+    auto family = [&out](const std::string &name, const char *type, const std::string &help)
+    {
+        MetricsRegistry::writeHeader(out, name, type, help);
+    };
+    auto sample = [&out](const std::string &name, const std::string &labels, double value)
+    {
+        MetricsRegistry::writeSample(out, name, labels, value);
+    };
+
+    VerificationStatsTotals::Snapshot totals = verificationTotals.snapshot();
+    family("rsm_verify_phase_seconds_total", "counter", "Wall time of verification phases");
+    for (const auto &entry : totals.phases)
+        sample("rsm_verify_phase_seconds_total", "phase=\"" + entry.first + "\"", entry.second.wallMs / 1000);
+    family("rsm_verify_phase_cpu_seconds_total", "counter", "Thread CPU time of verification phases");
+    for (const auto &entry : totals.phases)
+        sample("rsm_verify_phase_cpu_seconds_total", "phase=\"" + entry.first + "\"", entry.second.cpuMs / 1000);
+    family("rsm_verify_runs_total", "counter", "Verifications run, not answered from the cache");
+    sample("rsm_verify_runs_total", "", static_cast<double>(totals.runs));
+    family("rsm_verify_states_total", "counter", "States or configurations expanded by verifications");
+    sample("rsm_verify_states_total", "", static_cast<double>(totals.states));
+    family("rsm_verify_edges_total", "counter", "Edges or macrosteps followed by verifications");
+    sample("rsm_verify_edges_total", "", static_cast<double>(totals.edges));
+    family("rsm_verify_peak_bytes", "gauge", "Largest analysis tables of any verification");
+    sample("rsm_verify_peak_bytes", "", static_cast<double>(totals.peakBytes));
+
+    ReportCache::Stats cache = reportCache.stats();
+    family("rsm_report_cache_lookups_total", "counter", "Report cache lookups by outcome");
+    sample("rsm_report_cache_lookups_total", "outcome=\"hit\"", static_cast<double>(cache.hits));
+    sample("rsm_report_cache_lookups_total", "outcome=\"disk_hit\"", static_cast<double>(cache.diskHits));
+    sample("rsm_report_cache_lookups_total", "outcome=\"miss\"", static_cast<double>(cache.misses));
+    family("rsm_report_cache_entries", "gauge", "Reports held in memory");
+    sample("rsm_report_cache_entries", "", static_cast<double>(cache.entries));
+
+    JobScheduler::Stats jobs = scheduler.stats();
+    static const char *classes[] = {"interactive", "normal", "bulk"};
+    family("rsm_jobs_queued", "gauge", "Native jobs waiting for a worker");
+    for (int p = 0; p < 3; p++)
+        sample("rsm_jobs_queued", std::string("priority=\"") + classes[p] + "\"", static_cast<double>(jobs.queued[p]));
+    family("rsm_jobs_running", "gauge", "Native jobs running");
+    for (int p = 0; p < 3; p++)
+        sample("rsm_jobs_running", std::string("priority=\"") + classes[p] + "\"", static_cast<double>(jobs.running[p]));
+    family("rsm_jobs_finished_total", "counter", "Native jobs finished by outcome");
+    sample("rsm_jobs_finished_total", "outcome=\"completed\"", static_cast<double>(jobs.completed));
+    sample("rsm_jobs_finished_total", "outcome=\"failed\"", static_cast<double>(jobs.failed));
+    sample("rsm_jobs_finished_total", "outcome=\"cancelled\"", static_cast<double>(jobs.cancelled));
+
+    return String::New(env, out);
+}
+
+/**
+ * Canonical hash of the verification-relevant parts of a machine
+ */
+Value MachineHashOf(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        return String::New(env, canonicalHash(convertJSStateMachine(info[0].As<Object>())).hex());
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Resize the report cache or move it to disk
+ * Options: { capacity, directory } (an empty directory keeps it in memory)
+ */
+Value ConfigureReportCache(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Object options = info[0].As<Object>();
+        ReportCache::Stats current = reportCache.stats();
+        size_t capacity = options.Get("capacity").IsNumber()
+                              ? static_cast<size_t>(options.Get("capacity").As<Number>().Int64Value())
+                              : current.capacity;
+        std::string directory = options.Get("directory").IsString()
+                                    ? options.Get("directory").As<String>().Utf8Value()
+                                    : current.directory;
+        reportCache.configure(capacity, directory);
+        return ReportCacheStats(info);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Check reachability
+ */
+Value CheckReachability(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 2)
+    {
+        TypeError::New(env, "State machine and target state ID expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ScopedLatency latency(reachabilityMetrics.latency);
+    try
+    {
+        Object jsStateMachine = info[0].As<Object>();
+        std::string targetStateId = info[1].As<String>().Utf8Value();
+
+        StateMachine machine = convertJSStateMachine(jsStateMachine);
+        reachabilityMetrics.input(machine);
+        auto result = Verifier::isStateReachable(machine, targetStateId);
+
+        Object jsResult = Object::New(env);
+        jsResult.Set("isReachable", Boolean::New(env, result.isReachable));
+        jsResult.Set("message", String::New(env, result.message));
+
+        return jsResult;
+    }
+    catch (const std::exception &e)
+    {
+        reachabilityMetrics.errors.add();
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Find deadlocks
+ */
+Value FindDeadlocks(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ScopedLatency latency(deadlockMetrics.latency);
+    try
+    {
+        Object jsStateMachine = info[0].As<Object>();
+        StateMachine machine = convertJSStateMachine(jsStateMachine);
+        deadlockMetrics.input(machine);
+
+        auto deadlocks = Verifier::findDeadlocks(machine);
+
+        Array result = Array::New(env);
+        for (size_t i = 0; i < deadlocks.size(); i++)
+        {
+            result.Set(i, String::New(env, deadlocks[i]));
+        }
+
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        deadlockMetrics.errors.add();
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Simulate a nondeterministic machine on an input sequence
+ */
+Value SimulateNondeterministic(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsArray())
+    {
+        TypeError::New(env, "State machine and input array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ScopedLatency latency(simulateMetrics.latency);
+    try
+    {
+        StateMachine machine = convertJSStateMachine(info[0].As<Object>());
+        std::vector<std::string> inputs = convertJSStringArray(info[1].As<Array>());
+        simulateMetrics.input(machine);
+        simulateMetrics.input(inputs.size());
+
+        auto compiled = CompiledMachine::compile(machine);
+        auto run = NondeterministicSimulator::run(compiled, inputs);
+
+        Object result = Object::New(env);
+        result.Set("accepted", Boolean::New(env, run.accepted));
+        result.Set("stepsConsumed", Number::New(env, static_cast<double>(run.stepsConsumed)));
+
+        Array activeArray = Array::New(env);
+        for (size_t i = 0; i < run.activeStates.size(); i++)
+        {
+            activeArray.Set(i, String::New(env, run.activeStates[i]));
+        }
+        result.Set("activeStates", activeArray);
+
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        simulateMetrics.errors.add();
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Find every position in an input sequence where the machine accepts
+ */
+Value FindInputMatches(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsArray())
+    {
+        TypeError::New(env, "State machine and input array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        StateMachine machine = convertJSStateMachine(info[0].As<Object>());
+        std::vector<std::string> inputs = convertJSStringArray(info[1].As<Array>());
+
+        auto compiled = CompiledMachine::compile(machine);
+        auto ends = NondeterministicSimulator::findMatches(compiled, inputs);
+
+        Array result = Array::New(env);
+        for (size_t i = 0; i < ends.size(); i++)
+        {
+            result.Set(i, Number::New(env, static_cast<double>(ends[i])));
+        }
+
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Generate a standalone C++ header (and conformance test) for a machine
+ */
+Value GenerateCppCode(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        StateMachine machine = convertJSStateMachine(info[0].As<Object>());
+
+        CodeGenOptions options;
+        if (info.Length() > 1 && info[1].IsObject())
+        {
+            Object jsOptions = info[1].As<Object>();
+            if (jsOptions.Get("namespace").IsString())
+            {
+                options.namespaceName = jsOptions.Get("namespace").As<String>().Utf8Value();
+            }
+            if (jsOptions.Get("className").IsString())
+            {
+                options.className = jsOptions.Get("className").As<String>().Utf8Value();
+            }
+            if (jsOptions.Get("dispatch").IsString())
+            {
+                std::string dispatch = jsOptions.Get("dispatch").As<String>().Utf8Value();
+                if (dispatch == "switch")
+                    options.dispatch = CodeGenOptions::Dispatch::Switch;
+                else if (dispatch == "table")
+                    options.dispatch = CodeGenOptions::Dispatch::Table;
+            }
+        }
+
+        auto code = CodeGenerator::generate(machine, options);
+
+        Object result = Object::New(env);
+        result.Set("headerName", String::New(env, code.headerName));
+        result.Set("header", String::New(env, code.header));
+        result.Set("conformanceTest", String::New(env, code.conformanceTest));
+
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Encode SimulationStep[] ({step, currentState, nextState, input, output,
+ * transitionId}) into the compact binary trace format
+ */
+Value EncodeTrace(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray())
+    {
+        TypeError::New(env, "Simulation step array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        auto text = [](const Object &object, const char *key)
+        {
+            Napi::Value value = object.Get(key);
+            return value.IsString() ? value.As<String>().Utf8Value() : std::string();
+        };
+
+        Array jsSteps = info[0].As<Array>();
+        uint32_t blockRecords = TraceEncoder::DefaultBlockRecords;
+        if (info.Length() > 1 && info[1].IsObject() && info[1].As<Object>().Get("blockRecords").IsNumber())
+        {
+            blockRecords = info[1].As<Object>().Get("blockRecords").As<Number>().Uint32Value();
+        }
+
+        TraceEncoder encoder(blockRecords);
+        TraceRecord record;
+        for (uint32_t i = 0; i < jsSteps.Length(); i++)
+        {
+            Object jsStep = jsSteps.Get(i).As<Object>();
+            record.step = jsStep.Get("step").IsNumber()
+                              ? static_cast<uint64_t>(jsStep.Get("step").As<Number>().Int64Value())
+                              : record.step + 1;
+            record.currentState = text(jsStep, "currentState");
+            record.nextState = text(jsStep, "nextState");
+            record.input = text(jsStep, "input");
+            record.output = text(jsStep, "output");
+            record.transitionId = text(jsStep, "transitionId");
+            encoder.append(record);
+        }
+
+        std::vector<uint8_t> encoded = encoder.finish();
+        return Buffer<uint8_t>::Copy(env, encoded.data(), encoded.size());
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Decode steps [from, from + count) of an encoded trace
+ */
+Value DecodeTrace(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        TypeError::New(env, "Encoded trace buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Buffer<uint8_t> buffer = info[0].As<Buffer<uint8_t>>();
+        TraceReader reader(buffer.Data(), buffer.Length());
+
+        uint64_t from = info.Length() > 1 && info[1].IsNumber() ? convertStep(info[1], "from") : 0;
+        uint64_t count = info.Length() > 2 && info[2].IsNumber() ? convertStep(info[2], "count") : reader.size();
+
+        // One JS string per interned string
+        std::vector<Napi::Value> strings;
+        strings.reserve(reader.strings().size());
+        for (const auto &value : reader.strings())
+        {
+            strings.push_back(String::New(env, value));
+        }
+        Napi::Value empty = String::New(env, "");
+        auto text = [&](int32_t id)
+        { return id < 0 ? empty : strings[id]; };
+
+        auto records = reader.read(from, count);
+        Array steps = Array::New(env, records.size());
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            const EncodedRecord &record = records[i];
+            Object step = Object::New(env);
+            step.Set("step", Number::New(env, static_cast<double>(record.step)));
+            step.Set("currentState", text(record.currentState));
+            step.Set("nextState", text(record.nextState));
+            step.Set("input", text(record.input));
+            if (record.output >= 0)
+            {
+                step.Set("output", text(record.output));
+            }
+            step.Set("transitionId", text(record.transitionId));
+            steps.Set(i, step);
+        }
+
+        Object result = Object::New(env);
+        result.Set("totalSteps", Number::New(env, static_cast<double>(reader.size())));
+        result.Set("steps", steps);
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Long-lived simulation of one machine; hot sessions tier up from the
+ * bytecode interpreter to threaded code
+ */
+class SimulationSession : public ObjectWrap<SimulationSession>
+{
+public:
+    static Function Init(Napi::Env env)
+    {
+        return DefineClass(env, "SimulationSession",
+                           {InstanceMethod("step", &SimulationSession::Step),
+                            InstanceMethod("run", &SimulationSession::Run),
+                            InstanceMethod("runUntilBreakpoint", &SimulationSession::RunUntilBreakpoint),
+                            InstanceMethod("reset", &SimulationSession::Reset),
+                            InstanceMethod("stats", &SimulationSession::Stats)});
+    }
+
+    SimulationSession(const CallbackInfo &info) : ObjectWrap<SimulationSession>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject())
+        {
+            TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+            return;
+        }
+
+        try
+        {
+            machine = convertJSStateMachine(info[0].As<Object>());
+            program.reset(new MachineProgram(MachineProgram::compile(machine)));
+
+            uint64_t tierUpSteps = TieredSimulator::DefaultTierUpSteps;
+            if (info.Length() > 1 && info[1].IsObject() && info[1].As<Object>().Get("tierUpSteps").IsNumber())
+            {
+                tierUpSteps = convertCount(info[1].As<Object>(), "tierUpSteps", 0, MaxSafeInteger);
+            }
+            simulator.reset(new TieredSimulator(*program, tierUpSteps));
+            breakpointRunner.reset(new BreakpointRunner(*program, *simulator));
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    StateMachine machine;
+    std::unique_ptr<MachineProgram> program;
+    std::unique_ptr<TieredSimulator> simulator;
+    std::unique_ptr<BreakpointRunner> breakpointRunner;
+
+    std::string stateId() const
+    {
+        int32_t state = simulator->currentState();
+        return state < 0 ? std::string() : program->graph.stateIds[state];
+    }
+
+    Napi::Value Step(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!simulator || info.Length() < 1 || !info[0].IsString())
+        {
+            TypeError::New(env, "Input string expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        int32_t edge = simulator->step(program->graph.findInput(info[0].As<String>().Utf8Value()));
+
+        Object result = Object::New(env);
+        result.Set("fired", Boolean::New(env, edge >= 0));
+        result.Set("state", String::New(env, stateId()));
+        if (edge >= 0)
+        {
+            const Transition &transition = machine.transitions[program->graph.edgeTransitions[edge]];
+            result.Set("transitionId", String::New(env, transition.id));
+            result.Set("output", String::New(env, transition.output));
+        }
+        return result;
+    }
+
+    Napi::Value Run(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!simulator || info.Length() < 1 || !info[0].IsArray())
+        {
+            TypeError::New(env, "Input array expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        ScopedLatency latency(sessionRunMetrics.latency);
+        std::vector<std::string> inputs = convertJSStringArray(info[0].As<Array>());
+        sessionRunMetrics.input(inputs.size());
+        std::vector<int32_t> encoded;
+        encoded.reserve(inputs.size());
+        for (const auto &input : inputs)
+        {
+            encoded.push_back(program->graph.findInput(input));
+        }
+
+        std::vector<int32_t> edges(encoded.size(), -1);
+        auto run = simulator->run(encoded.data(), encoded.size(), edges.data());
+
+        Array transitionIds = Array::New(env);
+        for (size_t i = 0; i < run.steps; i++)
+        {
+            transitionIds.Set(i, String::New(env, machine.transitions[program->graph.edgeTransitions[edges[i]]].id));
+        }
+
+        Object result = Object::New(env);
+        result.Set("steps", Number::New(env, static_cast<double>(run.steps)));
+        result.Set("failed", Boolean::New(env, run.failed));
+        result.Set("state", String::New(env, stateId()));
+        result.Set("transitionIds", transitionIds);
+        return result;
+    }
+
+    /**
+     * Run until a breakpoint matches; only the frames around the hit are
+     * returned
+     */
+    Napi::Value RunUntilBreakpoint(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!simulator || info.Length() < 2 || !info[0].IsArray() || !info[1].IsArray())
+        {
+            TypeError::New(env, "Input array and breakpoint array expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        try
+        {
+            BreakpointSet breakpoints = BreakpointSet::compile(
+                machine, *program, convertJSBreakpoints(info[1].As<Array>()));
+
+            BreakpointWindow window;
+            if (info.Length() > 2 && info[2].IsObject())
+            {
+                Object options = info[2].As<Object>();
+                if (options.Get("before").IsNumber())
+                    window.before = options.Get("before").As<Number>().Uint32Value();
+                if (options.Get("after").IsNumber())
+                    window.after = options.Get("after").As<Number>().Uint32Value();
+            }
+
+            std::vector<std::string> inputs = convertJSStringArray(info[0].As<Array>());
+            std::vector<int32_t> encoded;
+            encoded.reserve(inputs.size());
+            for (const auto &input : inputs)
+            {
+                encoded.push_back(program->graph.findInput(input));
+            }
+
+            auto run = breakpointRunner->run(breakpoints, encoded.data(), encoded.size(), window);
+
+            Object result = Object::New(env);
+            result.Set("steps", Number::New(env, static_cast<double>(run.steps)));
+            result.Set("failed", Boolean::New(env, run.failed));
+            result.Set("state", String::New(env, stateId()));
+            if (run.breakpoint >= 0)
+            {
+                Array context = Array::New(env);
+                for (size_t i = 0; i < run.context.size(); i++)
+                {
+                    context.Set(i, convertTraceFrame(env, machine, *program, run.context[i]));
+                }
+                result.Set("breakpoint", Number::New(env, run.breakpoint));
+                result.Set("context", context);
+                result.Set("hitFrame", Number::New(env, static_cast<double>(run.hitFrame)));
+            }
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value Reset(const CallbackInfo &info)
+    {
+        if (simulator)
+        {
+            simulator->reset();
+            breakpointRunner->reset();
+        }
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Stats(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        Object result = Object::New(env);
+        if (simulator)
+        {
+            result.Set("totalSteps", Number::New(env, static_cast<double>(simulator->totalSteps())));
+            result.Set("compiled", Boolean::New(env, simulator->isCompiled()));
+        }
+        return result;
+    }
+};
+
+/**
+ * Time-travel trace: compact input log with periodic snapshots, seekable
+ * to any step
+ */
+class TraceRecorder : public ObjectWrap<TraceRecorder>
+{
+public:
+    static Function Init(Napi::Env env)
+    {
+        return DefineClass(env, "TraceRecorder",
+                           {InstanceMethod("record", &TraceRecorder::Record),
+                            InstanceMethod("seek", &TraceRecorder::Seek),
+                            InstanceMethod("frames", &TraceRecorder::Frames),
+                            InstanceMethod("stats", &TraceRecorder::Stats)});
+    }
+
+    TraceRecorder(const CallbackInfo &info) : ObjectWrap<TraceRecorder>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject())
+        {
+            TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+            return;
+        }
+
+        try
+        {
+            machine = convertJSStateMachine(info[0].As<Object>());
+            program.reset(new MachineProgram(MachineProgram::compile(machine)));
+
+            TraceStoreOptions options;
+            if (info.Length() > 1 && info[1].IsObject() && info[1].As<Object>().Get("targetSeekMicros").IsNumber())
+            {
+                // A seek target beyond a second defeats the snapshots
+                double micros = info[1].As<Object>().Get("targetSeekMicros").As<Number>().DoubleValue();
+                if (!(micros >= 0 && micros <= 1e6))
+                    throw std::invalid_argument("targetSeekMicros must be from 0 to 1000000");
+                options.targetSeekNanos = static_cast<uint64_t>(micros * 1000);
+            }
+            store.reset(new TraceStore(*program, options));
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    StateMachine machine;
+    std::unique_ptr<MachineProgram> program;
+    std::unique_ptr<TraceStore> store;
+
+    Napi::Value Record(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!store || info.Length() < 1 || !info[0].IsArray())
+        {
+            TypeError::New(env, "Input array expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        std::vector<std::string> inputs = convertJSStringArray(info[0].As<Array>());
+        std::vector<int32_t> encoded;
+        encoded.reserve(inputs.size());
+        for (const auto &input : inputs)
+        {
+            encoded.push_back(program->graph.findInput(input));
+        }
+        size_t consumed = store->record(encoded.data(), encoded.size());
+
+        Object result = Object::New(env);
+        result.Set("consumed", Number::New(env, static_cast<double>(consumed)));
+        result.Set("length", Number::New(env, static_cast<double>(store->length())));
+        return result;
+    }
+
+    Napi::Value Seek(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!store || info.Length() < 1 || !info[0].IsNumber())
+        {
+            TypeError::New(env, "Step number expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        try
+        {
+            return convertTraceFrame(env, machine, *program, store->seek(convertStep(info[0], "step")));
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value Frames(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!store || info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+        {
+            TypeError::New(env, "Start step and count expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        try
+        {
+            auto frames = store->frames(convertStep(info[0], "from"), static_cast<size_t>(convertStep(info[1], "count")));
+
+            Array result = Array::New(env);
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                result.Set(i, convertTraceFrame(env, machine, *program, frames[i]));
+            }
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value Stats(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        Object result = Object::New(env);
+        if (store)
+        {
+            result.Set("length", Number::New(env, static_cast<double>(store->length())));
+            result.Set("snapshots", Number::New(env, static_cast<double>(store->snapshotCount())));
+            result.Set("snapshotInterval", Number::New(env, store->snapshotInterval()));
+            result.Set("memoryBytes", Number::New(env, static_cast<double>(store->memoryBytes())));
+        }
+        return result;
+    }
+};
+
+/**
+ * Save a machine in the binary model format
+ */
+Value SaveModel(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString())
+    {
+        TypeError::New(env, "State machine object and path expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        MappedModel::save(convertJSStateMachine(info[0].As<Object>()), info[1].As<String>().Utf8Value());
+        return env.Undefined();
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Import a KISS2 (MCNC/LGSynth) machine from text or a Buffer
+ */
+Value ImportKiss2(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer()))
+    {
+        TypeError::New(env, "KISS2 text or buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        KissParser parser;
+        if (info[0].IsBuffer())
+        {
+            Buffer<char> buffer = info[0].As<Buffer<char>>();
+            parser.feed(buffer.Data(), buffer.Length());
+        }
+        else
+        {
+            std::string text = info[0].As<String>().Utf8Value();
+            parser.feed(text.data(), text.size());
+        }
+        KissMachine machine = parser.finish();
+
+        std::string name = info.Length() > 1 && info[1].IsString() ? info[1].As<String>().Utf8Value() : "kiss2";
+        Object result = Object::New(env);
+        result.Set("stateMachine", convertStateMachineToJS(env, machine.toStateMachine(name)));
+        result.Set("inputBits", Number::New(env, machine.inputBits));
+        result.Set("outputBits", Number::New(env, machine.outputBits));
+        result.Set("productTerms", Number::New(env, static_cast<double>(machine.productTerms)));
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Convert a statechart exploration report to JS
+ */
+Object convertStatechartReport(Env env, const StatechartReport &report)
+{
+    auto stringsToJS = [env](const std::vector<std::string> &strings)
+    {
+        Array result = Array::New(env, strings.size());
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            result.Set(i, String::New(env, strings[i]));
+        }
+        return result;
+    };
+
+    Object result = Object::New(env);
+    result.Set("configurations", Number::New(env, static_cast<double>(report.configurations)));
+    result.Set("macrosteps", Number::New(env, static_cast<double>(report.macrosteps)));
+    result.Set("terminalConfigurations", Number::New(env, static_cast<double>(report.terminalConfigurations)));
+    result.Set("divergentMacrosteps", Number::New(env, static_cast<double>(report.divergentMacrosteps)));
+    result.Set("deadlockCount", Number::New(env, static_cast<double>(report.deadlockCount)));
+    result.Set("complete", Boolean::New(env, report.complete));
+    result.Set("stopReason", String::New(env, stopReasonName(report.stopReason)));
+    result.Set("expanded", Number::New(env, static_cast<double>(report.expanded)));
+    result.Set("frontier", Number::New(env, static_cast<double>(report.frontier)));
+    result.Set("elapsedMs", Number::New(env, report.elapsedMs));
+    result.Set("flattenedSize", Number::New(env, report.flattenedSize));
+    result.Set("unreachableStates", stringsToJS(report.unreachableStates));
+
+    Array deadlocks = Array::New(env, report.deadlocks.size());
+    for (size_t i = 0; i < report.deadlocks.size(); i++)
+    {
+        deadlocks.Set(i, stringsToJS(report.deadlocks[i]));
+    }
+    result.Set("deadlocks", deadlocks);
+    result.Set("deadlockedStates", stringsToJS(report.deadlockedStates));
+    result.Set("deadlockPath", stringsToJS(report.deadlockPath));
+    return result;
+}
+
+/**
+ * A parsed SCXML document with its exploration
+ */
+struct ImportedScxml
+{
+    Statechart chart;
+    StatechartReport report;
+};
+
+ImportedScxml importScxmlDocument(const std::string &document, size_t maxConfigurations, const AnalysisBudget &budget,
+                                  const CheckpointOptions &checkpoint)
+{
+    ImportedScxml imported;
+    imported.chart = statechartFromScxml(document);
+    imported.report = StatechartExplorer::explore(imported.chart, maxConfigurations, budget, checkpoint);
+    return imported;
+}
+
+/**
+ * Document text from a string or Buffer argument
+ */
+std::string readDocument(const Napi::Value &value)
+{
+    if (value.IsBuffer())
+    {
+        Buffer<char> buffer = value.As<Buffer<char>>();
+        return std::string(buffer.Data(), buffer.Length());
+    }
+    return value.As<String>().Utf8Value();
+}
+
+size_t readMaxConfigurations(const CallbackInfo &info)
+{
+    size_t maxConfigurations = 1000000;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Object options = info[1].As<Object>();
+        if (options.Get("maxConfigurations").IsNumber())
+            maxConfigurations = static_cast<size_t>(
+                convertCount(options, "maxConfigurations", 1, StatechartExplorer::MaxConfigurations));
+    }
+    return maxConfigurations;
+}
+
+/**
+ * Checkpoint options from JS: { checkpointDir, checkpointIntervalMs }
+ */
+CheckpointOptions readCheckpointOptions(const Napi::Value &options)
+{
+    CheckpointOptions checkpoint;
+    if (!options.IsObject())
+    {
+        return checkpoint;
+    }
+
+    Object object = options.As<Object>();
+    if (object.Get("checkpointDir").IsString())
+        checkpoint.directory = object.Get("checkpointDir").As<String>().Utf8Value();
+    if (object.Get("checkpointIntervalMs").IsNumber())
+        checkpoint.interval = std::chrono::milliseconds(
+            convertCount(object, "checkpointIntervalMs", 1, CheckpointOptions::MaxIntervalMs));
+    return checkpoint;
+}
+
+Napi::Value convertImportedScxml(Napi::Env env, const ImportedScxml &imported)
+{
+    const Statechart &chart = imported.chart;
+    static const char *kinds[] = {"atomic", "compound", "parallel", "final", "history", "deepHistory"};
+
+    Array states = Array::New(env, chart.nodes.size() - 1);
+    for (size_t n = 1; n < chart.nodes.size(); n++)
+    {
+        const Statechart::Node &node = chart.nodes[n];
+        Object state = Object::New(env);
+        state.Set("id", String::New(env, node.id));
+        state.Set("kind", String::New(env, kinds[static_cast<int>(node.kind)]));
+        if (node.parent != Statechart::Root)
+            state.Set("parent", String::New(env, chart.nodes[node.parent].id));
+        states.Set(n - 1, state);
+    }
+
+    Array transitions = Array::New(env, chart.transitions.size());
+    for (size_t i = 0; i < chart.transitions.size(); i++)
+    {
+        const Statechart::Transition &t = chart.transitions[i];
+        Object transition = Object::New(env);
+        transition.Set("id", String::New(env, t.id));
+        transition.Set("source", String::New(env, chart.nodes[t.source].id));
+        Array targets = Array::New(env, t.targets.size());
+        for (size_t j = 0; j < t.targets.size(); j++)
+        {
+            targets.Set(j, String::New(env, chart.nodes[t.targets[j]].id));
+        }
+        transition.Set("targets", targets);
+        std::string events;
+        for (const auto &descriptor : t.events)
+        {
+            events += (events.empty() ? "" : " ") + descriptor;
+        }
+        transition.Set("event", String::New(env, events));
+        if (!t.condition.empty())
+            transition.Set("cond", String::New(env, t.condition));
+        transitions.Set(i, transition);
+    }
+
+    Object result = Object::New(env);
+    result.Set("name", String::New(env, chart.name));
+    result.Set("states", states);
+    result.Set("transitions", transitions);
+    result.Set("report", convertStatechartReport(env, imported.report));
+    return result;
+}
+
+/**
+ * Import an SCXML document and explore its configurations on the fly
+ * Options: { maxConfigurations, timeBudgetMs, memoryBudgetMb, checkpointDir,
+ * checkpointIntervalMs }. With a checkpoint directory, the exploration
+ * resumes from the chart's checkpoint there and keeps it up to date.
+ */
+Value ImportScxml(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer()))
+    {
+        TypeError::New(env, "SCXML text or buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        return convertImportedScxml(env, importScxmlDocument(readDocument(info[0]), readMaxConfigurations(info),
+                                                             convertBudget(options), readCheckpointOptions(options)));
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * importScxml as a bulk job on the scheduler, returning a Promise
+ * Options: { maxConfigurations, timeBudgetMs, memoryBudgetMb, checkpointDir,
+ * checkpointIntervalMs, priority = "bulk", deadlineMs, signal, onProgress }
+ */
+Value ImportScxmlAsync(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer()))
+    {
+        TypeError::New(env, "SCXML text or buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        std::string document = readDocument(info[0]);
+        size_t maxConfigurations = readMaxConfigurations(info);
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        AnalysisBudget budget = convertBudget(options);
+        CheckpointOptions checkpoint = readCheckpointOptions(options);
+        std::function<ImportedScxml()> work = [document, maxConfigurations, budget, checkpoint]()
+        {
+            return importScxmlDocument(document, maxConfigurations, budget, checkpoint);
+        };
+        return scheduleJob<ImportedScxml>(env, info.Length() > 1 ? info[1] : env.Undefined(), JobPriority::Bulk,
+                                          work, convertImportedScxml);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Swarm options from JS: { searches, threads, bitstateBytes, maxDepth,
+ * seed, timeBudgetMs, memoryBudgetMb }, the budgets applying per search;
+ * searches, threads and bitstateBytes are bounded by SwarmOptions
+ */
+SwarmOptions convertSwarmOptions(const Napi::Value &options)
+{
+    SwarmOptions swarm;
+    swarm.budget = convertBudget(options);
+    if (!options.IsObject())
+    {
+        return swarm;
+    }
+
+    Object object = options.As<Object>();
+    if (object.Get("searches").IsNumber())
+        swarm.searches = static_cast<unsigned>(convertCount(object, "searches", 0, SwarmOptions::MaxSearches));
+    if (object.Get("threads").IsNumber())
+        swarm.threads = static_cast<unsigned>(convertCount(object, "threads", 0, SwarmOptions::MaxThreads));
+    if (object.Get("bitstateBytes").IsNumber())
+        swarm.bitstateBytes = static_cast<size_t>(convertCount(object, "bitstateBytes", 8, SwarmOptions::MaxBitstateBytes));
+    if (object.Get("maxDepth").IsNumber())
+        swarm.maxDepth = static_cast<uint32_t>(convertCount(object, "maxDepth", 1, UINT32_MAX));
+    if (object.Get("seed").IsNumber())
+        swarm.seed = static_cast<uint64_t>(object.Get("seed").As<Number>().Int64Value());
+    return swarm;
+}
+
+Napi::Value convertSwarmReport(Napi::Env env, const SwarmReport &report)
+{
+    auto stringsToJS = [env](const std::vector<std::string> &strings)
+    {
+        Array result = Array::New(env, strings.size());
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            result.Set(i, String::New(env, strings[i]));
+        }
+        return result;
+    };
+
+    Array deadlocks = Array::New(env, report.deadlocks.size());
+    for (size_t i = 0; i < report.deadlocks.size(); i++)
+    {
+        Object finding = Object::New(env);
+        finding.Set("configuration", stringsToJS(report.deadlocks[i].configuration));
+        finding.Set("path", stringsToJS(report.deadlocks[i].path));
+        finding.Set("foundBy", Number::New(env, report.deadlocks[i].foundBy));
+        deadlocks.Set(i, finding);
+    }
+
+    Object result = Object::New(env);
+    result.Set("searches", Number::New(env, report.searches));
+    result.Set("threads", Number::New(env, report.threads));
+    result.Set("bitstateBytes", Number::New(env, static_cast<double>(report.bitstateBytes)));
+    result.Set("statesVisited", Number::New(env, static_cast<double>(report.statesVisited)));
+    result.Set("transitions", Number::New(env, static_cast<double>(report.transitions)));
+    result.Set("truncated", Number::New(env, static_cast<double>(report.truncated)));
+    result.Set("divergentMacrosteps", Number::New(env, static_cast<double>(report.divergentMacrosteps)));
+    result.Set("bitstateFill", Number::New(env, report.bitstateFill));
+    result.Set("elapsedMs", Number::New(env, report.elapsedMs));
+    result.Set("deadlockCount", Number::New(env, static_cast<double>(report.deadlockCount)));
+    result.Set("deadlocks", deadlocks);
+    result.Set("statesCovered", Number::New(env, report.statesCovered));
+    result.Set("stateCount", Number::New(env, report.stateCount));
+    result.Set("unreachedStates", stringsToJS(report.unreachedStates));
+    return result;
+}
+
+/**
+ * Swarm verification of a state machine object or an SCXML document, as a
+ * bulk job returning a Promise. The searches run on threads of their own
+ * beside the scheduler's workers.
+ * Options: swarm options (see convertSwarmOptions), priority = "bulk",
+ * deadlineMs, signal
+ */
+Value SwarmVerifyAsync(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsObject() || info[0].IsString()))
+    {
+        TypeError::New(env, "State machine object or SCXML document expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        auto chart = std::make_shared<Statechart>(
+            info[0].IsString() || info[0].IsBuffer()
+                ? statechartFromScxml(readDocument(info[0]))
+                : Statechart::fromStateMachine(convertJSStateMachine(info[0].As<Object>())));
+        SwarmOptions swarm = convertSwarmOptions(options);
+        std::function<SwarmReport()> work = [chart, swarm]()
+        {
+            return Swarm::run(*chart, swarm);
+        };
+        return scheduleJob<SwarmReport>(env, options, JobPriority::Bulk, work, convertSwarmReport);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Parallel search options from JS: { threads, maxStates, seed,
+ * timeBudgetMs, memoryBudgetMb }; threads is at most
+ * ParallelSearchOptions::MaxThreads and maxStates at most
+ * ConcurrentStateSet::MaxCapacity
+ */
+ParallelSearchOptions convertParallelSearchOptions(const Napi::Value &options)
+{
+    ParallelSearchOptions search;
+    search.budget = convertBudget(options);
+    if (!options.IsObject())
+    {
+        return search;
+    }
+
+    Object object = options.As<Object>();
+    if (object.Get("threads").IsNumber())
+        search.threads = static_cast<unsigned>(convertCount(object, "threads", 0, ParallelSearchOptions::MaxThreads));
+    if (object.Get("maxStates").IsNumber())
+        search.maxStates = static_cast<size_t>(convertCount(object, "maxStates", 1, ConcurrentStateSet::MaxCapacity));
+    if (object.Get("seed").IsNumber())
+        search.seed = static_cast<uint64_t>(object.Get("seed").As<Number>().Int64Value());
+    return search;
+}
+
+void setSearchStatistics(Napi::Env env, Object &result, const ParallelSearchStatistics &stats)
+{
+    result.Set("threads", Number::New(env, stats.threads));
+    result.Set("states", Number::New(env, static_cast<double>(stats.states)));
+    result.Set("transitions", Number::New(env, static_cast<double>(stats.transitions)));
+    result.Set("steals", Number::New(env, static_cast<double>(stats.steals)));
+    result.Set("divergentMacrosteps", Number::New(env, static_cast<double>(stats.divergentMacrosteps)));
+    result.Set("elapsedMs", Number::New(env, stats.elapsedMs));
+    result.Set("complete", Boolean::New(env, stats.complete));
+    result.Set("stopReason", String::New(env, stopReasonName(stats.stopReason)));
+}
+
+Napi::Value convertParallelDeadlockReport(Napi::Env env, const ParallelDeadlockReport &report)
+{
+    auto stringsToJS = [env](const std::vector<std::string> &strings)
+    {
+        Array result = Array::New(env, strings.size());
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            result.Set(i, String::New(env, strings[i]));
+        }
+        return result;
+    };
+
+    Array deadlocks = Array::New(env, report.deadlocks.size());
+    for (size_t i = 0; i < report.deadlocks.size(); i++)
+    {
+        Object finding = Object::New(env);
+        finding.Set("configuration", stringsToJS(report.deadlocks[i]));
+        finding.Set("path", stringsToJS(report.deadlockPaths[i]));
+        deadlocks.Set(i, finding);
+    }
+
+    Object result = Object::New(env);
+    setSearchStatistics(env, result, report);
+    result.Set("deadlockCount", Number::New(env, static_cast<double>(report.deadlockCount)));
+    result.Set("deadlocks", deadlocks);
+    return result;
+}
+
+Napi::Value convertCycleReport(Napi::Env env, const CycleReport &report)
+{
+    auto stringsToJS = [env](const std::vector<std::string> &strings)
+    {
+        Array result = Array::New(env, strings.size());
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            result.Set(i, String::New(env, strings[i]));
+        }
+        return result;
+    };
+
+    Object result = Object::New(env);
+    setSearchStatistics(env, result, report);
+    result.Set("cycleFound", Boolean::New(env, report.cycleFound));
+    result.Set("stem", stringsToJS(report.stem));
+    result.Set("cycle", stringsToJS(report.cycle));
+    result.Set("cycleEntry", stringsToJS(report.cycleEntry));
+    return result;
+}
+
+/**
+ * State machine object or SCXML document as a shared statechart
+ */
+std::shared_ptr<Statechart> readStatechart(const Napi::Value &input)
+{
+    return std::make_shared<Statechart>(input.IsString() || input.IsBuffer()
+                                            ? statechartFromScxml(readDocument(input))
+                                            : Statechart::fromStateMachine(convertJSStateMachine(input.As<Object>())));
+}
+
+/**
+ * Exhaustive work-stealing deadlock search of a state machine object or an
+ * SCXML document across threads, as a bulk job returning a Promise.
+ * Options: parallel search options (see convertParallelSearchOptions),
+ * priority = "bulk", deadlineMs, signal, onProgress
+ */
+Value ParallelDeadlocksAsync(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsObject() || info[0].IsString()))
+    {
+        TypeError::New(env, "State machine object or SCXML document expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        auto chart = readStatechart(info[0]);
+        ParallelSearchOptions search = convertParallelSearchOptions(options);
+        std::function<ParallelDeadlockReport()> work = [chart, search]()
+        {
+            return ParallelSearch::findDeadlocks(*chart, search);
+        };
+        return scheduleJob<ParallelDeadlockReport>(env, options, JobPriority::Bulk, work,
+                                                   convertParallelDeadlockReport);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Parallel cycle detection (CNDFS) as a bulk job returning a Promise.
+ * Options: property = "acceptance" | "non-progress" (default), states =
+ * accepting or progress state ids, plus the parallel search and job
+ * options
+ */
+Value FindCycleAsync(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsObject() || info[0].IsString()))
+    {
+        TypeError::New(env, "State machine object or SCXML document expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        auto chart = readStatechart(info[0]);
+        ParallelSearchOptions search = convertParallelSearchOptions(options);
+        CycleProperty property = CycleProperty::NonProgress;
+        std::vector<std::string> states;
+        if (options.IsObject())
+        {
+            Object object = options.As<Object>();
+            if (object.Get("property").IsString())
+            {
+                std::string name = object.Get("property").As<String>().Utf8Value();
+                if (name == "acceptance")
+                    property = CycleProperty::Acceptance;
+                else if (name != "non-progress")
+                    throw std::invalid_argument("Unknown cycle property: " + name);
+            }
+            if (object.Get("states").IsArray())
+            {
+                Array list = object.Get("states").As<Array>();
+                for (uint32_t i = 0; i < list.Length(); i++)
+                    states.push_back(list.Get(i).ToString().Utf8Value());
+            }
+        }
+        std::function<CycleReport()> work = [chart, property, states, search]()
+        {
+            return ParallelSearch::findCycle(*chart, property, states, search);
+        };
+        return scheduleJob<CycleReport>(env, options, JobPriority::Bulk, work, convertCycleReport);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Distributed exploration options from JS: { workers, ringBytes,
+ * batchSize, maxConfigurations, timeBudgetMs, memoryBudgetMb }, bounded
+ * as documented on DistributedOptions
+ */
+DistributedOptions convertDistributedOptions(const Napi::Value &options)
+{
+    DistributedOptions distributed;
+    distributed.budget = convertBudget(options);
+    if (!options.IsObject())
+    {
+        return distributed;
+    }
+
+    Object object = options.As<Object>();
+    if (object.Get("workers").IsNumber())
+        distributed.workers = static_cast<unsigned>(convertCount(object, "workers", 1, DistributedOptions::MaxWorkers));
+    if (object.Get("ringBytes").IsNumber())
+        distributed.ringBytes = static_cast<size_t>(convertCount(object, "ringBytes", 0, DistributedOptions::MaxRingBytes));
+    if (object.Get("batchSize").IsNumber())
+        distributed.batchSize = static_cast<size_t>(convertCount(object, "batchSize", 1, DistributedOptions::MaxBatchSize));
+    if (object.Get("maxConfigurations").IsNumber())
+        distributed.maxConfigurations =
+            static_cast<size_t>(convertCount(object, "maxConfigurations", 1, ConcurrentStateSet::MaxCapacity));
+    return distributed;
+}
+
+Napi::Value convertDistributedReport(Napi::Env env, const DistributedReport &report)
+{
+    Object result = convertStatechartReport(env, report);
+    Array partitions = Array::New(env, report.partitionSizes.size());
+    for (size_t i = 0; i < report.partitionSizes.size(); i++)
+    {
+        partitions.Set(i, Number::New(env, static_cast<double>(report.partitionSizes[i])));
+    }
+    result.Set("workers", Number::New(env, report.workers));
+    result.Set("partitionSizes", partitions);
+    result.Set("messages", Number::New(env, static_cast<double>(report.messages)));
+    return result;
+}
+
+/**
+ * Exploration of a state machine object or an SCXML document partitioned
+ * across forked worker processes, as a bulk job returning a Promise.
+ * Options: distributed options (see convertDistributedOptions), priority =
+ * "bulk", deadlineMs, signal, onProgress
+ */
+Value ExploreDistributedAsync(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsObject() || info[0].IsString()))
+    {
+        TypeError::New(env, "State machine object or SCXML document expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    try
+    {
+        Napi::Value options = info.Length() > 1 ? info[1] : env.Undefined();
+        auto chart = readStatechart(info[0]);
+        DistributedOptions distributed = convertDistributedOptions(options);
+        std::function<DistributedReport()> work = [chart, distributed]()
+        {
+            return DistributedExplorer::explore(*chart, distributed);
+        };
+        return scheduleJob<DistributedReport>(env, options, JobPriority::Bulk, work, convertDistributedReport);
+    }
+    catch (const std::exception &e)
+    {
+        TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * A binary model file mapped into memory; checks run on the mapping
+ * without materializing the machine
+ */
+class ModelHandle : public ObjectWrap<ModelHandle>
+{
+public:
+    static Function Init(Napi::Env env)
+    {
+        return DefineClass(env, "ModelHandle",
+                           {InstanceMethod("stats", &ModelHandle::Stats),
+                            InstanceMethod("findDeadlocks", &ModelHandle::FindDeadlocks),
+                            InstanceMethod("findUnreachable", &ModelHandle::FindUnreachable),
+                            InstanceMethod("toStateMachine", &ModelHandle::ToStateMachine)});
+    }
+
+    ModelHandle(const CallbackInfo &info) : ObjectWrap<ModelHandle>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsString())
+        {
+            TypeError::New(env, "Model path expected").ThrowAsJavaScriptException();
+            return;
+        }
+
+        try
+        {
+            model = MappedModel::open(info[0].As<String>().Utf8Value());
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    std::unique_ptr<MappedModel> model;
+
+    Napi::Value StateIds(Napi::Env env, const std::vector<uint32_t> &states) const
+    {
+        Array result = Array::New(env, states.size());
+        for (size_t i = 0; i < states.size(); i++)
+        {
+            std::string_view id = model->stateId(states[i]);
+            result.Set(i, String::New(env, id.data(), id.size()));
+        }
+        return result;
+    }
+
+    Napi::Value Stats(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        Object result = Object::New(env);
+        if (model)
+        {
+            const ModelHeader &header = model->header();
+            std::string_view name = model->string(header.machineName);
+            result.Set("name", String::New(env, name.data(), name.size()));
+            result.Set("version", Number::New(env, header.version));
+            result.Set("states", Number::New(env, header.stateCount));
+            result.Set("transitions", Number::New(env, header.edgeCount));
+            result.Set("variables", Number::New(env, header.variableCount));
+            result.Set("mappedBytes", Number::New(env, static_cast<double>(model->mappedBytes())));
+        }
+        return result;
+    }
+
+    Napi::Value FindDeadlocks(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!model)
+            return env.Null();
+        return StateIds(env, GraphAnalysis::deadlockStates(*model));
+    }
+
+    Napi::Value FindUnreachable(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!model)
+            return env.Null();
+
+        auto reachable = GraphAnalysis::reachableStates(*model);
+        std::vector<uint32_t> unreachable;
+        for (uint32_t s = 0; s < reachable.size(); s++)
+        {
+            if (!reachable[s])
+                unreachable.push_back(s);
+        }
+        return StateIds(env, unreachable);
+    }
+
+    Napi::Value ToStateMachine(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!model)
+            return env.Null();
+
+        return convertStateMachineToJS(env, model->toStateMachine());
+    }
+};
+
+/**
+ * Convert an incremental report to JS: the verifyStateMachine fields plus
+ * the incrementally maintained extras
+ */
+Object convertIncrementalReport(Env env, const IncrementalReport &report)
+{
+    auto stringsToJS = [env](const std::vector<std::string> &strings)
+    {
+        Array result = Array::New(env, strings.size());
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            result.Set(i, String::New(env, strings[i]));
+        }
+        return result;
+    };
+
+    std::vector<std::string> errors;
+    if (report.initialStates == 0)
+        errors.push_back("ERROR: No initial state defined");
+    else if (report.initialStates > 1)
+        errors.push_back("ERROR: Multiple initial states defined");
+
+    std::vector<std::string> warnings;
+    for (const auto &state : report.unreachableStates)
+        warnings.push_back("WARNING: Unreachable state: " + state);
+    for (const auto &state : report.deadlocks)
+        warnings.push_back("WARNING: Potential deadlock state: " + state);
+    if (!report.finalReachable)
+        warnings.push_back("WARNING: No final state is reachable");
+
+    std::string summary = "States: " + std::to_string(report.totalStates) +
+                          " (Reachable: " + std::to_string(report.reachableStates) + ")" +
+                          " | Transitions: " + std::to_string(report.transitions) +
+                          " | Status: " + (errors.empty() ? "VALID" : "INVALID");
+
+    Object result = Object::New(env);
+    result.Set("isValid", Boolean::New(env, errors.empty()));
+    result.Set("reachableStates", Number::New(env, report.reachableStates));
+    result.Set("totalStates", Number::New(env, report.totalStates));
+    result.Set("summary", String::New(env, summary));
+    result.Set("errors", stringsToJS(errors));
+    result.Set("warnings", stringsToJS(warnings));
+    result.Set("deadlocks", stringsToJS(report.deadlocks));
+
+    result.Set("revision", Number::New(env, static_cast<double>(report.revision)));
+    result.Set("transitions", Number::New(env, report.transitions));
+    result.Set("deadlockCount", Number::New(env, report.deadlockCount));
+    result.Set("unreachableStates", stringsToJS(report.unreachableStates));
+    result.Set("inputAlphabet", Number::New(env, report.inputAlphabet));
+    result.Set("incompleteCount", Number::New(env, report.incompleteCount));
+    result.Set("incompleteStates", stringsToJS(report.incompleteStates));
+    result.Set("components", Number::New(env, report.components));
+    result.Set("cyclicComponents", Number::New(env, report.cyclicComponents));
+    result.Set("trapComponents", Number::New(env, report.trapComponents));
+    Array traps = Array::New(env, report.traps.size());
+    for (size_t i = 0; i < report.traps.size(); i++)
+    {
+        traps.Set(i, stringsToJS(report.traps[i]));
+    }
+    result.Set("traps", traps);
+    result.Set("lastEditWork", Number::New(env, static_cast<double>(report.lastEditWork)));
+    return result;
+}
+
+/**
+ * Verification kept alive across editor edits; apply() takes the
+ * frontend's EditorAction objects and ignores the view-only ones
+ */
+class IncrementalSession : public ObjectWrap<IncrementalSession>
+{
+public:
+    static Function Init(Napi::Env env)
+    {
+        return DefineClass(env, "IncrementalVerifier",
+                           {InstanceMethod("apply", &IncrementalSession::Apply),
+                            InstanceMethod("report", &IncrementalSession::Report)});
+    }
+
+    IncrementalSession(const CallbackInfo &info) : ObjectWrap<IncrementalSession>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsObject())
+        {
+            TypeError::New(env, "State machine object expected").ThrowAsJavaScriptException();
+            return;
+        }
+
+        try
+        {
+            verifier.reset(new IncrementalVerifier(convertJSStateMachine(info[0].As<Object>())));
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    std::unique_ptr<IncrementalVerifier> verifier;
+
+    Napi::Value Apply(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!verifier || info.Length() < 1 || !info[0].IsArray())
+        {
+            TypeError::New(env, "Editor action array expected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        // Actions before a failing one stay applied, as in the editor
+        Array actions = info[0].As<Array>();
+        try
+        {
+            for (uint32_t i = 0; i < actions.Length(); i++)
+            {
+                Object action = actions.Get(i).As<Object>();
+                std::string type = action.Get("type").As<String>().Utf8Value();
+                Napi::Value payload = action.Get("payload");
+
+                if (type == "ADD_STATE")
+                    verifier->addState(convertJSState(payload.As<Object>()));
+                else if (type == "REMOVE_STATE")
+                    verifier->removeState(payload.As<String>().Utf8Value());
+                else if (type == "UPDATE_STATE")
+                    verifier->updateState(convertJSState(payload.As<Object>()));
+                else if (type == "ADD_TRANSITION")
+                    verifier->addTransition(convertJSTransition(payload.As<Object>()));
+                else if (type == "REMOVE_TRANSITION")
+                    verifier->removeTransition(payload.As<String>().Utf8Value());
+                else if (type == "UPDATE_TRANSITION")
+                    verifier->updateTransition(convertJSTransition(payload.As<Object>()));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            TypeError::New(env, std::string("C++ Error: ") + e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        return Report(info);
+    }
+
+    Napi::Value Report(const CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!verifier)
+            return env.Null();
+        return convertIncrementalReport(env, verifier->report());
+    }
+};
+
 /**
  * Module initialization
  */
 Object Init(Env env, Object exports)
 {
     exports.Set("verifyStateMachine", Function::New(env, VerifyStateMachine));
+    exports.Set("verifyStateMachineAsync", Function::New(env, VerifyStateMachineAsync));
+    exports.Set("machineHash", Function::New(env, MachineHashOf));
+    exports.Set("schedulerStats", Function::New(env, SchedulerStats));
+    exports.Set("metricsText", Function::New(env, MetricsText));
+    exports.Set("reportCacheStats", Function::New(env, ReportCacheStats));
+    exports.Set("verificationStats", Function::New(env, VerificationStatsOf));
+    exports.Set("traceEvents", Function::New(env, TraceEvents));
+    exports.Set("configureTracing", Function::New(env, ConfigureTracing));
+    exports.Set("configureReportCache", Function::New(env, ConfigureReportCache));
     exports.Set("checkReachability", Function::New(env, CheckReachability));
     exports.Set("findDeadlocks", Function::New(env, FindDeadlocks));
+    exports.Set("simulateNondeterministic", Function::New(env, SimulateNondeterministic));
+    exports.Set("findInputMatches", Function::New(env, FindInputMatches));
+    exports.Set("generateCppCode", Function::New(env, GenerateCppCode));
+    exports.Set("encodeTrace", Function::New(env, EncodeTrace));
+    exports.Set("decodeTrace", Function::New(env, DecodeTrace));
+    exports.Set("SimulationSession", SimulationSession::Init(env));
+    exports.Set("TraceRecorder", TraceRecorder::Init(env));
+    exports.Set("saveModel", Function::New(env, SaveModel));
+    exports.Set("importKiss2", Function::New(env, ImportKiss2));
+    exports.Set("importScxml", Function::New(env, ImportScxml));
+    exports.Set("importScxmlAsync", Function::New(env, ImportScxmlAsync));
+    exports.Set("swarmVerifyAsync", Function::New(env, SwarmVerifyAsync));
+    exports.Set("parallelDeadlocksAsync", Function::New(env, ParallelDeadlocksAsync));
+    exports.Set("findCycleAsync", Function::New(env, FindCycleAsync));
+    exports.Set("exploreDistributedAsync", Function::New(env, ExploreDistributedAsync));
+    exports.Set("ModelHandle", ModelHandle::Init(env));
+    exports.Set("IncrementalVerifier", IncrementalSession::Init(env));
 
     return exports;
 }
@@ -11,6 +11,8 @@ export interface State {
   isFinal: boolean;
   mode?: string;
   notes?: string;
+  parent?: string; // id of the enclosing composite state
+  kind?: "parallel" | "history" | "deepHistory";
 }
 
 export interface Transition {
@@ -19,6 +19,8 @@ export interface State {
   isFinal: boolean;
   mode?: string;
   notes?: string;
+  parent?: string; // id of the enclosing composite state
+  kind?: "parallel" | "history" | "deepHistory";
 }
 
 // Transition definition
@@ -1,5 +1,5 @@
 import axios, { AxiosInstance, AxiosError } from "axios";
-import { StateMachine } from "../models/types";
+import { EditorAction, StateMachine } from "../models/types";
 
 const API_BASE_URL =
   process.env.REACT_APP_API_URL || "http://localhost:5000/api";
@@ -11,6 +11,20 @@ interface ApiResponse<T> {
   timestamp: number;
 }
 
+/**
+ * Where one native verification spent its time; phases in run order,
+ * starting with the request's conversion
+ */
+export interface VerificationStats {
+  phases: { name: string; wallMs: number; cpuMs: number }[];
+  wallMs: number;
+  cpuMs: number;
+  states: number;
+  edges: number;
+  bytesTouched: number;
+  peakBytes: number;
+}
+
 class ApiService {
   private client: AxiosInstance;
 
@@ -48,9 +62,13 @@ class ApiService {
   }
 
   /**
-   * Verify state machine with C++ engine
+   * Verify state machine with C++ engine; with a budget the report may be
+   * partial (complete === false)
    */
-  async verifyMachine(stateMachine: StateMachine): Promise<{
+  async verifyMachine(
+    stateMachine: StateMachine,
+    budget?: { timeBudgetMs?: number; memoryBudgetMb?: number },
+  ): Promise<{
     isValid: boolean;
     reachableStates: number;
     totalStates: number;
@@ -58,6 +76,12 @@ class ApiService {
     warnings: string[];
     deadlocks: string[];
     summary: string;
+    complete: boolean;
+    stopReason: "" | "time" | "memory" | "configurations";
+    statesExplored: number;
+    frontierSize: number;
+    coverage: number;
+    stats: VerificationStats;
   }> {
     const response = await this.client.post<
       ApiResponse<{
@@ -68,8 +92,14 @@ class ApiService {
         warnings: string[];
         deadlocks: string[];
         summary: string;
+        complete: boolean;
+        stopReason: "" | "time" | "memory" | "configurations";
+        statesExplored: number;
+        frontierSize: number;
+        coverage: number;
+        stats: VerificationStats;
       }>
-    >("/verify", stateMachine);
+    >("/verify", stateMachine, { params: budget });
 
     if (!response.data.success) {
       throw new Error(response.data.error || "Verification failed");
@@ -77,6 +107,58 @@ class ApiService {
     return response.data.data!;
   }
 
+  /**
+   * verifyMachine with progress events, read from the server-sent event
+   * stream of /verify/stream
+   */
+  async verifyMachineWithProgress(
+    stateMachine: StateMachine,
+    onProgress: (progress: {
+      explored: number;
+      frontier: number;
+      depth: number;
+      bytes: number;
+      elapsedMs: number;
+      statesPerSecond: number;
+      etaMs: number;
+    }) => void,
+    budget?: { timeBudgetMs?: number; memoryBudgetMb?: number },
+  ): Promise<any> {
+    const query = new URLSearchParams(
+      Object.entries(budget || {}).map(([key, value]) => [key, String(value)]),
+    );
+    const response = await fetch(`${API_BASE_URL}/verify/stream?${query}`, {
+      method: "POST",
+      headers: { "Content-Type": "application/json" },
+      body: JSON.stringify(stateMachine),
+    });
+    if (!response.ok || !response.body) {
+      throw new Error(`Verification failed: HTTP ${response.status}`);
+    }
+
+    const reader = response.body.getReader();
+    const decoder = new TextDecoder();
+    let buffered = "";
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) {
+        throw new Error("Verification stream ended without a result");
+      }
+      buffered += decoder.decode(value, { stream: true });
+
+      let end;
+      while ((end = buffered.indexOf("\n\n")) >= 0) {
+        const message = buffered.slice(0, end);
+        buffered = buffered.slice(end + 2);
+        const event = /^event: (.*)$/m.exec(message)?.[1];
+        const data = JSON.parse(/^data: (.*)$/m.exec(message)?.[1] || "null");
+        if (event === "progress") onProgress(data);
+        else if (event === "result") return data;
+        else if (event === "error") throw new Error(data.error);
+      }
+    }
+  }
+
   /**
    * Check if state is reachable
    */
@@ -157,6 +239,91 @@ class ApiService {
     }
     return response.data.data!;
   }
+
+  /**
+   * Record a long simulation natively; frames are fetched on demand
+   */
+  async recordTrace(
+    stateMachine: StateMachine,
+    inputs: string[],
+  ): Promise<{
+    traceId: string;
+    consumed: number;
+    stats: { length: number; snapshots: number; snapshotInterval: number };
+  }> {
+    const response = await this.client.post<
+      ApiResponse<{
+        traceId: string;
+        consumed: number;
+        stats: { length: number; snapshots: number; snapshotInterval: number };
+      }>
+    >("/traces", { stateMachine, inputs });
+
+    if (!response.data.success) {
+      throw new Error(response.data.error || "Trace recording failed");
+    }
+    return response.data.data!;
+  }
+
+  async getTraceFrames(
+    traceId: string,
+    from: number,
+    count: number,
+  ): Promise<
+    {
+      step: number;
+      stateId: string;
+      transitionId?: string;
+      variables: Record<string, number>;
+    }[]
+  > {
+    const response = await this.client.get<
+      ApiResponse<{
+        frames: {
+          step: number;
+          stateId: string;
+          transitionId?: string;
+          variables: Record<string, number>;
+        }[];
+      }>
+    >(`/traces/${traceId}/frames`, { params: { from, count } });
+
+    if (!response.data.success) {
+      throw new Error(response.data.error || "Trace seek failed");
+    }
+    return response.data.data!.frames;
+  }
+
+  /**
+   * Start an incremental verifier; later edits are sent as editor actions
+   */
+  async startIncrementalVerification(
+    stateMachine: StateMachine,
+  ): Promise<{ verifierId: string; report: any }> {
+    const response = await this.client.post<
+      ApiResponse<{ verifierId: string; report: any }>
+    >("/incremental", { stateMachine });
+
+    if (!response.data.success) {
+      throw new Error(response.data.error || "Verification failed");
+    }
+    return response.data.data!;
+  }
+
+  async applyEditorActions(
+    verifierId: string,
+    actions: EditorAction[],
+  ): Promise<any> {
+    const response = await this.client.post<ApiResponse<any>>(
+      `/incremental/${verifierId}/actions`,
+      { actions },
+    );
+
+    if (!response.data.success) {
+      throw new Error(response.data.error || "Verification failed");
+    }
+    return response.data.data;
+  }
 }
 
 export const apiService = new ApiService();